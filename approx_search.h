@@ -0,0 +1,286 @@
+#ifndef APPROX_SEARCH_H
+#define APPROX_SEARCH_H
+
+#include "log_list.h"
+#include "kmp.h"
+#include <cmath>
+#include <cstring>
+
+// Estimated keyword counts from a sample of the stored logs
+struct ApproxEstimate {
+    double logs;               // Logs containing the keyword
+    double logsLow;            // Confidence interval for logs
+    double logsHigh;
+    double occurrences;        // Keyword occurrences (as searchKeyword() counts)
+    double occurrencesLow;
+    double occurrencesHigh;
+    long long sampledLogs;
+    long long totalLogs;
+    int sampledUnits;
+    int totalUnits;
+    double confidence;
+    bool exact;                // Every log was scanned: the counts are exact
+
+    // Half the interval width relative to the estimate (0 when exact); with
+    // no match sampled yet, the upper bound relative to all logs
+    inline double relativeError() const {
+        if (exact) {
+            return 0.0;
+        }
+        if (logs > 0.0) {
+            return (logsHigh - logsLow) / 2.0 / logs;
+        }
+        return totalLogs > 0 ? logsHigh / totalLogs : 0.0;
+    }
+};
+
+// Keyword count estimated from a growing random sample of the log store
+// The store is cut into units of UNIT_ROWS consecutive rows (slices of the
+// column store's blocks, so each is scanned sequentially) and the units are
+// visited in a random order without replacement. After any number of
+// refine() calls the count is estimated with the ratio estimator (matches per
+// sampled row times all rows) and a normal-approximation confidence interval
+// for cluster sampling with the finite population correction. The interval
+// narrows as more units are scanned and collapses to the exact count when
+// every unit has been.
+class ApproximateSearch {
+public:
+    static const int UNIT_ROWS = 512;
+
+private:
+    // Sums over sampled units for one count (y = count, m = rows in the unit)
+    struct Sums {
+        double y;
+        double yy;
+        double my;
+    };
+
+    KMPPattern pattern;
+    int* order;                // Units in sampling order
+    int unitCount;
+    int nextUnit;
+    int totalRows;
+    long long generation;
+    double confidence;
+    double z;                  // Normal quantile for the confidence level
+    double sampledRows;        // Sum of m
+    double sampledRowsSquared; // Sum of m * m
+    long long refinedRows;     // Rows scanned by the last refine()
+    Sums logs;
+    Sums occurrences;
+
+    static inline unsigned long long mix(unsigned long long x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // z such that a standard normal lies within +-z with probability p
+    static inline double normalQuantile(double p) {
+        double low = 0.0;
+        double high = 10.0;
+        for (int i = 0; i < 60; i++) {
+            double middle = (low + high) / 2.0;
+            if (std::erf(middle / std::sqrt(2.0)) < p) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        return (low + high) / 2.0;
+    }
+
+    // Student t quantile for the confidence level (Cornish-Fisher expansion
+    // around z), which widens the interval while few units are sampled
+    inline double quantile(int degrees) const {
+        double z3 = z * z * z;
+        double z5 = z3 * z * z;
+        return z + (z3 + z) / (4.0 * degrees) + (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * degrees * degrees);
+    }
+
+    inline void add(Sums& sums, double m, double y) {
+        sums.y += y;
+        sums.yy += y * y;
+        sums.my += m * y;
+    }
+
+    // Estimate, interval and the bounds already certain from the sample
+    inline void estimate(const Sums& sums, double upperLimit, double& value, double& low, double& high) const {
+        int n = nextUnit;
+        double rows = (double)totalRows;
+        if (n == unitCount) {
+            value = sums.y;
+            low = sums.y;
+            high = sums.y;
+            return;
+        }
+        if (n == 0 || sampledRows == 0.0) {
+            value = 0.0;
+            low = 0.0;
+            high = upperLimit;
+            return;
+        }
+        double ratio = sums.y / sampledRows;
+        value = ratio * rows;
+        if (sums.y == 0.0) {
+            // Nothing seen yet: the "rule of three" bound (3 / rows at 95%)
+            low = 0.0;
+            high = -std::log(1.0 - confidence) / sampledRows * rows;
+        } else if (n < 2) {
+            low = sums.y;
+            high = upperLimit;
+            return;
+        } else {
+            // Residual variance of the unit counts around the ratio
+            double residual = sums.yy - 2.0 * ratio * sums.my + ratio * ratio * sampledRowsSquared;
+            if (residual < 0.0) {
+                residual = 0.0;
+            }
+            // Var(total) = U^2 (1 - n/U) s^2 / n, with U units
+            double variance = residual / (n - 1);
+            double fpc = 1.0 - (double)n / unitCount;
+            double half = quantile(n - 1) * unitCount * std::sqrt(fpc * variance / n);
+            low = value - half;
+            high = value + half;
+        }
+        // The sample itself bounds the count
+        if (low < sums.y) {
+            low = sums.y;
+        }
+        if (high > upperLimit) {
+            high = upperLimit;
+        }
+        if (value < low) {
+            value = low;
+        }
+        if (value > high) {
+            value = high;
+        }
+    }
+
+public:
+    inline ApproximateSearch() {
+        order = nullptr;
+        unitCount = 0;
+        nextUnit = 0;
+        totalRows = 0;
+        generation = 0;
+        confidence = 0.95;
+        z = normalQuantile(confidence);
+        sampledRows = 0.0;
+        sampledRowsSquared = 0.0;
+        refinedRows = 0;
+        memset(&logs, 0, sizeof(logs));
+        memset(&occurrences, 0, sizeof(occurrences));
+    }
+
+    inline ~ApproximateSearch() {
+        delete[] order;
+    }
+
+    // Sample the first rowCount rows for keyword; the seed picks the order
+    // of units. confidence is the interval's coverage (e.g. 0.95).
+    // Returns false for an empty keyword.
+    inline bool start(const char* keyword, bool caseSensitive, int rowCount, long long dataGeneration,
+                      unsigned long long seed, double confidenceLevel = 0.95) {
+        pattern.compile(keyword != nullptr ? keyword : "", caseSensitive);
+        delete[] order;
+        totalRows = rowCount > 0 ? rowCount : 0;
+        unitCount = (totalRows + UNIT_ROWS - 1) / UNIT_ROWS;
+        order = new int[unitCount > 0 ? unitCount : 1];
+        for (int i = 0; i < unitCount; i++) {
+            order[i] = i;
+        }
+        // Fisher-Yates shuffle
+        unsigned long long state = seed;
+        for (int i = unitCount - 1; i > 0; i--) {
+            state = mix(state);
+            int j = (int)(state % (unsigned long long)(i + 1));
+            int swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+        nextUnit = 0;
+        generation = dataGeneration;
+        if (confidenceLevel <= 0.0 || confidenceLevel >= 1.0) {
+            confidenceLevel = 0.95;
+        }
+        confidence = confidenceLevel;
+        z = normalQuantile(confidence);
+        sampledRows = 0.0;
+        sampledRowsSquared = 0.0;
+        refinedRows = 0;
+        memset(&logs, 0, sizeof(logs));
+        memset(&occurrences, 0, sizeof(occurrences));
+        return pattern.getLength() > 0;
+    }
+
+    // Scan up to units more sample units; returns the number scanned
+    inline int refine(const LogList& list, int units) {
+        refinedRows = 0;
+        if (pattern.getLength() == 0) {
+            return 0;
+        }
+        int scanned = 0;
+        while (scanned < units && nextUnit < unitCount) {
+            int first = order[nextUnit] * UNIT_ROWS;
+            int end = first + UNIT_ROWS < totalRows ? first + UNIT_ROWS : totalRows;
+            double matchingRows = 0.0;
+            double found = 0.0;
+            for (int row = first; row < end; row++) {
+                int count = pattern.count(list.getMessage(row));
+                if (count > 0) {
+                    matchingRows += 1.0;
+                    found += count;
+                }
+            }
+            double m = (double)(end - first);
+            refinedRows += end - first;
+            sampledRows += m;
+            sampledRowsSquared += m * m;
+            add(logs, m, matchingRows);
+            add(occurrences, m, found);
+            nextUnit++;
+            scanned++;
+        }
+        return scanned;
+    }
+
+    // Current estimates and confidence intervals
+    inline void getEstimate(ApproxEstimate& result) const {
+        double rows = (double)totalRows;
+        estimate(logs, rows - (sampledRows - logs.y), result.logs, result.logsLow, result.logsHigh);
+        // Occurrences have no upper bound from the row count; use the interval as is
+        estimate(occurrences, HUGE_VAL, result.occurrences, result.occurrencesLow, result.occurrencesHigh);
+        result.sampledLogs = (long long)sampledRows;
+        result.totalLogs = totalRows;
+        result.sampledUnits = nextUnit;
+        result.totalUnits = unitCount;
+        result.confidence = confidence;
+        result.exact = nextUnit == unitCount;
+    }
+
+    inline bool isComplete() const {
+        return nextUnit == unitCount || pattern.getLength() == 0;
+    }
+
+    inline long long getRefinedRows() const {
+        return refinedRows;
+    }
+
+    inline int getRemainingUnits() const {
+        return unitCount - nextUnit;
+    }
+
+    inline long long getGeneration() const {
+        return generation;
+    }
+
+private:
+    // Copying is not supported
+    ApproximateSearch(const ApproximateSearch&);
+    ApproximateSearch& operator=(const ApproximateSearch&);
+};
+
+#endif // APPROX_SEARCH_H
@@ -0,0 +1,596 @@
+#ifndef ASYNC_READER_H
+#define ASYNC_READER_H
+
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
+
+// How AsyncFileReader issues its reads
+enum AsyncIoBackend {
+    ASYNC_IO_NONE,          // No async reader; callers read files directly
+    ASYNC_IO_URING,         // io_uring (falls back to the thread pool if unavailable)
+    ASYNC_IO_THREAD_POOL    // Blocking open/pread on a pool of threads
+};
+
+// Reads many files ahead of their consumers with many requests in flight
+//
+// Every file gets two buffers of chunkSize: one holds data the consumer is
+// copying out with read(), the other is being filled by the next read. A
+// file is opened, read chunk by chunk and closed without the consumer ever
+// blocking in a system call unless its data has not arrived yet.
+//
+// Requests are served in file order from a queue; a consumer waiting on a
+// file moves that file to the front. With io_uring one thread submits opens
+// and reads (up to queueDepth in flight) and reaps completions; consumers
+// wake it through an eventfd read kept in the ring. The thread pool backend
+// runs the same requests as blocking open()/pread() calls.
+//
+// A read shorter than requested is taken as end of file, as holds for
+// regular files that are not being appended to.
+class AsyncFileReader {
+private:
+    struct AsyncFile {
+        const char* path;
+        int fd;
+        long long offset;           // Next read offset
+        char* ready;                // Data for the consumer
+        size_t readyLength;
+        size_t readyUsed;
+        char* spare;                // Target of the next read
+        size_t spareLength;
+        bool spareFull;             // Completed read waiting for the consumer to drain ready
+        bool busy;                  // Queued or in flight
+        bool endOfFile;
+        int error;                  // errno of a failed open or read
+    };
+
+    // Memory-mapped io_uring submission and completion rings
+    struct Ring {
+        int fd;
+        void* sqMemory;
+        size_t sqSize;
+        void* cqMemory;
+        size_t cqSize;
+        io_uring_sqe* sqes;
+        size_t sqesSize;
+        unsigned* sqHead;
+        unsigned* sqTail;
+        unsigned* sqMask;
+        unsigned* sqArray;
+        unsigned* cqHead;
+        unsigned* cqTail;
+        unsigned* cqMask;
+        io_uring_cqe* cqes;
+    };
+
+    // user_data tags (file index in the high bits)
+    static const unsigned long long OP_OPEN = 1;
+    static const unsigned long long OP_READ = 2;
+    static const unsigned long long OP_WAKE = 3;
+
+    AsyncFile* files;
+    int fileCount;
+    size_t chunkSize;
+    int queueDepth;
+    int poolThreads;
+    AsyncIoBackend backend;
+
+    std::mutex lock;
+    std::condition_variable dataSignal;     // Consumers wait for data
+    std::condition_variable requestSignal;  // Pool threads wait for requests
+    int* requests;                          // Ring of files needing an open or read
+    int requestHead;
+    int requestCount;
+    bool stopping;
+
+    std::thread* threads;
+    int threadCount;
+    Ring ring;
+    int wakeFd;
+    unsigned long long wakeValue;
+
+    // ---- Shared request and completion logic (caller holds lock) ----
+
+    inline void pushRequest(int index, bool urgent) {
+        if (urgent) {
+            requestHead = (requestHead + fileCount - 1) % fileCount;
+            requests[requestHead] = index;
+        } else {
+            requests[(requestHead + requestCount) % fileCount] = index;
+        }
+        requestCount++;
+        files[index].busy = true;
+    }
+
+    inline int popRequest() {
+        int index = requests[requestHead];
+        requestHead = (requestHead + 1) % fileCount;
+        requestCount--;
+        return index;
+    }
+
+    inline void promoteRequest(int index) {
+        for (int i = 0; i < requestCount; i++) {
+            if (requests[(requestHead + i) % fileCount] != index) {
+                continue;
+            }
+            for (int j = i; j > 0; j--) {
+                requests[(requestHead + j) % fileCount] = requests[(requestHead + j - 1) % fileCount];
+            }
+            requests[requestHead] = index;
+            return;
+        }
+    }
+
+    // Record a finished read of `result` bytes (or -errno); returns true if
+    // the file should be read again right away
+    inline bool completeRead(AsyncFile& file, long long result, size_t requested) {
+        if (result < 0) {
+            file.error = (int)-result;
+            file.endOfFile = true;
+        } else {
+            file.offset += result;
+            file.spareLength = (size_t)result;
+            if ((size_t)result < requested) {
+                file.endOfFile = true;
+            }
+            if (file.endOfFile && file.spareLength < chunkSize / 2) {
+                // Small tail: keep only the bytes read
+                char* fitted = new char[file.spareLength > 0 ? file.spareLength : 1];
+                memcpy(fitted, file.spare, file.spareLength);
+                delete[] file.spare;
+                file.spare = fitted;
+            }
+            if (file.spareLength > 0) {
+                file.spareFull = true;
+            }
+        }
+        if (file.endOfFile && file.fd >= 0) {
+            ::close(file.fd);
+            file.fd = -1;
+        }
+        if (file.spareFull && file.readyUsed == file.readyLength) {
+            swapBuffers(file);
+        }
+        file.busy = false;
+        return !file.endOfFile && !file.spareFull;
+    }
+
+    // Hand the completed spare buffer to the consumer
+    inline void swapBuffers(AsyncFile& file) {
+        char* drained = file.ready;
+        file.ready = file.spare;
+        file.readyLength = file.spareLength;
+        file.readyUsed = 0;
+        file.spare = drained;
+        file.spareLength = 0;
+        file.spareFull = false;
+        if (file.endOfFile) {
+            delete[] file.spare;
+            file.spare = nullptr;
+        }
+    }
+
+    inline void prepareSpare(AsyncFile& file) {
+        if (file.spare == nullptr) {
+            file.spare = new char[chunkSize];
+        }
+    }
+
+    // ---- Thread pool backend ----
+
+    inline void poolLoop() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            while (requestCount == 0 && !stopping) {
+                requestSignal.wait(guard);
+            }
+            if (stopping) {
+                return;
+            }
+            int index = popRequest();
+            AsyncFile& file = files[index];
+            prepareSpare(file);
+            char* target = file.spare;
+            long long offset = file.offset;
+            guard.unlock();
+
+            long long result = 0;
+            if (file.fd < 0) {
+                file.fd = ::open(file.path, O_RDONLY | O_CLOEXEC);
+                if (file.fd < 0) {
+                    result = -errno;
+                }
+            }
+            if (result == 0) {
+                ssize_t got;
+                do {
+                    got = ::pread(file.fd, target, chunkSize, offset);
+                } while (got < 0 && errno == EINTR);
+                result = got < 0 ? -errno : got;
+            }
+
+            guard.lock();
+            if (completeRead(file, result, chunkSize)) {
+                pushRequest(index, false);
+                requestSignal.notify_one();
+            }
+            dataSignal.notify_all();
+        }
+    }
+
+    // ---- io_uring backend (raw system calls) ----
+
+    inline static int ringSetup(unsigned entries, io_uring_params* params) {
+        return (int)syscall(__NR_io_uring_setup, entries, params);
+    }
+
+    inline static int ringEnter(int fd, unsigned submit, unsigned wait, unsigned flags) {
+        return (int)syscall(__NR_io_uring_enter, fd, submit, wait, flags, nullptr, 0);
+    }
+
+    inline bool openRing(unsigned entries) {
+        memset(&ring, 0, sizeof(ring));
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring.fd = ringSetup(entries, &params);
+        if (ring.fd < 0) {
+            return false;
+        }
+        ring.sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring.cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single && ring.cqSize > ring.sqSize) {
+            ring.sqSize = ring.cqSize;
+        }
+        ring.sqMemory = mmap(nullptr, ring.sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring.fd, IORING_OFF_SQ_RING);
+        if (ring.sqMemory == MAP_FAILED) {
+            ::close(ring.fd);
+            return false;
+        }
+        if (single) {
+            ring.cqMemory = ring.sqMemory;
+            ring.cqSize = 0;
+        } else {
+            ring.cqMemory = mmap(nullptr, ring.cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                 ring.fd, IORING_OFF_CQ_RING);
+            if (ring.cqMemory == MAP_FAILED) {
+                munmap(ring.sqMemory, ring.sqSize);
+                ::close(ring.fd);
+                return false;
+            }
+        }
+        ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        ring.sqes = (io_uring_sqe*)mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE,
+                                        MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+        if (ring.sqes == MAP_FAILED) {
+            closeRing();
+            return false;
+        }
+        char* sq = (char*)ring.sqMemory;
+        char* cq = (char*)ring.cqMemory;
+        ring.sqHead = (unsigned*)(sq + params.sq_off.head);
+        ring.sqTail = (unsigned*)(sq + params.sq_off.tail);
+        ring.sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+        ring.sqArray = (unsigned*)(sq + params.sq_off.array);
+        ring.cqHead = (unsigned*)(cq + params.cq_off.head);
+        ring.cqTail = (unsigned*)(cq + params.cq_off.tail);
+        ring.cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+        ring.cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    inline void closeRing() {
+        if (ring.sqes != nullptr && ring.sqes != MAP_FAILED) {
+            munmap(ring.sqes, ring.sqesSize);
+        }
+        if (ring.cqSize > 0) {
+            munmap(ring.cqMemory, ring.cqSize);
+        }
+        munmap(ring.sqMemory, ring.sqSize);
+        ::close(ring.fd);
+    }
+
+    // Queue one submission entry (only the ring thread submits)
+    inline void queueEntry(unsigned char opcode, int fd, const void* address, unsigned length,
+                           unsigned long long offset, unsigned long long tag) {
+        unsigned tail = *ring.sqTail;
+        unsigned slot = tail & *ring.sqMask;
+        io_uring_sqe* sqe = &ring.sqes[slot];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = (unsigned long long)(size_t)address;
+        sqe->len = length;
+        sqe->off = offset;
+        sqe->user_data = tag;
+        if (opcode == IORING_OP_OPENAT) {
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        }
+        ring.sqArray[slot] = slot;
+        __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    inline void ringLoop() {
+        int inFlight = 0;          // Opens and reads, not counting the wake read
+        unsigned toSubmit = 0;
+        queueEntry(IORING_OP_READ, wakeFd, &wakeValue, sizeof(wakeValue), 0, OP_WAKE);
+        toSubmit++;
+        std::unique_lock<std::mutex> guard(lock);
+        while (!stopping) {
+            // Start queued requests while there is room in flight
+            while (requestCount > 0 && inFlight < queueDepth) {
+                int index = popRequest();
+                AsyncFile& file = files[index];
+                unsigned long long tag = ((unsigned long long)index << 8);
+                if (file.fd < 0) {
+                    queueEntry(IORING_OP_OPENAT, AT_FDCWD, file.path, 0, 0, tag | OP_OPEN);
+                } else {
+                    prepareSpare(file);
+                    queueEntry(IORING_OP_READ, file.fd, file.spare, (unsigned)chunkSize,
+                               (unsigned long long)file.offset, tag | OP_READ);
+                }
+                inFlight++;
+                toSubmit++;
+            }
+            guard.unlock();
+
+            int entered = ringEnter(ring.fd, toSubmit, 1, IORING_ENTER_GETEVENTS);
+            if (entered >= 0) {
+                toSubmit -= (unsigned)entered;
+            } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                guard.lock();
+                failAll(errno);
+                return;
+            }
+
+            // Reap completions
+            guard.lock();
+            unsigned head = *ring.cqHead;
+            unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+            bool delivered = false;
+            while (head != tail) {
+                io_uring_cqe* cqe = &ring.cqes[head & *ring.cqMask];
+                unsigned long long kind = cqe->user_data & 0xFF;
+                int index = (int)(cqe->user_data >> 8);
+                int result = cqe->res;
+                head++;
+                if (kind == OP_WAKE) {
+                    queueEntry(IORING_OP_READ, wakeFd, &wakeValue, sizeof(wakeValue), 0, OP_WAKE);
+                    toSubmit++;
+                    continue;
+                }
+                inFlight--;
+                AsyncFile& file = files[index];
+                if (kind == OP_OPEN) {
+                    if (result == -EINVAL) {
+                        // Kernel without async open: open synchronously
+                        result = ::open(file.path, O_RDONLY | O_CLOEXEC);
+                        result = result < 0 ? -errno : result;
+                    }
+                    if (result < 0) {
+                        file.error = -result;
+                        file.endOfFile = true;
+                        file.busy = false;
+                        delivered = true;
+                    } else {
+                        file.fd = result;
+                        pushRequest(index, true);   // Read it next
+                    }
+                    continue;
+                }
+                if (completeRead(file, result, chunkSize)) {
+                    pushRequest(index, false);
+                }
+                delivered = true;
+            }
+            __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+            if (delivered) {
+                dataSignal.notify_all();
+            }
+        }
+    }
+
+    // Give up on every unfinished file (caller holds lock)
+    inline void failAll(int error) {
+        for (int i = 0; i < fileCount; i++) {
+            if (!files[i].endOfFile) {
+                files[i].error = error;
+                files[i].endOfFile = true;
+                files[i].busy = false;
+            }
+        }
+        dataSignal.notify_all();
+    }
+
+    // Wake the ring thread after queueing a request
+    inline void wakeRing() {
+        if (backend == ASYNC_IO_URING) {
+            unsigned long long one = 1;
+            ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        } else {
+            requestSignal.notify_one();
+        }
+    }
+
+public:
+    // paths must stay valid while the reader is in use
+    inline AsyncFileReader(const char* const* paths, int count, AsyncIoBackend ioBackend,
+                           size_t bufferSize, int depth = 256, int poolSize = 16) {
+        fileCount = count;
+        files = new AsyncFile[count > 0 ? count : 1];
+        requests = new int[count > 0 ? count : 1];
+        requestHead = 0;
+        requestCount = 0;
+        for (int i = 0; i < count; i++) {
+            memset(&files[i], 0, sizeof(AsyncFile));
+            files[i].path = paths[i];
+            files[i].fd = -1;
+        }
+        chunkSize = bufferSize >= 4096 ? bufferSize : 4096;
+        queueDepth = depth > 0 ? depth : 1;
+        poolThreads = poolSize > 0 ? poolSize : 1;
+        backend = ioBackend;
+        stopping = false;
+        threads = nullptr;
+        threadCount = 0;
+        wakeFd = -1;
+        wakeValue = 0;
+        memset(&ring, 0, sizeof(ring));
+    }
+
+    inline ~AsyncFileReader() {
+        stop();
+        for (int i = 0; i < fileCount; i++) {
+            if (files[i].fd >= 0) {
+                ::close(files[i].fd);
+            }
+            delete[] files[i].ready;
+            delete[] files[i].spare;
+        }
+        delete[] files;
+        delete[] requests;
+    }
+
+    // Start reading every file in order; io_uring falls back to the thread pool
+    inline void start() {
+        for (int i = 0; i < fileCount; i++) {
+            pushRequest(i, false);
+        }
+        if (backend == ASYNC_IO_URING) {
+            unsigned entries = 1;
+            while (entries < (unsigned)queueDepth + 1) {
+                entries <<= 1;
+            }
+            wakeFd = eventfd(0, EFD_CLOEXEC);
+            if (wakeFd < 0 || !openRing(entries)) {
+                if (wakeFd >= 0) {
+                    ::close(wakeFd);
+                    wakeFd = -1;
+                }
+                backend = ASYNC_IO_THREAD_POOL;
+            }
+        }
+        if (backend == ASYNC_IO_URING) {
+            threadCount = 1;
+            threads = new std::thread[1];
+            threads[0] = std::thread(&AsyncFileReader::ringLoop, this);
+        } else {
+            backend = ASYNC_IO_THREAD_POOL;
+            threadCount = poolThreads < fileCount ? poolThreads : (fileCount > 0 ? fileCount : 1);
+            threads = new std::thread[threadCount];
+            for (int t = 0; t < threadCount; t++) {
+                threads[t] = std::thread(&AsyncFileReader::poolLoop, this);
+            }
+        }
+    }
+
+    // Stop the I/O threads (files not fully read stay unread)
+    inline void stop() {
+        if (threads == nullptr) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        requestSignal.notify_all();
+        if (backend == ASYNC_IO_URING) {
+            wakeRing();
+        }
+        for (int t = 0; t < threadCount; t++) {
+            threads[t].join();
+        }
+        delete[] threads;
+        threads = nullptr;
+        if (backend == ASYNC_IO_URING) {
+            closeRing();
+            ::close(wakeFd);
+            wakeFd = -1;
+        }
+    }
+
+    // Copy up to size bytes of a file, waiting for its next chunk if needed
+    // Returns bytes copied, 0 at end of file, -1 on error (errno set).
+    inline ssize_t read(int index, char* into, size_t size) {
+        std::unique_lock<std::mutex> guard(lock);
+        AsyncFile& file = files[index];
+        while (file.readyUsed == file.readyLength) {
+            if (file.spareFull) {
+                swapBuffers(file);
+                break;
+            }
+            if (file.endOfFile) {
+                if (file.error != 0) {
+                    errno = file.error;
+                    return -1;
+                }
+                return 0;
+            }
+            if (!file.busy) {
+                pushRequest(index, true);
+                wakeRing();
+            } else {
+                promoteRequest(index);
+            }
+            dataSignal.wait(guard);
+        }
+        size_t available = file.readyLength - file.readyUsed;
+        size_t copied = available < size ? available : size;
+        memcpy(into, file.ready + file.readyUsed, copied);
+        file.readyUsed += copied;
+        if (file.readyUsed == file.readyLength) {
+            if (file.spareFull) {
+                swapBuffers(file);
+            } else if (file.endOfFile) {
+                delete[] file.ready;    // Fully consumed
+                file.ready = nullptr;
+                file.readyLength = 0;
+                file.readyUsed = 0;
+            }
+        }
+        // Keep the next chunk in flight while this one is consumed
+        if (!file.endOfFile && !file.busy && !file.spareFull) {
+            pushRequest(index, false);
+            wakeRing();
+        }
+        return (ssize_t)copied;
+    }
+
+    // errno of a failed open or read of a file (0 if none)
+    inline int getError(int index) {
+        std::lock_guard<std::mutex> guard(lock);
+        return files[index].error;
+    }
+
+    // Backend in use after start() (io_uring may have fallen back)
+    inline AsyncIoBackend getBackend() const {
+        return backend;
+    }
+
+    inline static const char* backendName(AsyncIoBackend backend) {
+        switch (backend) {
+            case ASYNC_IO_URING:       return "io_uring";
+            case ASYNC_IO_THREAD_POOL: return "thread pool";
+            default:                   return "blocking";
+        }
+    }
+
+private:
+    // Copying is not supported
+    AsyncFileReader(const AsyncFileReader&);
+    AsyncFileReader& operator=(const AsyncFileReader&);
+};
+
+#endif // ASYNC_READER_H
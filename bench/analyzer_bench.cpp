@@ -0,0 +1,715 @@
+// Benchmark suite for the core data structures and LogAnalyzer
+// Micro-benchmarks: HashTable insert and lookup, StringPool interning,
+// substring search kernels (KMP against strstr, memmem, Horspool and a naive
+// loop) and entry allocation (column store rows against one heap node per
+// entry). Macro-benchmarks: ingesting N lines through addLog(), keyword
+// queries and ERROR analysis over the ingested data.
+//
+// Each benchmark runs its operations in batches and reports throughput,
+// per-operation latency percentiles (batch time / batch size, so micro
+// latencies exclude clock overhead) and heap allocations per operation,
+// counted by replacing the global operator new and delete. With --output,
+// results are also written as one JSON object per line for regression
+// tracking (compare two files benchmark by benchmark).
+// Compile with: g++ -O2 -std=c++11 -pthread -I.. -o analyzer_bench analyzer_bench.cpp ../core.cpp
+// Usage: ./analyzer_bench [--lines N] [--filter TEXT] [--output FILE]
+// (or `make bench` from the top directory)
+
+#include "core.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <new>
+
+// Heap allocation counters (operator new[] and delete[] forward to these)
+// The replacements are kept out of line so the compiler never pairs an
+// inlined free() with a call to operator new.
+static std::atomic<long long> allocationCount(0);
+static std::atomic<long long> allocationBytes(0);
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add((long long)size, std::memory_order_relaxed);
+    void* block = malloc(size > 0 ? size : 1);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+__attribute__((noinline)) void operator delete(void* block) noexcept {
+    free(block);
+}
+
+__attribute__((noinline)) void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+
+// Discards output of report functions (analyzeErrorFrequency)
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) {
+        return c;
+    }
+    std::streamsize xsputn(const char*, std::streamsize count) {
+        return count;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Workload
+
+static const char* LEVELS[4] = { "INFO", "WARNING", "ERROR", "DEBUG" };
+static const char* ERRORS[8] = {
+    "Failed to connect to database %d",
+    "Request timeout after %d ms",
+    "File not found: /var/data/file-%d.dat",
+    "Payment gateway returned status %d",
+    "Null reference in handler %d",
+    "Disk quota exceeded on volume %d",
+    "Authentication failed for user %d",
+    "Cache node %d unreachable"
+};
+static const char* MESSAGES[6] = {
+    "User %d logged in from 10.0.%d.1",
+    "Processing request ID %d for tenant %d",
+    "Cache hit ratio %d%% on shard %d",
+    "Scheduled job %d finished in %d ms",
+    "Connection pool size %d, idle %d",
+    "Served GET /api/items/%d in %d ms"
+};
+
+struct Workload {
+    int lines;
+    char** timestamps;
+    const char** levels;
+    char** messages;
+    long long textBytes;       // Sum of message lengths
+    unsigned int* hashIds;     // Keys for the hash benchmarks
+    char** hashKeys;
+    int hashDistinct;
+};
+
+static char* copyText(const char* text) {
+    char* copy = new char[strlen(text) + 1];
+    strcpy(copy, text);
+    return copy;
+}
+
+static unsigned int nextRandom(unsigned long long& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned int)(state >> 33);
+}
+
+static void buildWorkload(int lines, Workload& w) {
+    w.lines = lines;
+    w.timestamps = new char*[lines];
+    w.levels = new const char*[lines];
+    w.messages = new char*[lines];
+    w.textBytes = 0;
+    unsigned long long state = 42;
+    char buffer[256];
+    for (int i = 0; i < lines; i++) {
+        long long epoch = 1705305600LL + i / 4;
+        formatTimestamp(epoch, buffer);
+        w.timestamps[i] = copyText(buffer);
+        unsigned int r = nextRandom(state);
+        w.levels[i] = LEVELS[r % 10 < 6 ? 0 : (r % 10 < 8 ? 1 : (r % 10 < 9 ? 2 : 3))];
+        if (w.levels[i] == LEVELS[2]) {
+            // Skewed error mix: low template indices and values dominate
+            unsigned int pick = nextRandom(state) % 64;
+            int errorIndex = pick < 32 ? 0 : (pick < 48 ? 1 : (int)(2 + pick % 6));
+            snprintf(buffer, sizeof(buffer), ERRORS[errorIndex], (int)(nextRandom(state) % 20));
+        } else {
+            snprintf(buffer, sizeof(buffer), MESSAGES[r % 6], (int)(nextRandom(state) % 100000),
+                     (int)(nextRandom(state) % 1000));
+        }
+        w.messages[i] = copyText(buffer);
+        w.textBytes += (long long)strlen(buffer);
+    }
+    w.hashDistinct = lines / 20 > 16 ? lines / 20 : 16;
+    w.hashIds = new unsigned int[lines];
+    w.hashKeys = new char*[w.hashDistinct];
+    for (int i = 0; i < w.hashDistinct; i++) {
+        snprintf(buffer, sizeof(buffer), "error message %d", i);
+        w.hashKeys[i] = copyText(buffer);
+    }
+    for (int i = 0; i < lines; i++) {
+        unsigned int a = nextRandom(state) % (unsigned int)w.hashDistinct;
+        unsigned int b = nextRandom(state) % (unsigned int)w.hashDistinct;
+        w.hashIds[i] = a < b ? a : b;    // Skewed towards small IDs
+    }
+}
+
+static void freeWorkload(Workload& w) {
+    for (int i = 0; i < w.lines; i++) {
+        delete[] w.timestamps[i];
+        delete[] w.messages[i];
+    }
+    for (int i = 0; i < w.hashDistinct; i++) {
+        delete[] w.hashKeys[i];
+    }
+    delete[] w.timestamps;
+    delete[] w.levels;
+    delete[] w.messages;
+    delete[] w.hashIds;
+    delete[] w.hashKeys;
+}
+
+// ---------------------------------------------------------------------------
+// Runner
+
+// Run operations [first, first + count) of a benchmark
+typedef void (*BenchBatch)(void* context, long long first, int count);
+
+struct BenchResult {
+    const char* name;
+    const char* kind;
+    long long ops;
+    double seconds;
+    double bytesPerOp;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    double allocsPerOp;
+    double allocBytesPerOp;
+};
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static double percentile(const double* sorted, int count, double p) {
+    int index = (int)(p * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+static void runBench(const char* name, const char* kind, BenchBatch batchFn, void* context,
+                     long long ops, int batch, double bytesPerOp, BenchResult& result) {
+    int batches = (int)((ops + batch - 1) / batch);
+    double* latencies = new double[batches];
+    long long allocsBefore = allocationCount.load();
+    long long bytesBefore = allocationBytes.load();
+    double total = 0.0;
+    for (int b = 0; b < batches; b++) {
+        long long first = (long long)b * batch;
+        int count = (int)(ops - first < batch ? ops - first : batch);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        batchFn(context, first, count);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        total += ns;
+        latencies[b] = ns / count;
+    }
+    long long allocs = allocationCount.load() - allocsBefore;
+    long long bytes = allocationBytes.load() - bytesBefore;
+    qsort(latencies, (size_t)batches, sizeof(double), compareDoubles);
+
+    result.name = name;
+    result.kind = kind;
+    result.ops = ops;
+    result.seconds = total / 1e9;
+    result.bytesPerOp = bytesPerOp;
+    result.p50 = percentile(latencies, batches, 0.50);
+    result.p90 = percentile(latencies, batches, 0.90);
+    result.p99 = percentile(latencies, batches, 0.99);
+    result.max = latencies[batches - 1];
+    result.allocsPerOp = (double)allocs / (double)ops;
+    result.allocBytesPerOp = (double)bytes / (double)ops;
+    delete[] latencies;
+}
+
+static void printResult(const BenchResult& r) {
+    double opsPerSecond = r.seconds > 0.0 ? r.ops / r.seconds : 0.0;
+    char throughput[32];
+    if (r.bytesPerOp > 0.0) {
+        snprintf(throughput, sizeof(throughput), "%9.1f", opsPerSecond * r.bytesPerOp / 1e6);
+    } else {
+        snprintf(throughput, sizeof(throughput), "%9s", "-");
+    }
+    printf("%-24s %-5s %9lld %12.0f %s %9.0f %9.0f %9.0f %10.0f %9.2f %10.1f\n", r.name, r.kind, r.ops,
+           opsPerSecond, throughput, r.p50, r.p90, r.p99, r.max, r.allocsPerOp, r.allocBytesPerOp);
+}
+
+static void writeResult(FILE* out, const BenchResult& r, int lines) {
+    double opsPerSecond = r.seconds > 0.0 ? r.ops / r.seconds : 0.0;
+    fprintf(out,
+            "{\"benchmark\":\"%s\",\"kind\":\"%s\",\"lines\":%d,\"ops\":%lld,\"seconds\":%.6f,"
+            "\"ops_per_sec\":%.1f,\"mb_per_sec\":%.2f,\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,"
+            "\"max_ns\":%.1f,\"allocs_per_op\":%.4f,\"alloc_bytes_per_op\":%.2f}\n",
+            r.name, r.kind, lines, r.ops, r.seconds, opsPerSecond, opsPerSecond * r.bytesPerOp / 1e6, r.p50, r.p90,
+            r.p99, r.max, r.allocsPerOp, r.allocBytesPerOp);
+}
+
+// ---------------------------------------------------------------------------
+// Micro-benchmarks
+
+struct HashContext {
+    Workload* w;
+    HashTable* table;
+    long long checksum;
+};
+
+static void hashInsertBatch(void* context, long long first, int count) {
+    HashContext* c = (HashContext*)context;
+    for (long long i = first; i < first + count; i++) {
+        unsigned int id = c->w->hashIds[i % c->w->lines];
+        c->table->insert(id, c->w->hashKeys[id]);
+    }
+}
+
+static void hashLookupBatch(void* context, long long first, int count) {
+    HashContext* c = (HashContext*)context;
+    for (long long i = first; i < first + count; i++) {
+        c->checksum += c->table->getCount(c->w->hashIds[(i * 7) % c->w->lines]);
+    }
+}
+
+struct PoolContext {
+    Workload* w;
+    StringPool* pool;
+    long long checksum;
+};
+
+static void internBatch(void* context, long long first, int count) {
+    PoolContext* c = (PoolContext*)context;
+    for (long long i = first; i < first + count; i++) {
+        c->checksum += c->pool->intern(c->w->messages[i]);
+    }
+}
+
+// Substring search kernels: count occurrences of pattern in text
+static const char* SEARCH_PATTERN = "timeout";
+
+static int countStrstr(const char* text, const char* pattern, size_t patternLength) {
+    int count = 0;
+    const char* p = text;
+    while ((p = strstr(p, pattern)) != nullptr) {
+        count++;
+        p += patternLength;
+    }
+    return count;
+}
+
+static int countMemmem(const char* text, size_t length, const char* pattern, size_t patternLength) {
+    int count = 0;
+    const char* p = text;
+    const char* end = text + length;
+    while (p < end) {
+        const char* found = (const char*)memmem(p, (size_t)(end - p), pattern, patternLength);
+        if (found == nullptr) {
+            break;
+        }
+        count++;
+        p = found + patternLength;
+    }
+    return count;
+}
+
+static int countNaive(const char* text, size_t length, const char* pattern, size_t patternLength) {
+    int count = 0;
+    for (size_t i = 0; i + patternLength <= length; i++) {
+        size_t j = 0;
+        while (j < patternLength && text[i + j] == pattern[j]) {
+            j++;
+        }
+        if (j == patternLength) {
+            count++;
+            i += patternLength - 1;
+        }
+    }
+    return count;
+}
+
+// Boyer-Moore-Horspool with a precomputed shift table
+struct Horspool {
+    size_t shift[256];
+    const char* pattern;
+    size_t length;
+};
+
+static void buildHorspool(Horspool& h, const char* pattern) {
+    h.pattern = pattern;
+    h.length = strlen(pattern);
+    for (int c = 0; c < 256; c++) {
+        h.shift[c] = h.length;
+    }
+    for (size_t i = 0; i + 1 < h.length; i++) {
+        h.shift[(unsigned char)pattern[i]] = h.length - 1 - i;
+    }
+}
+
+static int countHorspool(const Horspool& h, const char* text, size_t length) {
+    int count = 0;
+    size_t i = 0;
+    while (i + h.length <= length) {
+        unsigned char last = (unsigned char)text[i + h.length - 1];
+        if (last == (unsigned char)h.pattern[h.length - 1] && memcmp(text + i, h.pattern, h.length - 1) == 0) {
+            count++;
+            i += h.length;
+        } else {
+            i += h.shift[last];
+        }
+    }
+    return count;
+}
+
+enum SearchKernel { SEARCH_KMP, SEARCH_KMP_NOCASE, SEARCH_STRSTR, SEARCH_MEMMEM, SEARCH_HORSPOOL, SEARCH_NAIVE };
+
+struct SearchContext {
+    Workload* w;
+    size_t* lengths;
+    KMP kmp;
+    Horspool horspool;
+    SearchKernel kernel;
+    long long matches;
+};
+
+static void searchBatch(void* context, long long first, int count) {
+    SearchContext* c = (SearchContext*)context;
+    size_t patternLength = strlen(SEARCH_PATTERN);
+    for (long long i = first; i < first + count; i++) {
+        const char* text = c->w->messages[i];
+        switch (c->kernel) {
+            case SEARCH_KMP:
+                c->matches += c->kmp.search(text, SEARCH_PATTERN);
+                break;
+            case SEARCH_KMP_NOCASE:
+                c->matches += c->kmp.searchCaseInsensitive(text, SEARCH_PATTERN);
+                break;
+            case SEARCH_STRSTR:
+                c->matches += countStrstr(text, SEARCH_PATTERN, patternLength);
+                break;
+            case SEARCH_MEMMEM:
+                c->matches += countMemmem(text, c->lengths[i], SEARCH_PATTERN, patternLength);
+                break;
+            case SEARCH_HORSPOOL:
+                c->matches += countHorspool(c->horspool, text, c->lengths[i]);
+                break;
+            case SEARCH_NAIVE:
+                c->matches += countNaive(text, c->lengths[i], SEARCH_PATTERN, patternLength);
+                break;
+        }
+    }
+}
+
+// Entry allocation: column store rows against one heap node per entry
+struct HeapEntry {
+    char* timestamp;
+    char* level;
+    char* message;
+    HeapEntry* next;
+};
+
+struct AllocContext {
+    Workload* w;
+    LogList* list;
+    unsigned int* ids;         // Pre-interned message IDs
+    HeapEntry* head;
+};
+
+static void columnAppendBatch(void* context, long long first, int count) {
+    AllocContext* c = (AllocContext*)context;
+    for (long long i = first; i < first + count; i++) {
+        unsigned int id = c->ids[i];
+        c->list->addEntry(id, 1705305600LL + i, id, id, id);
+    }
+}
+
+static void heapAppendBatch(void* context, long long first, int count) {
+    AllocContext* c = (AllocContext*)context;
+    for (long long i = first; i < first + count; i++) {
+        HeapEntry* entry = new HeapEntry;
+        entry->timestamp = copyText(c->w->timestamps[i]);
+        entry->level = copyText(c->w->levels[i]);
+        entry->message = copyText(c->w->messages[i]);
+        entry->next = c->head;
+        c->head = entry;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Macro-benchmarks
+
+struct AnalyzerContext {
+    Workload* w;
+    LogAnalyzer* analyzer;
+    long long checksum;
+};
+
+static void ingestBatch(void* context, long long first, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    for (long long i = first; i < first + count; i++) {
+        c->analyzer->addLog(c->w->timestamps[i], c->w->levels[i], c->w->messages[i]);
+    }
+}
+
+static void keywordBatch(void* context, long long, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    for (int i = 0; i < count; i++) {
+        c->checksum += c->analyzer->searchKeyword(SEARCH_PATTERN, true);
+    }
+}
+
+static void keywordNoCaseBatch(void* context, long long, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    for (int i = 0; i < count; i++) {
+        c->checksum += c->analyzer->searchKeyword("TIMEOUT", false);
+    }
+}
+
+// A longer keyword each time, filtered from the cached "timeout" rows
+static void narrowedBatch(void* context, long long first, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    char keyword[32];
+    for (int i = 0; i < count; i++) {
+        snprintf(keyword, sizeof(keyword), "%s%c", SEARCH_PATTERN, (char)(' ' + (first + i) % 95));
+        c->checksum += c->analyzer->searchKeyword(keyword, true);
+    }
+}
+
+// Newest 50 matches through a search cursor (stops once the page is full)
+static void firstPageBatch(void* context, long long, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    int rows[50];
+    for (int i = 0; i < count; i++) {
+        SearchCursor cursor;
+        c->analyzer->openSearchCursor(SEARCH_PATTERN, true, true, cursor);
+        c->checksum += c->analyzer->nextSearchPage(cursor, rows, 50);
+    }
+}
+
+// Sampled keyword count over `percent` of the logs (fixed seeds, so every
+// run samples the same units)
+static void approximateBatch(AnalyzerContext* c, long long first, int count, int percent) {
+    ApproxEstimate estimate;
+    for (int i = 0; i < count; i++) {
+        ApproximateSearch search;
+        c->analyzer->startApproximateSearch(SEARCH_PATTERN, true, search, (unsigned long long)(first + i));
+        c->analyzer->refineApproximateSearch(search, 0, estimate);
+        int units = estimate.totalUnits * percent / 100;
+        c->analyzer->refineApproximateSearch(search, units > 2 ? units : 2, estimate);
+        c->checksum += (long long)estimate.logs;
+    }
+}
+
+static void approximate1Batch(void* context, long long first, int count) {
+    approximateBatch((AnalyzerContext*)context, first, count, 1);
+}
+
+static void approximate10Batch(void* context, long long first, int count) {
+    approximateBatch((AnalyzerContext*)context, first, count, 10);
+}
+
+static void topErrorsExactBatch(void* context, long long, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    TopKEntry top[10];
+    for (int i = 0; i < count; i++) {
+        c->checksum += c->analyzer->topErrors(10, true, top);
+    }
+}
+
+static void topErrorsApproxBatch(void* context, long long, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    TopKEntry top[10];
+    for (int i = 0; i < count; i++) {
+        c->checksum += c->analyzer->topErrors(10, false, top);
+    }
+}
+
+static void errorReportBatch(void* context, long long, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    NullBuffer sink;
+    std::streambuf* saved = std::cout.rdbuf(&sink);
+    for (int i = 0; i < count; i++) {
+        c->analyzer->analyzeErrorFrequency(true);
+    }
+    std::cout.rdbuf(saved);
+}
+
+static void groupByLevelBatch(void* context, long long, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    GroupByQuery query;
+    query.first = GROUP_LEVEL;
+    query.second = GROUP_HOUR;
+    GroupByResult result;
+    for (int i = 0; i < count; i++) {
+        c->analyzer->groupBy(query, result);
+        c->checksum += result.getCount();
+    }
+}
+
+static void savedSearchPollBatch(void* context, long long, int count) {
+    AnalyzerContext* c = (AnalyzerContext*)context;
+    SavedSearchStatus status;
+    for (int i = 0; i < count; i++) {
+        c->analyzer->getSavedSearch(0, status);
+        c->checksum += status.occurrences;
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    int lines = 200000;
+    const char* filter = nullptr;
+    const char* outputPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            lines = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--lines N] [--filter TEXT] [--output FILE]\n";
+            return 1;
+        }
+    }
+    if (lines < 1000) {
+        lines = 1000;
+    }
+    FILE* output = nullptr;
+    if (outputPath != nullptr) {
+        output = fopen(outputPath, "w");
+        if (output == nullptr) {
+            std::cerr << "Cannot write " << outputPath << "\n";
+            return 1;
+        }
+    }
+
+    Workload w;
+    buildWorkload(lines, w);
+    double averageMessage = (double)w.textBytes / lines;
+    std::cout << "Workload: " << lines << " lines, " << averageMessage << " bytes per message, "
+              << w.hashDistinct << " distinct hash keys\n";
+    printf("%-24s %-5s %9s %12s %9s %9s %9s %9s %10s %9s %10s\n", "benchmark", "kind", "ops", "ops/s", "MB/s",
+           "p50 ns", "p90 ns", "p99 ns", "max ns", "allocs/op", "bytes/op");
+
+    BenchResult result;
+#define RUN_BENCH(NAME, KIND, FN, CONTEXT, OPS, BATCH, BYTES)                          \
+    if (filter == nullptr || strstr(NAME, filter) != nullptr) {                        \
+        runBench(NAME, KIND, FN, CONTEXT, OPS, BATCH, BYTES, result);                  \
+        printResult(result);                                                           \
+        if (output != nullptr) {                                                       \
+            writeResult(output, result, lines);                                        \
+        }                                                                              \
+    }
+
+    // Hash table
+    {
+        HashTable table;
+        HashContext c = { &w, &table, 0 };
+        RUN_BENCH("hash_insert", "micro", hashInsertBatch, &c, lines, 1000, 0.0);
+        if (table.getTotalEntries() == 0) {
+            hashInsertBatch(&c, 0, lines);
+        }
+        RUN_BENCH("hash_lookup", "micro", hashLookupBatch, &c, lines, 1000, 0.0);
+    }
+
+    // String interning (mostly repeated messages after the first pass)
+    {
+        StringPool pool;
+        PoolContext c = { &w, &pool, 0 };
+        RUN_BENCH("string_pool_intern", "micro", internBatch, &c, lines, 1000, averageMessage);
+    }
+
+    // Search kernels over every message
+    {
+        SearchContext c;
+        c.w = &w;
+        c.lengths = new size_t[lines];
+        for (int i = 0; i < lines; i++) {
+            c.lengths[i] = strlen(w.messages[i]);
+        }
+        buildHorspool(c.horspool, SEARCH_PATTERN);
+        const char* names[6] = { "search_kmp", "search_kmp_nocase", "search_strstr",
+                                 "search_memmem", "search_horspool", "search_naive" };
+        for (int k = 0; k < 6; k++) {
+            c.kernel = (SearchKernel)k;
+            c.matches = 0;
+            RUN_BENCH(names[k], "micro", searchBatch, &c, lines, 1000, averageMessage);
+        }
+        delete[] c.lengths;
+    }
+
+    // Entry allocation
+    {
+        StringPool pool;
+        AllocContext c;
+        c.w = &w;
+        c.ids = new unsigned int[lines];
+        for (int i = 0; i < lines; i++) {
+            c.ids[i] = pool.intern(w.messages[i]);
+        }
+        c.list = new LogList(pool);
+        c.head = nullptr;
+        RUN_BENCH("entry_alloc_columns", "micro", columnAppendBatch, &c, lines, 1000, 0.0);
+        RUN_BENCH("entry_alloc_heap_node", "micro", heapAppendBatch, &c, lines, 1000, 0.0);
+        while (c.head != nullptr) {
+            HeapEntry* next = c.head->next;
+            delete[] c.head->timestamp;
+            delete[] c.head->level;
+            delete[] c.head->message;
+            delete c.head;
+            c.head = next;
+        }
+        delete c.list;
+        delete[] c.ids;
+    }
+
+    // Analyzer: ingest, then query the ingested data
+    {
+        LogAnalyzer* analyzer = new LogAnalyzer();
+        AnalyzerContext c = { &w, analyzer, 0 };
+        RUN_BENCH("ingest_addlog", "macro", ingestBatch, &c, lines, 1000, averageMessage);
+        if (analyzer->getTotalLogs() == 0) {
+            ingestBatch(&c, 0, lines);
+        }
+        double scanned = (double)w.textBytes;
+        analyzer->setQueryCacheEnabled(false);
+        RUN_BENCH("query_keyword", "macro", keywordBatch, &c, 10, 1, scanned);
+        RUN_BENCH("query_keyword_nocase", "macro", keywordNoCaseBatch, &c, 10, 1, scanned);
+        RUN_BENCH("query_keyword_first_page", "macro", firstPageBatch, &c, 1000, 1, 0.0);
+        RUN_BENCH("query_approx_1pct", "macro", approximate1Batch, &c, 200, 1, scanned / 100);
+        RUN_BENCH("query_approx_10pct", "macro", approximate10Batch, &c, 50, 1, scanned / 10);
+        analyzer->setQueryCacheEnabled(true);
+        keywordBatch(&c, 0, 1);
+        RUN_BENCH("query_keyword_cached", "macro", keywordBatch, &c, 1000, 1, 0.0);
+        RUN_BENCH("query_keyword_narrowed", "macro", narrowedBatch, &c, 100, 1, 0.0);
+        RUN_BENCH("error_topk_exact", "macro", topErrorsExactBatch, &c, 200, 1, 0.0);
+        RUN_BENCH("error_topk_approx", "macro", topErrorsApproxBatch, &c, 200, 1, 0.0);
+        RUN_BENCH("error_analysis_report", "macro", errorReportBatch, &c, 20, 1, 0.0);
+        RUN_BENCH("error_groupby_level_hour", "macro", groupByLevelBatch, &c, 20, 1, 0.0);
+        delete analyzer;
+    }
+
+    // Saved searches: matching cost added to ingest, then polling the result
+    {
+        LogAnalyzer* analyzer = new LogAnalyzer();
+        analyzer->addSavedSearch(SEARCH_PATTERN, true);
+        analyzer->addSavedSearch("TIMEOUT", false);
+        analyzer->addSavedSearch("connection", true);
+        analyzer->addSavedSearch("disk", false);
+        AnalyzerContext c = { &w, analyzer, 0 };
+        RUN_BENCH("ingest_addlog_4_saved", "macro", ingestBatch, &c, lines, 1000, averageMessage);
+        if (analyzer->getTotalLogs() == 0) {
+            ingestBatch(&c, 0, lines);
+        }
+        RUN_BENCH("query_saved_search_poll", "macro", savedSearchPollBatch, &c, 100000, 1000, 0.0);
+        delete analyzer;
+    }
+#undef RUN_BENCH
+
+    if (output != nullptr) {
+        fclose(output);
+        std::cout << "Results written to " << outputPath << "\n";
+    }
+    freeWorkload(w);
+    return 0;
+}
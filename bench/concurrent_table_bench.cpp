@@ -0,0 +1,264 @@
+// Contention benchmark for the ERROR frequency table and the ingest path
+// Compares one HashTable behind a single mutex, per-thread HashTables merged
+// at the end, and the lock-striped ShardedCountTable on a Zipf-distributed
+// error workload at 1, 8 and 32 threads. Then runs generated entries through
+// TemplateMiner::addMessage() (sharded, and behind one outer mutex as the
+// miner-wide lock used to be) and through LogAnalyzer::addLog() from the
+// same thread counts.
+// Compile with: g++ -O2 -std=c++11 -pthread -I.. -o concurrent_table_bench concurrent_table_bench.cpp ../core.cpp
+
+#include "concurrent_table.h"
+#include "core.h"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <mutex>
+
+static const int KEY_COUNT = 100000;          // Distinct error messages
+static const double ZIPF_EXPONENT = 1.1;      // Skew of the error distribution
+static const long long OPS_PER_RUN = 8000000; // Increments per run, split across threads
+static const int INGEST_ENTRIES = 400000;      // Generated entries per ingest run
+
+// Cumulative Zipf distribution over key ranks (rank 0 is the most frequent)
+static double* buildZipfCdf(int n, double exponent) {
+    double* cdf = new double[n];
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        total += 1.0 / std::pow(i + 1.0, exponent);
+        cdf[i] = total;
+    }
+    for (int i = 0; i < n; i++) {
+        cdf[i] /= total;
+    }
+    return cdf;
+}
+
+// xorshift64* generator, one per thread
+struct Rng {
+    unsigned long long state;
+    inline double next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (double)((state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// Pre-draw each thread's key sequence so the timed loop measures only the table
+static unsigned int* drawKeys(const double* cdf, long long count, unsigned long long seed) {
+    unsigned int* keys = new unsigned int[count];
+    Rng rng = { seed * 0x9E3779B97F4A7C15ULL + 1 };
+    for (long long i = 0; i < count; i++) {
+        double u = rng.next();
+        int lo = 0;
+        int hi = KEY_COUNT - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (cdf[mid] < u) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        keys[i] = (unsigned int)lo;
+    }
+    return keys;
+}
+
+enum Mode { SINGLE_MUTEX, PER_THREAD_MERGE, SHARDED };
+
+static const char* modeName(Mode mode) {
+    return mode == SINGLE_MUTEX ? "single-mutex" : (mode == PER_THREAD_MERGE ? "per-thread+merge" : "sharded");
+}
+
+// Run one configuration; returns million increments per second
+static double runBenchmark(Mode mode, int threads, unsigned int** keys, long long perThread) {
+    HashTable shared;
+    std::mutex sharedLock;
+    ShardedCountTable sharded;
+    HashTable** local = new HashTable*[threads];
+    for (int t = 0; t < threads; t++) {
+        local[t] = new HashTable();
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread* workers = new std::thread[threads];
+    for (int t = 0; t < threads; t++) {
+        workers[t] = std::thread([&, t]() {
+            const unsigned int* mine = keys[t];
+            for (long long i = 0; i < perThread; i++) {
+                if (mode == SINGLE_MUTEX) {
+                    std::lock_guard<std::mutex> guard(sharedLock);
+                    shared.insert(mine[i], "error");
+                } else if (mode == PER_THREAD_MERGE) {
+                    local[t]->insert(mine[i], "error");
+                } else {
+                    sharded.insert(mine[i], "error");
+                }
+            }
+        });
+    }
+    for (int t = 0; t < threads; t++) {
+        workers[t].join();
+    }
+    if (mode == PER_THREAD_MERGE) {
+        // The merge is part of the cost of this approach
+        for (int t = 0; t < threads; t++) {
+            const HashNode** all = new const HashNode*[local[t]->getTotalEntries()];
+            int found = local[t]->topK(local[t]->getTotalEntries(), all);
+            for (int i = 0; i < found; i++) {
+                shared.insert(all[i]->id, all[i]->key, all[i]->count);
+            }
+            delete[] all;
+        }
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    delete[] workers;
+    for (int t = 0; t < threads; t++) {
+        delete local[t];
+    }
+    delete[] local;
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return (double)perThread * threads / seconds / 1e6;
+}
+
+// Generated entries, copied out of the generator
+struct IngestWorkload {
+    char** timestamps;
+    char** levels;
+    char** messages;
+    unsigned int* messageIds;   // Interned in `pool` for the miner runs
+    StringPool* pool;
+};
+
+static char* copyText(const char* text) {
+    size_t length = strlen(text);
+    char* copy = new char[length + 1];
+    memcpy(copy, text, length + 1);
+    return copy;
+}
+
+static void buildIngestWorkload(IngestWorkload& w) {
+    GeneratorConfig config;
+    config.entries = INGEST_ENTRIES;
+    LogGenerator generator(config);
+    GeneratedEntry entry;
+    w.timestamps = new char*[INGEST_ENTRIES];
+    w.levels = new char*[INGEST_ENTRIES];
+    w.messages = new char*[INGEST_ENTRIES];
+    w.messageIds = new unsigned int[INGEST_ENTRIES];
+    w.pool = new StringPool();
+    for (int i = 0; i < INGEST_ENTRIES; i++) {
+        if (!generator.next(entry)) {
+            std::cerr << "Generator stopped early\n";
+            exit(1);
+        }
+        w.timestamps[i] = copyText(entry.timestamp);
+        w.levels[i] = copyText(entry.level);
+        w.messages[i] = copyText(entry.message);
+        w.messageIds[i] = w.pool->intern(w.messages[i]);
+    }
+}
+
+enum IngestMode { MINER_SINGLE_MUTEX, MINER_SHARDED, ADD_LOG };
+
+static const char* ingestModeName(IngestMode mode) {
+    return mode == MINER_SINGLE_MUTEX ? "miner, one mutex" : (mode == MINER_SHARDED ? "miner, sharded" : "addLog");
+}
+
+// Each thread feeds a contiguous slice; returns million entries per second
+static double runIngest(IngestMode mode, int threads, const IngestWorkload& w) {
+    TemplateMiner miner;
+    std::mutex minerLock;
+    LogAnalyzer* analyzer = mode == ADD_LOG ? new LogAnalyzer() : nullptr;
+    int perThread = INGEST_ENTRIES / threads;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread* workers = new std::thread[threads];
+    for (int t = 0; t < threads; t++) {
+        workers[t] = std::thread([&, t]() {
+            for (int i = t * perThread; i < (t + 1) * perThread; i++) {
+                if (mode == MINER_SINGLE_MUTEX) {
+                    std::lock_guard<std::mutex> guard(minerLock);
+                    miner.addMessage(w.messageIds[i], w.messages[i]);
+                } else if (mode == MINER_SHARDED) {
+                    miner.addMessage(w.messageIds[i], w.messages[i]);
+                } else {
+                    analyzer->addLog(w.timestamps[i], w.levels[i], w.messages[i]);
+                }
+            }
+        });
+    }
+    for (int t = 0; t < threads; t++) {
+        workers[t].join();
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    delete[] workers;
+    delete analyzer;
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return (double)perThread * threads / seconds / 1e6;
+}
+
+int main() {
+    const int threadCounts[] = { 1, 8, 32 };
+    double* cdf = buildZipfCdf(KEY_COUNT, ZIPF_EXPONENT);
+
+    std::cout << "Zipf(" << ZIPF_EXPONENT << ") over " << KEY_COUNT << " keys, "
+              << OPS_PER_RUN << " increments per run, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << "threads  mode               Mops/s\n";
+
+    for (int c = 0; c < 3; c++) {
+        int threads = threadCounts[c];
+        long long perThread = OPS_PER_RUN / threads;
+        unsigned int** keys = new unsigned int*[threads];
+        for (int t = 0; t < threads; t++) {
+            keys[t] = drawKeys(cdf, perThread, t + 1);
+        }
+        for (int m = 0; m < 3; m++) {
+            Mode mode = (Mode)m;
+            double mops = runBenchmark(mode, threads, keys, perThread);
+            std::cout.width(7);
+            std::cout << threads << "  ";
+            std::cout.width(17);
+            std::cout << std::left << modeName(mode) << std::right << "  " << mops << "\n";
+        }
+        for (int t = 0; t < threads; t++) {
+            delete[] keys[t];
+        }
+        delete[] keys;
+    }
+
+    delete[] cdf;
+
+    IngestWorkload workload;
+    buildIngestWorkload(workload);
+    std::cout << "\n" << INGEST_ENTRIES << " generated entries per run\n";
+    std::cout << "threads  mode               Mentries/s\n";
+    for (int c = 0; c < 3; c++) {
+        for (int m = 0; m < 3; m++) {
+            IngestMode mode = (IngestMode)m;
+            double rate = runIngest(mode, threadCounts[c], workload);
+            std::cout.width(7);
+            std::cout << threadCounts[c] << "  ";
+            std::cout.width(17);
+            std::cout << std::left << ingestModeName(mode) << std::right << "  " << rate << "\n";
+        }
+    }
+    for (int i = 0; i < INGEST_ENTRIES; i++) {
+        delete[] workload.timestamps[i];
+        delete[] workload.levels[i];
+        delete[] workload.messages[i];
+    }
+    delete[] workload.timestamps;
+    delete[] workload.levels;
+    delete[] workload.messages;
+    delete[] workload.messageIds;
+    delete workload.pool;
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Synthetic log generator
+// Writes seeded, reproducible logs (see log_generator.h) to a file or
+// standard output. Chunks are generated on worker threads and written in
+// order, so the output is byte-identical for any --threads value.
+// Compile with: g++ -O2 -std=c++11 -pthread -I.. -o log_gen log_gen.cpp
+// Usage: ./log_gen [--entries N | --size BYTES[K|M|G]] [--seed S] [--threads T]
+//                  [--rate R] [--errors SHARE] [--zipf S] [--traces SHARE]
+//                  [--depth N] [--output FILE]
+
+#include "log_generator.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const int MAX_THREADS = 64;
+
+// Chunks handed out to workers and written back in order
+struct Shared {
+    const GeneratorConfig* config;
+    int fd;
+    long long chunks;
+    long long nextChunk;       // Next chunk to generate
+    long long nextWrite;       // Next chunk to write
+    long long bytes;
+    bool failed;
+    std::mutex lock;
+    std::condition_variable turn;
+};
+
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            return false;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+// Generate one chunk into a growing buffer
+static size_t generateChunk(const GeneratorConfig& config, long long index, char*& buffer, size_t& capacity) {
+    LogGenerator generator(config, index, 1);
+    size_t size = 0;
+    while (!generator.done()) {
+        if (capacity - size < LogGenerator::MAX_ENTRY_BYTES * 4) {
+            capacity *= 2;
+            char* grown = new char[capacity];
+            memcpy(grown, buffer, size);
+            delete[] buffer;
+            buffer = grown;
+        }
+        size += generator.fill(buffer + size, capacity - size);
+    }
+    return size;
+}
+
+static void worker(Shared* shared) {
+    size_t capacity = (size_t)8 << 20;
+    char* buffer = new char[capacity];
+    while (true) {
+        long long index;
+        {
+            std::lock_guard<std::mutex> guard(shared->lock);
+            if (shared->nextChunk >= shared->chunks || shared->failed) {
+                break;
+            }
+            index = shared->nextChunk++;
+        }
+        size_t size = generateChunk(*shared->config, index, buffer, capacity);
+
+        std::unique_lock<std::mutex> guard(shared->lock);
+        while (shared->nextWrite != index && !shared->failed) {
+            shared->turn.wait(guard);
+        }
+        if (!shared->failed && !writeAll(shared->fd, buffer, size)) {
+            perror("write");
+            shared->failed = true;
+        }
+        shared->bytes += (long long)size;
+        shared->nextWrite++;
+        shared->turn.notify_all();
+    }
+    delete[] buffer;
+}
+
+// "512M" -> bytes
+static long long parseSize(const char* text) {
+    char* end;
+    double value = strtod(text, &end);
+    switch (*end) {
+        case 'k': case 'K': value *= 1024.0; break;
+        case 'm': case 'M': value *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': value *= 1024.0 * 1024.0 * 1024.0; break;
+    }
+    return (long long)value;
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorConfig config;
+    long long size = 0;
+    int threads = (int)std::thread::hardware_concurrency();
+    const char* output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--entries") == 0 && hasValue) {
+            config.entries = atoll(argv[++i]);
+        } else if (strcmp(arg, "--size") == 0 && hasValue) {
+            size = parseSize(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+            config.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--rate") == 0 && hasValue) {
+            config.entriesPerSecond = atof(argv[++i]);
+        } else if (strcmp(arg, "--errors") == 0 && hasValue) {
+            config.errorShare = atof(argv[++i]);
+        } else if (strcmp(arg, "--zipf") == 0 && hasValue) {
+            config.zipfExponent = atof(argv[++i]);
+        } else if (strcmp(arg, "--traces") == 0 && hasValue) {
+            config.stackTraceShare = atof(argv[++i]);
+        } else if (strcmp(arg, "--depth") == 0 && hasValue) {
+            config.maxStackDepth = atoi(argv[++i]);
+        } else if (strcmp(arg, "--output") == 0 && hasValue) {
+            output = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--entries N | --size BYTES[K|M|G]] [--seed S]"
+                      << " [--threads T] [--rate R] [--errors SHARE] [--zipf S] [--traces SHARE]"
+                      << " [--depth N] [--output FILE]\n";
+            return 1;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    if (size > 0) {
+        // Size the entry count from the first chunk, so the output depends
+        // only on the settings and not on timing
+        size_t capacity = (size_t)8 << 20;
+        char* buffer = new char[capacity];
+        GeneratorConfig probe = config;
+        probe.entries = config.chunkEntries;
+        size_t probeBytes = generateChunk(probe, 0, buffer, capacity);
+        delete[] buffer;
+        config.entries = (long long)((double)size * config.chunkEntries / (double)probeBytes);
+    }
+
+    int fd = 1;
+    if (output != nullptr) {
+        fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            perror(output);
+            return 1;
+        }
+    }
+
+    Shared shared;
+    shared.config = &config;
+    shared.fd = fd;
+    shared.chunks = (config.entries + config.chunkEntries - 1) / config.chunkEntries;
+    shared.nextChunk = 0;
+    shared.nextWrite = 0;
+    shared.bytes = 0;
+    shared.failed = false;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread* pool[MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        pool[t] = new std::thread(worker, &shared);
+    }
+    for (int t = 0; t < threads; t++) {
+        pool[t]->join();
+        delete pool[t];
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (output != nullptr) {
+        close(fd);
+    }
+
+    fprintf(stderr, "Generated %lld entries, %.1f MB in %.2f s (%.0f MB/s, %d threads, seed %llu)\n",
+            config.entries, shared.bytes / 1e6, seconds, shared.bytes / 1e6 / (seconds > 0.0 ? seconds : 1e-9),
+            threads, config.seed);
+    return shared.failed ? 1 : 0;
+}
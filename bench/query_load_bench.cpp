@@ -0,0 +1,258 @@
+// Load test for the query server
+// Opens --clients connections, each sending requests back to back for
+// --seconds, and reports queries per second and latency percentiles per
+// request type. Without --socket an in-process server is started over
+// generated logs; with it, a running ./analyzer --serve is measured.
+// Compile with: g++ -O2 -std=c++11 -pthread -I.. -o query_load_bench query_load_bench.cpp ../core.cpp
+// Usage: ./query_load_bench [--socket PATH] [--entries N] [--server-threads T]
+//                           [--clients C] [--seconds S] [--query stats|search|logs|errors|mixed]
+
+#include "core.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+static const int MAX_CLIENTS = 256;
+static const int KIND_COUNT = 4;
+
+struct QueryKind {
+    const char* name;
+    unsigned char op;
+    unsigned char flags;
+    int limit;
+    const char* argument;
+};
+
+// Keywords that occur in generated logs (see log_generator.h)
+static const QueryKind KINDS[KIND_COUNT] = {
+    { "stats", QUERY_STATS, 0, 0, nullptr },
+    { "search", QUERY_SEARCH, QUERY_CASE_INSENSITIVE, 0, "timeout" },
+    { "logs", QUERY_LOGS, 0, 20, "Heartbeat" },
+    { "errors", QUERY_ERRORS, QUERY_BY_TEMPLATE, 10, nullptr }
+};
+
+// Latencies of one client, by request kind
+struct ClientResult {
+    long long* nanos[KIND_COUNT];
+    long long count[KIND_COUNT];
+    long long capacity[KIND_COUNT];
+    long long failures;
+};
+
+struct LoadConfig {
+    const char* socketPath;
+    int kind;                  // -1 = rotate through every kind
+    double seconds;
+};
+
+static void record(ClientResult& result, int kind, long long nanos) {
+    if (result.count[kind] == result.capacity[kind]) {
+        long long capacity = result.capacity[kind] * 2;
+        long long* grown = new long long[capacity];
+        memcpy(grown, result.nanos[kind], sizeof(long long) * result.count[kind]);
+        delete[] result.nanos[kind];
+        result.nanos[kind] = grown;
+        result.capacity[kind] = capacity;
+    }
+    result.nanos[kind][result.count[kind]++] = nanos;
+}
+
+static void runClient(const LoadConfig* config, int index, ClientResult* result) {
+    QueryClient client;
+    if (!client.connectTo(config->socketPath)) {
+        result->failures++;
+        return;
+    }
+    QueryBuffer response;
+    unsigned char status;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+        std::chrono::microseconds((long long)(config->seconds * 1e6));
+    for (long long i = index; ; i++) {
+        int kind = config->kind >= 0 ? config->kind : (int)(i % KIND_COUNT);
+        const QueryKind& query = KINDS[kind];
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (start >= deadline) {
+            break;
+        }
+        if (!client.query(query.op, query.flags, query.limit, query.argument, status, response)) {
+            result->failures++;
+            break;
+        }
+        long long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (status != QUERY_OK) {
+            result->failures++;
+        } else {
+            record(*result, kind, nanos);
+        }
+    }
+}
+
+static int compareLongLong(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static double percentileMs(const long long* sorted, long long count, double p) {
+    if (count == 0) {
+        return 0.0;
+    }
+    long long index = (long long)(p * (count - 1) + 0.5);
+    return sorted[index] / 1e6;
+}
+
+static void printRow(const char* name, long long* nanos, long long count, double seconds) {
+    qsort(nanos, (size_t)count, sizeof(long long), compareLongLong);
+    double sum = 0.0;
+    for (long long i = 0; i < count; i++) {
+        sum += (double)nanos[i];
+    }
+    printf("%-8s %10lld %10.0f %9.3f %9.3f %9.3f %9.3f %9.3f\n", name, count, count / seconds,
+           count > 0 ? sum / count / 1e6 : 0.0, percentileMs(nanos, count, 0.5),
+           percentileMs(nanos, count, 0.9), percentileMs(nanos, count, 0.99),
+           count > 0 ? nanos[count - 1] / 1e6 : 0.0);
+}
+
+static void runServer(QueryServer* server, const char* path, LogAnalyzer* analyzer) {
+    server->run(path, LogAnalyzer::serveQuery, analyzer);
+}
+
+int main(int argc, char* argv[]) {
+    LoadConfig config;
+    config.socketPath = nullptr;
+    config.kind = -1;
+    config.seconds = 5.0;
+    int clients = 8;
+    long long entries = 200000;
+    QueryServerConfig serverConfig;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--socket") == 0 && hasValue) {
+            config.socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--entries") == 0 && hasValue) {
+            entries = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--server-threads") == 0 && hasValue) {
+            serverConfig.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--clients") == 0 && hasValue) {
+            clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            config.seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--query") == 0 && hasValue) {
+            const char* name = argv[++i];
+            for (int k = 0; k < KIND_COUNT; k++) {
+                if (strcmp(name, KINDS[k].name) == 0) {
+                    config.kind = k;
+                }
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--socket PATH] [--entries N] [--server-threads T]"
+                      << " [--clients C] [--seconds S] [--query stats|search|logs|errors|mixed]\n";
+            return 1;
+        }
+    }
+    if (clients < 1) {
+        clients = 1;
+    } else if (clients > MAX_CLIENTS) {
+        clients = MAX_CLIENTS;
+    }
+
+    // In-process server over generated logs unless a socket was given
+    LogAnalyzer* analyzer = nullptr;
+    QueryServer* server = nullptr;
+    std::thread* serverThread = nullptr;
+    char ownPath[108];
+    if (config.socketPath == nullptr) {
+        analyzer = new LogAnalyzer();
+        GeneratorConfig generator;
+        generator.entries = entries;
+        analyzer->loadGeneratedData(generator);
+        snprintf(ownPath, sizeof(ownPath), "/tmp/query_load_bench.%d.sock", (int)getpid());
+        config.socketPath = ownPath;
+        server = new QueryServer(serverConfig);
+        serverThread = new std::thread(runServer, server, ownPath, analyzer);
+        QueryClient probe;
+        int attempts = 0;
+        while (!probe.connectTo(ownPath) && attempts++ < 500) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    ClientResult* results = new ClientResult[clients];
+    for (int c = 0; c < clients; c++) {
+        for (int k = 0; k < KIND_COUNT; k++) {
+            results[c].capacity[k] = 1024;
+            results[c].nanos[k] = new long long[1024];
+            results[c].count[k] = 0;
+        }
+        results[c].failures = 0;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread* threads[MAX_CLIENTS];
+    for (int c = 0; c < clients; c++) {
+        threads[c] = new std::thread(runClient, &config, c, &results[c]);
+    }
+    for (int c = 0; c < clients; c++) {
+        threads[c]->join();
+        delete threads[c];
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Merge per-client latencies by kind, then all together
+    long long total = 0;
+    long long failures = 0;
+    for (int c = 0; c < clients; c++) {
+        failures += results[c].failures;
+        for (int k = 0; k < KIND_COUNT; k++) {
+            total += results[c].count[k];
+        }
+    }
+    long long* all = new long long[total > 0 ? total : 1];
+    long long allCount = 0;
+    printf("%d clients for %.1f s on %s\n", clients, seconds, config.socketPath);
+    printf("%-8s %10s %10s %9s %9s %9s %9s %9s\n", "query", "requests", "qps", "mean ms", "p50 ms",
+           "p90 ms", "p99 ms", "max ms");
+    for (int k = 0; k < KIND_COUNT; k++) {
+        long long count = 0;
+        for (int c = 0; c < clients; c++) {
+            count += results[c].count[k];
+        }
+        if (count == 0) {
+            continue;
+        }
+        long long* kind = new long long[count];
+        long long used = 0;
+        for (int c = 0; c < clients; c++) {
+            memcpy(kind + used, results[c].nanos[k], sizeof(long long) * results[c].count[k]);
+            used += results[c].count[k];
+        }
+        memcpy(all + allCount, kind, sizeof(long long) * count);
+        allCount += count;
+        printRow(KINDS[k].name, kind, count, seconds);
+        delete[] kind;
+    }
+    printRow("all", all, allCount, seconds);
+    if (failures > 0) {
+        printf("%lld failed requests or connections\n", failures);
+    }
+    delete[] all;
+    for (int c = 0; c < clients; c++) {
+        for (int k = 0; k < KIND_COUNT; k++) {
+            delete[] results[c].nanos[k];
+        }
+    }
+    delete[] results;
+
+    if (server != nullptr) {
+        server->stop();
+        serverThread->join();
+        delete serverThread;
+        delete server;
+        delete analyzer;
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+// Throughput test for the syslog listener
+// Sender threads push generated messages (alternately RFC 5424 and RFC 3164)
+// with sendmmsg() to an in-process SyslogListener over a Unix datagram socket
+// or loopback UDP, as fast as they can. Reports messages per second received
+// and ingested, and how many were dropped. --sink null measures receiving
+// and parsing alone; the default adds every message to a LogAnalyzer.
+// Compile with: g++ -O2 -std=c++11 -pthread -I.. -o syslog_bench syslog_bench.cpp ../core.cpp
+// Usage: ./syslog_bench [--messages N] [--senders S] [--udp PORT] [--batch B]
+//                       [--queue BATCHES] [--sink analyzer|null]
+
+#include "core.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+static const int MAX_SENDERS = 64;
+static const int TEMPLATE_MESSAGES = 4096;
+static const int SEND_BATCH = 64;
+
+struct BenchConfig {
+    long long messages;        // Per sender
+    const char* path;
+    int udpPort;
+    char* texts[TEMPLATE_MESSAGES];
+    size_t lengths[TEMPLATE_MESSAGES];
+};
+
+// Pre-format generated entries as syslog messages
+static void buildMessages(BenchConfig& config) {
+    GeneratorConfig generator;
+    generator.entries = TEMPLATE_MESSAGES;
+    LogGenerator logs(generator);
+    GeneratedEntry entry;
+    char line[1024];
+    for (int i = 0; i < TEMPLATE_MESSAGES && logs.next(entry); i++) {
+        int severity = strcmp(entry.level, "ERROR") == 0 ? 3 : (strcmp(entry.level, "WARNING") == 0 ? 4 : 6);
+        size_t messageLength = strcspn(entry.message, "\n");   // First line of stack traces
+        int length;
+        if (i % 2 == 0) {
+            char isoTime[20];
+            memcpy(isoTime, entry.timestamp, 20);
+            isoTime[10] = 'T';
+            length = snprintf(line, sizeof(line), "<%d>1 %sZ bench-host app %d - [req id=\"%d\"] %.*s",
+                              8 + severity, isoTime, 1000 + i % 7, i, (int)messageLength, entry.message);
+        } else {
+            static const char* const MONTHS[12] = {
+                "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+            };
+            int month = atoi(entry.timestamp + 5);
+            length = snprintf(line, sizeof(line), "<%d>%s %2d %.8s bench-host app[%d]: %.*s",
+                              8 + severity, MONTHS[(month + 11) % 12], atoi(entry.timestamp + 8),
+                              entry.timestamp + 11, 1000 + i % 7, (int)messageLength, entry.message);
+        }
+        if (length >= (int)sizeof(line)) {
+            length = (int)sizeof(line) - 1;
+        }
+        config.texts[i] = new char[length + 1];
+        memcpy(config.texts[i], line, (size_t)length + 1);
+        config.lengths[i] = (size_t)length;
+    }
+}
+
+static void runSender(const BenchConfig* config, int index, long long* sent) {
+    int fd;
+    struct sockaddr_un unixAddress;
+    struct sockaddr_in udpAddress;
+    struct sockaddr* address;
+    socklen_t addressLength;
+    if (config->udpPort > 0) {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        memset(&udpAddress, 0, sizeof(udpAddress));
+        udpAddress.sin_family = AF_INET;
+        udpAddress.sin_port = htons((unsigned short)config->udpPort);
+        udpAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address = (struct sockaddr*)&udpAddress;
+        addressLength = sizeof(udpAddress);
+    } else {
+        fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        memset(&unixAddress, 0, sizeof(unixAddress));
+        unixAddress.sun_family = AF_UNIX;
+        strcpy(unixAddress.sun_path, config->path);
+        address = (struct sockaddr*)&unixAddress;
+        addressLength = sizeof(unixAddress);
+    }
+    if (fd < 0 || connect(fd, address, addressLength) != 0) {
+        perror("connect");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+    struct mmsghdr headers[SEND_BATCH];
+    struct iovec vectors[SEND_BATCH];
+    long long next = (long long)index * 997;
+    long long remaining = config->messages;
+    while (remaining > 0) {
+        int count = remaining < SEND_BATCH ? (int)remaining : SEND_BATCH;
+        for (int i = 0; i < count; i++) {
+            int message = (int)((next + i) % TEMPLATE_MESSAGES);
+            vectors[i].iov_base = config->texts[message];
+            vectors[i].iov_len = config->lengths[message];
+            memset(&headers[i].msg_hdr, 0, sizeof(headers[i].msg_hdr));
+            headers[i].msg_hdr.msg_iov = &vectors[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        int done = sendmmsg(fd, headers, (unsigned int)count, 0);
+        if (done < 0) {
+            if (errno == EINTR || errno == ENOBUFS || errno == EAGAIN) {
+                continue;
+            }
+            perror("sendmmsg");
+            break;
+        }
+        next += done;
+        remaining -= done;
+        *sent += done;
+    }
+    close(fd);
+}
+
+static void nullSink(void* context, const char*, const char*, const char*) {
+    (*(long long*)context)++;
+}
+
+static void analyzerSink(void* context, const char* timestamp, const char* level, const char* message) {
+    ((LogAnalyzer*)context)->addLog(timestamp, level, message);
+}
+
+static void runListener(SyslogListener* listener, IngestSink sink, void* context, bool* ok) {
+    *ok = listener->run(sink, context);
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    long long total = 1000000;
+    int senders = 2;
+    bool useAnalyzer = true;
+    SyslogConfig listenerConfig;
+    config.udpPort = 0;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--messages") == 0 && hasValue) {
+            total = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--senders") == 0 && hasValue) {
+            senders = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--udp") == 0 && hasValue) {
+            config.udpPort = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && hasValue) {
+            listenerConfig.batchMessages = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queue") == 0 && hasValue) {
+            listenerConfig.queueBatches = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sink") == 0 && hasValue) {
+            useAnalyzer = strcmp(argv[++i], "null") != 0;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--messages N] [--senders S] [--udp PORT] [--batch B]"
+                      << " [--queue BATCHES] [--sink analyzer|null]\n";
+            return 1;
+        }
+    }
+    if (senders < 1) {
+        senders = 1;
+    } else if (senders > MAX_SENDERS) {
+        senders = MAX_SENDERS;
+    }
+    config.messages = total / senders;
+    buildMessages(config);
+
+    char path[108];
+    snprintf(path, sizeof(path), "/tmp/syslog_bench.%d.sock", (int)getpid());
+    config.path = path;
+    if (config.udpPort > 0) {
+        listenerConfig.udpPort = config.udpPort;
+    } else {
+        strcpy(listenerConfig.datagramPath, path);
+    }
+
+    LogAnalyzer* analyzer = useAnalyzer ? new LogAnalyzer() : nullptr;
+    long long nullCount = 0;
+    SyslogListener listener(listenerConfig);
+    bool ok = false;
+    std::thread listenerThread(runListener, &listener, useAnalyzer ? analyzerSink : nullSink,
+                               useAnalyzer ? (void*)analyzer : (void*)&nullCount, &ok);
+    // Wait for the socket to be bound
+    for (int attempt = 0; attempt < 500; attempt++) {
+        if (config.udpPort > 0 || access(path, F_OK) == 0) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    long long sent[MAX_SENDERS];
+    std::thread* threads[MAX_SENDERS];
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int s = 0; s < senders; s++) {
+        sent[s] = 0;
+        threads[s] = new std::thread(runSender, &config, s, &sent[s]);
+    }
+    long long sentTotal = 0;
+    for (int s = 0; s < senders; s++) {
+        threads[s]->join();
+        delete threads[s];
+        sentTotal += sent[s];
+    }
+    double sendSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // Let the last datagrams reach the listener, then stop it (it drains its queue)
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    listener.stop();
+    listenerThread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!ok) {
+        std::cerr << "Listener failed to start\n";
+        return 1;
+    }
+
+    const SyslogStats& stats = listener.getStats();
+    printf("%s, %d senders, sink %s, recvmmsg batch %d, queue %d batches\n",
+           config.udpPort > 0 ? "UDP loopback" : "Unix datagram", senders, useAnalyzer ? "analyzer" : "null",
+           listenerConfig.batchMessages, listenerConfig.queueBatches);
+    printf("sent       %10lld  %10.0f msg/s\n", sentTotal, sentTotal / sendSeconds);
+    printf("received   %10lld  %10.0f msg/s\n", stats.received, stats.received / sendSeconds);
+    printf("ingested   %10lld  %10.0f msg/s\n", stats.ingested, stats.ingested / seconds);
+    printf("dropped    %10lld  (ingest queue full)\n", stats.dropped);
+    printf("kernel     %10lld  (socket buffer full)\n", stats.kernelDropped);
+    printf("malformed  %10lld\n", stats.malformed);
+    if (analyzer != nullptr) {
+        printf("analyzer   %10lld logs\n", (long long)analyzer->getTotalLogs());
+        delete analyzer;
+    }
+    for (int i = 0; i < TEMPLATE_MESSAGES; i++) {
+        delete[] config.texts[i];
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Durability benchmark for LogAnalyzer::addLog()
+// Measures ingest throughput in memory and with the write-ahead log under
+// each sync policy (none, interval, always/group commit) at 1 and 8 threads,
+// and a single-threaded bulk load (ingestStream(), one commit per batch).
+// Compile with: g++ -O2 -std=c++11 -pthread -I.. -o wal_bench wal_bench.cpp ../core.cpp
+// Usage: ./wal_bench [directory for WAL files, default /tmp]
+
+#include "core.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+
+static const int ENTRIES_PER_RUN = 200000;   // Split across threads
+
+static const char* LEVELS[4] = { "INFO", "WARNING", "ERROR", "DEBUG" };
+
+static void formatEntry(int i, char* timestamp, size_t timestampSize, char* message, size_t messageSize) {
+    snprintf(timestamp, timestampSize, "2024-01-15 %02d:%02d:%02d", i / 3600 % 24, i / 60 % 60, i % 60);
+    snprintf(message, messageSize, "Request %d from host-%d took %d ms", i, i % 64, i % 997);
+}
+
+static void ingestRange(LogAnalyzer* analyzer, int first, int last) {
+    char timestamp[32];
+    char message[96];
+    for (int i = first; i < last; i++) {
+        formatEntry(i, timestamp, sizeof(timestamp), message, sizeof(message));
+        analyzer->addLog(timestamp, LEVELS[i % 4], message);
+    }
+}
+
+// Ingest ENTRIES_PER_RUN entries; returns entries per second
+static double runOnce(int threads, bool durable, WalSyncPolicy policy, const char* dir, long long& syncs) {
+    char logPath[512];
+    char snapshotPath[512];
+    snprintf(logPath, sizeof(logPath), "%s/wal_bench.wal", dir);
+    snprintf(snapshotPath, sizeof(snapshotPath), "%s/wal_bench.snap", dir);
+    unlink(logPath);
+    unlink(snapshotPath);
+
+    LogAnalyzer analyzer;
+    if (durable) {
+        WalConfig config;
+        config.policy = policy;
+        config.checkpointRecords = 0;   // Measure logging only
+        if (!analyzer.enableDurability(logPath, snapshotPath, config)) {
+            return 0.0;
+        }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread* workers = new std::thread[threads];
+    for (int t = 0; t < threads; t++) {
+        int first = (int)((long long)ENTRIES_PER_RUN * t / threads);
+        int last = (int)((long long)ENTRIES_PER_RUN * (t + 1) / threads);
+        workers[t] = std::thread(ingestRange, &analyzer, first, last);
+    }
+    for (int t = 0; t < threads; t++) {
+        workers[t].join();
+    }
+    delete[] workers;
+    syncs = analyzer.getWalSyncCount();
+    analyzer.disableDurability();   // The final sync counts toward the run time
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unlink(logPath);
+    unlink(snapshotPath);
+    return ENTRIES_PER_RUN / seconds;
+}
+
+// Ingest the same entries as log lines through ingestStream() (one thread,
+// WAL_SYNC_ALWAYS); returns entries per second
+static double runBulk(const char* dir, long long& syncs) {
+    char logPath[512];
+    char snapshotPath[512];
+    char inputPath[512];
+    snprintf(logPath, sizeof(logPath), "%s/wal_bench.wal", dir);
+    snprintf(snapshotPath, sizeof(snapshotPath), "%s/wal_bench.snap", dir);
+    snprintf(inputPath, sizeof(inputPath), "%s/wal_bench.log", dir);
+    unlink(logPath);
+    unlink(snapshotPath);
+
+    FILE* input = fopen(inputPath, "w");
+    if (input == nullptr) {
+        return 0.0;
+    }
+    char timestamp[32];
+    char message[96];
+    for (int i = 0; i < ENTRIES_PER_RUN; i++) {
+        formatEntry(i, timestamp, sizeof(timestamp), message, sizeof(message));
+        fprintf(input, "%s %s %s\n", timestamp, LEVELS[i % 4], message);
+    }
+    fclose(input);
+
+    LogAnalyzer analyzer;
+    WalConfig config;
+    config.checkpointRecords = 0;
+    if (!analyzer.enableDurability(logPath, snapshotPath, config)) {
+        return 0.0;
+    }
+    int fd = open(inputPath, O_RDONLY);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::streambuf* saved = std::cout.rdbuf(nullptr);   // ingestStream() reports its own timing
+    analyzer.ingestStream(fd);
+    std::cout.rdbuf(saved);
+    syncs = analyzer.getWalSyncCount();
+    analyzer.disableDurability();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    close(fd);
+
+    unlink(logPath);
+    unlink(snapshotPath);
+    unlink(inputPath);
+    return ENTRIES_PER_RUN / seconds;
+}
+
+int main(int argc, char* argv[]) {
+    const char* dir = argc > 1 ? argv[1] : "/tmp";
+    const int threadCounts[2] = { 1, 8 };
+    const char* names[4] = { "in-memory", "wal none", "wal interval", "wal always" };
+    const WalSyncPolicy policies[4] = { WAL_SYNC_NONE, WAL_SYNC_NONE, WAL_SYNC_INTERVAL, WAL_SYNC_ALWAYS };
+
+    std::cout << "Ingesting " << ENTRIES_PER_RUN << " entries per run (WAL in " << dir << ")\n";
+    std::cout << "mode           threads   entries/s    slowdown   fsyncs\n";
+    for (int t = 0; t < 2; t++) {
+        double baseline = 0.0;
+        for (int m = 0; m < 4; m++) {
+            long long syncs = 0;
+            double rate = runOnce(threadCounts[t], m > 0, policies[m], dir, syncs);
+            if (m == 0) {
+                baseline = rate;
+            }
+            printf("%-14s %7d %11.0f %10.2fx %8lld\n", names[m], threadCounts[t], rate,
+                   rate > 0.0 ? baseline / rate : 0.0, syncs);
+        }
+        if (t == 0) {
+            long long syncs = 0;
+            double rate = runBulk(dir, syncs);
+            printf("%-14s %7d %11.0f %10.2fx %8lld\n", "always, bulk", 1, rate,
+                   rate > 0.0 ? baseline / rate : 0.0, syncs);
+        }
+    }
+    return 0;
+}
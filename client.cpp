@@ -0,0 +1,90 @@
+// Command-line client for the query server (./analyzer --serve SOCKET)
+// Usage: ./analyzer_client SOCKET COMMAND [ARGUMENTS] [OPTIONS]
+//   ping | stats | search KEYWORD | logs KEYWORD [LIMIT] | errors [K]
+//   -i           case-insensitive search and logs
+//   --templates  errors grouped by message template
+//   --approx     errors from the fixed-memory heavy-hitter summary
+
+#include "query_protocol.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void usage(const char* program) {
+    std::cerr << "Usage: " << program << " SOCKET COMMAND [ARGUMENTS] [OPTIONS]\n"
+              << "Commands:\n"
+              << "  ping                  Check that the server answers\n"
+              << "  stats                 Log, error and template counts\n"
+              << "  search KEYWORD        Occurrences of KEYWORD in log messages\n"
+              << "  logs KEYWORD [LIMIT]  Newest logs containing KEYWORD (default 20)\n"
+              << "  errors [K]            K most frequent ERROR messages (default 10)\n"
+              << "Options:\n"
+              << "  -i                    Case-insensitive search and logs\n"
+              << "  --templates           Group errors by message template\n"
+              << "  --approx              Errors from the fixed-memory heavy-hitter summary\n";
+}
+
+int main(int argc, char* argv[]) {
+    const char* positional[4];
+    int positionalCount = 0;
+    unsigned char flags = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0) {
+            flags |= QUERY_CASE_INSENSITIVE;
+        } else if (strcmp(argv[i], "--templates") == 0) {
+            flags |= QUERY_BY_TEMPLATE;
+        } else if (strcmp(argv[i], "--approx") == 0) {
+            flags |= QUERY_APPROXIMATE;
+        } else if (positionalCount < 4 && (argv[i][0] != '-' || positionalCount >= 2)) {
+            positional[positionalCount++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (positionalCount < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* command = positional[1];
+    const char* argument = positionalCount > 2 ? positional[2] : nullptr;
+    int limit = 0;
+    unsigned char op;
+    if (strcmp(command, "ping") == 0) {
+        op = QUERY_PING;
+    } else if (strcmp(command, "stats") == 0) {
+        op = QUERY_STATS;
+    } else if (strcmp(command, "search") == 0 && argument != nullptr) {
+        op = QUERY_SEARCH;
+    } else if (strcmp(command, "logs") == 0 && argument != nullptr) {
+        op = QUERY_LOGS;
+        limit = positionalCount > 3 ? atoi(positional[3]) : 0;
+    } else if (strcmp(command, "errors") == 0) {
+        op = QUERY_ERRORS;
+        limit = argument != nullptr ? atoi(argument) : 0;
+        argument = nullptr;
+    } else {
+        usage(argv[0]);
+        return 1;
+    }
+
+    QueryClient client;
+    if (!client.connectTo(positional[0])) {
+        perror(positional[0]);
+        return 1;
+    }
+    unsigned char status;
+    QueryBuffer response;
+    if (!client.query(op, flags, limit, argument, status, response)) {
+        std::cerr << "Connection to " << positional[0] << " failed\n";
+        return 1;
+    }
+    if (status != QUERY_OK) {
+        std::cerr << "Error: " << response.data << "\n";
+        return 1;
+    }
+    fwrite(response.data, 1, response.size, stdout);
+    return 0;
+}
@@ -0,0 +1,157 @@
+#ifndef CONCURRENT_TABLE_H
+#define CONCURRENT_TABLE_H
+
+#include "hash_table.h"
+#include "snapshot.h"
+#include <iostream>
+#include <mutex>
+
+// Lock-striped counting table for multi-writer ingestion
+// Keys are spread over SHARD_COUNT independent HashTables, each guarded by its
+// own mutex, so threads incrementing different keys almost never wait on each
+// other. Only writers that hit the same shard at the same moment serialize.
+class ShardedCountTable {
+private:
+    static const int SHARD_BITS = 6;
+    static const int SHARD_COUNT = 1 << SHARD_BITS;
+
+    // Pad each shard to its own cache lines to avoid false sharing of the locks
+    struct Shard {
+        std::mutex lock;
+        HashTable table;
+        char padding[64];
+    };
+
+    mutable Shard shards[SHARD_COUNT];
+
+    // Shard index from the high bits of a mixed ID (MurmurHash3 fmix32)
+    static inline int shardOf(unsigned int id) {
+        id ^= id >> 16;
+        id *= 0x85ebca6bu;
+        id ^= id >> 13;
+        id *= 0xc2b2ae35u;
+        id ^= id >> 16;
+        return (int)(id >> (32 - SHARD_BITS));
+    }
+
+public:
+    // Insert or update a key (thread-safe)
+    // key must remain valid for as long as the entry is in the table
+    inline void insert(unsigned int id, const char* key, int amount = 1) {
+        Shard& shard = shards[shardOf(id)];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.table.insert(id, key, amount);
+    }
+
+    // Get the count for a specific key (thread-safe)
+    inline int getCount(unsigned int id) const {
+        Shard& shard = shards[shardOf(id)];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.table.getCount(id);
+    }
+
+    // Find the k entries with the highest counts across all shards
+    // Shards hold disjoint keys, so the global top k is the top k of the
+    // per-shard winners. out must hold k pointers; returns the number written.
+    // The returned nodes stay valid until the table is cleared.
+    inline int topK(int k, const HashNode** out) const {
+        if (k <= 0) {
+            return 0;
+        }
+        const HashNode** shardTop = new const HashNode*[k];
+        int size = 0;
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            int found = shards[i].table.topK(k, shardTop);
+            for (int j = 0; j < found; j++) {
+                HashTable::offerTopK(shardTop[j], k, out, size);
+            }
+        }
+        HashTable::sortTopK(out, size);
+        delete[] shardTop;
+        return size;
+    }
+
+    // Display all entries
+    inline void displayAll() const {
+        bool hasEntries = false;
+        std::cout << "\n=== Hash Table Entries ===\n";
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            if (shards[i].table.displayEntries()) {
+                hasEntries = true;
+            }
+        }
+        if (!hasEntries) {
+            std::cout << "No entries found.\n";
+        } else {
+            std::cout << "\nTotal unique entries: " << getTotalEntries() << "\n";
+        }
+    }
+
+    // Total number of distinct keys
+    inline int getTotalEntries() const {
+        int total = 0;
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            total += shards[i].table.getTotalEntries();
+        }
+        return total;
+    }
+
+    // Add the memory held by every shard's table
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            shards[i].table.addMemoryUsage(usage);
+        }
+    }
+
+    // Write every (id, count) pair to a snapshot, shard by shard
+    inline void saveTo(SnapshotWriter& writer) const {
+        writer.writeU64((unsigned long long)getTotalEntries());
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            int entries = shards[i].table.getTotalEntries();
+            unsigned int* ids = new unsigned int[entries > 0 ? entries : 1];
+            int* counts = new int[entries > 0 ? entries : 1];
+            shards[i].table.copyEntries(ids, counts);
+            for (int j = 0; j < entries; j++) {
+                writer.writeU64(((unsigned long long)ids[j] << 32) | (unsigned int)counts[j]);
+            }
+            delete[] ids;
+            delete[] counts;
+        }
+    }
+
+    // Add the pairs saved by saveTo(); labels are resolved through label()
+    inline bool loadFrom(SnapshotCursor& cursor, SnapshotLabelFunction label, const void* context) {
+        unsigned long long entries = cursor.readU64();
+        const unsigned long long* pairs =
+            (const unsigned long long*)cursor.readArray(sizeof(unsigned long long) * entries);
+        if (cursor.hasFailed() || entries > 0x7FFFFFFFULL) {
+            cursor.fail();
+            return false;
+        }
+        for (unsigned long long i = 0; i < entries; i++) {
+            unsigned int id = (unsigned int)(pairs[i] >> 32);
+            const char* key = label(context, id);
+            if (key == nullptr) {
+                cursor.fail();
+                return false;
+            }
+            insert(id, key, (int)(unsigned int)pairs[i]);
+        }
+        return true;
+    }
+
+    // Clear all entries (not safe while other threads are inserting)
+    inline void clear() {
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            shards[i].table.clear();
+        }
+    }
+};
+
+#endif // CONCURRENT_TABLE_H
@@ -2,104 +2,1153 @@
 #include <iostream>
 #include <cstring>
 #include <cctype>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 // Constructor
-LogAnalyzer::LogAnalyzer() {
+LogAnalyzer::LogAnalyzer() : logList(stringPool) {
     // All data structures are initialized by their constructors
+    sketches = nullptr;
+    dataGeneration = 0;
+    wal = nullptr;
+    walPath[0] = '\0';
+    checkpointPath[0] = '\0';
+    appliedSequence = 0;
+    recordsSinceCheckpoint.store(0);
+    checkpointRunning.store(false);
+    ingestInFlight.store(0);
+    ingestPaused.store(false);
+    internKnownLevels();
 }
 
 // Destructor
 LogAnalyzer::~LogAnalyzer() {
     // All data structures clean up automatically via their destructors
+    disableDurability();
+    delete sketches;
 }
 
-// Helper function to check if log level is ERROR
-bool LogAnalyzer::isErrorLevel(const char* level) const {
-    return (strcmp(level, "ERROR") == 0 || strcmp(level, "error") == 0);
+// Helper function to check if an interned log level is ERROR
+bool LogAnalyzer::isErrorLevel(unsigned int levelId) const {
+    return (levelId == errorLevelId || levelId == errorLevelLowerId);
+}
+
+// Map an interned log level to its slot in sketches and histograms
+LogSketches::Level LogAnalyzer::levelSlot(unsigned int levelId) const {
+    if (isErrorLevel(levelId)) {
+        return LogSketches::LEVEL_ERROR;
+    }
+    if (levelId == infoLevelId) {
+        return LogSketches::LEVEL_INFO;
+    }
+    if (levelId == warningLevelId) {
+        return LogSketches::LEVEL_WARNING;
+    }
+    if (levelId == debugLevelId) {
+        return LogSketches::LEVEL_DEBUG;
+    }
+    return LogSketches::LEVEL_OTHER;
+}
+
+// Intern the level names the analyzer recognises
+void LogAnalyzer::internKnownLevels() {
+    errorLevelId = stringPool.intern("ERROR");
+    errorLevelLowerId = stringPool.intern("error");
+    infoLevelId = stringPool.intern("INFO");
+    warningLevelId = stringPool.intern("WARNING");
+    debugLevelId = stringPool.intern("DEBUG");
 }
 
 // Add a log entry to the system
 void LogAnalyzer::addLog(const char* timestamp, const char* log_level, const char* message) {
-    // Add to linked list
-    logList.addEntry(timestamp, log_level, message);
+    METRIC_SCOPE_SAMPLED(&metrics, TIMER_ADD_LOG, 16);
+    METRIC_COUNT(&metrics, COUNTER_ENTRIES, 1);
+    METRIC_COUNT(&metrics, COUNTER_MESSAGE_BYTES, strlen(message));
+    unsigned long long sequence = appendLog(timestamp, log_level, message);
+    if (wal != nullptr) {
+        commitLogs(sequence, 1);
+    }
+}
+
+// Store one entry (logged first when durability is on) without committing it
+unsigned long long LogAnalyzer::appendLog(const char* timestamp, const char* log_level, const char* message) {
+    if (wal == nullptr) {
+        ingest(timestamp, log_level, message, nullptr);
+        return 0;
+    }
+    enterIngest();
+    unsigned long long sequence = ingest(timestamp, log_level, message, wal);
+    leaveIngest();
+    return sequence;
+}
+
+// Wait for the group commit covering a sequence, then account for checkpoints
+void LogAnalyzer::commitLogs(unsigned long long sequence, long long records) {
+    if (!wal->commit(sequence)) {
+        std::cout << "WAL: write failed; recent entries may not be durable\n";
+    }
     
-    // If it's an ERROR, add to hash table
-    if (isErrorLevel(log_level)) {
-        errorTable.insert(message);
+    // One caller at a time runs the periodic checkpoint
+    if (walConfig.checkpointRecords > 0 &&
+        recordsSinceCheckpoint.fetch_add(records) + records >= walConfig.checkpointRecords &&
+        !checkpointRunning.exchange(true)) {
+        checkpoint();
+        checkpointRunning.store(false);
     }
 }
 
+// Add one entry of a bulk load; its WAL record is committed with the batch
+void LogAnalyzer::addPending(PendingCommit& pending, const char* timestamp, const char* log_level,
+                             const char* message) {
+    METRIC_SCOPE_SAMPLED(&metrics, TIMER_ADD_LOG, 16);
+    METRIC_COUNT(&metrics, COUNTER_ENTRIES, 1);
+    METRIC_COUNT(&metrics, COUNTER_MESSAGE_BYTES, strlen(message));
+    pending.sequence = appendLog(timestamp, log_level, message);
+    pending.records++;
+    if (pending.records >= COMMIT_BATCH) {
+        commitPending(pending);
+    }
+}
+
+void LogAnalyzer::commitPending(PendingCommit& pending) {
+    if (wal != nullptr && pending.records > 0) {
+        commitLogs(pending.sequence, pending.records);
+    }
+    pending.records = 0;
+}
+
+// Store one log entry, logging it to the WAL first when given
+unsigned long long LogAnalyzer::ingest(const char* timestamp, const char* log_level, const char* message,
+                                       WriteAheadLog* log) {
+    // Deduplicate timestamp, level and message text and mine the template (thread-safe)
+    unsigned int timestampId = stringPool.intern(timestamp);
+    unsigned int levelId = stringPool.intern(log_level);
+    unsigned long long messageHash;
+    unsigned int messageId = stringPool.intern(message, strlen(message), messageHash);
+    const char* messageText = stringPool.lookup(messageId);
+    unsigned int templateId = templateMiner.addMessage(messageId, messageText);
+    long long epoch = parseTimestamp(timestamp);
+    LogSketches::Level level = levelSlot(levelId);
+    bool isError = isErrorLevel(levelId);
+    
+    // If it's an ERROR, add to the striped hash tables (thread-safe)
+    if (isError) {
+        METRIC_COUNT(&metrics, COUNTER_ERROR_ENTRIES, 1);
+        errorTable.insert(messageId, messageText);
+        templateErrorTable.insert(templateId, templateMiner.getText(templateId));
+    }
+    
+    // Short critical section for the store and the single-writer summaries
+    std::lock_guard<std::mutex> guard(ingestLock);
+    
+    // Log before storing, so WAL order matches store order
+    unsigned long long sequence = 0;
+    if (log != nullptr) {
+        sequence = log->append(timestamp, log_level, message);
+        appliedSequence = sequence;
+    }
+    
+    // Append to the columnar log store
+    logList.addEntry(timestampId, epoch, levelId, messageId, templateId);
+    if (savedSearches.getActiveCount() > 0) {
+        savedSearches.matchNew(logList.getSize() - 1, timestamp, log_level, message);
+    }
+    
+    if (sketches != nullptr) {
+        sketches->add(level, messageHash, epoch);
+    }
+    timeHistogram.addLevel(epoch, level);
+    if (isError) {
+        errorHeavyHitters.offer(messageId, messageText);
+        timeHistogram.addErrorKey(epoch, templateId);
+    }
+    return sequence;
+}
+
 // Display all log entries
 void LogAnalyzer::displayAllLogs() const {
     logList.displayAll();
 }
 
+// Print one sorted row (payload is the row number)
+struct TimeOrderDisplay {
+    const LogList* logList;
+    int index;
+};
+
+static void displaySortedRow(void* context, long long, const char* payload, unsigned int) {
+    TimeOrderDisplay* display = (TimeOrderDisplay*)context;
+    int row;
+    memcpy(&row, payload, sizeof(row));
+    LogEntry entry;
+    display->logList->getEntry(row, entry);
+    std::cout << "[" << ++display->index << "] " << entry.timestamp
+              << " [" << entry.log_level << "] " << entry.message << "\n";
+}
+
+// Display all log entries in timestamp order
+void LogAnalyzer::displayLogsByTime(size_t memoryLimit) const {
+    METRIC_SCOPE(&metrics, TIMER_LOGS_BY_TIME);
+    int total = logList.getSize();
+    if (total == 0) {
+        std::cout << "No log entries found.\n";
+        return;
+    }
+    
+    // Sort (epoch, row) pairs straight from the epoch column
+    ExternalSorter sorter(memoryLimit);
+    int row = 0;
+    for (int b = 0; b < logList.getBlockCount(); b++) {
+        const LogBlock* block = logList.getBlock(b);
+        for (int i = 0; i < block->count; i++, row++) {
+            if (!sorter.add(block->epochs[i], (const char*)&row, sizeof(row))) {
+                return;
+            }
+        }
+    }
+    
+    std::cout << "\n=== All Log Entries (oldest first) ===\n";
+    TimeOrderDisplay display = { &logList, 0 };
+    sorter.finish(displaySortedRow, &display);
+    std::cout << "\nTotal entries: " << total << "\n";
+    if (sorter.getRunCount() > 0) {
+        std::cout << "(sorted in " << sorter.getRunCount() << " runs on disk)\n";
+    }
+}
+
 // Count and display ERROR frequency using hash table
-void LogAnalyzer::analyzeErrorFrequency() const {
-    std::cout << "\n=== ERROR Frequency Analysis ===\n";
-    errorTable.displayAll();
+void LogAnalyzer::analyzeErrorFrequency(bool byTemplate) const {
+    METRIC_SCOPE(&metrics, TIMER_ERROR_FREQUENCY);
+    if (byTemplate) {
+        std::cout << "\n=== ERROR Frequency Analysis (by template) ===\n";
+        templateErrorTable.displayAll();
+    } else {
+        std::cout << "\n=== ERROR Frequency Analysis ===\n";
+        errorTable.displayAll();
+    }
 }
 
-// Search for a keyword in log messages using KMP
-int LogAnalyzer::searchKeyword(const char* keyword, bool caseSensitive) const {
-    if (keyword == nullptr || strlen(keyword) == 0) {
+// Get the k most frequent ERROR messages
+int LogAnalyzer::topErrors(int k, bool exact, TopKEntry* out) const {
+    METRIC_SCOPE(&metrics, TIMER_TOP_ERRORS);
+    if (k <= 0) {
         return 0;
     }
+    if (!exact) {
+        return errorHeavyHitters.topK(k, out);
+    }
+    
+    // Partial selection over the exact table
+    const HashNode** nodes = new const HashNode*[k];
+    int found = errorTable.topK(k, nodes);
+    for (int i = 0; i < found; i++) {
+        out[i].id = nodes[i]->id;
+        out[i].key = nodes[i]->key;
+        out[i].count = nodes[i]->count;
+        out[i].error = 0;
+        out[i].guaranteed = true;
+    }
+    delete[] nodes;
+    return found;
+}
+
+// Get the k most frequent ERROR templates (exact counts)
+int LogAnalyzer::topErrorTemplates(int k, TopKEntry* out) const {
+    if (k <= 0) {
+        return 0;
+    }
+    const HashNode** nodes = new const HashNode*[k];
+    int found = templateErrorTable.topK(k, nodes);
+    for (int i = 0; i < found; i++) {
+        out[i].id = nodes[i]->id;
+        out[i].key = nodes[i]->key;
+        out[i].count = nodes[i]->count;
+        out[i].error = 0;
+        out[i].guaranteed = true;
+    }
+    delete[] nodes;
+    return found;
+}
+
+// Display the k most frequent ERROR messages
+void LogAnalyzer::displayTopErrors(int k, bool exact) const {
+    if (k <= 0) {
+        std::cout << "Invalid number of entries.\n";
+        return;
+    }
+    
+    std::cout << "\n=== Top " << k << " ERROR Messages ("
+              << (exact ? "exact" : "approximate") << ") ===\n";
+    
+    TopKEntry* entries = new TopKEntry[k];
+    int found = topErrors(k, exact, entries);
+    for (int i = 0; i < found; i++) {
+        std::cout << "[" << (i + 1) << "] \"" << entries[i].key << "\" -> Count: "
+                  << entries[i].count;
+        if (!exact) {
+            std::cout << " (error <= " << entries[i].error << ")";
+            if (!entries[i].guaranteed) {
+                std::cout << " *";
+            }
+        }
+        std::cout << "\n";
+    }
+    
+    if (found == 0) {
+        std::cout << "No ERROR entries found.\n";
+    } else if (!exact) {
+        std::cout << "\nCounts are upper bounds; overestimation is at most "
+                  << errorHeavyHitters.errorBound() << ".\n";
+        std::cout << "* = may not be in the true top " << k << ".\n";
+    }
+    delete[] entries;
+}
+
+// Enable sketches, replacing any existing ones
+void LogAnalyzer::enableSketches(const SketchConfig& config) {
+    delete sketches;
+    sketches = new LogSketches(config);
+    
+    // Catch up with logs added before the sketches existed (hashing the
+    // stored text again, as the hashes are not kept)
+    for (int b = 0; b < logList.getBlockCount(); b++) {
+        const LogBlock* block = logList.getBlock(b);
+        for (int i = 0; i < block->count; i++) {
+            unsigned int messageId = block->messageIds[i];
+            unsigned long long hash = StringPool::hashBytes(stringPool.lookup(messageId),
+                                                            stringPool.lengthOf(messageId));
+            sketches->add(levelSlot(block->levelIds[i]), hash, block->epochs[i]);
+        }
+    }
+}
+
+void LogAnalyzer::disableSketches() {
+    delete sketches;
+    sketches = nullptr;
+}
+
+bool LogAnalyzer::sketchesEnabled() const {
+    return sketches != nullptr;
+}
+
+// Display sketch estimates
+void LogAnalyzer::displaySketchEstimates(const char* message) {
+    METRIC_SCOPE(&metrics, TIMER_SKETCH_ESTIMATES);
+    if (sketches == nullptr) {
+        std::cout << "Sketches are disabled.\n";
+        return;
+    }
+    
+    std::cout << "\n=== Sketch Estimates ===\n";
+    std::cout << "Distinct messages (all levels): ~" << (long long)(sketches->distinctMessages() + 0.5)
+              << "\n";
+    for (int i = 0; i < LogSketches::LEVEL_COUNT; i++) {
+        LogSketches::Level level = (LogSketches::Level)i;
+        std::cout << "Distinct " << LogSketches::levelName(level) << " messages: ~"
+                  << (long long)(sketches->distinctMessages(level) + 0.5) << "\n";
+    }
+    
+    const int MAX_WINDOWS = 64;
+    long long starts[MAX_WINDOWS];
+    double estimates[MAX_WINDOWS];
+    int windowCount = sketches->getWindows(starts, estimates, MAX_WINDOWS);
+    if (windowCount > 0) {
+        std::cout << "\nDistinct messages per " << sketches->getConfig().windowSeconds / 60 << "-minute window:\n";
+        for (int i = 0; i < windowCount; i++) {
+            char start[20];
+            formatTimestamp(starts[i], start);
+            std::cout << "  " << start << "  ~" << (long long)(estimates[i] + 0.5) << "\n";
+        }
+    }
+    std::cout << "Sketch memory: " << sketches->getMemoryBytes() << " bytes\n";
+    
+    if (message != nullptr && strlen(message) > 0) {
+        long long estimate = sketches->messageFrequency(StringPool::hashBytes(message, strlen(message)));
+        std::cout << "\nEstimated count of \"" << message << "\": " << estimate
+                  << " (overcount <= " << sketches->frequencyErrorBound() << ")\n";
+    }
+}
+
+// Display per-level counts for a time range
+void LogAnalyzer::displayLevelCounts(long long from, long long to) const {
+    METRIC_SCOPE(&metrics, TIMER_LEVEL_COUNTS);
+    char fromText[20];
+    char toText[20];
+    formatTimestamp(from, fromText);
+    formatTimestamp(to, toText);
+    std::cout << "\n=== Log Levels from " << fromText << " to " << toText << " ===\n";
+    
+    for (int i = 0; i < LogSketches::LEVEL_COUNT; i++) {
+        std::cout << LogSketches::levelName((LogSketches::Level)i) << ": "
+                  << timeHistogram.countLevel(i, from, to) << "\n";
+    }
+    
+    // ERROR rate series: per minute up to two hours, per hour beyond
+    long long step = (to - from) <= 2 * 3600 ? 60 : 3600;
+    std::cout << "\nERROR count per " << (step == 60 ? "minute" : "hour") << ":\n";
+    bool any = false;
+    for (long long t = from - (from % step); t < to; t += step) {
+        long long count = timeHistogram.countLevel(LogSketches::LEVEL_ERROR, t, t + step);
+        if (count > 0) {
+            char bucketText[20];
+            formatTimestamp(t, bucketText);
+            std::cout << "  " << bucketText << "  " << count << "\n";
+            any = true;
+        }
+    }
+    if (!any) {
+        std::cout << "  No ERROR entries in this range.\n";
+    }
+}
+
+// Display error templates whose recent rate spiked
+void LogAnalyzer::displayErrorSpikes(int windowMinutes, int baselineMinutes, double factor) const {
+    METRIC_SCOPE(&metrics, TIMER_ERROR_SPIKES);
+    long long now = timeHistogram.getMaxEpoch();
+    if (now == INVALID_EPOCH) {
+        std::cout << "No timestamped log entries found.\n";
+        return;
+    }
+    // Include the latest minute in the window
+    now = (now / 60 + 1) * 60;
     
-    int matchCount = 0;
-    LogEntry* current = logList.getHead();
+    std::cout << "\n=== ERROR Spikes (last " << windowMinutes << " min vs previous "
+              << baselineMinutes << " min) ===\n";
     
-    while (current != nullptr) {
-        int count;
-        if (caseSensitive) {
-            count = kmpMatcher.search(current->message, keyword);
+    const int MAX_SPIKES = 20;
+    SpikeEntry spikes[MAX_SPIKES];
+    int found = timeHistogram.findSpikes(now, windowMinutes * 60LL, baselineMinutes * 60LL,
+                                         factor, spikes, MAX_SPIKES);
+    for (int i = 0; i < found; i++) {
+        std::cout << "[" << (i + 1) << "] \"" << templateMiner.getText(spikes[i].key) << "\" -> "
+                  << spikes[i].windowCount << " now vs " << spikes[i].baselineCount
+                  << " baseline (x" << spikes[i].ratio << ")\n";
+    }
+    if (found == 0) {
+        std::cout << "No spikes found.\n";
+    }
+}
+
+long long LogAnalyzer::getLatestEpoch() const {
+    return timeHistogram.getMaxEpoch();
+}
+
+// Run a group-by over the column store
+void LogAnalyzer::groupBy(const GroupByQuery& query, GroupByResult& result) const {
+    METRIC_SCOPE(&metrics, TIMER_GROUP_BY);
+    GroupByEngine::run(logList, query, result);
+}
+
+// Write the display label of a group key into buffer
+void LogAnalyzer::formatGroupKey(GroupDimension dim, unsigned int key, char* buffer, int size) const {
+    const char* text = nullptr;
+    long long width = 0;
+    switch (dim) {
+        case GROUP_LEVEL:
+        case GROUP_MESSAGE:
+            text = stringPool.lookup(key);
+            break;
+        case GROUP_TEMPLATE:
+            text = templateMiner.getText(key);
+            break;
+        case GROUP_MINUTE:
+            width = 60;
+            break;
+        case GROUP_HOUR:
+            width = 3600;
+            break;
+        case GROUP_DAY:
+            width = 86400;
+            break;
+        default:
+            text = "";
+            break;
+    }
+    if (width > 0) {
+        if (key == GROUP_NO_TIME || size < 20) {
+            text = "(no timestamp)";
         } else {
-            count = kmpMatcher.searchCaseInsensitive(current->message, keyword);
+            formatTimestamp((long long)key * width, buffer);
+            return;
         }
-        matchCount += count;
-        current = current->next;
+    }
+    strncpy(buffer, text, size - 1);
+    buffer[size - 1] = '\0';
+}
+
+// Display a group-by result
+void LogAnalyzer::displayGroupBy(const GroupByQuery& query) const {
+    GroupByResult result;
+    groupBy(query, result);
+    
+    bool timeOrdered = query.first >= GROUP_MINUTE;
+    result.sort(!timeOrdered);
+    
+    std::cout << "\n=== Group-By Results ===\n";
+    if (result.getCount() == 0) {
+        std::cout << "No matching log entries found.\n";
+        return;
     }
     
-    return matchCount;
+    const int MAX_GROUPS = 200;
+    char firstText[96];
+    char secondText[96];
+    char minText[20];
+    char maxText[20];
+    long long total = 0;
+    for (int i = 0; i < result.getCount(); i++) {
+        const GroupRow& row = result.getRow(i);
+        total += row.count;
+        if (i >= MAX_GROUPS) {
+            continue;
+        }
+        formatGroupKey(query.first, row.firstKey, firstText, sizeof(firstText));
+        std::cout << "[" << (i + 1) << "] " << firstText;
+        if (query.second != GROUP_NONE) {
+            formatGroupKey(query.second, row.secondKey, secondText, sizeof(secondText));
+            std::cout << " | " << secondText;
+        }
+        std::cout << " -> count " << row.count;
+        if (row.minValue != INVALID_EPOCH) {
+            formatTimestamp(row.minValue, minText);
+            formatTimestamp(row.maxValue, maxText);
+            std::cout << ", min " << minText << ", max " << maxText;
+        }
+        std::cout << ", first row " << (row.firstRow + 1) << ", last row " << (row.lastRow + 1) << "\n";
+        std::cout << "    last: " << logList.getMessage(row.lastRow) << "\n";
+    }
+    if (result.getCount() > MAX_GROUPS) {
+        std::cout << "... " << (result.getCount() - MAX_GROUPS) << " more groups\n";
+    }
+    std::cout << "\nGroups: " << result.getCount() << ", rows: " << total << "\n";
 }
 
-// Display logs containing a specific keyword
-void LogAnalyzer::displayLogsWithKeyword(const char* keyword, bool caseSensitive) const {
-    if (keyword == nullptr || strlen(keyword) == 0) {
-        std::cout << "Invalid keyword.\n";
+// Display logs matching a field filter
+void LogAnalyzer::displayLogsWhere(const char* filter) const {
+    METRIC_SCOPE(&metrics, TIMER_LOGS_WHERE);
+    std::lock_guard<std::mutex> guard(fieldLock);
+    FieldFilter filters[FieldStore::MAX_FILTERS];
+    int filterCount = 0;
+    if (filter == nullptr || !fields.parseFilter(filter, logList, stringPool, filters, filterCount)) {
+        return;
+    }
+    if (filterCount == 0) {
+        std::cout << "Invalid filter.\n";
         return;
     }
     
-    std::cout << "\n=== Logs containing \"" << keyword << "\" ===\n";
+    std::cout << "\n=== Logs where " << filter << " ===\n";
     
-    LogEntry* current = logList.getHead();
+    // Columns were extended to every stored row while parsing the filter
+    int total = filters[0].column->getRows();
     int foundCount = 0;
     int index = 1;
+    LogEntry entry;
     
-    while (current != nullptr) {
-        int count;
-        if (caseSensitive) {
-            count = kmpMatcher.search(current->message, keyword);
-        } else {
-            count = kmpMatcher.searchCaseInsensitive(current->message, keyword);
+    // Newest first, numbered like displayAllLogs()
+    for (int row = total - 1; row >= 0; row--, index++) {
+        int b = row >> LogList::BLOCK_BITS;
+        int i = row & (LogList::BLOCK_ROWS - 1);
+        bool matches = true;
+        for (int f = 0; f < filterCount && matches; f++) {
+            matches = fieldMatches(filters[f].column->getBlock(b)[i], filters[f].op, filters[f].operand);
         }
-        
-        if (count > 0) {
-            std::cout << "[" << index << "] " << current->timestamp 
-                      << " [" << current->log_level << "] " 
-                      << current->message << "\n";
+        if (matches) {
+            logList.getEntry(row, entry);
+            std::cout << "[" << index << "] " << entry.timestamp
+                      << " [" << entry.log_level << "] "
+                      << entry.message << "\n";
             foundCount++;
         }
-        current = current->next;
-        index++;
     }
     
     if (foundCount == 0) {
-        std::cout << "No logs found containing the keyword.\n";
+        std::cout << "No logs match the filter.\n";
     } else {
         std::cout << "\nTotal matching logs: " << foundCount << "\n";
     }
 }
 
+// Display per-group statistics of a numeric field
+void LogAnalyzer::displayFieldStats(const char* field, const char* filter, GroupDimension by) const {
+    METRIC_SCOPE(&metrics, TIMER_FIELD_STATS);
+    if (field == nullptr || strlen(field) == 0) {
+        std::cout << "Invalid field name.\n";
+        return;
+    }
+    
+    std::lock_guard<std::mutex> guard(fieldLock);
+    FieldFilter filters[FieldStore::MAX_FILTERS];
+    int filterCount = 0;
+    if (filter != nullptr && !fields.parseFilter(filter, logList, stringPool, filters, filterCount)) {
+        return;
+    }
+    
+    GroupByQuery query;
+    query.first = by;
+    query.fieldFilters = filters;
+    query.fieldFilterCount = filterCount;
+    query.valueField = fields.column(field, logList, stringPool);
+    GroupByResult result;
+    groupBy(query, result);
+    result.sort(by < GROUP_MINUTE);
+    
+    std::cout << "\n=== Statistics of " << field;
+    if (filterCount > 0) {
+        std::cout << " where " << filter;
+    }
+    std::cout << " ===\n";
+    if (result.getCount() == 0) {
+        std::cout << "No matching log entries found.\n";
+        return;
+    }
+    
+    const int MAX_GROUPS = 200;
+    char keyText[96];
+    long long withField = 0;
+    for (int i = 0; i < result.getCount(); i++) {
+        const GroupRow& row = result.getRow(i);
+        withField += row.fieldCount;
+        if (i >= MAX_GROUPS) {
+            continue;
+        }
+        if (by == GROUP_NONE) {
+            strcpy(keyText, "(all)");
+        } else {
+            formatGroupKey(by, row.firstKey, keyText, sizeof(keyText));
+        }
+        std::cout << "[" << (i + 1) << "] " << keyText << " -> rows " << row.count
+                  << ", with " << field << " " << row.fieldCount;
+        if (row.fieldCount > 0) {
+            std::cout << ", avg " << row.fieldSum / row.fieldCount << ", min " << row.fieldMin
+                      << ", max " << row.fieldMax << ", sum " << row.fieldSum;
+        }
+        std::cout << "\n";
+    }
+    if (result.getCount() > MAX_GROUPS) {
+        std::cout << "... " << (result.getCount() - MAX_GROUPS) << " more groups\n";
+    }
+    std::cout << "\nGroups: " << result.getCount() << ", rows with " << field << ": " << withField
+              << " (" << query.valueField->getParsedMessages() << " distinct messages parsed)\n";
+}
+
+unsigned int LogAnalyzer::findLevelId(const char* level) {
+    return stringPool.find(level);
+}
+
+// Collect the rows containing a keyword, reusing cached results
+void LogAnalyzer::matchKeyword(const char* keyword, bool caseSensitive, KeywordMatches& matches) const {
+    char* key = new char[strlen(keyword) + 1];
+    QueryCache::normalize(keyword, caseSensitive, key);
+    long long generation = dataGeneration;
+    int total = logList.getSize();
+    QueryCacheOutcome outcome = queryCache.lookup(key, caseSensitive, generation, matches);
+    KMPPattern pattern;
+    pattern.compile(key, caseSensitive);
+    long long scanned = 0;
+    if (outcome == QUERY_CACHE_NARROWED) {
+        // Keep the parent's rows that also contain the longer keyword
+        int kept = 0;
+        for (int i = 0; i < matches.count; i++) {
+            int count = pattern.count(logList.getMessage(matches.rows[i]));
+            if (count > 0) {
+                matches.rows[kept++] = matches.rows[i];
+                matches.occurrences += count;
+            }
+        }
+        scanned += matches.count;
+        matches.count = kept;
+        METRIC_COUNT(&metrics, COUNTER_QUERY_CACHE_NARROWED, 1);
+    } else if (outcome == QUERY_CACHE_HIT) {
+        METRIC_COUNT(&metrics, COUNTER_QUERY_CACHE_HITS, 1);
+    }
+    // Rows added since the cached result (every row on a miss)
+    for (int row = matches.watermark; row < total; row++) {
+        int count = pattern.count(logList.getMessage(row));
+        if (count > 0) {
+            matches.append(row);
+            matches.occurrences += count;
+        }
+    }
+    scanned += total - matches.watermark;
+    matches.watermark = total;
+    queryCache.store(key, caseSensitive, generation, matches);
+    METRIC_COUNT(&metrics, COUNTER_ROWS_SCANNED, scanned);
+    delete[] key;
+}
+
+// Search for a keyword in log messages using KMP
+int LogAnalyzer::searchKeyword(const char* keyword, bool caseSensitive) const {
+    METRIC_SCOPE(&metrics, TIMER_SEARCH_KEYWORD);
+    if (keyword == nullptr || strlen(keyword) == 0) {
+        return 0;
+    }
+    
+    KeywordMatches matches;
+    matchKeyword(keyword, caseSensitive, matches);
+    METRIC_COUNT(&metrics, COUNTER_KEYWORD_MATCHES, matches.occurrences);
+    return (int)matches.occurrences;
+}
+
+// Display logs containing a specific keyword
+void LogAnalyzer::displayLogsWithKeyword(const char* keyword, bool caseSensitive) const {
+    METRIC_SCOPE(&metrics, TIMER_DISPLAY_KEYWORD);
+    if (keyword == nullptr || strlen(keyword) == 0) {
+        std::cout << "Invalid keyword.\n";
+        return;
+    }
+    
+    std::cout << "\n=== Logs containing \"" << keyword << "\" ===\n";
+    
+    KeywordMatches matches;
+    matchKeyword(keyword, caseSensitive, matches);
+    LogEntry entry;
+    
+    // Newest first, numbered like displayAllLogs()
+    for (int i = matches.count - 1; i >= 0; i--) {
+        int row = matches.rows[i];
+        logList.getEntry(row, entry);
+        std::cout << "[" << (matches.watermark - row) << "] " << entry.timestamp 
+                  << " [" << entry.log_level << "] " 
+                  << entry.message << "\n";
+    }
+    
+    METRIC_COUNT(&metrics, COUNTER_KEYWORD_MATCHES, matches.count);
+    if (matches.count == 0) {
+        std::cout << "No logs found containing the keyword.\n";
+    } else {
+        std::cout << "\nTotal matching logs: " << matches.count << "\n";
+    }
+}
+
+// Find logs containing a keyword, newest first
+int LogAnalyzer::findLogsWithKeyword(const char* keyword, bool caseSensitive, int* rows, int maxRows) const {
+    METRIC_SCOPE(&metrics, TIMER_FIND_KEYWORD);
+    if (keyword == nullptr || keyword[0] == '\0') {
+        return 0;
+    }
+    KeywordMatches matches;
+    matchKeyword(keyword, caseSensitive, matches);
+    for (int i = 0; i < maxRows && i < matches.count; i++) {
+        rows[i] = matches.rows[matches.count - 1 - i];
+    }
+    return matches.count;
+}
+
+void LogAnalyzer::getQueryCacheStats(QueryCacheStats& stats) const {
+    queryCache.getStats(stats);
+}
+
+void LogAnalyzer::setQueryCacheEnabled(bool enabled) {
+    queryCache.setEnabled(enabled);
+}
+
+void LogAnalyzer::getLogEntry(int row, LogEntry& entry) const {
+    logList.getEntry(row, entry);
+}
+
+// Start a paged keyword search over the stored logs
+bool LogAnalyzer::openSearchCursor(const char* keyword, bool caseSensitive, bool newestFirst,
+                                   SearchCursor& cursor) const {
+    return cursor.open(keyword, caseSensitive, newestFirst, logList.getSize(), dataGeneration);
+}
+
+// Scan from the cursor until a page is full
+int LogAnalyzer::nextSearchPage(SearchCursor& cursor, int* rows, int maxRows) const {
+    METRIC_SCOPE(&metrics, TIMER_SEARCH_PAGE);
+    if (cursor.getGeneration() != dataGeneration) {
+        cursor.close();   // Row numbers refer to data that is gone
+        return 0;
+    }
+    int found = cursor.nextPage(logList, rows, maxRows);
+    METRIC_COUNT(&metrics, COUNTER_ROWS_SCANNED, cursor.getPageScanned());
+    METRIC_COUNT(&metrics, COUNTER_KEYWORD_MATCHES, found);
+    return found;
+}
+
+bool LogAnalyzer::searchCursorDone(const SearchCursor& cursor) const {
+    return cursor.getGeneration() != dataGeneration || cursor.isDone(logList);
+}
+
+// Display the next page of a cursor search
+int LogAnalyzer::displaySearchPage(SearchCursor& cursor, int pageSize) const {
+    if (pageSize < 1) {
+        pageSize = 1;
+    }
+    int* rows = new int[pageSize];
+    long long first = cursor.getMatched() + 1;
+    int count = nextSearchPage(cursor, rows, pageSize);
+    int total = logList.getSize();
+    LogEntry entry;
+    for (int i = 0; i < count; i++) {
+        // Numbered like displayAllLogs() (newest first)
+        logList.getEntry(rows[i], entry);
+        std::cout << "[" << (total - rows[i]) << "] " << entry.timestamp << " [" << entry.log_level << "] "
+                  << entry.message << "\n";
+    }
+    if (count > 0) {
+        std::cout << "\nMatches " << first << "-" << (first + count - 1) << ", " << cursor.getScanned()
+                  << " of " << total << " logs examined\n";
+    } else {
+        std::cout << "No more matching logs.\n";
+    }
+    delete[] rows;
+    return count;
+}
+
+// Start a sampled keyword count over the stored logs
+bool LogAnalyzer::startApproximateSearch(const char* keyword, bool caseSensitive, ApproximateSearch& search,
+                                         unsigned long long seed, double confidence) const {
+    return search.start(keyword, caseSensitive, logList.getSize(), dataGeneration, seed, confidence);
+}
+
+// Scan more sample units and re-estimate
+int LogAnalyzer::refineApproximateSearch(ApproximateSearch& search, int units, ApproxEstimate& estimate) const {
+    METRIC_SCOPE(&metrics, TIMER_APPROXIMATE_SEARCH);
+    int scanned = 0;
+    if (search.getGeneration() == dataGeneration) {
+        scanned = search.refine(logList, units);
+        METRIC_COUNT(&metrics, COUNTER_ROWS_SCANNED, search.getRefinedRows());
+    }
+    search.getEstimate(estimate);
+    return scanned;
+}
+
+// Display a sampled keyword count
+void LogAnalyzer::displayApproximateEstimate(const ApproxEstimate& estimate) const {
+    char line[256];
+    double percent = estimate.totalLogs > 0 ? 100.0 * estimate.sampledLogs / estimate.totalLogs : 100.0;
+    snprintf(line, sizeof(line), "Sampled %5.1f%% (%lld of %lld logs): ", percent, estimate.sampledLogs,
+             estimate.totalLogs);
+    std::cout << line;
+    if (estimate.exact) {
+        snprintf(line, sizeof(line), "%.0f logs contain the keyword, %.0f occurrences (exact)", estimate.logs,
+                 estimate.occurrences);
+    } else if (estimate.sampledUnits < 2) {
+        snprintf(line, sizeof(line), "too few logs sampled to estimate");
+    } else {
+        snprintf(line, sizeof(line), "~%.0f logs (%.0f%% CI %.0f-%.0f), ~%.0f occurrences (%.0f-%.0f)",
+                 estimate.logs, estimate.confidence * 100.0, estimate.logsLow, estimate.logsHigh,
+                 estimate.occurrences, estimate.occurrencesLow, estimate.occurrencesHigh);
+    }
+    std::cout << line << "\n";
+}
+
+// Register a saved search and match the logs already stored
+int LogAnalyzer::addSavedSearch(const char* keyword, bool caseSensitive, SavedSearchCallback callback,
+                                void* context) {
+    std::lock_guard<std::mutex> guard(ingestLock);
+    int id = savedSearches.add(keyword, caseSensitive, callback, context);
+    if (id >= 0) {
+        matchStoredRows(id);
+    }
+    return id;
+}
+
+bool LogAnalyzer::removeSavedSearch(int id) {
+    std::lock_guard<std::mutex> guard(ingestLock);
+    return savedSearches.remove(id);
+}
+
+bool LogAnalyzer::getSavedSearch(int id, SavedSearchStatus& status) const {
+    std::lock_guard<std::mutex> guard(ingestLock);
+    return savedSearches.getStatus(id, status);
+}
+
+int LogAnalyzer::getSavedSearchRows(int id, int* rows, int maxRows, int skip) const {
+    std::lock_guard<std::mutex> guard(ingestLock);
+    return savedSearches.getRows(id, rows, maxRows, skip);
+}
+
+// Match every stored row against one saved search
+void LogAnalyzer::matchStoredRows(int searchId) {
+    int total = logList.getSize();
+    for (int row = 0; row < total; row++) {
+        savedSearches.matchExisting(searchId, row, logList.getMessage(row));
+    }
+    METRIC_COUNT(&metrics, COUNTER_ROWS_SCANNED, total);
+}
+
+// Display every saved search with its counts
+void LogAnalyzer::displaySavedSearches() const {
+    std::cout << "\n=== Saved Searches ===\n";
+    int shown = 0;
+    SavedSearchStatus status;
+    LogEntry entry;
+    for (int id = 0; id < SavedSearchSet::MAX_SEARCHES; id++) {
+        if (!getSavedSearch(id, status)) {
+            continue;
+        }
+        std::cout << "[" << id << "] \"" << status.keyword << "\"" << (status.caseSensitive ? "" : " (any case)")
+                  << ": " << status.matchingLogs << " logs, " << status.occurrences << " occurrences";
+        if (status.lastRow >= 0) {
+            logList.getEntry(status.lastRow, entry);
+            std::cout << ", newest " << entry.timestamp;
+        }
+        std::cout << "\n";
+        shown++;
+    }
+    if (shown == 0) {
+        std::cout << "No saved searches.\n";
+    }
+}
+
+// Display the newest logs matched by a saved search
+void LogAnalyzer::displaySavedSearchLogs(int id, int maxRows) const {
+    SavedSearchStatus status;
+    if (!getSavedSearch(id, status)) {
+        std::cout << "No saved search " << id << ".\n";
+        return;
+    }
+    if (maxRows < 1) {
+        maxRows = 1;
+    }
+    int* rows = new int[maxRows];
+    int count = getSavedSearchRows(id, rows, maxRows);
+    std::cout << "\n=== Newest logs containing \"" << status.keyword << "\" ===\n";
+    LogEntry entry;
+    int total = logList.getSize();
+    for (int i = 0; i < count; i++) {
+        // Numbered like displayAllLogs() (newest first)
+        logList.getEntry(rows[i], entry);
+        std::cout << "[" << (total - rows[i]) << "] " << entry.timestamp << " [" << entry.log_level << "] "
+                  << entry.message << "\n";
+    }
+    std::cout << "\nShowing " << count << " of " << status.matchingLogs << " matching logs\n";
+    delete[] rows;
+}
+
+// Display operation timings and counters
+void LogAnalyzer::displayMetrics() const {
+    std::cout << "\n=== Performance Metrics ===\n";
+    metrics.print(std::cout);
+}
+
+void LogAnalyzer::resetMetrics() {
+    metrics.reset();
+}
+
+// Answer one query server request
+unsigned char LogAnalyzer::serveQuery(void* context, const QueryRequest& request, QueryBuffer& response) {
+    const LogAnalyzer* analyzer = (const LogAnalyzer*)context;
+    METRIC_SCOPE(&analyzer->metrics, TIMER_SERVE_QUERY);
+    bool caseSensitive = (request.flags & QUERY_CASE_INSENSITIVE) == 0;
+    if ((request.op == QUERY_SEARCH || request.op == QUERY_LOGS) && request.argumentLength == 0) {
+        response.append("missing keyword");
+        return QUERY_BAD_REQUEST;
+    }
+    
+    switch (request.op) {
+        case QUERY_PING:
+            response.append("pong\n");
+            return QUERY_OK;
+            
+        case QUERY_STATS:
+            response.append("logs ");
+            response.appendNumber(analyzer->getTotalLogs());
+            response.append("\nunique_errors ");
+            response.appendNumber(analyzer->getErrorCount());
+            response.append("\nerror_templates ");
+            response.appendNumber(analyzer->getErrorTemplateCount());
+            response.append("\ntemplates ");
+            response.appendNumber(analyzer->getTemplateCount());
+            response.append("\n");
+            return QUERY_OK;
+            
+        case QUERY_SEARCH:
+            response.appendNumber(analyzer->searchKeyword(request.argument, caseSensitive));
+            response.append("\n");
+            return QUERY_OK;
+            
+        case QUERY_LOGS: {
+            int limit = request.limit > 0 ? request.limit : 20;
+            int* rows = new int[limit];
+            int found = analyzer->findLogsWithKeyword(request.argument, caseSensitive, rows, limit);
+            response.append("total ");
+            response.appendNumber(found);
+            response.append("\n");
+            LogEntry entry;
+            for (int i = 0; i < found && i < limit; i++) {
+                analyzer->getLogEntry(rows[i], entry);
+                response.append(entry.timestamp);
+                response.append(" [");
+                response.append(entry.log_level);
+                response.append("] ");
+                response.append(entry.message);
+                response.append("\n");
+            }
+            delete[] rows;
+            return QUERY_OK;
+        }
+        
+        case QUERY_ERRORS: {
+            int limit = request.limit > 0 ? request.limit : 10;
+            TopKEntry* entries = new TopKEntry[limit];
+            int found;
+            if (request.flags & QUERY_BY_TEMPLATE) {
+                found = analyzer->topErrorTemplates(limit, entries);
+            } else {
+                found = analyzer->topErrors(limit, (request.flags & QUERY_APPROXIMATE) == 0, entries);
+            }
+            for (int i = 0; i < found; i++) {
+                response.appendNumber(entries[i].count);
+                response.append("\t");
+                response.append(entries[i].key);
+                response.append("\n");
+            }
+            delete[] entries;
+            return QUERY_OK;
+        }
+    }
+    response.append("unknown request");
+    return QUERY_BAD_REQUEST;
+}
+
+// Serve queries until stopped
+bool LogAnalyzer::serve(const char* socketPath, const QueryServerConfig& config) {
+    QueryServer server(config);
+    std::cout << "Serving " << logList.getSize() << " logs on " << socketPath
+              << " (Ctrl+C to stop)\n";
+    if (!server.run(socketPath, serveQuery, this)) {
+        return false;
+    }
+    const QueryServerStats& stats = server.getStats();
+    std::cout << "Server stopped: " << stats.requests << " requests from " << stats.connections
+              << " connections";
+    if (stats.rejected > 0 || stats.badFrames > 0) {
+        std::cout << " (" << stats.rejected << " refused, " << stats.badFrames << " bad frames)";
+    }
+    std::cout << "\n";
+    return true;
+}
+
+// Receive syslog messages until stopped
+bool LogAnalyzer::listenSyslog(const SyslogConfig& config, SyslogStats& stats) {
+    SyslogListener listener(config);
+    std::cout << "Receiving syslog messages on";
+    if (config.datagramPath[0] != '\0') {
+        std::cout << " " << config.datagramPath;
+    }
+    if (config.streamPath[0] != '\0') {
+        std::cout << " " << config.streamPath << " (stream)";
+    }
+    if (config.udpPort > 0) {
+        std::cout << " 127.0.0.1:" << config.udpPort << " (UDP)";
+    }
+    std::cout << " (Ctrl+C to stop)\n";
+    PendingCommit pending = { this, 0, 0 };
+    if (!listener.run(ingestRecord, &pending, flushRecords)) {
+        return false;
+    }
+    stats = listener.getStats();
+    METRIC_COUNT(&metrics, COUNTER_SYSLOG_MESSAGES, stats.received);
+    METRIC_COUNT(&metrics, COUNTER_SYSLOG_DROPPED, stats.dropped + stats.kernelDropped);
+    std::cout << "Received " << stats.received << " syslog messages (" << stats.bytes << " bytes) in "
+              << stats.seconds << " s, added " << stats.ingested << "\n";
+    if (stats.dropped > 0 || stats.kernelDropped > 0) {
+        std::cout << "  Dropped " << stats.dropped << " with the ingest queue full, " << stats.kernelDropped
+                  << " in the kernel\n";
+    }
+    if (stats.malformed > 0 || stats.truncated > 0) {
+        std::cout << "  " << stats.malformed << " without a <PRI> header, " << stats.truncated << " truncated\n";
+    }
+    return true;
+}
+
+// Collect the memory held by each data structure
+void LogAnalyzer::getMemoryReport(MemoryReport& report) {
+    stringPool.addMemoryUsage(report.part("String pool"));
+    templateMiner.addMemoryUsage(report.part("Message templates"));
+    errorTable.addMemoryUsage(report.part("Error counts"));
+    templateErrorTable.addMemoryUsage(report.part("Error counts"));
+    {
+        std::lock_guard<std::mutex> guard(fieldLock);
+        fields.addMemoryUsage(report.part("Field columns"));
+    }
+    {
+        std::lock_guard<std::mutex> guard(ingestLock);
+        savedSearches.addMemoryUsage(report.part("Saved searches"));
+    }
+    queryCache.addMemoryUsage(report.part("Query cache"));
+    metrics.addMemoryUsage(report.part("Metrics"));
+    if (wal != nullptr) {
+        MemoryUsage& usage = report.part("Write-ahead log");
+        usage.addHeap(sizeof(WriteAheadLog), 0, sizeof(WriteAheadLog));
+        wal->addMemoryUsage(usage);
+    }
+    
+    // Single-writer structures are read under the ingest lock
+    std::lock_guard<std::mutex> guard(ingestLock);
+    logList.addMemoryUsage(report.part("Log columns"));
+    errorHeavyHitters.addMemoryUsage(report.part("Heavy hitters"));
+    timeHistogram.addMemoryUsage(report.part("Time histogram"));
+    if (sketches != nullptr) {
+        MemoryUsage& usage = report.part("Sketches");
+        usage.addHeap(sizeof(LogSketches), 0, sizeof(LogSketches));
+        sketches->addMemoryUsage(usage);
+    }
+    // Fixed-size members: shard headers, directories and scratch arrays
+    report.part("Analyzer object").addInline(0, sizeof(LogAnalyzer));
+    report.rows = logList.getSize();
+}
+
+// Print one row of the memory table
+static void printMemoryRow(const char* name, const MemoryUsage& usage, long long total, long long rows) {
+    char line[160];
+    snprintf(line, sizeof(line), "%-18s %12lld %12lld %12lld %12lld %6.1f%% %9.1f\n", name,
+             usage.payload, usage.overhead, usage.fragmentation, usage.total(),
+             total > 0 ? 100.0 * usage.total() / total : 0.0,
+             rows > 0 ? (double)usage.total() / rows : 0.0);
+    std::cout << line;
+}
+
+// Display the memory breakdown
+void LogAnalyzer::displayMemoryUsage() {
+    MemoryReport report;
+    getMemoryReport(report);
+    MemoryUsage total = report.total();
+    
+    std::cout << "\n=== Memory Usage ===\n";
+    char line[160];
+    snprintf(line, sizeof(line), "%-18s %12s %12s %12s %12s %7s %9s\n", "structure", "payload",
+             "overhead", "fragmented", "total", "share", "B/row");
+    std::cout << line;
+    for (int i = 0; i < report.partCount; i++) {
+        printMemoryRow(report.names[i], report.parts[i], total.total(), report.rows);
+    }
+    printMemoryRow("Total", total, total.total(), report.rows);
+    std::cout << "Rows: " << report.rows << ", heap allocations: " << total.allocations << "\n";
+    if (total.mapped > 0) {
+        std::cout << "Mapped from snapshot: " << total.mapped << " bytes in use ("
+                  << snapshotFile.getMappedSize() << " bytes mapped)\n";
+    }
+    
+    // What the allocator and the kernel see, to expose memory not accounted above
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 heap = mallinfo2();
+    long long inUse = (long long)(heap.uordblks + heap.hblkhd);
+    std::cout << "Allocator: " << inUse << " bytes in use (" << inUse - total.total()
+              << " not accounted above), " << (long long)heap.fordblks << " bytes free in the heap\n";
+#endif
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm != nullptr) {
+        long long pages = 0;
+        long long residentPages = 0;
+        if (fscanf(statm, "%lld %lld", &pages, &residentPages) == 2) {
+            std::cout << "Resident set: " << residentPages * sysconf(_SC_PAGESIZE) << " bytes\n";
+        }
+        fclose(statm);
+    }
+}
+
 // Get statistics
 int LogAnalyzer::getTotalLogs() const {
     return logList.getSize();
@@ -109,10 +1158,485 @@ int LogAnalyzer::getErrorCount() const {
     return errorTable.getTotalEntries();
 }
 
+int LogAnalyzer::getErrorTemplateCount() const {
+    return templateErrorTable.getTotalEntries();
+}
+
+int LogAnalyzer::getTemplateCount() const {
+    return templateMiner.getTemplateCount();
+}
+
+void LogAnalyzer::getStringPoolStats(PoolStats& stats) {
+    stringPool.getStats(stats);
+}
+
+// Snapshot label resolvers for restored hash table and heavy-hitter keys
+static const char* poolLabel(const void* context, unsigned int id) {
+    const StringPool* pool = (const StringPool*)context;
+    return pool->contains(id) ? pool->lookup(id) : nullptr;
+}
+
+static const char* templateLabel(const void* context, unsigned int id) {
+    const TemplateMiner* miner = (const TemplateMiner*)context;
+    return id < (unsigned int)miner->getTemplateCount() ? miner->getText(id) : nullptr;
+}
+
+// Save all state to a snapshot file
+bool LogAnalyzer::saveSnapshot(const char* path) {
+    METRIC_SCOPE(&metrics, TIMER_SNAPSHOT_SAVE);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> guard(ingestLock);
+    SnapshotWriter writer;
+    if (!writer.open(path)) {
+        std::cout << "Cannot create snapshot " << path << "\n";
+        return false;
+    }
+    
+    writer.beginSection(SNAPSHOT_STRING_POOL);
+    stringPool.saveTo(writer);
+    writer.endSection();
+    writer.beginSection(SNAPSHOT_LOG_STORE);
+    logList.saveTo(writer);
+    writer.endSection();
+    writer.beginSection(SNAPSHOT_TEMPLATES);
+    templateMiner.saveTo(writer);
+    writer.endSection();
+    writer.beginSection(SNAPSHOT_ERROR_COUNTS);
+    errorTable.saveTo(writer);
+    writer.endSection();
+    writer.beginSection(SNAPSHOT_TEMPLATE_ERROR_COUNTS);
+    templateErrorTable.saveTo(writer);
+    writer.endSection();
+    writer.beginSection(SNAPSHOT_HEAVY_HITTERS);
+    errorHeavyHitters.saveTo(writer);
+    writer.endSection();
+    writer.beginSection(SNAPSHOT_TIME_HISTOGRAM);
+    timeHistogram.saveTo(writer);
+    writer.endSection();
+    writer.beginSection(SNAPSHOT_WAL_POSITION);
+    writer.writeU64(appliedSequence);
+    writer.endSection();
+    
+    if (!writer.finish()) {
+        std::cout << "Failed to write snapshot " << path << "\n";
+        return false;
+    }
+    unsigned long long bytes = writer.getBytesWritten();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Snapshot saved: " << logList.getSize() << " logs, " << bytes << " bytes in "
+              << ms << " ms\n";
+    return true;
+}
+
+// Load all state from a snapshot file
+bool LogAnalyzer::loadSnapshot(const char* path) {
+    METRIC_SCOPE(&metrics, TIMER_SNAPSHOT_LOAD);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    clearState();
+    stringPool.clear();  // Drop the level names clearState() re-interned; IDs come from the file
+    if (!snapshotFile.open(path)) {
+        internKnownLevels();
+        return false;
+    }
+    
+    // The pool and templates must be restored before anything whose IDs are checked against them
+    SnapshotCursor cursor;
+    bool ok = snapshotFile.openSection(SNAPSHOT_STRING_POOL, cursor) && stringPool.loadFrom(cursor) &&
+              snapshotFile.openSection(SNAPSHOT_TEMPLATES, cursor) && templateMiner.loadFrom(cursor) &&
+              snapshotFile.openSection(SNAPSHOT_LOG_STORE, cursor) &&
+              logList.loadFrom(cursor, templateMiner.getTemplateCount()) &&
+              snapshotFile.openSection(SNAPSHOT_ERROR_COUNTS, cursor) &&
+              errorTable.loadFrom(cursor, poolLabel, &stringPool) &&
+              snapshotFile.openSection(SNAPSHOT_TEMPLATE_ERROR_COUNTS, cursor) &&
+              templateErrorTable.loadFrom(cursor, templateLabel, &templateMiner) &&
+              snapshotFile.openSection(SNAPSHOT_HEAVY_HITTERS, cursor) &&
+              errorHeavyHitters.loadFrom(cursor, poolLabel, &stringPool) &&
+              snapshotFile.openSection(SNAPSHOT_TIME_HISTOGRAM, cursor) &&
+              timeHistogram.loadFrom(cursor, templateMiner.getTemplateCount());
+    if (!ok) {
+        std::cout << "Cannot load snapshot: section missing or corrupt\n";
+        clearState();
+        return false;
+    }
+    // WAL records up to this sequence are already in the snapshot (optional section)
+    if (snapshotFile.openSection(SNAPSHOT_WAL_POSITION, cursor)) {
+        unsigned long long covered = cursor.readU64();
+        if (covered > appliedSequence) {
+            appliedSequence = covered;
+        }
+    }
+    internKnownLevels();
+    if (sketches != nullptr) {
+        // Rebuild enabled sketches from the restored logs
+        SketchConfig config = sketches->getConfig();
+        disableSketches();
+        enableSketches(config);
+    }
+    for (int id = 0; id < SavedSearchSet::MAX_SEARCHES; id++) {
+        if (savedSearches.exists(id)) {
+            matchStoredRows(id);
+        }
+    }
+    
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Snapshot loaded: " << logList.getSize() << " logs, " << snapshotFile.getMappedSize()
+              << " bytes mapped in " << ms << " ms\n";
+    if (wal != nullptr) {
+        checkpoint();  // The loaded state replaces what the WAL describes
+    }
+    return true;
+}
+
+// Wait while a checkpoint holds the gate, then register an in-flight addLog()
+void LogAnalyzer::enterIngest() {
+    while (true) {
+        ingestInFlight.fetch_add(1);
+        if (!ingestPaused.load()) {
+            return;
+        }
+        ingestInFlight.fetch_sub(1);
+        std::unique_lock<std::mutex> guard(gateLock);
+        while (ingestPaused.load()) {
+            gateSignal.wait(guard);
+        }
+    }
+}
+
+void LogAnalyzer::leaveIngest() {
+    ingestInFlight.fetch_sub(1);
+}
+
+// Block new addLog() calls and wait for running ones to finish
+void LogAnalyzer::pauseIngest() {
+    ingestPaused.store(true);
+    while (ingestInFlight.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void LogAnalyzer::resumeIngest() {
+    {
+        std::lock_guard<std::mutex> guard(gateLock);
+        ingestPaused.store(false);
+    }
+    gateSignal.notify_all();
+}
+
+// Apply one WAL record during recovery, skipping those the snapshot covers
+void LogAnalyzer::replayRecord(void* context, const WalRecord& record) {
+    LogAnalyzer* analyzer = (LogAnalyzer*)context;
+    if (record.sequence <= analyzer->appliedSequence) {
+        return;
+    }
+    analyzer->ingest(record.timestamp, record.level, record.message, nullptr);
+    analyzer->appliedSequence = record.sequence;
+}
+
+// Add one entry from LogIngestor or SyslogListener
+void LogAnalyzer::ingestRecord(void* context, const char* timestamp, const char* level, const char* message) {
+    PendingCommit* pending = (PendingCommit*)context;
+    pending->analyzer->addPending(*pending, timestamp, level, message);
+}
+
+void LogAnalyzer::flushRecords(void* context) {
+    PendingCommit* pending = (PendingCommit*)context;
+    pending->analyzer->commitPending(*pending);
+}
+
+// Ingest a directory or glob of log files in timestamp order
+long long LogAnalyzer::ingestFiles(const char* pattern, const IngestConfig& config, IngestStats& stats) {
+    METRIC_SCOPE(&metrics, TIMER_INGEST_FILES);
+    IngestConfig timed = config;
+    if (timed.metrics == nullptr) {
+        timed.metrics = &metrics;
+    }
+    LogIngestor ingestor(timed);
+    PendingCommit pending = { this, 0, 0 };
+    long long entries = ingestor.run(pattern, ingestRecord, &pending, stats);
+    commitPending(pending);
+    METRIC_COUNT(&metrics, COUNTER_INGEST_BYTES, stats.bytes);
+    METRIC_COUNT(&metrics, COUNTER_CONTINUATION_LINES, stats.continuationLines);
+    if (stats.files == 0) {
+        std::cout << "No files match " << pattern << "\n";
+        return 0;
+    }
+    std::cout << "Ingested " << entries << " entries from " << stats.files << " files ("
+              << stats.bytes << " bytes, " << stats.ioBackend << " reads) in "
+              << stats.seconds * 1000.0 << " ms\n";
+    if (stats.continuationLines > 0) {
+        std::cout << "  " << stats.continuationLines << " continuation lines folded into their entries\n";
+    }
+    if (stats.outOfOrder > 0) {
+        std::cout << "  " << stats.outOfOrder << " entries out of order by more than the reorder window\n";
+    }
+    if (stats.failedFiles > 0) {
+        std::cout << "  " << stats.failedFiles << " files could not be read\n";
+    }
+    return entries;
+}
+
+// A stream that ends at end of input or when SIGINT or SIGTERM arrives
+struct StoppableStream {
+    int fd;
+    int signalFd;              // -1 if the signalfd could not be created
+    bool stopped;
+};
+
+// LineSource: wait for input or a stop signal, whichever comes first
+static ssize_t readUntilStopped(void* context, char* into, size_t size) {
+    StoppableStream* stream = (StoppableStream*)context;
+    if (stream->signalFd >= 0) {
+        struct pollfd watched[2] = { { stream->fd, POLLIN, 0 }, { stream->signalFd, POLLIN, 0 } };
+        int ready;
+        do {
+            ready = poll(watched, 2, -1);
+        } while (ready < 0 && errno == EINTR);
+        if (ready > 0 && (watched[1].revents & POLLIN) != 0) {
+            stream->stopped = true;
+            return 0;
+        }
+    }
+    ssize_t got;
+    do {
+        got = read(stream->fd, into, size);
+    } while (got < 0 && errno == EINTR);
+    return got;
+}
+
+// Ingest a stream line by line, reading ahead on a second buffer
+// SIGINT and SIGTERM are taken through a signalfd while reading (before the
+// prefetch thread starts, so it inherits the mask) and end the stream like
+// end of input: the held-back last entry is still added.
+long long LogAnalyzer::ingestStream(int fd, const JsonFormat* jsonFormat) {
+    METRIC_SCOPE(&metrics, TIMER_INGEST_STREAM);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    sigset_t stopSignals;
+    sigset_t previousMask;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previousMask);
+    StoppableStream stream = { fd, signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC), false };
+    LineReader reader(readUntilStopped, &stream, 1 << 20, true);
+    JsonLineParser json(jsonFormat != nullptr ? *jsonFormat : JsonFormat());
+    LogLineAssembler assembler(jsonFormat != nullptr ? JsonLineParser::parseLine : nullptr, &json);
+    PendingCommit pending = { this, 0, 0 };
+    long long entries = 0;
+    char* line;
+    size_t length;
+    while (reader.next(line, length)) {
+        if (assembler.addLine(line, length)) {
+            const AssembledEntry& entry = assembler.entry();
+            addPending(pending, entry.timestamp, entry.level, entry.message);
+            entries++;
+        }
+        // Commit before a read that may wait for more input
+        if (reader.isDrained()) {
+            commitPending(pending);
+        }
+    }
+    if (assembler.finish()) {
+        const AssembledEntry& entry = assembler.entry();
+        addPending(pending, entry.timestamp, entry.level, entry.message);
+        entries++;
+    }
+    commitPending(pending);
+    if (stream.signalFd >= 0) {
+        struct signalfd_siginfo info;
+        while (read(stream.signalFd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+            // Consume the signal, or it is delivered when the mask is restored
+        }
+        close(stream.signalFd);
+    }
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+    
+    METRIC_COUNT(&metrics, COUNTER_INGEST_BYTES, reader.getBytesRead());
+    METRIC_COUNT(&metrics, COUNTER_CONTINUATION_LINES, assembler.getContinuationLines());
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Ingested " << entries << " entries (" << reader.getBytesRead() << " bytes) in "
+              << ms << " ms" << (stream.stopped ? " (stopped by signal)" : "") << "\n";
+    if (assembler.getContinuationLines() > 0) {
+        std::cout << "  " << assembler.getContinuationLines() << " continuation lines folded into their entries\n";
+    }
+    return entries;
+}
+
+// State for sorting log files: entries go into the sorter, sorted lines to the output
+struct FileSortState {
+    ExternalSorter* sorter;
+    FILE* output;
+    bool ok;
+};
+
+// Sort each entry's original lines (entries without a timestamp sort with the one before)
+static void addToSort(void* context, long long sortKey, const char* text, size_t length) {
+    FileSortState* state = (FileSortState*)context;
+    if (state->ok && !state->sorter->add(sortKey, text, (unsigned int)length)) {
+        state->ok = false;
+    }
+}
+
+static void writeSortedLine(void* context, long long, const char* payload, unsigned int length) {
+    FileSortState* state = (FileSortState*)context;
+    fwrite(payload, 1, length, state->output);
+    fputc('\n', state->output);
+}
+
+// Sort log files by timestamp into one output file
+bool LogAnalyzer::sortLogFiles(const char* pattern, const char* outputPath, size_t memoryLimit,
+                               const JsonFormat* jsonFormat) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FILE* output = fopen(outputPath, "w");
+    if (output == nullptr) {
+        std::cout << "Cannot create " << outputPath << "\n";
+        return false;
+    }
+    setvbuf(output, nullptr, _IOFBF, 1 << 20);
+    
+    ExternalSorter sorter(memoryLimit);
+    FileSortState state = { &sorter, output, true };
+    IngestConfig config;
+    config.jsonFormat = jsonFormat;
+    LogIngestor ingestor(config);
+    IngestStats stats;
+    ingestor.runRaw(pattern, addToSort, &state, stats);
+    bool ok = stats.files > 0 && state.ok && sorter.finish(writeSortedLine, &state);
+    ok = fclose(output) == 0 && ok;
+    if (stats.files == 0) {
+        std::cout << "No files match " << pattern << "\n";
+        return false;
+    }
+    if (!ok) {
+        std::cout << "Sorting failed; " << outputPath << " is incomplete\n";
+        return false;
+    }
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Sorted " << sorter.getRecordCount() << " entries from " << stats.files << " files ("
+              << stats.bytes << " bytes) into " << outputPath << " in " << seconds << " s";
+    if (sorter.getRunCount() > 0) {
+        std::cout << " using " << sorter.getRunCount() << " runs (" << sorter.getSpilledBytes()
+                  << " bytes spilled";
+        if (sorter.getMergePassCount() > 0) {
+            std::cout << ", " << sorter.getMergePassCount() << " intermediate merges";
+        }
+        std::cout << ")";
+    }
+    std::cout << "\n";
+    return true;
+}
+
+// Recover from the snapshot and WAL tail, then log all further entries
+bool LogAnalyzer::enableDurability(const char* logPath, const char* snapshotPath, const WalConfig& config) {
+    disableDurability();
+    if (strlen(logPath) >= sizeof(walPath) || strlen(snapshotPath) >= sizeof(checkpointPath)) {
+        std::cout << "Path too long.\n";
+        return false;
+    }
+    
+    bool haveSnapshot = access(snapshotPath, F_OK) == 0;
+    bool haveLog = access(logPath, F_OK) == 0;
+    if (haveSnapshot) {
+        if (!loadSnapshot(snapshotPath)) {
+            return false;
+        }
+    } else if (haveLog) {
+        clearState();
+    }
+    
+    // Replay only the records newer than the snapshot
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long long before = logList.getSize();
+    unsigned long long lastSequence = 0;
+    if (WriteAheadLog::replay(logPath, replayRecord, this, lastSequence) < 0) {
+        std::cout << "Cannot recover: " << logPath << " is not a write-ahead log\n";
+        return false;
+    }
+    if (haveLog) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "WAL: replayed " << (logList.getSize() - before) << " entries in " << ms << " ms\n";
+    }
+    
+    unsigned long long nextSequence = (lastSequence > appliedSequence ? lastSequence : appliedSequence) + 1;
+    wal = new WriteAheadLog();
+    if (!wal->open(logPath, config, nextSequence) || (!haveLog && !syncParentDirectory(logPath))) {
+        std::cout << "Cannot open write-ahead log " << logPath << "\n";
+        delete wal;
+        wal = nullptr;
+        return false;
+    }
+    strcpy(walPath, logPath);
+    strcpy(checkpointPath, snapshotPath);
+    walConfig = config;
+    recordsSinceCheckpoint.store(0);
+    
+    // Existing in-memory data is not in the log yet
+    if (!haveSnapshot && !haveLog && logList.getSize() > 0) {
+        return checkpoint();
+    }
+    return true;
+}
+
+// Flush and close the write-ahead log
+void LogAnalyzer::disableDurability() {
+    if (wal != nullptr) {
+        wal->close();
+        delete wal;
+        wal = nullptr;
+    }
+}
+
+bool LogAnalyzer::durabilityEnabled() const {
+    return wal != nullptr;
+}
+
+long long LogAnalyzer::getWalSyncCount() {
+    return wal != nullptr ? wal->getSyncCount() : 0;
+}
+
+// Snapshot the current state and truncate the WAL it now covers
+bool LogAnalyzer::checkpoint() {
+    METRIC_SCOPE(&metrics, TIMER_CHECKPOINT);
+    if (wal == nullptr) {
+        return false;
+    }
+    pauseIngest();
+    // Truncate only once the snapshot and its directory entry are on disk
+    bool ok = wal->sync() && saveSnapshot(checkpointPath) && wal->truncate();
+    recordsSinceCheckpoint.store(0);
+    resumeIngest();
+    if (!ok) {
+        std::cout << "Checkpoint failed; the write-ahead log is kept\n";
+    }
+    return ok;
+}
+
 // Clear all data
 void LogAnalyzer::clearAll() {
+    clearState();
+    if (wal != nullptr) {
+        checkpoint();  // Persist the empty state
+    }
+}
+
+// Clear every in-memory structure and release the mapped snapshot
+void LogAnalyzer::clearState() {
     logList.clear();
     errorTable.clear();
+    errorHeavyHitters.clear();
+    timeHistogram.clear();
+    templateErrorTable.clear();
+    templateMiner.clear();
+    fields.clear();  // Columns are keyed by row and message ID
+    savedSearches.reset();  // Searches stay registered; their results are gone
+    dataGeneration++;       // Retires cached query results
+    queryCache.clear();
+    stringPool.clear();
+    internKnownLevels();
+    if (sketches != nullptr) {
+        sketches->clear();
+    }
+    snapshotFile.close();
 }
 
 // Load sample data for testing
@@ -141,3 +1665,19 @@ void LogAnalyzer::loadSampleData() {
     std::cout << "   Total logs: " << getTotalLogs() << "\n";
     std::cout << "   Unique errors: " << getErrorCount() << "\n";
 }
+
+void LogAnalyzer::loadGeneratedData(const GeneratorConfig& config) {
+    clearAll();
+    
+    LogGenerator generator(config);
+    GeneratedEntry entry;
+    PendingCommit pending = { this, 0, 0 };
+    while (generator.next(entry)) {
+        addPending(pending, entry.timestamp, entry.level, entry.message);
+    }
+    commitPending(pending);
+    
+    std::cout << "\n✓ Generated data loaded (seed " << config.seed << ")\n";
+    std::cout << "   Total logs: " << getTotalLogs() << "\n";
+    std::cout << "   Unique errors: " << getErrorCount() << "\n";
+}
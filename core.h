@@ -4,18 +4,135 @@
 #include "log_list.h"
 #include "hash_table.h"
 #include "kmp.h"
+#include "string_pool.h"
+#include "template_miner.h"
+#include "space_saving.h"
+#include "sketches.h"
+#include "time_histogram.h"
+#include "concurrent_table.h"
+#include "group_by.h"
+#include "snapshot.h"
+#include "wal.h"
+#include "log_ingest.h"
+#include "external_sort.h"
+#include "field_store.h"
+#include "log_generator.h"
+#include "metrics.h"
+#include "query_server.h"
+#include "syslog_listener.h"
+#include "saved_search.h"
+#include "query_cache.h"
+#include "search_cursor.h"
+#include "approx_search.h"
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 // Core application logic - completely independent of UI
 class LogAnalyzer {
 private:
-    LogList logList;           // Linked list to store all log entries
-    HashTable errorTable;      // Hash table to count ERROR frequency
-    KMP kmpMatcher;            // KMP pattern matcher
+    SnapshotReader snapshotFile;   // Mapped snapshot backing loaded data (declared first so it outlives it)
+    StringPool stringPool;     // Interned timestamp, level and message text
+    LogList logList;           // Columnar store of all log entries
+    ShardedCountTable errorTable;  // Hash table to count ERROR frequency (by message)
+    TemplateMiner templateMiner;   // Groups messages into templates
+    ShardedCountTable templateErrorTable;  // Hash table to count ERROR frequency (by template)
+    SpaceSaving errorHeavyHitters; // Fixed-memory top-K summary of ERROR messages
+    LogSketches* sketches;     // Optional distinct/frequency sketches (nullptr when off)
+    TimeHistogram timeHistogram;   // Per-level and per-error-template time buckets
+    mutable FieldStore fields;     // Numeric key=value columns, extracted on first query
+    mutable std::mutex fieldLock;  // Serializes field queries (columns grow lazily)
+    mutable Metrics metrics;       // Operation latency histograms and counters
+    mutable std::mutex ingestLock; // Guards the log store and the single-writer summaries
+    SavedSearchSet savedSearches;  // Standing keyword queries matched on ingest (under ingestLock)
+    mutable QueryCache queryCache; // Recent keyword search results, extended as rows are added
+    long long dataGeneration;      // Bumped whenever stored rows are cleared or replaced
+    unsigned int errorLevelId;       // Interned ID of "ERROR"
+    unsigned int errorLevelLowerId;  // Interned ID of "error"
+    unsigned int infoLevelId;        // Interned ID of "INFO"
+    unsigned int warningLevelId;     // Interned ID of "WARNING"
+    unsigned int debugLevelId;       // Interned ID of "DEBUG"
     
-    // Helper function to check if log level is ERROR
-    bool isErrorLevel(const char* level) const;
+    // Durable ingestion (write-ahead log plus periodic snapshots)
+    WriteAheadLog* wal;              // nullptr when durability is off
+    WalConfig walConfig;
+    char walPath[1024];
+    char checkpointPath[1024];
+    unsigned long long appliedSequence;       // Last WAL sequence reflected in memory
+    std::atomic<long long> recordsSinceCheckpoint;
+    std::atomic<bool> checkpointRunning;
+    std::atomic<int> ingestInFlight;          // addLog() calls between enter/leave
+    std::atomic<bool> ingestPaused;           // Set while a checkpoint runs
+    std::mutex gateLock;
+    std::condition_variable gateSignal;
+    
+    // Helper function to check if an interned log level is ERROR
+    bool isErrorLevel(unsigned int levelId) const;
+    
+    // Map an interned log level to its slot in sketches and histograms
+    LogSketches::Level levelSlot(unsigned int levelId) const;
+    
+    // Intern the level names the analyzer recognises
+    void internKnownLevels();
+    
+    // Store one log entry; logs it to `log` first when given
+    // Returns the WAL sequence number assigned (0 if not logged)
+    unsigned long long ingest(const char* timestamp, const char* log_level, const char* message,
+                              WriteAheadLog* log);
+    
+    // Store one entry, logging it to the WAL if enabled, without waiting for
+    // it to be durable; returns its sequence number (0 if not logged)
+    unsigned long long appendLog(const char* timestamp, const char* log_level, const char* message);
+    
+    // Wait until WAL records up to sequence are durable, then count `records`
+    // toward the next checkpoint (running it if due)
+    void commitLogs(unsigned long long sequence, long long records);
+    
+    // WAL records appended by a single-threaded bulk load and not yet committed
+    struct PendingCommit {
+        LogAnalyzer* analyzer;
+        unsigned long long sequence;   // Last appended record
+        long long records;
+    };
+    
+    // Entries per WAL commit in bulk loads (one fsync per batch under WAL_SYNC_ALWAYS)
+    static const int COMMIT_BATCH = 4096;
+    
+    // Add one entry of a bulk load, committing every COMMIT_BATCH entries
+    void addPending(PendingCommit& pending, const char* timestamp, const char* log_level, const char* message);
+    
+    // Commit the entries a bulk load has added so far
+    void commitPending(PendingCommit& pending);
+    
+    // Clear all data without checkpointing
+    void clearState();
+    
+    // Match every stored row against a saved search (caller holds ingestLock)
+    void matchStoredRows(int searchId);
+    
+    // Rows containing keyword (oldest first) and its occurrences, from the
+    // query cache where possible; only rows the cache does not cover are searched
+    void matchKeyword(const char* keyword, bool caseSensitive, KeywordMatches& matches) const;
+    
+    // Quiesce addLog() around checkpoints
+    void enterIngest();
+    void leaveIngest();
+    void pauseIngest();
+    void resumeIngest();
+    
+    // Apply one replayed WAL record (WriteAheadLog::replay callback)
+    static void replayRecord(void* context, const WalRecord& record);
+    
+    // Add one entry of a bulk load (IngestSink over a PendingCommit)
+    static void ingestRecord(void* context, const char* timestamp, const char* level, const char* message);
+    
+    // Commit a bulk load's entries at a batch boundary (IngestFlush over a PendingCommit)
+    static void flushRecords(void* context);
+    
+    // Write the display label of a group-by key into buffer
+    void formatGroupKey(GroupDimension dim, unsigned int key, char* buffer, int size) const;
     
 public:
     // Constructor
@@ -25,13 +142,72 @@ public:
     ~LogAnalyzer();
     
     // Add a log entry to the system
+    // Safe to call from several threads at once; queries and clearAll() must
+    // not run concurrently with ingestion.
     void addLog(const char* timestamp, const char* log_level, const char* message);
     
     // Display all log entries
     void displayAllLogs() const;
     
+    // Display all log entries oldest first by parsed timestamp (entries
+    // with equal or unparseable timestamps keep insertion order)
+    // Sorting uses at most memoryLimit bytes, spilling runs to disk beyond it.
+    void displayLogsByTime(size_t memoryLimit) const;
+    
     // Count and display ERROR frequency using hash table
-    void analyzeErrorFrequency() const;
+    // Groups by message template by default, or by exact message text
+    void analyzeErrorFrequency(bool byTemplate = true) const;
+    
+    // Get the k most frequent ERROR messages, in descending order
+    // exact = true selects from the full hash table (O(e log k));
+    // otherwise the fixed-memory Space-Saving summary is used (O(m), bounded error)
+    int topErrors(int k, bool exact, TopKEntry* out) const;
+    
+    // Get the k most frequent ERROR message templates, in descending order
+    int topErrorTemplates(int k, TopKEntry* out) const;
+    
+    // Display the k most frequent ERROR messages
+    void displayTopErrors(int k, bool exact) const;
+    
+    // Maintain HyperLogLog and Count-Min sketches alongside the hash tables
+    // Existing logs are added once when sketches are enabled
+    void enableSketches(const SketchConfig& config);
+    void disableSketches();
+    bool sketchesEnabled() const;
+    
+    // Display sketch estimates; message may be nullptr to skip the frequency query
+    void displaySketchEstimates(const char* message);
+    
+    // Display per-level counts for timestamps in [from, to) and the ERROR
+    // rate per minute (or per hour for long windows), from time buckets
+    void displayLevelCounts(long long from, long long to) const;
+    
+    // Display error templates whose count in the last windowMinutes (ending at
+    // the latest timestamp seen) is at least factor times their baseline rate
+    void displayErrorSpikes(int windowMinutes, int baselineMinutes, double factor) const;
+    
+    // Latest timestamp seen, in seconds since the epoch (INVALID_EPOCH if none)
+    long long getLatestEpoch() const;
+    
+    // Aggregate stored logs grouped by one or two columns (count, min/max
+    // timestamp, first/last row per group), scanning the column store in parallel
+    void groupBy(const GroupByQuery& query, GroupByResult& result) const;
+    
+    // Display a group-by result; time groups are listed in time order,
+    // other groups by descending count
+    void displayGroupBy(const GroupByQuery& query) const;
+    
+    // Display logs whose numeric key=value fields match filter, newest first
+    // (e.g. "latency_ms > 300 and status >= 500"). Each field is extracted
+    // into a typed column on first use and extended incrementally afterwards.
+    void displayLogsWhere(const char* filter) const;
+    
+    // Display count, average, min, max and sum of a numeric field per group
+    // for rows matching filter (blank = all rows); by = GROUP_NONE for one total
+    void displayFieldStats(const char* field, const char* filter, GroupDimension by) const;
+    
+    // String pool ID of a log level name (StringPool::INVALID_ID if never seen)
+    unsigned int findLevelId(const char* level);
     
     // Search for a keyword in log messages using KMP
     // Returns the number of matches found
@@ -40,15 +216,159 @@ public:
     // Display logs containing a specific keyword
     void displayLogsWithKeyword(const char* keyword, bool caseSensitive = true) const;
     
+    // Find logs containing a keyword, newest first; the first maxRows row
+    // numbers go to rows. Returns the number of matching logs.
+    int findLogsWithKeyword(const char* keyword, bool caseSensitive, int* rows, int maxRows) const;
+    
+    // Get a stored log entry (row 0 is the oldest)
+    void getLogEntry(int row, LogEntry& entry) const;
+    
+    // Start a paged keyword search (see SearchCursor); false for an empty keyword
+    bool openSearchCursor(const char* keyword, bool caseSensitive, bool newestFirst,
+                          SearchCursor& cursor) const;
+    
+    // Next page of up to maxRows matching rows; scanning stops once the page
+    // is full. Returns the number of rows, 0 when the search is finished or
+    // the data was cleared since the cursor was opened.
+    int nextSearchPage(SearchCursor& cursor, int* rows, int maxRows) const;
+    
+    // True when a cursor has no rows left to examine
+    bool searchCursorDone(const SearchCursor& cursor) const;
+    
+    // Display the next page of a cursor search; returns the logs shown
+    int displaySearchPage(SearchCursor& cursor, int pageSize) const;
+    
+    // Start a sampled keyword count (see ApproximateSearch); the seed picks
+    // which logs are sampled first. False for an empty keyword.
+    bool startApproximateSearch(const char* keyword, bool caseSensitive, ApproximateSearch& search,
+                                unsigned long long seed = 1, double confidence = 0.95) const;
+    
+    // Scan up to `units` more sample units (ApproximateSearch::UNIT_ROWS logs
+    // each) and update estimate. Returns the units scanned: 0 once every log
+    // has been, or when the data was cleared since the search started.
+    int refineApproximateSearch(ApproximateSearch& search, int units, ApproxEstimate& estimate) const;
+    
+    // Display a sampled keyword count and its confidence interval
+    void displayApproximateEstimate(const ApproxEstimate& estimate) const;
+    
+    // Register a keyword search that is kept up to date as logs are added:
+    // existing logs are scanned once, then every new log is matched when it
+    // is stored and, if it matches, passed to callback (when given) on the
+    // adding thread. Callbacks run under the ingest lock, so they must be
+    // quick and must not call back into the analyzer.
+    // Returns the search ID, or -1 if the keyword is empty or too many
+    // searches are registered (see SavedSearchSet::MAX_SEARCHES).
+    int addSavedSearch(const char* keyword, bool caseSensitive, SavedSearchCallback callback = nullptr,
+                       void* context = nullptr);
+    bool removeSavedSearch(int id);
+    
+    // Counts of a saved search in O(1); safe while logs are being added
+    bool getSavedSearch(int id, SavedSearchStatus& status) const;
+    
+    // Copy up to maxRows rows matched by a saved search, newest first,
+    // after skipping the newest `skip`; returns the number copied
+    int getSavedSearchRows(int id, int* rows, int maxRows, int skip = 0) const;
+    
+    // Hits, narrowed queries and misses of the keyword query cache
+    void getQueryCacheStats(QueryCacheStats& stats) const;
+    
+    // Cache keyword search results (on by default); off, every query scans all rows
+    void setQueryCacheEnabled(bool enabled);
+    
+    // Display every saved search with its counts, and the newest logs of one
+    void displaySavedSearches() const;
+    void displaySavedSearchLogs(int id, int maxRows) const;
+    
+    // Display latency percentiles of every operation that ran, ingest stage
+    // timings and event counters (compiled out with -DLOG_METRICS=0)
+    void displayMetrics() const;
+    void resetMetrics();
+    
+    // Break down the heap memory held by each data structure (payload,
+    // overhead, fragmentation) and the bytes mapped from a loaded snapshot
+    void getMemoryReport(MemoryReport& report);
+    
+    // Display the memory breakdown with bytes per stored row, next to what
+    // the allocator and the operating system report for the whole process
+    void displayMemoryUsage();
+    
     // Get statistics
     int getTotalLogs() const;
     int getErrorCount() const;
+    int getErrorTemplateCount() const;
+    int getTemplateCount() const;
+    
+    // Get string interning statistics (dedup ratio, memory saved)
+    void getStringPoolStats(PoolStats& stats);
+    
+    // Save all state to a binary snapshot file (written to path.tmp, then renamed)
+    // Sketches are not saved; re-enabling them rebuilds them from the stored logs.
+    // Not safe while other threads are adding logs.
+    bool saveSnapshot(const char* path);
+    
+    // Replace all state with a snapshot; the file is memory-mapped and used in
+    // place, so loading time does not grow with the number of rows
+    bool loadSnapshot(const char* path);
+    
+    // Make addLog() crash-safe: every entry is appended to a write-ahead log
+    // before it is stored, and a snapshot is checkpointed to snapshotPath every
+    // config.checkpointRecords entries, after which the log is truncated.
+    // If the snapshot or the log already exist, state is first recovered from
+    // them (snapshot, then the log records it does not cover), replacing the
+    // current data; otherwise the current data is checkpointed immediately.
+    bool enableDurability(const char* logPath, const char* snapshotPath, const WalConfig& config);
+    
+    // Flush and close the write-ahead log
+    void disableDurability();
+    bool durabilityEnabled() const;
+    
+    // Number of WAL fsyncs so far (each group commit is one)
+    long long getWalSyncCount();
+    
+    // Snapshot now and truncate the write-ahead log (blocks addLog() meanwhile)
+    bool checkpoint();
+    
+    // Ingest every file in a directory or matching a glob pattern, merged
+    // into one stream in timestamp order (files are read in parallel)
+    // Returns the number of entries added.
+    long long ingestFiles(const char* pattern, const IngestConfig& config, IngestStats& stats);
+    
+    // Ingest log lines from a file descriptor (such as stdin) until end of
+    // input or SIGINT/SIGTERM, parsed exactly like ingestFiles(); entries are
+    // added as they arrive, and the last one is kept when a signal ends the
+    // stream. Lines holding a JSON object are mapped through jsonFormat when given.
+    // Returns the number of entries added.
+    long long ingestStream(int fd, const JsonFormat* jsonFormat = nullptr);
+    
+    // Sort log files (directory or glob) by timestamp into outputPath using
+    // at most memoryLimit bytes; inputs larger than memory are sorted in runs
+    // on disk and merged. Each entry is written as it was read (its first line
+    // and continuation lines); lines holding a JSON object are timed through
+    // jsonFormat when given. Does not change the analyzer's data.
+    static bool sortLogFiles(const char* pattern, const char* outputPath, size_t memoryLimit,
+                             const JsonFormat* jsonFormat = nullptr);
     
     // Clear all data
     void clearAll();
     
     // Load sample data for testing
     void loadSampleData();
+    
+    // Replace the data with generated entries (see LogGenerator)
+    void loadGeneratedData(const GeneratorConfig& config);
+    
+    // Serve search, error frequency and statistics queries on a Unix domain
+    // socket (see QueryServer) until SIGINT or SIGTERM. Queries run
+    // concurrently, so nothing else may modify the analyzer meanwhile.
+    bool serve(const char* socketPath, const QueryServerConfig& config);
+    
+    // Answer one query server request; a QueryHandler whose context is the
+    // analyzer, for running a QueryServer directly
+    static unsigned char serveQuery(void* context, const QueryRequest& request, QueryBuffer& response);
+    
+    // Add syslog messages sent to the configured sockets (see SyslogListener)
+    // until SIGINT or SIGTERM; returns false if a socket could not be opened
+    bool listenSyslog(const SyslogConfig& config, SyslogStats& stats);
 };
 
 #endif // CORE_H
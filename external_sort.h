@@ -0,0 +1,583 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <iostream>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// A sort key with a payload reference
+struct SortRecord {
+    long long key;
+    unsigned long long value;
+};
+
+// Stable LSD radix sort of records by signed key, 8 bits per pass
+// Byte positions where every key has the same value are skipped, so keys
+// within a narrow range (such as timestamps from one week) need only a few
+// passes. The result is left in records; scratch must hold count records.
+inline void radixSortRecords(SortRecord* records, SortRecord* scratch, size_t count) {
+    if (count < 2) {
+        return;
+    }
+    const unsigned long long SIGN = 1ULL << 63;   // Flip so signed keys order as unsigned
+    size_t (*histogram)[256] = new size_t[8][256];
+    memset(histogram, 0, sizeof(size_t) * 8 * 256);
+    for (size_t i = 0; i < count; i++) {
+        unsigned long long key = (unsigned long long)records[i].key ^ SIGN;
+        for (int d = 0; d < 8; d++) {
+            histogram[d][(key >> (d * 8)) & 0xFF]++;
+        }
+    }
+
+    SortRecord* from = records;
+    SortRecord* to = scratch;
+    unsigned long long firstKey = (unsigned long long)records[0].key ^ SIGN;
+    for (int d = 0; d < 8; d++) {
+        if (histogram[d][(firstKey >> (d * 8)) & 0xFF] == count) {
+            continue;   // All keys share this byte
+        }
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t n = histogram[d][b];
+            histogram[d][b] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            unsigned long long key = (unsigned long long)from[i].key ^ SIGN;
+            to[histogram[d][(key >> (d * 8)) & 0xFF]++] = from[i];
+        }
+        SortRecord* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != records) {
+        memcpy(records, from, count * sizeof(SortRecord));
+    }
+    delete[] histogram;
+}
+
+// Receives sorted records: key and payload bytes
+typedef void (*SortVisitor)(void* context, long long key, const char* payload, unsigned int length);
+
+// Sort (key, payload) records of any total size within a memory limit
+//
+// Records are buffered until the limit is reached; the buffer is then
+// radix-sorted by key and written to a temporary file as a sorted run.
+// finish() merges the runs with a min-heap, reading each through its own
+// buffer, and passes records to a visitor in key order. If everything fits,
+// no file is written. Equal keys keep insertion order.
+//
+// At most maxFanIn runs are open or merged at once: enough for a 64 KB
+// buffer each within the memory limit and half the open-file limit. When
+// spilling reaches it, the newest runs are merged into one first.
+//
+// Run files are unlinked as soon as they are created, so they disappear
+// when the sorter is destroyed or the process exits.
+class ExternalSorter {
+private:
+    static const size_t RECORD_HEADER = sizeof(long long) + sizeof(unsigned int);
+    static const size_t WRITE_BUFFER = 1 << 20;
+
+    static const size_t MIN_MERGE_BUFFER = 64 << 10;
+
+    // Buffered writer of one sorted run
+    struct RunWriter {
+        int fd;
+        char* buffer;
+        size_t used;
+        long long bytes;
+        bool ok;
+    };
+
+    // Buffered reader over one sorted run
+    struct RunReader {
+        int fd;
+        char* buffer;
+        size_t capacity;
+        size_t start;
+        size_t end;
+        long long key;          // Current record
+        const char* payload;
+        unsigned int length;
+    };
+
+    size_t memoryLimit;
+    char tempDirectory[512];
+
+    // In-memory run: payloads in an arena, records hold (key, arena offset)
+    char* arena;
+    size_t arenaSize;
+    size_t arenaCapacity;
+    SortRecord* records;
+    size_t recordCount;
+    size_t recordCapacity;
+
+    int* runFiles;
+    int* runLevels;             // Merge passes behind each run (0 = spilled)
+    int runCount;
+    int runCapacity;
+    int maxFanIn;               // Runs open or merged at once
+    int runsWritten;
+    int mergePasses;
+    long long totalRecords;
+    long long spilledBytes;
+    bool failed;
+
+    // Bytes the in-memory run would need to be sorted (records twice for scratch)
+    inline size_t bufferedBytes(size_t extraPayload) const {
+        return arenaSize + extraPayload + (recordCount + 1) * sizeof(SortRecord) * 2;
+    }
+
+    // Double a buffer capacity without passing the limit unless needed
+    inline static size_t grownCapacity(size_t capacity, size_t needed, size_t limit) {
+        size_t grown = capacity * 2;
+        while (grown < needed) {
+            grown *= 2;
+        }
+        if (grown > limit) {
+            grown = limit > needed ? limit : needed;
+        }
+        return grown;
+    }
+
+    inline static bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= (size_t)written;
+        }
+        return true;
+    }
+
+    inline int createRunFile() {
+        char path[600];
+        snprintf(path, sizeof(path), "%s/slasort.XXXXXX", tempDirectory);
+        int fd = mkstemp(path);
+        if (fd < 0) {
+            std::cerr << "Cannot create sort run in " << tempDirectory << ": " << strerror(errno) << "\n";
+            return -1;
+        }
+        unlink(path);
+        return fd;
+    }
+
+    // Sort the in-memory run; it stays in place for the caller to visit or spill
+    inline void sortBuffered() {
+        SortRecord* scratch = new SortRecord[recordCount > 0 ? recordCount : 1];
+        radixSortRecords(records, scratch, recordCount);
+        delete[] scratch;
+    }
+
+    // Start a new run file with its write buffer
+    inline bool beginRun(RunWriter& out) {
+        out.fd = createRunFile();
+        out.buffer = out.fd >= 0 ? new char[WRITE_BUFFER] : nullptr;
+        out.used = 0;
+        out.bytes = 0;
+        out.ok = out.fd >= 0;
+        return out.ok;
+    }
+
+    // Append one record to a run being written
+    inline static void writeRecord(RunWriter& out, long long key, const char* payload, unsigned int length) {
+        size_t size = RECORD_HEADER + length;
+        if (out.used + size > WRITE_BUFFER) {
+            out.ok = out.ok && writeAll(out.fd, out.buffer, out.used);
+            out.used = 0;
+        }
+        if (size > WRITE_BUFFER) {
+            // Oversized record: write header and payload directly
+            out.ok = out.ok && writeAll(out.fd, (const char*)&key, sizeof(long long)) &&
+                     writeAll(out.fd, (const char*)&length, sizeof(unsigned int)) &&
+                     writeAll(out.fd, payload, length);
+        } else {
+            memcpy(out.buffer + out.used, &key, sizeof(long long));
+            memcpy(out.buffer + out.used + sizeof(long long), &length, sizeof(unsigned int));
+            memcpy(out.buffer + out.used + RECORD_HEADER, payload, length);
+            out.used += size;
+        }
+        out.bytes += (long long)size;
+    }
+
+    // SortVisitor that writes merged records to a run (context is a RunWriter)
+    static inline void writeMerged(void* context, long long key, const char* payload, unsigned int length) {
+        writeRecord(*(RunWriter*)context, key, payload, length);
+    }
+
+    // Flush a run and rewind it for reading; returns its fd, or -1 on error
+    inline int endRun(RunWriter& out) {
+        out.ok = out.ok && writeAll(out.fd, out.buffer, out.used);
+        delete[] out.buffer;
+        spilledBytes += out.bytes;
+        if (!out.ok || lseek(out.fd, 0, SEEK_SET) < 0) {
+            std::cerr << "Cannot write sort run: " << strerror(errno) << "\n";
+            ::close(out.fd);
+            failed = true;
+            return -1;
+        }
+        return out.fd;
+    }
+
+    // Append a run file at a merge level
+    inline void addRun(int fd, int level) {
+        if (runCount == runCapacity) {
+            runCapacity = runCapacity == 0 ? 8 : runCapacity * 2;
+            int* grownFiles = new int[runCapacity];
+            int* grownLevels = new int[runCapacity];
+            for (int i = 0; i < runCount; i++) {
+                grownFiles[i] = runFiles[i];
+                grownLevels[i] = runLevels[i];
+            }
+            delete[] runFiles;
+            delete[] runLevels;
+            runFiles = grownFiles;
+            runLevels = grownLevels;
+        }
+        runFiles[runCount] = fd;
+        runLevels[runCount] = level;
+        runCount++;
+    }
+
+    // Free the in-memory run's buffers so a merge can use the memory
+    inline void releaseBuffers() {
+        delete[] arena;
+        delete[] records;
+        arenaCapacity = 1 << 16;
+        arena = new char[arenaCapacity];
+        arenaSize = 0;
+        recordCapacity = 1 << 12;
+        records = new SortRecord[recordCapacity];
+        recordCount = 0;
+    }
+
+    // Sort the in-memory run and write it to a new run file
+    inline bool spill() {
+        if (recordCount == 0) {
+            return true;
+        }
+        sortBuffered();
+        RunWriter out;
+        if (!beginRun(out)) {
+            failed = true;
+            return false;
+        }
+        for (size_t i = 0; i < recordCount; i++) {
+            const char* stored = arena + records[i].value;
+            unsigned int length;
+            memcpy(&length, stored, sizeof(length));
+            writeRecord(out, records[i].key, stored + sizeof(length), length);
+        }
+        int fd = endRun(out);
+        if (fd < 0) {
+            return false;
+        }
+        addRun(fd, 0);
+        runsWritten++;
+        arenaSize = 0;
+        recordCount = 0;
+        return runCount < maxFanIn || compactRuns();
+    }
+
+    // Merge the newest runs into one so fewer than maxFanIn stay open
+    // Runs are tiered: the newest runs sharing the lowest level (or, if only
+    // one has it, those and the next level's) become one run a level higher.
+    // Each record is therefore rewritten about once per level, log(runs) / log(maxFanIn)
+    // times in all, and no merge reads more than maxFanIn runs.
+    inline bool compactRuns() {
+        releaseBuffers();
+        while (runCount >= maxFanIn) {
+            int first = runCount - 1;
+            while (first > 0 && runLevels[first - 1] == runLevels[runCount - 1]) {
+                first--;
+            }
+            if (first == runCount - 1 && first > 0) {
+                int next = runLevels[first - 1];
+                while (first > 0 && runLevels[first - 1] == next) {
+                    first--;
+                }
+            }
+            int count = runCount - first;   // At most runCount, which is maxFanIn
+            RunWriter out;
+            if (!beginRun(out)) {
+                failed = true;
+                return false;
+            }
+            mergeRuns(first, count, writeMerged, &out);
+            int fd = endRun(out);
+            if (fd < 0) {
+                return false;
+            }
+            int level = runLevels[first] + 1;
+            for (int i = first; i < runCount; i++) {
+                ::close(runFiles[i]);
+            }
+            runCount = first;
+            addRun(fd, level);
+            mergePasses++;
+        }
+        return true;
+    }
+
+    // Make the next record of a run current; false at the end of the run
+    inline static bool readRecord(RunReader& run) {
+        while (true) {
+            size_t available = run.end - run.start;
+            if (available >= RECORD_HEADER) {
+                unsigned int length;
+                memcpy(&length, run.buffer + run.start + sizeof(long long), sizeof(length));
+                size_t size = RECORD_HEADER + length;
+                if (available >= size) {
+                    memcpy(&run.key, run.buffer + run.start, sizeof(long long));
+                    run.payload = run.buffer + run.start + RECORD_HEADER;
+                    run.length = length;
+                    run.start += size;
+                    return true;
+                }
+                if (size > run.capacity) {
+                    char* grown = new char[size];
+                    memcpy(grown, run.buffer + run.start, available);
+                    delete[] run.buffer;
+                    run.buffer = grown;
+                    run.capacity = size;
+                    run.start = 0;
+                    run.end = available;
+                }
+            }
+            // Refill: keep the partial record, read after it
+            memmove(run.buffer, run.buffer + run.start, available);
+            run.start = 0;
+            run.end = available;
+            ssize_t got;
+            do {
+                got = ::read(run.fd, run.buffer + run.end, run.capacity - run.end);
+            } while (got < 0 && errno == EINTR);
+            if (got <= 0) {
+                return false;
+            }
+            run.end += (size_t)got;
+        }
+    }
+
+    inline static bool runBefore(const RunReader* runs, int a, int b) {
+        if (runs[a].key != runs[b].key) {
+            return runs[a].key < runs[b].key;
+        }
+        return a < b;   // Earlier runs hold earlier input
+    }
+
+    inline static void siftDown(const RunReader* runs, int* heap, int size, int i) {
+        int item = heap[i];
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= size) {
+                break;
+            }
+            if (child + 1 < size && runBefore(runs, heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!runBefore(runs, heap[child], item)) {
+                break;
+            }
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = item;
+    }
+
+    // K-way merge of count consecutive runs starting at first (at most maxFanIn)
+    inline void mergeRuns(int first, int count, SortVisitor visitor, void* context) {
+        // The merge buffers share the memory limit
+        size_t bufferSize = memoryLimit / (size_t)count;
+        if (bufferSize < MIN_MERGE_BUFFER) {
+            bufferSize = MIN_MERGE_BUFFER;
+        }
+        if (bufferSize > (4 << 20)) {
+            bufferSize = 4 << 20;
+        }
+        RunReader* runs = new RunReader[count];
+        int* heap = new int[count];
+        int heapSize = 0;
+        for (int i = 0; i < count; i++) {
+            runs[i].fd = runFiles[first + i];
+            runs[i].buffer = new char[bufferSize];
+            runs[i].capacity = bufferSize;
+            runs[i].start = 0;
+            runs[i].end = 0;
+            if (readRecord(runs[i])) {
+                heap[heapSize++] = i;
+            }
+        }
+        for (int i = heapSize / 2 - 1; i >= 0; i--) {
+            siftDown(runs, heap, heapSize, i);
+        }
+        while (heapSize > 0) {
+            RunReader& run = runs[heap[0]];
+            visitor(context, run.key, run.payload, run.length);
+            if (!readRecord(run)) {
+                heap[0] = heap[--heapSize];
+            }
+            if (heapSize > 0) {
+                siftDown(runs, heap, heapSize, 0);
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            delete[] runs[i].buffer;
+        }
+        delete[] runs;
+        delete[] heap;
+    }
+
+    inline void closeRuns() {
+        for (int i = 0; i < runCount; i++) {
+            ::close(runFiles[i]);
+        }
+        runCount = 0;
+    }
+
+public:
+    // memoryLimit bounds the buffered records and merge buffers (at least 1 MB)
+    // Run files go to tempDir, or $TMPDIR, or /tmp.
+    inline explicit ExternalSorter(size_t limit, const char* tempDir = nullptr) {
+        memoryLimit = limit > (1 << 20) ? limit : (1 << 20);
+        if (tempDir == nullptr || tempDir[0] == '\0') {
+            tempDir = getenv("TMPDIR");
+        }
+        if (tempDir == nullptr || tempDir[0] == '\0' || strlen(tempDir) >= sizeof(tempDirectory)) {
+            tempDir = "/tmp";
+        }
+        strcpy(tempDirectory, tempDir);
+        arenaCapacity = 1 << 16;
+        arena = new char[arenaCapacity];
+        arenaSize = 0;
+        recordCapacity = 1 << 12;
+        records = new SortRecord[recordCapacity];
+        recordCount = 0;
+        runFiles = nullptr;
+        runLevels = nullptr;
+        runCount = 0;
+        runCapacity = 0;
+        runsWritten = 0;
+        mergePasses = 0;
+
+        // Each merged run needs a buffer of at least MIN_MERGE_BUFFER and a
+        // file descriptor; half the descriptors are left to the rest of the process
+        maxFanIn = (int)(memoryLimit / MIN_MERGE_BUFFER);
+        struct rlimit files;
+        if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur != RLIM_INFINITY &&
+            (rlim_t)maxFanIn > files.rlim_cur / 2) {
+            maxFanIn = (int)(files.rlim_cur / 2);
+        }
+        if (maxFanIn < 2) {
+            maxFanIn = 2;
+        }
+        totalRecords = 0;
+        spilledBytes = 0;
+        failed = false;
+    }
+
+    inline ~ExternalSorter() {
+        closeRuns();
+        delete[] runFiles;
+        delete[] runLevels;
+        delete[] arena;
+        delete[] records;
+    }
+
+    // Add one record; the payload is copied. False once a run could not be written.
+    inline bool add(long long key, const char* payload, unsigned int length) {
+        if (failed) {
+            return false;
+        }
+        size_t stored = sizeof(unsigned int) + length;
+        if (recordCount > 0 && bufferedBytes(stored) > memoryLimit && !spill()) {
+            return false;
+        }
+        if (arenaSize + stored > arenaCapacity) {
+            size_t capacity = grownCapacity(arenaCapacity, arenaSize + stored, memoryLimit);
+            char* grown = new char[capacity];
+            memcpy(grown, arena, arenaSize);
+            delete[] arena;
+            arena = grown;
+            arenaCapacity = capacity;
+        }
+        if (recordCount == recordCapacity) {
+            recordCapacity = grownCapacity(recordCapacity, recordCount + 1,
+                                           memoryLimit / (sizeof(SortRecord) * 2));
+            SortRecord* grown = new SortRecord[recordCapacity];
+            memcpy(grown, records, recordCount * sizeof(SortRecord));
+            delete[] records;
+            records = grown;
+        }
+        memcpy(arena + arenaSize, &length, sizeof(length));
+        memcpy(arena + arenaSize + sizeof(length), payload, length);
+        records[recordCount].key = key;
+        records[recordCount].value = arenaSize;
+        recordCount++;
+        arenaSize += stored;
+        totalRecords++;
+        return true;
+    }
+
+    // Visit all records in key order; the sorter is empty afterwards
+    inline bool finish(SortVisitor visitor, void* context) {
+        if (failed) {
+            return false;
+        }
+        if (runCount == 0) {
+            sortBuffered();
+            for (size_t i = 0; i < recordCount; i++) {
+                const char* stored = arena + records[i].value;
+                unsigned int length;
+                memcpy(&length, stored, sizeof(length));
+                visitor(context, records[i].key, stored + sizeof(length), length);
+            }
+            arenaSize = 0;
+            recordCount = 0;
+            return true;
+        }
+        if (!spill()) {
+            return false;
+        }
+        // Release the run buffer before the merge allocates its readers
+        releaseBuffers();
+        mergeRuns(0, runCount, visitor, context);
+        closeRuns();
+        return true;
+    }
+
+    inline long long getRecordCount() const {
+        return totalRecords;
+    }
+
+    // Sorted runs written to disk (0 if everything fit in memory)
+    inline int getRunCount() const {
+        return runsWritten;
+    }
+
+    // Intermediate merges that combined runs before the final merge
+    inline int getMergePassCount() const {
+        return mergePasses;
+    }
+
+    // Bytes written to run files, including intermediate merges
+    inline long long getSpilledBytes() const {
+        return spilledBytes;
+    }
+
+private:
+    // Copying is not supported
+    ExternalSorter(const ExternalSorter&);
+    ExternalSorter& operator=(const ExternalSorter&);
+};
+
+#endif // EXTERNAL_SORT_H
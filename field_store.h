@@ -0,0 +1,356 @@
+#ifndef FIELD_STORE_H
+#define FIELD_STORE_H
+
+#include "log_list.h"
+#include "string_pool.h"
+#include "int_hash_map.h"
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <iostream>
+
+// Comparison in a field filter
+enum FieldOp {
+    FIELD_GT,
+    FIELD_GE,
+    FIELD_LT,
+    FIELD_LE,
+    FIELD_EQ,
+    FIELD_NE
+};
+
+// Find "name=value" in text and parse a numeric value
+// The name must start a token (start of text, or after a space, comma,
+// semicolon, brace or quote). Values may be quoted and may carry a unit
+// suffix ("310ms" reads as 310). The first numeric match is used; returns
+// false if the field is absent or never numeric.
+inline bool extractNumericField(const char* text, const char* name, size_t nameLength, double& value) {
+    const char* p = text;
+    while ((p = strstr(p, name)) != nullptr) {
+        bool tokenStart = p == text || p[-1] == ' ' || p[-1] == '\t' || p[-1] == ',' ||
+                          p[-1] == ';' || p[-1] == '{' || p[-1] == '"' || p[-1] == '\n';
+        const char* after = p + nameLength;
+        p++;
+        if (!tokenStart || *after != '=') {
+            continue;
+        }
+        after++;
+        if (*after == '"' || *after == '\'') {
+            after++;
+        }
+        char* end;
+        double parsed = strtod(after, &end);
+        if (end == after) {
+            continue;   // "user=alice ... user=42": a later match may be numeric
+        }
+        value = parsed;
+        return true;
+    }
+    return false;
+}
+
+// One numeric key=value field as a column aligned with the log store rows
+// Rows are materialized lazily up to the store size at query time, and each
+// distinct message is parsed only once (memoized by message ID), so a field
+// costs one text scan per distinct message no matter how often it is queried.
+// Rows without the field hold NaN.
+class FieldColumn {
+private:
+    char name[64];
+    size_t nameLength;
+    double** blocks;           // BLOCK_ROWS values each, like LogBlock columns
+    int blockCount;
+    int blockCapacity;
+    int rows;                  // Rows materialized so far
+    IntHashMap memo;           // Message ID -> value bits
+    long long parsedMessages;
+
+    inline static long long toBits(double value) {
+        long long bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline static double fromBits(long long bits) {
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+public:
+    inline FieldColumn(const char* fieldName) : memo(256) {
+        strncpy(name, fieldName, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+        nameLength = strlen(name);
+        blockCapacity = 16;
+        blocks = new double*[blockCapacity];
+        blockCount = 0;
+        rows = 0;
+        parsedMessages = 0;
+    }
+
+    inline ~FieldColumn() {
+        for (int i = 0; i < blockCount; i++) {
+            delete[] blocks[i];
+        }
+        delete[] blocks;
+    }
+
+    inline static bool isMissing(double value) {
+        return value != value;
+    }
+
+    // Materialize rows [rows, totalRows)
+    inline void extend(const LogList& list, const StringPool& pool, int totalRows) {
+        const double MISSING = strtod("nan", nullptr);
+        while (rows < totalRows) {
+            int b = rows >> LogList::BLOCK_BITS;
+            if (b == blockCount) {
+                if (blockCount == blockCapacity) {
+                    blockCapacity *= 2;
+                    double** grown = new double*[blockCapacity];
+                    memcpy(grown, blocks, sizeof(double*) * blockCount);
+                    delete[] blocks;
+                    blocks = grown;
+                }
+                blocks[blockCount++] = new double[LogList::BLOCK_ROWS];
+            }
+            const LogBlock* block = list.getBlock(b);
+            double* values = blocks[b];
+            int first = rows & (LogList::BLOCK_ROWS - 1);
+            int last = block->count;
+            if ((b << LogList::BLOCK_BITS) + last > totalRows) {
+                last = totalRows - (b << LogList::BLOCK_BITS);
+            }
+            const unsigned int* messageIds = block->messageIds;
+            for (int i = first; i < last; i++) {
+                long long bits;
+                if (!memo.get(messageIds[i], bits)) {
+                    double value;
+                    if (!extractNumericField(pool.lookup(messageIds[i]), name, nameLength, value)) {
+                        value = MISSING;
+                    }
+                    bits = toBits(value);
+                    memo.put(messageIds[i], bits);
+                    parsedMessages++;
+                }
+                values[i] = fromBits(bits);
+            }
+            rows += last - first;
+        }
+    }
+
+    inline const double* getBlock(int index) const {
+        return blocks[index];
+    }
+
+    inline int getRows() const {
+        return rows;
+    }
+
+    inline const char* getName() const {
+        return name;
+    }
+
+    // Add the memory held by the value blocks and the message memo
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        usage.addHeap(sizeof(double*) * blockCapacity, 0, sizeof(double*) * blockCount);
+        for (int b = 0; b < blockCount; b++) {
+            int filled = rows - (b << LogList::BLOCK_BITS);
+            if (filled > LogList::BLOCK_ROWS) {
+                filled = LogList::BLOCK_ROWS;
+            }
+            usage.addHeap(sizeof(double) * LogList::BLOCK_ROWS, sizeof(double) * filled, 0);
+        }
+        memo.addMemoryUsage(usage);
+    }
+
+    // Distinct messages parsed for this field
+    inline long long getParsedMessages() const {
+        return parsedMessages;
+    }
+
+private:
+    // Copying is not supported
+    FieldColumn(const FieldColumn&);
+    FieldColumn& operator=(const FieldColumn&);
+};
+
+// One condition of a field filter ("latency_ms > 300")
+struct FieldFilter {
+    const FieldColumn* column;
+    FieldOp op;
+    double operand;
+};
+
+// Does a value satisfy a condition? Missing values never do.
+inline bool fieldMatches(double value, FieldOp op, double operand) {
+    switch (op) {
+        case FIELD_GT: return value > operand;
+        case FIELD_GE: return value >= operand;
+        case FIELD_LT: return value < operand;
+        case FIELD_LE: return value <= operand;
+        case FIELD_EQ: return value == operand;
+        case FIELD_NE: return value == value && value != operand;
+    }
+    return false;
+}
+
+// Named field columns, created on first use
+// Not thread-safe: callers serialize access (LogAnalyzer holds a lock per query).
+class FieldStore {
+private:
+    FieldColumn** columns;
+    int count;
+    int capacity;
+
+    inline static bool isNameChar(char c) {
+        return isalnum((unsigned char)c) || c == '_' || c == '.' || c == '-';
+    }
+
+public:
+    static const int MAX_FILTERS = 8;
+
+    inline FieldStore() {
+        capacity = 8;
+        columns = new FieldColumn*[capacity];
+        count = 0;
+    }
+
+    inline ~FieldStore() {
+        clear();
+        delete[] columns;
+    }
+
+    // Column for a field, materialized through every row currently stored
+    inline FieldColumn* column(const char* name, const LogList& list, const StringPool& pool) {
+        FieldColumn* found = nullptr;
+        for (int i = 0; i < count && found == nullptr; i++) {
+            if (strcmp(columns[i]->getName(), name) == 0) {
+                found = columns[i];
+            }
+        }
+        if (found == nullptr) {
+            if (count == capacity) {
+                capacity *= 2;
+                FieldColumn** grown = new FieldColumn*[capacity];
+                memcpy(grown, columns, sizeof(FieldColumn*) * count);
+                delete[] columns;
+                columns = grown;
+            }
+            found = new FieldColumn(name);
+            columns[count++] = found;
+        }
+        found->extend(list, pool, list.getSize());
+        return found;
+    }
+
+    // Parse "name op number [and name op number ...]" (op: > >= < <= == = !=)
+    // into filters over materialized columns; prints the problem and returns
+    // false on a syntax error. Blank text gives zero filters.
+    inline bool parseFilter(const char* text, const LogList& list, const StringPool& pool,
+                            FieldFilter* filters, int& filterCount) {
+        filterCount = 0;
+        const char* p = text;
+        while (true) {
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            if (*p == '\0') {
+                break;
+            }
+            if (filterCount > 0) {
+                // Conditions are joined with "and" or "&&"
+                if (strncmp(p, "and", 3) == 0 && !isNameChar(p[3])) {
+                    p += 3;
+                } else if (strncmp(p, "&&", 2) == 0) {
+                    p += 2;
+                } else {
+                    std::cout << "Expected 'and' before: " << p << "\n";
+                    return false;
+                }
+                while (*p == ' ' || *p == '\t') {
+                    p++;
+                }
+            }
+            char name[64];
+            int length = 0;
+            while (isNameChar(*p) && length < (int)sizeof(name) - 1) {
+                name[length++] = *p++;
+            }
+            name[length] = '\0';
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            FieldOp op;
+            if (p[0] == '>' && p[1] == '=') {
+                op = FIELD_GE;
+                p += 2;
+            } else if (p[0] == '<' && p[1] == '=') {
+                op = FIELD_LE;
+                p += 2;
+            } else if (p[0] == '!' && p[1] == '=') {
+                op = FIELD_NE;
+                p += 2;
+            } else if (p[0] == '=' && p[1] == '=') {
+                op = FIELD_EQ;
+                p += 2;
+            } else if (p[0] == '=') {
+                op = FIELD_EQ;
+                p++;
+            } else if (p[0] == '>') {
+                op = FIELD_GT;
+                p++;
+            } else if (p[0] == '<') {
+                op = FIELD_LT;
+                p++;
+            } else {
+                std::cout << "Expected a comparison (> >= < <= == !=) after '" << name << "'\n";
+                return false;
+            }
+            char* end;
+            double operand = strtod(p, &end);
+            if (length == 0 || end == p) {
+                std::cout << "Expected 'field op number', e.g. latency_ms > 300\n";
+                return false;
+            }
+            p = end;
+            if (filterCount == MAX_FILTERS) {
+                std::cout << "At most " << MAX_FILTERS << " conditions are supported\n";
+                return false;
+            }
+            filters[filterCount].column = column(name, list, pool);
+            filters[filterCount].op = op;
+            filters[filterCount].operand = operand;
+            filterCount++;
+        }
+        return true;
+    }
+
+    inline int getCount() const {
+        return count;
+    }
+
+    // Add the memory held by every column
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        usage.addHeap(sizeof(FieldColumn*) * capacity, 0, sizeof(FieldColumn*) * count);
+        for (int i = 0; i < count; i++) {
+            usage.addHeap(sizeof(FieldColumn), 0, sizeof(FieldColumn));
+            columns[i]->addMemoryUsage(usage);
+        }
+    }
+
+    inline void clear() {
+        for (int i = 0; i < count; i++) {
+            delete columns[i];
+        }
+        count = 0;
+    }
+
+private:
+    // Copying is not supported
+    FieldStore(const FieldStore&);
+    FieldStore& operator=(const FieldStore&);
+};
+
+#endif // FIELD_STORE_H
@@ -0,0 +1,442 @@
+#ifndef GROUP_BY_H
+#define GROUP_BY_H
+
+#include "log_list.h"
+#include "int_hash_map.h"
+#include "timestamp.h"
+#include "field_store.h"
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+
+// Column a group-by can group on
+enum GroupDimension {
+    GROUP_NONE = 0,   // Single group (only valid as the second dimension)
+    GROUP_LEVEL,
+    GROUP_TEMPLATE,
+    GROUP_MESSAGE,
+    GROUP_MINUTE,
+    GROUP_HOUR,
+    GROUP_DAY
+};
+
+// Key used for rows without a valid timestamp in time dimensions
+const unsigned int GROUP_NO_TIME = 0xFFFFFFFFu;
+
+// Parse a dimension name ("level", "template", "message", "minute", "hour",
+// "day"); returns GROUP_NONE if the name is not recognised
+inline GroupDimension parseGroupDimension(const char* name) {
+    static const char* names[] = { "none", "level", "template", "message", "minute", "hour", "day" };
+    for (int i = 1; i <= (int)GROUP_DAY; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return (GroupDimension)i;
+        }
+    }
+    return GROUP_NONE;
+}
+
+// A group-by request
+struct GroupByQuery {
+    GroupDimension first;     // Outer grouping column
+    GroupDimension second;    // Inner grouping column (GROUP_NONE for one level)
+    long long fromEpoch;      // Keep rows with fromEpoch <= epoch (INVALID_EPOCH = no bound)
+    long long toEpoch;        // Keep rows with epoch < toEpoch (INVALID_EPOCH = no bound)
+    unsigned int levelId;     // Keep only this level (StringPool::INVALID_ID = all)
+    int threads;              // Worker threads (0 = hardware concurrency)
+    const FieldFilter* fieldFilters;  // Keep rows matching all of these (materialized columns)
+    int fieldFilterCount;
+    const FieldColumn* valueField;    // Also aggregate this numeric field (nullptr = none)
+
+    inline GroupByQuery() {
+        first = GROUP_LEVEL;
+        second = GROUP_NONE;
+        fromEpoch = INVALID_EPOCH;
+        toEpoch = INVALID_EPOCH;
+        levelId = StringPool::INVALID_ID;
+        threads = 0;
+        fieldFilters = nullptr;
+        fieldFilterCount = 0;
+        valueField = nullptr;
+    }
+};
+
+// Aggregates for one group
+// The value column is the row's epoch: min/max give the time span and
+// first/last are taken in row (insertion) order. The field aggregates cover
+// rows of the group where the query's value field is present.
+struct GroupRow {
+    unsigned int firstKey;
+    unsigned int secondKey;
+    long long count;
+    long long minValue;
+    long long maxValue;
+    long long firstValue;
+    long long lastValue;
+    int firstRow;
+    int lastRow;
+    long long fieldCount;
+    double fieldSum;
+    double fieldMin;
+    double fieldMax;
+};
+
+// Growable set of group rows indexed by packed key
+class GroupByResult {
+private:
+    GroupRow* rows;
+    int count;
+    int capacity;
+    IntHashMap index;          // Packed key -> row index
+    int noKeyRow;              // Row index for the packed key EMPTY_KEY (-1 if none)
+
+    static inline bool lessThan(const GroupRow& a, const GroupRow& b, bool byCount) {
+        if (byCount && a.count != b.count) {
+            return a.count > b.count;
+        }
+        if (a.firstKey != b.firstKey) {
+            return a.firstKey < b.firstKey;
+        }
+        return a.secondKey < b.secondKey;
+    }
+
+    inline void siftDown(int i, int size, bool byCount) {
+        while (true) {
+            int largest = i;
+            int left = 2 * i + 1;
+            int right = left + 1;
+            if (left < size && lessThan(rows[largest], rows[left], byCount)) {
+                largest = left;
+            }
+            if (right < size && lessThan(rows[largest], rows[right], byCount)) {
+                largest = right;
+            }
+            if (largest == i) {
+                return;
+            }
+            GroupRow tmp = rows[i];
+            rows[i] = rows[largest];
+            rows[largest] = tmp;
+            i = largest;
+        }
+    }
+
+public:
+    // Constructor
+    inline GroupByResult() : index(64) {
+        capacity = 64;
+        rows = new GroupRow[capacity];
+        count = 0;
+        noKeyRow = -1;
+    }
+
+    // Destructor
+    inline ~GroupByResult() {
+        delete[] rows;
+    }
+
+    // Index of the group for a packed key, creating it if absent
+    // Returned indices stay valid as the result grows; row references do not.
+    inline int groupFor(unsigned long long packed) {
+        // EMPTY_KEY cannot live in the index, so that one key gets its own slot
+        long long fallback = noKeyRow;
+        long long& slot = packed == IntHashMap::EMPTY_KEY ? fallback : index.valueRef(packed, -1);
+        if (slot >= 0) {
+            return (int)slot;
+        }
+        if (count == capacity) {
+            GroupRow* grown = new GroupRow[capacity * 2];
+            memcpy(grown, rows, sizeof(GroupRow) * count);
+            delete[] rows;
+            rows = grown;
+            capacity *= 2;
+        }
+        slot = count;
+        if (packed == IntHashMap::EMPTY_KEY) {
+            noKeyRow = count;
+        }
+        GroupRow& row = rows[count];
+        row.firstKey = (unsigned int)(packed >> 32);
+        row.secondKey = (unsigned int)packed;
+        row.count = 0;
+        row.firstRow = -1;
+        row.lastRow = -1;
+        row.fieldCount = 0;
+        row.fieldSum = 0.0;
+        row.fieldMin = 0.0;
+        row.fieldMax = 0.0;
+        return count++;
+    }
+
+    // Group at an index returned by groupFor
+    inline GroupRow& groupAt(int i) {
+        return rows[i];
+    }
+
+    // Fold one row into a group
+    static inline void accumulate(GroupRow& group, int row, long long value) {
+        if (group.count == 0) {
+            group.minValue = value;
+            group.maxValue = value;
+            group.firstValue = value;
+            group.firstRow = row;
+        } else {
+            if (value < group.minValue) {
+                group.minValue = value;
+            }
+            if (value > group.maxValue) {
+                group.maxValue = value;
+            }
+        }
+        group.lastValue = value;
+        group.lastRow = row;
+        group.count++;
+    }
+
+    // Fold one value of the query's value field into a group
+    static inline void accumulateField(GroupRow& group, double value) {
+        if (group.fieldCount == 0) {
+            group.fieldMin = value;
+            group.fieldMax = value;
+        } else {
+            if (value < group.fieldMin) {
+                group.fieldMin = value;
+            }
+            if (value > group.fieldMax) {
+                group.fieldMax = value;
+            }
+        }
+        group.fieldSum += value;
+        group.fieldCount++;
+    }
+
+    // Merge a partial result computed over later rows into this one
+    inline void mergeFrom(const GroupByResult& other) {
+        for (int i = 0; i < other.count; i++) {
+            const GroupRow& src = other.rows[i];
+            unsigned long long packed = ((unsigned long long)src.firstKey << 32) | src.secondKey;
+            int slot = groupFor(packed);
+            GroupRow& dst = rows[slot];
+            if (dst.count == 0) {
+                dst = src;
+                continue;
+            }
+            if (src.minValue < dst.minValue) {
+                dst.minValue = src.minValue;
+            }
+            if (src.maxValue > dst.maxValue) {
+                dst.maxValue = src.maxValue;
+            }
+            if (src.firstRow < dst.firstRow) {
+                dst.firstRow = src.firstRow;
+                dst.firstValue = src.firstValue;
+            }
+            if (src.lastRow > dst.lastRow) {
+                dst.lastRow = src.lastRow;
+                dst.lastValue = src.lastValue;
+            }
+            dst.count += src.count;
+            if (src.fieldCount > 0) {
+                if (dst.fieldCount == 0 || src.fieldMin < dst.fieldMin) {
+                    dst.fieldMin = src.fieldMin;
+                }
+                if (dst.fieldCount == 0 || src.fieldMax > dst.fieldMax) {
+                    dst.fieldMax = src.fieldMax;
+                }
+                dst.fieldSum += src.fieldSum;
+                dst.fieldCount += src.fieldCount;
+            }
+        }
+    }
+
+    // Sort groups by key, or by descending count (heap sort, O(g log g))
+    // The key index is not maintained after sorting.
+    inline void sort(bool byCount) {
+        for (int i = count / 2 - 1; i >= 0; i--) {
+            siftDown(i, count, byCount);
+        }
+        for (int end = count - 1; end > 0; end--) {
+            GroupRow tmp = rows[0];
+            rows[0] = rows[end];
+            rows[end] = tmp;
+            siftDown(0, end, byCount);
+        }
+        index.clear();
+        noKeyRow = -1;
+    }
+
+    inline int getCount() const {
+        return count;
+    }
+
+    inline const GroupRow& getRow(int i) const {
+        return rows[i];
+    }
+
+    inline void clear() {
+        count = 0;
+        index.clear();
+        noKeyRow = -1;
+    }
+
+private:
+    // Copying is not supported
+    GroupByResult(const GroupByResult&);
+    GroupByResult& operator=(const GroupByResult&);
+};
+
+// Columnar group-by over a LogList
+// Blocks are split into contiguous ranges, one per worker thread. Each worker
+// computes key columns block by block in tight per-column loops, aggregates
+// into a private GroupByResult, and the partials are merged in row order.
+class GroupByEngine {
+private:
+    // Fill keys[0..n) for one block and one dimension
+    static inline void computeKeys(const LogBlock* block, int n, GroupDimension dim, unsigned int* keys) {
+        switch (dim) {
+            case GROUP_LEVEL:
+                memcpy(keys, block->levelIds, sizeof(unsigned int) * n);
+                break;
+            case GROUP_TEMPLATE:
+                memcpy(keys, block->templateIds, sizeof(unsigned int) * n);
+                break;
+            case GROUP_MESSAGE:
+                memcpy(keys, block->messageIds, sizeof(unsigned int) * n);
+                break;
+            case GROUP_MINUTE:
+            case GROUP_HOUR:
+            case GROUP_DAY: {
+                long long width = dim == GROUP_MINUTE ? 60 : (dim == GROUP_HOUR ? 3600 : 86400);
+                const long long* epochs = block->epochs;
+                for (int i = 0; i < n; i++) {
+                    keys[i] = epochs[i] >= 0 ? (unsigned int)(epochs[i] / width) : GROUP_NO_TIME;
+                }
+                break;
+            }
+            default:
+                memset(keys, 0, sizeof(unsigned int) * n);
+                break;
+        }
+    }
+
+    // Aggregate blocks [firstBlock, lastBlock) into result
+    static inline void runRange(const LogList& list, const GroupByQuery& query,
+                                int firstBlock, int lastBlock, int totalRows, GroupByResult& result) {
+        unsigned int* firstKeys = new unsigned int[LogList::BLOCK_ROWS];
+        unsigned int* secondKeys = new unsigned int[LogList::BLOCK_ROWS];
+        unsigned char* selected = new unsigned char[LogList::BLOCK_ROWS];
+        bool filterTime = query.fromEpoch != INVALID_EPOCH || query.toEpoch != INVALID_EPOCH;
+        long long from = query.fromEpoch;
+        long long to = query.toEpoch == INVALID_EPOCH ? 0x7FFFFFFFFFFFFFFFLL : query.toEpoch;
+
+        for (int b = firstBlock; b < lastBlock; b++) {
+            const LogBlock* block = list.getBlock(b);
+            int baseRow = b * LogList::BLOCK_ROWS;
+            int n = block->count;
+            if (baseRow + n > totalRows) {
+                n = totalRows - baseRow;  // Ignore rows published after the query started
+            }
+            const long long* epochs = block->epochs;
+
+            // Selection vector from the filter columns
+            for (int i = 0; i < n; i++) {
+                selected[i] = 1;
+            }
+            if (filterTime) {
+                for (int i = 0; i < n; i++) {
+                    selected[i] &= (unsigned char)(epochs[i] != INVALID_EPOCH &&
+                                                   epochs[i] >= from && epochs[i] < to);
+                }
+            }
+            if (query.levelId != StringPool::INVALID_ID) {
+                const unsigned int* levels = block->levelIds;
+                for (int i = 0; i < n; i++) {
+                    selected[i] &= (unsigned char)(levels[i] == query.levelId);
+                }
+            }
+            for (int f = 0; f < query.fieldFilterCount; f++) {
+                const FieldFilter& filter = query.fieldFilters[f];
+                const double* values = filter.column->getBlock(b);
+                for (int i = 0; i < n; i++) {
+                    selected[i] &= (unsigned char)fieldMatches(values[i], filter.op, filter.operand);
+                }
+            }
+            const double* fieldValues = query.valueField != nullptr ? query.valueField->getBlock(b) : nullptr;
+
+            // Key columns
+            computeKeys(block, n, query.first, firstKeys);
+            computeKeys(block, n, query.second, secondKeys);
+
+            // Aggregate, reusing the previous group while keys repeat
+            unsigned long long lastPacked = 0;
+            int group = -1;
+            for (int i = 0; i < n; i++) {
+                if (!selected[i]) {
+                    continue;
+                }
+                unsigned long long packed = ((unsigned long long)firstKeys[i] << 32) | secondKeys[i];
+                if (group < 0 || packed != lastPacked) {
+                    group = result.groupFor(packed);
+                    lastPacked = packed;
+                }
+                GroupRow& row = result.groupAt(group);
+                GroupByResult::accumulate(row, baseRow + i, epochs[i]);
+                if (fieldValues != nullptr && !FieldColumn::isMissing(fieldValues[i])) {
+                    GroupByResult::accumulateField(row, fieldValues[i]);
+                }
+            }
+        }
+
+        delete[] firstKeys;
+        delete[] secondKeys;
+        delete[] selected;
+    }
+
+public:
+    // Run a group-by over all rows present when the call starts
+    // Field columns in the query must already be materialized; rows past the
+    // shortest one are left out.
+    static inline void run(const LogList& list, const GroupByQuery& query, GroupByResult& result) {
+        result.clear();
+        int totalRows = list.getSize();
+        for (int f = 0; f < query.fieldFilterCount; f++) {
+            if (query.fieldFilters[f].column->getRows() < totalRows) {
+                totalRows = query.fieldFilters[f].column->getRows();
+            }
+        }
+        if (query.valueField != nullptr && query.valueField->getRows() < totalRows) {
+            totalRows = query.valueField->getRows();
+        }
+        int blocks = (totalRows + LogList::BLOCK_ROWS - 1) / LogList::BLOCK_ROWS;
+        int threads = query.threads > 0 ? query.threads : (int)std::thread::hardware_concurrency();
+        if (threads < 1) {
+            threads = 1;
+        }
+        if (threads > blocks) {
+            threads = blocks > 0 ? blocks : 1;
+        }
+
+        if (threads == 1) {
+            runRange(list, query, 0, blocks, totalRows, result);
+            return;
+        }
+
+        // Per-thread partial aggregates over contiguous block ranges
+        GroupByResult* partials = new GroupByResult[threads];
+        std::thread* workers = new std::thread[threads];
+        for (int t = 0; t < threads; t++) {
+            int firstBlock = (int)((long long)blocks * t / threads);
+            int lastBlock = (int)((long long)blocks * (t + 1) / threads);
+            workers[t] = std::thread(runRange, std::cref(list), std::cref(query),
+                                     firstBlock, lastBlock, totalRows, std::ref(partials[t]));
+        }
+        for (int t = 0; t < threads; t++) {
+            workers[t].join();
+            result.mergeFrom(partials[t]);
+        }
+        delete[] workers;
+        delete[] partials;
+    }
+};
+
+#endif // GROUP_BY_H
@@ -5,42 +5,94 @@
 #include <iostream>
 #include <cstdlib>
 #include <cctype>
+#include "memory_usage.h"
 
 // Structure to represent a hash table entry (for chaining)
+// Entries are keyed by a 32-bit string pool ID; the key text is not copied.
 struct HashNode {
-    char* key;         // Error message or keyword
+    unsigned int id;   // Interned ID of the error message or keyword
+    const char* key;   // Text for the ID (owned by the string pool)
     int count;         // Frequency count
     HashNode* next;    // Pointer to next node in chain
     
     // Constructor
-    inline HashNode(const char* k, int c) {
-        key = new char[strlen(k) + 1];
-        strcpy(key, k);
+    inline HashNode(unsigned int i, const char* k, int c) {
+        id = i;
+        key = k;
         count = c;
         next = nullptr;
     }
-    
-    // Destructor
-    inline ~HashNode() {
-        delete[] key;
-    }
 };
 
 // Hash Table class with chaining for collision resolution
 class HashTable {
 private:
-    static const int TABLE_SIZE = 101;  // Prime number for better distribution
-    HashNode** buckets;                 // Array of pointers to hash nodes
-    int totalEntries;                   // Total number of entries
+    static const int INITIAL_SIZE = 101;  // Prime number for better distribution
+    HashNode** buckets;                   // Array of pointers to hash nodes
+    int tableSize;                        // Number of buckets
+    int totalEntries;                     // Total number of entries
+    
+    // Hash function (Knuth multiplicative hash of the ID)
+    inline int hashFunction(unsigned int id) const {
+        unsigned int hash = id * 2654435761u;
+        return (int)(hash % (unsigned int)tableSize);
+    }
+    
+    // Roughly double the bucket array and relink every node (O(n))
+    inline void rehash() {
+        int oldSize = tableSize;
+        HashNode** oldBuckets = buckets;
+        tableSize = oldSize * 2 + 1;
+        buckets = new HashNode*[tableSize];
+        for (int i = 0; i < tableSize; i++) {
+            buckets[i] = nullptr;
+        }
+        for (int i = 0; i < oldSize; i++) {
+            HashNode* current = oldBuckets[i];
+            while (current != nullptr) {
+                HashNode* next = current->next;
+                int index = hashFunction(current->id);
+                current->next = buckets[index];
+                buckets[index] = current;
+                current = next;
+            }
+        }
+        delete[] oldBuckets;
+    }
     
-    // Hash function (djb2 algorithm)
-    inline int hashFunction(const char* key) const {
-        unsigned long hash = 5381;
-        int c;
-        while ((c = *key++)) {
-            hash = ((hash << 5) + hash) + c; // hash * 33 + c
+    // Min-heap helpers on node counts, used by topK()
+    static inline void siftDown(const HashNode** heap, int size, int i) {
+        while (true) {
+            int smallest = i;
+            int left = 2 * i + 1;
+            int right = left + 1;
+            if (left < size && heap[left]->count < heap[smallest]->count) {
+                smallest = left;
+            }
+            if (right < size && heap[right]->count < heap[smallest]->count) {
+                smallest = right;
+            }
+            if (smallest == i) {
+                return;
+            }
+            const HashNode* tmp = heap[i];
+            heap[i] = heap[smallest];
+            heap[smallest] = tmp;
+            i = smallest;
+        }
+    }
+    
+    static inline void siftUp(const HashNode** heap, int i) {
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (heap[parent]->count <= heap[i]->count) {
+                return;
+            }
+            const HashNode* tmp = heap[i];
+            heap[i] = heap[parent];
+            heap[parent] = tmp;
+            i = parent;
         }
-        return hash % TABLE_SIZE;
     }
     
     // Helper function to convert string to lowercase for case-insensitive comparison
@@ -53,8 +105,9 @@ private:
 public:
     // Constructor
     inline HashTable() {
-        buckets = new HashNode*[TABLE_SIZE];
-        for (int i = 0; i < TABLE_SIZE; i++) {
+        tableSize = INITIAL_SIZE;
+        buckets = new HashNode*[tableSize];
+        for (int i = 0; i < tableSize; i++) {
             buckets[i] = nullptr;
         }
         totalEntries = 0;
@@ -66,36 +119,42 @@ public:
         delete[] buckets;
     }
     
-    // Insert or update a key with its count
-    inline void insert(const char* key) {
-        int index = hashFunction(key);
+    // Insert or update a key, adding amount to its count
+    // key must remain valid for as long as the entry is in the table
+    inline void insert(unsigned int id, const char* key, int amount = 1) {
+        int index = hashFunction(id);
         HashNode* current = buckets[index];
         
         // Search for existing key in the chain
         while (current != nullptr) {
-            if (strcmp(current->key, key) == 0) {
+            if (current->id == id) {
                 // Key found, increment count
-                current->count++;
+                current->count += amount;
                 return;
             }
             current = current->next;
         }
         
         // Key not found, create new node and insert at the beginning of chain
-        HashNode* newNode = new HashNode(key, 1);
+        HashNode* newNode = new HashNode(id, key, amount);
         newNode->next = buckets[index];
         buckets[index] = newNode;
         totalEntries++;
+        
+        // Keep chains short as the number of unique keys grows
+        if (totalEntries > tableSize * 2) {
+            rehash();
+        }
     }
     
     // Get the count for a specific key
-    inline int getCount(const char* key) const {
-        int index = hashFunction(key);
+    inline int getCount(unsigned int id) const {
+        int index = hashFunction(id);
         HashNode* current = buckets[index];
         
         // Search for the key in the chain
         while (current != nullptr) {
-            if (strcmp(current->key, key) == 0) {
+            if (current->id == id) {
                 return current->count;
             }
             current = current->next;
@@ -105,12 +164,10 @@ public:
         return 0;
     }
     
-    // Display all entries in the hash table
-    inline void displayAll() const {
+    // Print every entry without a header; returns true if any were printed
+    inline bool displayEntries() const {
         bool hasEntries = false;
-        
-        std::cout << "\n=== Hash Table Entries ===\n";
-        for (int i = 0; i < TABLE_SIZE; i++) {
+        for (int i = 0; i < tableSize; i++) {
             HashNode* current = buckets[i];
             while (current != nullptr) {
                 std::cout << "Key: \"" << current->key 
@@ -119,6 +176,13 @@ public:
                 hasEntries = true;
             }
         }
+        return hasEntries;
+    }
+    
+    // Display all entries in the hash table
+    inline void displayAll() const {
+        std::cout << "\n=== Hash Table Entries ===\n";
+        bool hasEntries = displayEntries();
         
         if (!hasEntries) {
             std::cout << "No entries found.\n";
@@ -127,9 +191,50 @@ public:
         }
     }
     
+    // Find the k entries with the highest counts (exact)
+    // Uses a size-k min-heap over all nodes: O(n log k) instead of sorting all n.
+    // out must hold k pointers; results are written in descending count order.
+    // Returns the number of entries written (min(k, total entries)).
+    inline int topK(int k, const HashNode** out) const {
+        if (k <= 0) {
+            return 0;
+        }
+        int size = 0;
+        for (int i = 0; i < tableSize; i++) {
+            for (const HashNode* current = buckets[i]; current != nullptr; current = current->next) {
+                offerTopK(current, k, out, size);
+            }
+        }
+        sortTopK(out, size);
+        return size;
+    }
+    
+    // Building blocks of topK() for selecting across several tables:
+    // offer each candidate node, then sort the heap into descending order
+    static inline void offerTopK(const HashNode* node, int k, const HashNode** heap, int& size) {
+        if (size < k) {
+            heap[size] = node;
+            siftUp(heap, size);
+            size++;
+        } else if (node->count > heap[0]->count) {
+            heap[0] = node;
+            siftDown(heap, size, 0);
+        }
+    }
+    
+    static inline void sortTopK(const HashNode** heap, int size) {
+        // Heap-sort the survivors into descending order
+        for (int end = size - 1; end > 0; end--) {
+            const HashNode* tmp = heap[0];
+            heap[0] = heap[end];
+            heap[end] = tmp;
+            siftDown(heap, end, 0);
+        }
+    }
+    
     // Clear all entries
     inline void clear() {
-        for (int i = 0; i < TABLE_SIZE; i++) {
+        for (int i = 0; i < tableSize; i++) {
             HashNode* current = buckets[i];
             while (current != nullptr) {
                 HashNode* next = current->next;
@@ -141,6 +246,28 @@ public:
         totalEntries = 0;
     }
     
+    // Copy every (id, count) pair; the arrays must hold getTotalEntries() items
+    inline int copyEntries(unsigned int* ids, int* counts) const {
+        int written = 0;
+        for (int i = 0; i < tableSize; i++) {
+            for (const HashNode* current = buckets[i]; current != nullptr; current = current->next) {
+                ids[written] = current->id;
+                counts[written] = current->count;
+                written++;
+            }
+        }
+        return written;
+    }
+    
+    // Add the memory held by the buckets and nodes
+    // Payload is each node's ID and count; the key pointer, chain link and
+    // bucket array are overhead.
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        usage.addHeap(sizeof(HashNode*) * tableSize, 0, sizeof(HashNode*) * tableSize);
+        usage.addHeap(sizeof(HashNode), sizeof(unsigned int) + sizeof(int),
+                      sizeof(const char*) + sizeof(HashNode*), totalEntries);
+    }
+    
     // Get total number of entries
     inline int getTotalEntries() const {
         return totalEntries;
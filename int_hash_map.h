@@ -0,0 +1,223 @@
+#ifndef INT_HASH_MAP_H
+#define INT_HASH_MAP_H
+
+#include "snapshot.h"
+#include "memory_usage.h"
+#include <cstring>
+#include <cstdlib>
+
+// Open-addressing hash map from 64-bit keys to 64-bit values
+// Used for compact ID -> ID and bucket -> count lookups where a chained
+// HashTable node per key would cost too much memory.
+class IntHashMap {
+public:
+    static const unsigned long long EMPTY_KEY = 0xFFFFFFFFFFFFFFFFULL;
+
+private:
+    unsigned long long* keys;    // EMPTY_KEY marks a free slot
+    long long* values;
+    int capacity;                // Power of two
+    int count;
+
+    // 64-bit finalizer (from MurmurHash3)
+    static inline unsigned long long mix(unsigned long long key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    inline void allocate(int newCapacity) {
+        keys = new unsigned long long[newCapacity];
+        values = new long long[newCapacity];
+        memset(keys, 0xFF, sizeof(unsigned long long) * newCapacity);
+        capacity = newCapacity;
+    }
+
+    // Find the slot holding key, or the free slot where it belongs
+    inline int findSlot(unsigned long long key) const {
+        int mask = capacity - 1;
+        int pos = (int)(mix(key) & (unsigned long long)mask);
+        while (keys[pos] != EMPTY_KEY && keys[pos] != key) {
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    inline void grow() {
+        unsigned long long* oldKeys = keys;
+        long long* oldValues = values;
+        int oldCapacity = capacity;
+        allocate(oldCapacity * 2);
+        for (int i = 0; i < oldCapacity; i++) {
+            if (oldKeys[i] != EMPTY_KEY) {
+                int pos = findSlot(oldKeys[i]);
+                keys[pos] = oldKeys[i];
+                values[pos] = oldValues[i];
+            }
+        }
+        delete[] oldKeys;
+        delete[] oldValues;
+    }
+
+public:
+    // Constructor (initialCapacity must be a power of two)
+    inline IntHashMap(int initialCapacity = 16) {
+        allocate(initialCapacity);
+        count = 0;
+    }
+
+    // Destructor
+    inline ~IntHashMap() {
+        delete[] keys;
+        delete[] values;
+    }
+
+    // Look up a key; returns false if it is absent
+    inline bool get(unsigned long long key, long long& value) const {
+        int pos = findSlot(key);
+        if (keys[pos] == EMPTY_KEY) {
+            return false;
+        }
+        value = values[pos];
+        return true;
+    }
+
+    // Insert or overwrite a key
+    inline void put(unsigned long long key, long long value) {
+        valueRef(key, 0) = value;
+    }
+
+    // Add delta to a key's value (absent keys start at zero); returns the new value
+    inline long long add(unsigned long long key, long long delta) {
+        long long& value = valueRef(key, 0);
+        value += delta;
+        return value;
+    }
+
+    // Reference to a key's value, inserting initial if absent
+    // The reference is invalidated by the next insertion
+    inline long long& valueRef(unsigned long long key, long long initial) {
+        int pos = findSlot(key);
+        if (keys[pos] == EMPTY_KEY) {
+            // Keep the load factor at or below 0.7
+            if ((count + 1) * 10 > capacity * 7) {
+                grow();
+                pos = findSlot(key);
+            }
+            keys[pos] = key;
+            values[pos] = initial;
+            count++;
+        }
+        return values[pos];
+    }
+
+    // Remove a key if present (backward-shift deletion keeps probe chains intact)
+    inline void remove(unsigned long long key) {
+        int mask = capacity - 1;
+        int pos = findSlot(key);
+        if (keys[pos] == EMPTY_KEY) {
+            return;
+        }
+        int next = (pos + 1) & mask;
+        while (keys[next] != EMPTY_KEY) {
+            int home = (int)(mix(keys[next]) & (unsigned long long)mask);
+            // Move the entry back if its home slot is not in (pos, next]
+            if (((next - home) & mask) >= ((next - pos) & mask)) {
+                keys[pos] = keys[next];
+                values[pos] = values[next];
+                pos = next;
+            }
+            next = (next + 1) & mask;
+        }
+        keys[pos] = EMPTY_KEY;
+        count--;
+    }
+
+    // Number of keys stored
+    inline int size() const {
+        return count;
+    }
+
+    // Slot-level iteration: for (i < getCapacity()) if (isOccupied(i)) ...
+    inline int getCapacity() const {
+        return capacity;
+    }
+
+    inline bool isOccupied(int slot) const {
+        return keys[slot] != EMPTY_KEY;
+    }
+
+    inline unsigned long long keyAt(int slot) const {
+        return keys[slot];
+    }
+
+    inline long long valueAt(int slot) const {
+        return values[slot];
+    }
+
+    // Add the memory held by the slot arrays
+    // Occupied slots are payload; free slots kept for the load factor are overhead.
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        size_t used = (size_t)count;
+        size_t empty = (size_t)(capacity - count);
+        usage.addHeap(sizeof(unsigned long long) * capacity, sizeof(unsigned long long) * used,
+                      sizeof(unsigned long long) * empty);
+        usage.addHeap(sizeof(long long) * capacity, sizeof(long long) * used, sizeof(long long) * empty);
+    }
+
+    // Write the table to a snapshot as raw slot arrays
+    inline void saveTo(SnapshotWriter& writer) const {
+        writer.writeU64((unsigned long long)capacity);
+        writer.writeU64((unsigned long long)count);
+        writer.writeArray(keys, sizeof(unsigned long long) * capacity);
+        writer.writeArray(values, sizeof(long long) * capacity);
+    }
+
+    // Replace the contents with a table saved by saveTo() (two bulk copies, no rehashing)
+    inline bool loadFrom(SnapshotCursor& cursor) {
+        unsigned long long newCapacity = cursor.readU64();
+        unsigned long long newCount = cursor.readU64();
+        if (newCapacity == 0 || newCapacity > (1ULL << 30) || (newCapacity & (newCapacity - 1)) != 0 ||
+            newCount >= newCapacity) {
+            cursor.fail();
+            return false;
+        }
+        const void* savedKeys = cursor.readArray(sizeof(unsigned long long) * newCapacity);
+        const void* savedValues = cursor.readArray(sizeof(long long) * newCapacity);
+        if (cursor.hasFailed()) {
+            return false;
+        }
+        // A count that disagrees with the slots could leave no free slot to probe to
+        unsigned long long occupied = 0;
+        for (unsigned long long i = 0; i < newCapacity; i++) {
+            occupied += ((const unsigned long long*)savedKeys)[i] != EMPTY_KEY;
+        }
+        if (occupied != newCount) {
+            cursor.fail();
+            return false;
+        }
+        delete[] keys;
+        delete[] values;
+        allocate((int)newCapacity);
+        memcpy(keys, savedKeys, sizeof(unsigned long long) * newCapacity);
+        memcpy(values, savedValues, sizeof(long long) * newCapacity);
+        count = (int)newCount;
+        return true;
+    }
+
+    // Remove all keys (keeps the current capacity)
+    inline void clear() {
+        memset(keys, 0xFF, sizeof(unsigned long long) * capacity);
+        count = 0;
+    }
+
+private:
+    // Copying is not supported
+    IntHashMap(const IntHashMap&);
+    IntHashMap& operator=(const IntHashMap&);
+};
+
+#endif // INT_HASH_MAP_H
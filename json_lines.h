@@ -0,0 +1,611 @@
+#ifndef JSON_LINES_H
+#define JSON_LINES_H
+
+#include "log_parser.h"
+#include "timestamp.h"
+#include <cstring>
+#include <cstdlib>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Which JSON keys hold the entry fields
+// Each list is comma-separated alternatives, tried in order. Other keys are
+// appended to the message as " key=value" when keepExtraFields is set, so
+// numeric ones can be queried with field filters.
+struct JsonFormat {
+    char timestampKeys[128];
+    char levelKeys[128];
+    char messageKeys[128];
+    bool keepExtraFields;
+
+    inline JsonFormat() {
+        strcpy(timestampKeys, "timestamp,time,ts,@timestamp");
+        strcpy(levelKeys, "level,severity,lvl,loglevel");
+        strcpy(messageKeys, "message,msg,@message");
+        keepExtraFields = true;
+    }
+};
+
+// Bitmasks for one 64-byte chunk: bit i is set if byte i is that character
+struct JsonChunkMasks {
+    unsigned long long quote;
+    unsigned long long backslash;
+    unsigned long long structural;    // { } [ ] : ,
+};
+
+// Classify 64 bytes one at a time
+inline void classifyJsonChunkScalar(const char* chunk, JsonChunkMasks& masks) {
+    masks.quote = 0;
+    masks.backslash = 0;
+    masks.structural = 0;
+    for (int i = 0; i < 64; i++) {
+        unsigned long long bit = 1ULL << i;
+        char c = chunk[i];
+        if (c == '"') {
+            masks.quote |= bit;
+        } else if (c == '\\') {
+            masks.backslash |= bit;
+        } else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') {
+            masks.structural |= bit;
+        }
+    }
+}
+
+#if defined(__SSE2__)
+// Classify 64 bytes with SSE2 compares, 16 bytes per instruction
+// Brackets and braces differ only in bit 0x20, so OR-ing it in folds
+// '[' and ']' onto '{' and '}' and four compares cover all six characters.
+inline void classifyJsonChunk(const char* chunk, JsonChunkMasks& masks) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    masks.quote = 0;
+    masks.backslash = 0;
+    masks.structural = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(chunk + i * 16));
+        __m128i folded = _mm_or_si128(bytes, caseBit);
+        __m128i structural = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, colon), _mm_cmpeq_epi8(bytes, comma)));
+        int shift = i * 16;
+        masks.quote |= (unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)) << shift;
+        masks.backslash |= (unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash)) << shift;
+        masks.structural |= (unsigned long long)(unsigned int)_mm_movemask_epi8(structural) << shift;
+    }
+}
+#else
+inline void classifyJsonChunk(const char* chunk, JsonChunkMasks& masks) {
+    classifyJsonChunkScalar(chunk, masks);
+}
+#endif
+
+// Bits of characters escaped by a backslash run (odd-length runs escape
+// the next character); carry holds whether the next chunk starts escaped
+inline unsigned long long findEscapedBits(unsigned long long backslash, unsigned long long& carry) {
+    const unsigned long long EVEN_BITS = 0x5555555555555555ULL;
+    backslash &= ~carry;
+    unsigned long long followsEscape = (backslash << 1) | carry;
+    unsigned long long oddStarts = backslash & ~EVEN_BITS & ~followsEscape;
+    unsigned long long evenStartRuns;
+    carry = __builtin_add_overflow(oddStarts, backslash, &evenStartRuns) ? 1 : 0;
+    unsigned long long invert = evenStartRuns << 1;
+    return (EVEN_BITS ^ invert) & followsEscape;
+}
+
+// Prefix XOR: bit i is the parity of bits 0..i, i.e. "inside a string"
+// when applied to unescaped quote bits
+inline unsigned long long prefixXor(unsigned long long bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Parser for one JSON object per line
+// Stage one classifies the line 64 bytes at a time into bitmasks, removes
+// escaped quotes and everything inside strings, and records the positions
+// of the remaining structural characters and string quotes. Stage two walks
+// only those positions to find each key and value, so the bytes of long
+// strings are never looked at one by one. Nested objects and arrays are kept
+// as raw text. Fields are mapped onto timestamp, level and message by a
+// JsonFormat; a numeric timestamp is read as Unix seconds (or milliseconds,
+// microseconds, nanoseconds by magnitude).
+class JsonLineParser {
+private:
+    // One top-level key and its value (spans in the line)
+    struct Field {
+        const char* key;
+        size_t keyLength;
+        const char* value;
+        size_t valueLength;
+        char kind;             // 's' string (without quotes), 'n' scalar, 'o' object or array
+    };
+
+    // Entry fields a key can map onto
+    static const int ROLE_TIMESTAMP = 0;
+    static const int ROLE_LEVEL = 1;
+    static const int ROLE_MESSAGE = 2;
+    static const int ROLE_COUNT = 3;
+    static const int MAX_KEYS = 16;        // Alternatives per role
+
+    JsonFormat format;
+    const char* keyNames[ROLE_COUNT][MAX_KEYS];  // Into format's lists
+    size_t keyLengths[ROLE_COUNT][MAX_KEYS];
+    int keyCount[ROLE_COUNT];
+    unsigned char firstByteRoles[256];      // Bit r set if a role r key starts with the byte
+    bool vectorized;
+    unsigned int* indexes;     // Structural positions from stage one
+    size_t indexCapacity;
+    Field* fields;
+    int fieldCapacity;
+    int fieldCount;
+    char* text;                // Output "timestamp\0level\0message\0"
+    size_t textCapacity;
+    size_t textLength;
+
+    inline void reserveText(size_t needed) {
+        if (needed <= textCapacity) {
+            return;
+        }
+        while (textCapacity < needed) {
+            textCapacity *= 2;
+        }
+        char* grown = new char[textCapacity];
+        memcpy(grown, text, textLength);
+        delete[] text;
+        text = grown;
+    }
+
+    inline void append(const char* data, size_t length) {
+        reserveText(textLength + length + 1);
+        memcpy(text + textLength, data, length);
+        textLength += length;
+    }
+
+    inline void appendChar(char c) {
+        reserveText(textLength + 2);
+        text[textLength++] = c;
+    }
+
+    inline static int hexValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    inline static unsigned int readHex4(const char* p, const char* end, bool& ok) {
+        unsigned int value = 0;
+        ok = end - p >= 4;
+        for (int i = 0; ok && i < 4; i++) {
+            int digit = hexValue(p[i]);
+            ok = digit >= 0;
+            value = (value << 4) | (unsigned int)digit;
+        }
+        return value;
+    }
+
+    inline void appendUtf8(unsigned int code) {
+        if (code == 0) {
+            appendChar(' ');
+        } else if (code < 0x80) {
+            appendChar((char)code);
+        } else if (code < 0x800) {
+            appendChar((char)(0xC0 | (code >> 6)));
+            appendChar((char)(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            appendChar((char)(0xE0 | (code >> 12)));
+            appendChar((char)(0x80 | ((code >> 6) & 0x3F)));
+            appendChar((char)(0x80 | (code & 0x3F)));
+        } else {
+            appendChar((char)(0xF0 | (code >> 18)));
+            appendChar((char)(0x80 | ((code >> 12) & 0x3F)));
+            appendChar((char)(0x80 | ((code >> 6) & 0x3F)));
+            appendChar((char)(0x80 | (code & 0x3F)));
+        }
+    }
+
+    // Append a string value, decoding escapes
+    inline void appendString(const char* value, size_t length) {
+        const char* end = value + length;
+        const char* escape = (const char*)memchr(value, '\\', length);
+        while (escape != nullptr) {
+            append(value, (size_t)(escape - value));
+            const char* p = escape + 1;
+            char c = p < end ? *p++ : '\\';
+            switch (c) {
+                case 'n': appendChar('\n'); break;
+                case 't': appendChar('\t'); break;
+                case 'r': appendChar('\r'); break;
+                case 'b': appendChar('\b'); break;
+                case 'f': appendChar('\f'); break;
+                case 'u': {
+                    bool ok;
+                    unsigned int code = readHex4(p, end, ok);
+                    if (!ok) {
+                        appendChar('?');
+                        break;
+                    }
+                    p += 4;
+                    if (code >= 0xD800 && code < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        unsigned int low = readHex4(p + 2, end, ok);
+                        if (ok && low >= 0xDC00 && low < 0xE000) {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                            p += 6;
+                        }
+                    }
+                    appendUtf8(code);
+                    break;
+                }
+                default: appendChar(c); break;  // \" \\ \/ and anything unknown
+            }
+            value = p;
+            escape = (const char*)memchr(value, '\\', (size_t)(end - value));
+        }
+        append(value, (size_t)(end - value));
+    }
+
+    // Append a field value as text (strings decoded, others raw)
+    inline void appendValue(const Field& field) {
+        if (field.kind == 's') {
+            appendString(field.value, field.valueLength);
+        } else {
+            append(field.value, field.valueLength);
+        }
+    }
+
+    // Split the comma-separated key lists of the format into keyNames
+    inline void compileKeys() {
+        const char* lists[ROLE_COUNT] = { format.timestampKeys, format.levelKeys, format.messageKeys };
+        memset(firstByteRoles, 0, sizeof(firstByteRoles));
+        for (int role = 0; role < ROLE_COUNT; role++) {
+            keyCount[role] = 0;
+            const char* name = lists[role];
+            while (*name != '\0' && keyCount[role] < MAX_KEYS) {
+                const char* comma = strchr(name, ',');
+                size_t length = comma != nullptr ? (size_t)(comma - name) : strlen(name);
+                if (length > 0) {
+                    keyNames[role][keyCount[role]] = name;
+                    keyLengths[role][keyCount[role]] = length;
+                    keyCount[role]++;
+                    firstByteRoles[(unsigned char)name[0]] |= (unsigned char)(1 << role);
+                }
+                if (comma == nullptr) {
+                    break;
+                }
+                name = comma + 1;
+            }
+        }
+    }
+
+    // Field index for each role (-1 if absent); earlier alternatives win
+    inline void assignRoles(int* roleField) const {
+        int rank[ROLE_COUNT];
+        for (int role = 0; role < ROLE_COUNT; role++) {
+            roleField[role] = -1;
+            rank[role] = keyCount[role];
+        }
+        for (int i = 0; i < fieldCount; i++) {
+            const Field& field = fields[i];
+            unsigned int roles = field.keyLength > 0 ? firstByteRoles[(unsigned char)field.key[0]] : 0;
+            for (int role = 0; roles != 0 && role < ROLE_COUNT; role++) {
+                if ((roles & (1u << role)) == 0) {
+                    continue;
+                }
+                for (int k = 0; k < rank[role]; k++) {
+                    if (keyLengths[role][k] == field.keyLength &&
+                        memcmp(keyNames[role][k], field.key, field.keyLength) == 0) {
+                        roleField[role] = i;
+                        rank[role] = k;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    inline void addField(const char* key, size_t keyLength, const char* value, size_t valueLength, char kind) {
+        if (fieldCount == fieldCapacity) {
+            Field* grown = new Field[fieldCapacity * 2];
+            memcpy(grown, fields, sizeof(Field) * fieldCount);
+            delete[] fields;
+            fields = grown;
+            fieldCapacity *= 2;
+        }
+        Field& field = fields[fieldCount++];
+        field.key = key;
+        field.keyLength = keyLength;
+        field.value = value;
+        field.valueLength = valueLength;
+        field.kind = kind;
+    }
+
+    // Stage one: positions of structural characters and string quotes
+    // outside strings; returns the count, or -1 if a string is unterminated
+    inline long long indexStructurals(const char* line, size_t length) {
+        if (indexCapacity < length + 72) {
+            delete[] indexes;
+            indexCapacity = length + 72;
+            indexes = new unsigned int[indexCapacity];
+        }
+        size_t count = 0;
+        unsigned long long escapeCarry = 0;
+        unsigned long long inStringCarry = 0;
+        char tail[64];
+        for (size_t offset = 0; offset < length; offset += 64) {
+            const char* chunk = line + offset;
+            if (length - offset < 64) {
+                // Pad the last partial chunk with spaces (no structural meaning)
+                memset(tail, ' ', sizeof(tail));
+                memcpy(tail, chunk, length - offset);
+                chunk = tail;
+            }
+            JsonChunkMasks masks;
+            if (vectorized) {
+                classifyJsonChunk(chunk, masks);
+            } else {
+                classifyJsonChunkScalar(chunk, masks);
+            }
+            unsigned long long quotes = masks.quote;
+            if (masks.backslash != 0 || escapeCarry != 0) {
+                quotes &= ~findEscapedBits(masks.backslash, escapeCarry);
+            }
+            unsigned long long inString = prefixXor(quotes) ^ inStringCarry;
+            inStringCarry = (unsigned long long)((long long)inString >> 63);
+            unsigned long long bits = (masks.structural & ~inString) | quotes;
+            while (bits != 0) {
+                indexes[count++] = (unsigned int)(offset + (size_t)__builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+        return inStringCarry != 0 ? -1 : (long long)count;
+    }
+
+    inline static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Stage two: split a flat object into fields using the positions
+    inline bool walkObject(const char* line, size_t length, size_t count) {
+        fieldCount = 0;
+        size_t k = 0;
+        if (count < 2 || line[indexes[0]] != '{') {
+            return false;
+        }
+        for (size_t i = 0; i < indexes[0]; i++) {
+            if (!isSpace(line[i])) {
+                return false;
+            }
+        }
+        k = 1;
+        if (line[indexes[k]] != '}') {
+            while (true) {
+                // "key" :
+                if (k + 2 >= count || line[indexes[k]] != '"' || line[indexes[k + 1]] != '"' ||
+                    line[indexes[k + 2]] != ':') {
+                    return false;
+                }
+                const char* key = line + indexes[k] + 1;
+                size_t keyLength = indexes[k + 1] - indexes[k] - 1;
+                size_t colon = indexes[k + 2];
+                k += 3;
+                if (k >= count) {
+                    return false;
+                }
+                char opener = line[indexes[k]];
+                if (opener == '"') {
+                    if (k + 1 >= count) {
+                        return false;
+                    }
+                    addField(key, keyLength, line + indexes[k] + 1, indexes[k + 1] - indexes[k] - 1, 's');
+                    k += 2;
+                } else if (opener == '{' || opener == '[') {
+                    size_t first = indexes[k];
+                    int depth = 0;
+                    do {
+                        char c = line[indexes[k]];
+                        if (c == '{' || c == '[') {
+                            depth++;
+                        } else if (c == '}' || c == ']') {
+                            depth--;
+                        }
+                        k++;
+                    } while (depth > 0 && k < count);
+                    if (depth != 0) {
+                        return false;
+                    }
+                    addField(key, keyLength, line + first, indexes[k - 1] + 1 - first, 'o');
+                } else {
+                    // Number, true, false or null: the text up to the next ',' or '}'
+                    size_t first = colon + 1;
+                    size_t last = indexes[k];
+                    while (first < last && isSpace(line[first])) {
+                        first++;
+                    }
+                    while (last > first && isSpace(line[last - 1])) {
+                        last--;
+                    }
+                    if (first == last) {
+                        return false;
+                    }
+                    addField(key, keyLength, line + first, last - first, 'n');
+                }
+                if (k >= count) {
+                    return false;
+                }
+                if (line[indexes[k]] == '}') {
+                    break;
+                }
+                if (line[indexes[k]] != ',') {
+                    return false;
+                }
+                k++;
+            }
+        }
+        // Only whitespace may follow the closing brace
+        if (k + 1 != count) {
+            return false;
+        }
+        for (size_t i = indexes[k] + 1; i < length; i++) {
+            if (!isSpace(line[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Write the timestamp field, converting numeric epochs to text
+    inline long long appendTimestamp(int index) {
+        if (index < 0) {
+            return INVALID_EPOCH;
+        }
+        const Field& field = fields[index];
+        if (field.kind == 'n') {
+            char number[64];
+            size_t length = field.valueLength < sizeof(number) - 1 ? field.valueLength : sizeof(number) - 1;
+            memcpy(number, field.value, length);
+            number[length] = '\0';
+            char* end;
+            double value = strtod(number, &end);
+            if (end != number && value > 0) {
+                // Scale milliseconds, microseconds and nanoseconds down to seconds
+                while (value >= 1e11) {
+                    value /= 1000.0;
+                }
+                char formatted[20];
+                formatTimestamp((long long)value, formatted);
+                append(formatted, strlen(formatted));
+                return (long long)value;
+            }
+        }
+        size_t start = textLength;
+        appendValue(field);
+        reserveText(textLength + 1);
+        text[textLength] = '\0';
+        return parseTimestamp(text + start);
+    }
+
+public:
+    // Constructor; vectorized = false forces the scalar classifier
+    inline explicit JsonLineParser(const JsonFormat& jsonFormat = JsonFormat(), bool useSimd = true)
+        : format(jsonFormat) {
+        vectorized = useSimd;
+        compileKeys();
+        indexCapacity = 1024;
+        indexes = new unsigned int[indexCapacity];
+        fieldCapacity = 16;
+        fields = new Field[fieldCapacity];
+        fieldCount = 0;
+        textCapacity = 1024;
+        text = new char[textCapacity];
+        textLength = 0;
+    }
+
+    inline ~JsonLineParser() {
+        delete[] indexes;
+        delete[] fields;
+        delete[] text;
+    }
+
+    // Parse one line holding a JSON object
+    // Returns false if the line is not a well-formed flat-or-nested JSON
+    // object. The output points into the parser and stays valid until the
+    // next call; an entry without a timestamp key has epoch INVALID_EPOCH.
+    inline bool parse(const char* line, size_t length, ParsedLine& out) {
+        size_t first = 0;
+        while (first < length && isSpace(line[first])) {
+            first++;
+        }
+        if (first == length || line[first] != '{' || length > 0xFFFFFFFFu) {
+            return false;
+        }
+        long long count = indexStructurals(line, length);
+        if (count < 0 || !walkObject(line, length, (size_t)count)) {
+            return false;
+        }
+
+        int roleField[ROLE_COUNT];
+        assignRoles(roleField);
+        int timestampField = roleField[ROLE_TIMESTAMP];
+        int levelField = roleField[ROLE_LEVEL];
+        int messageField = roleField[ROLE_MESSAGE];
+
+        textLength = 0;
+        long long epoch = appendTimestamp(timestampField);
+        appendChar('\0');
+        size_t levelOffset = textLength;
+        if (levelField >= 0 && fields[levelField].valueLength > 0) {
+            // Level aliases ("warn", "fatal", "Error") get the text parser's names
+            appendValue(fields[levelField]);
+            const char* canonical = canonicalLevel(text + levelOffset, textLength - levelOffset);
+            if (canonical != nullptr) {
+                textLength = levelOffset;
+                append(canonical, strlen(canonical));
+            }
+        } else {
+            append(UNKNOWN_LEVEL, strlen(UNKNOWN_LEVEL));
+        }
+        appendChar('\0');
+        size_t messageOffset = textLength;
+        if (messageField >= 0) {
+            appendValue(fields[messageField]);
+        }
+        if (format.keepExtraFields) {
+            for (int i = 0; i < fieldCount; i++) {
+                if (i == timestampField || i == levelField || i == messageField) {
+                    continue;
+                }
+                const Field& field = fields[i];
+                if (textLength > messageOffset) {
+                    appendChar(' ');
+                }
+                append(field.key, field.keyLength);
+                appendChar('=');
+                bool quoted = field.kind == 's' && memchr(field.value, ' ', field.valueLength) != nullptr;
+                if (quoted) {
+                    appendChar('"');
+                }
+                appendValue(field);
+                if (quoted) {
+                    appendChar('"');
+                }
+            }
+        }
+        reserveText(textLength + 1);
+        text[textLength] = '\0';
+
+        out.timestamp = text;
+        out.level = text + levelOffset;
+        out.message = text + messageOffset;
+        out.messageLength = textLength - messageOffset;
+        out.epoch = epoch;
+        return true;
+    }
+
+    // LogLineAssembler hook
+    inline static bool parseLine(void* parser, char* line, size_t length, ParsedLine& out) {
+        return ((JsonLineParser*)parser)->parse(line, length, out);
+    }
+
+private:
+    // Copying is not supported
+    JsonLineParser(const JsonLineParser&);
+    JsonLineParser& operator=(const JsonLineParser&);
+};
+
+#endif // JSON_LINES_H
@@ -145,4 +145,99 @@ public:
     }
 };
 
+// A pattern compiled once for repeated searches
+// The failure table is built up front; a case-insensitive pattern is stored
+// in lowercase and text is folded while it is scanned, so no copy is made.
+class KMPPattern {
+private:
+    char* pattern;
+    int* failure;
+    int length;
+    bool caseSensitive;
+    
+public:
+    inline KMPPattern() {
+        pattern = nullptr;
+        failure = nullptr;
+        length = 0;
+        caseSensitive = true;
+    }
+    
+    inline ~KMPPattern() {
+        release();
+    }
+    
+    // Compile text (an empty pattern never matches)
+    inline void compile(const char* text, bool matchCase) {
+        release();
+        length = (int)strlen(text);
+        caseSensitive = matchCase;
+        pattern = new char[length + 1];
+        for (int i = 0; i < length; i++) {
+            pattern[i] = matchCase ? text[i] : (char)tolower((unsigned char)text[i]);
+        }
+        pattern[length] = '\0';
+        failure = new int[length > 0 ? length : 1];
+        failure[0] = 0;
+        int j = 0;
+        for (int i = 1; i < length; i++) {
+            while (j > 0 && pattern[i] != pattern[j]) {
+                j = failure[j - 1];
+            }
+            if (pattern[i] == pattern[j]) {
+                j++;
+            }
+            failure[i] = j;
+        }
+    }
+    
+    inline void release() {
+        delete[] pattern;
+        delete[] failure;
+        pattern = nullptr;
+        failure = nullptr;
+        length = 0;
+    }
+    
+    // Number of occurrences in text, overlapping ones included (as KMP::search)
+    inline int count(const char* text) const {
+        if (length == 0) {
+            return 0;
+        }
+        int found = 0;
+        int j = 0;
+        for (const char* p = text; *p != '\0'; p++) {
+            char c = caseSensitive ? *p : (char)tolower((unsigned char)*p);
+            while (j > 0 && c != pattern[j]) {
+                j = failure[j - 1];
+            }
+            if (c == pattern[j]) {
+                j++;
+            }
+            if (j == length) {
+                found++;
+                j = failure[j - 1];
+            }
+        }
+        return found;
+    }
+    
+    inline const char* getText() const {
+        return pattern != nullptr ? pattern : "";
+    }
+    
+    inline int getLength() const {
+        return length;
+    }
+    
+    inline bool isCaseSensitive() const {
+        return caseSensitive;
+    }
+    
+private:
+    // Copying is not supported
+    KMPPattern(const KMPPattern&);
+    KMPPattern& operator=(const KMPPattern&);
+};
+
 #endif // KMP_H
\ No newline at end of file
@@ -0,0 +1,229 @@
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unistd.h>
+
+// Supplies bytes to a LineReader in place of read(); returns the number of
+// bytes copied into `into` (at most size), 0 at end of input, -1 on error
+typedef ssize_t (*LineSource)(void* context, char* into, size_t size);
+
+// Buffered line reader over a file descriptor or a LineSource
+// Reads in large chunks and hands out lines in place (NUL-terminated, with
+// the '\n' and any trailing '\r' removed). Lines of any length are supported:
+// the buffer grows to hold the longest line seen.
+//
+// With prefetching on, a background thread reads the next block into a
+// second buffer while the caller parses the current one (double buffering),
+// so waiting on a slow pipe overlaps with parsing. Each read returns as soon
+// as some input is available, so lines are delivered as they arrive.
+class LineReader {
+private:
+    int fd;
+    LineSource source;
+    void* sourceContext;
+    char* buffer;
+    size_t capacity;
+    size_t start;              // First unread byte
+    size_t end;                // One past the last buffered byte
+    bool eof;
+    long long bytesRead;
+
+    // Double buffering (prefetch mode only)
+    bool prefetching;
+    std::thread prefetcher;
+    std::mutex lock;
+    std::condition_variable signal;
+    char* block;               // Filled by the prefetch thread
+    size_t blockSize;
+    ssize_t blockFilled;       // Result of the last read into block
+    bool blockReady;
+    bool stopping;
+
+    inline static ssize_t readSome(int fd, char* into, size_t size) {
+        ssize_t got;
+        do {
+            got = ::read(fd, into, size);
+        } while (got < 0 && errno == EINTR);
+        return got;
+    }
+
+    inline ssize_t readFrom(char* into, size_t size) {
+        return source != nullptr ? source(sourceContext, into, size) : readSome(fd, into, size);
+    }
+
+    inline void prefetchLoop() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            while (blockReady && !stopping) {
+                signal.wait(guard);
+            }
+            if (stopping) {
+                return;
+            }
+            guard.unlock();
+            ssize_t got = readFrom(block, blockSize);
+            guard.lock();
+            blockFilled = got;
+            blockReady = true;
+            signal.notify_all();
+            if (got <= 0) {
+                return;
+            }
+        }
+    }
+
+    // Take the block the prefetch thread filled and let it read the next one
+    inline ssize_t takeBlock(char* into) {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!blockReady) {
+            signal.wait(guard);
+        }
+        ssize_t got = blockFilled;
+        if (got > 0) {
+            memcpy(into, block, (size_t)got);
+            blockReady = false;
+            signal.notify_all();
+        }
+        return got;
+    }
+
+    // Move unread bytes to the front, growing if the buffer is full, then read more
+    inline bool refill() {
+        if (start > 0) {
+            memmove(buffer, buffer + start, end - start);
+            end -= start;
+            start = 0;
+        }
+        size_t needed = end + 1 + (prefetching ? blockSize : 1);
+        if (needed > capacity) {
+            while (capacity < needed) {
+                capacity *= 2;
+            }
+            char* grown = new char[capacity];
+            memcpy(grown, buffer, end);
+            delete[] buffer;
+            buffer = grown;
+        }
+        // Keep one byte free for the terminator of an unterminated last line
+        ssize_t got = prefetching ? takeBlock(buffer + end) : readFrom(buffer + end, capacity - end - 1);
+        if (got <= 0) {
+            eof = true;
+            return false;
+        }
+        end += (size_t)got;
+        bytesRead += got;
+        return true;
+    }
+
+    // Shared constructor setup
+    inline void init(size_t bufferSize, bool prefetch) {
+        capacity = bufferSize > 16 ? bufferSize : 16;
+        buffer = new char[capacity];
+        start = 0;
+        end = 0;
+        eof = false;
+        bytesRead = 0;
+        prefetching = prefetch;
+        block = nullptr;
+        blockSize = capacity;
+        blockFilled = 0;
+        blockReady = false;
+        stopping = false;
+        if (prefetching) {
+            block = new char[blockSize];
+            prefetcher = std::thread(&LineReader::prefetchLoop, this);
+        }
+    }
+
+public:
+    // Constructor (does not take ownership of fd)
+    // With prefetch, reading starts immediately on a background thread.
+    inline LineReader(int fileDescriptor, size_t bufferSize = 1 << 20, bool prefetch = false) {
+        fd = fileDescriptor;
+        source = nullptr;
+        sourceContext = nullptr;
+        init(bufferSize, prefetch);
+    }
+
+    // Constructor reading through a LineSource instead of a file descriptor
+    // With prefetch, the source is called on the background thread.
+    inline LineReader(LineSource lineSource, void* context, size_t bufferSize = 1 << 20,
+                      bool prefetch = false) {
+        fd = -1;
+        source = lineSource;
+        sourceContext = context;
+        init(bufferSize, prefetch);
+    }
+
+    // Destructor
+    // A prefetching reader waits for a read in progress, so on a pipe or
+    // terminal it should be read to end of input first.
+    inline ~LineReader() {
+        if (prefetching) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            signal.notify_all();
+            prefetcher.join();
+            delete[] block;
+        }
+        delete[] buffer;
+    }
+
+    // Get the next line; false at end of input
+    // The line stays valid until the next call.
+    inline bool next(char*& line, size_t& length) {
+        size_t scanned = start;
+        while (true) {
+            char* newline = (char*)memchr(buffer + scanned, '\n', end - scanned);
+            if (newline != nullptr) {
+                line = buffer + start;
+                length = (size_t)(newline - line);
+                start = (size_t)(newline - buffer) + 1;
+                break;
+            }
+            if (eof) {
+                if (start == end) {
+                    return false;
+                }
+                line = buffer + start;
+                length = end - start;
+                start = end;
+                break;
+            }
+            // Only the bytes after what was already scanned need searching
+            size_t searched = end - start;
+            refill();
+            scanned = start + searched;
+        }
+        if (length > 0 && line[length - 1] == '\r') {
+            length--;
+        }
+        line[length] = '\0';
+        return true;
+    }
+
+    inline long long getBytesRead() const {
+        return bytesRead;
+    }
+
+    // True when every buffered byte has been returned, so the next call reads
+    // (and on a pipe or terminal may wait for input)
+    inline bool isDrained() const {
+        return start == end;
+    }
+
+private:
+    // Copying is not supported
+    LineReader(const LineReader&);
+    LineReader& operator=(const LineReader&);
+};
+
+#endif // LINE_READER_H
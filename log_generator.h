@@ -0,0 +1,617 @@
+#ifndef LOG_GENERATOR_H
+#define LOG_GENERATOR_H
+
+#include "timestamp.h"
+#include <cstring>
+#include <cmath>
+
+// Settings for LogGenerator
+// The same settings and seed always produce the same output, however the
+// work is split across threads.
+struct GeneratorConfig {
+    unsigned long long seed;
+    long long entries;          // Entries to generate (a stack trace belongs to its entry)
+    long long startEpoch;       // First timestamp, seconds since the epoch
+    double entriesPerSecond;    // Average rate
+    double burstStart;          // Chance per second that a burst begins
+    double burstStop;           // Chance per second that a burst ends
+    double burstFactor;         // Rate multiplier in bursts; the ERROR share rises by the same factor
+    double errorShare;          // Level mix outside bursts; the rest is INFO
+    double warningShare;
+    double debugShare;
+    int errorMessages;          // Distinct ERROR messages, ranked by a Zipf law
+    double zipfExponent;        // Skew of the ranking (1 = classic Zipf)
+    double stackTraceShare;     // ERROR entries followed by a stack trace
+    int maxStackDepth;          // Frames in the longest trace (at most MAX_STACK_DEPTH)
+    int chunkEntries;           // Entries per independently seeded chunk
+
+    inline GeneratorConfig() {
+        seed = 1;
+        entries = 1000000;
+        startEpoch = 1704067200;    // 2024-01-01 00:00:00
+        entriesPerSecond = 200.0;
+        burstStart = 0.001;
+        burstStop = 0.05;
+        burstFactor = 8.0;
+        errorShare = 0.02;
+        warningShare = 0.08;
+        debugShare = 0.15;
+        errorMessages = 200;
+        zipfExponent = 1.1;
+        stackTraceShare = 0.3;
+        maxStackDepth = 24;
+        chunkEntries = 1 << 16;
+    }
+};
+
+// One generated entry split into fields (valid until the next call)
+struct GeneratedEntry {
+    const char* timestamp;
+    const char* level;
+    const char* message;       // Stack trace lines are joined with '\n'
+};
+
+// Synthetic log generator
+// Writes "YYYY-MM-DD HH:MM:SS LEVEL message" lines. Messages come from
+// templates with variable IDs, latencies and addresses; ERROR messages are
+// drawn from a Zipf-ranked set, and some are followed by a multi-line stack
+// trace (frames are fixed per error, as real repeated failures are).
+// Timestamps follow a bursty rate: incident bursts run at burstFactor times
+// the surrounding rate, with more errors, and quiet periods slow down to keep
+// the average at entriesPerSecond.
+//
+// The stream is cut into chunks of chunkEntries, each seeded from the seed
+// and its index and given a fixed span of seconds, so chunks can be
+// generated in parallel and concatenated into exactly the sequential output.
+// Text is assembled from pre-split template segments with table-driven
+// number formatting, and the timestamp text is rebuilt once per second.
+class LogGenerator {
+public:
+    static const int MAX_STACK_DEPTH = 64;
+    static const size_t MAX_ENTRY_BYTES = 16384;   // Upper bound of one entry with its trace
+
+private:
+    // Template piece: literal text followed by an optional variable
+    enum VariableKind {
+        VAR_NONE = 0,
+        VAR_ID,          // 0-999999
+        VAR_SMALL,       // 0-63
+        VAR_MS,          // Latency 5-5000, mostly under 250
+        VAR_PCT,         // 0-100
+        VAR_IP,          // 10.x.y.z
+        VAR_HEX,         // 16 hex digits
+        VAR_USER         // user-NNNNN
+    };
+
+    // Literal text is held padded so it can be copied in fixed-size moves
+    static const int SEGMENT_BYTES = 64;
+    static const int FRAME_BYTES = 96;
+
+    struct Segment {
+        char text[SEGMENT_BYTES];
+        unsigned char length;
+        unsigned char kind;
+    };
+
+    struct Template {
+        Segment segments[16];
+        int count;
+    };
+
+    static const int INFO_TEMPLATES = 10;
+    static const int WARNING_TEMPLATES = 6;
+    static const int DEBUG_TEMPLATES = 6;
+    static const int ERROR_TEMPLATES = 24;
+    static const int FRAME_POOL = 48;
+
+    GeneratorConfig config;
+    Template infoTemplates[INFO_TEMPLATES];
+    Template warningTemplates[WARNING_TEMPLATES];
+    Template debugTemplates[DEBUG_TEMPLATES];
+    Template errorTemplates[ERROR_TEMPLATES];
+    char frameText[FRAME_POOL][FRAME_BYTES];     // "\n\tat class.method(File.java:"
+    unsigned char frameLength[FRAME_POOL];
+    double* errorCdf;          // Zipf cumulative distribution over error ranks
+    long long chunkSeconds;    // Span of every chunk
+    double errorBase;          // Cumulative thresholds for the level mix
+    double warningBase;
+    double debugBase;
+
+    // Position in the stream
+    long long chunk;
+    long long lastChunk;       // One past the last chunk to generate
+    long long chunkLeft;       // Entries left in the current chunk
+    unsigned long long state;  // splitmix64 state
+    long long chunkEnd;        // Last second of the current chunk
+    long long second;
+    long long leftInSecond;
+    bool burst;
+    char timestampText[20];
+    long long generated;
+    long long bytes;
+
+    char* entryText;           // next() output
+
+    inline static unsigned long long mix(unsigned long long x) {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    inline unsigned long long nextRandom() {
+        state += 0x9E3779B97F4A7C15ULL;
+        return mix(state);
+    }
+
+    // Uniform in [0, 1)
+    inline double nextUnit() {
+        return (double)(nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Split "{kind}" placeholders out of a template string
+    inline static void compile(const char* text, Template& t) {
+        static const char* const NAMES[] = { "", "id", "small", "ms", "pct", "ip", "hex", "user" };
+        t.count = 0;
+        const char* p = text;
+        while (*p != '\0' && t.count < 16) {
+            Segment& segment = t.segments[t.count++];
+            memset(segment.text, 0, SEGMENT_BYTES);
+            segment.kind = VAR_NONE;
+            const char* brace = strchr(p, '{');
+            size_t length = brace != nullptr ? (size_t)(brace - p) : strlen(p);
+            if (length > SEGMENT_BYTES) {
+                // Long literal: continue it in the next segment
+                length = SEGMENT_BYTES;
+                brace = nullptr;
+            }
+            memcpy(segment.text, p, length);
+            segment.length = (unsigned char)length;
+            p += length;
+            if (brace != nullptr) {
+                const char* close = strchr(brace, '}');
+                for (int k = 1; k <= (int)VAR_USER; k++) {
+                    size_t nameLength = strlen(NAMES[k]);
+                    if ((size_t)(close - brace - 1) == nameLength && memcmp(brace + 1, NAMES[k], nameLength) == 0) {
+                        segment.kind = (unsigned char)k;
+                    }
+                }
+                p = close + 1;
+            }
+        }
+    }
+
+    // Write v in decimal
+    inline static char* writeNumber(char* out, unsigned long long v) {
+        static const char DIGIT_PAIRS[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        int length = 1;
+        for (unsigned long long limit = 10; v >= limit && length < 20; limit *= 10) {
+            length++;
+        }
+        char* p = out + length;
+        while (v >= 100) {
+            unsigned int pair = (unsigned int)(v % 100) * 2;
+            v /= 100;
+            p -= 2;
+            p[0] = DIGIT_PAIRS[pair];
+            p[1] = DIGIT_PAIRS[pair + 1];
+        }
+        if (v >= 10) {
+            p[-2] = DIGIT_PAIRS[v * 2];
+            p[-1] = DIGIT_PAIRS[v * 2 + 1];
+        } else {
+            p[-1] = (char)('0' + v);
+        }
+        return out + length;
+    }
+
+    inline char* writeVariable(char* out, int kind) {
+        unsigned long long r = nextRandom();
+        switch (kind) {
+            case VAR_ID:
+                return writeNumber(out, r % 1000000);
+            case VAR_SMALL:
+                return writeNumber(out, r & 63);
+            case VAR_MS: {
+                // Nine in ten fast, the rest a long tail
+                if ((r >> 32) % 10 != 0) {
+                    return writeNumber(out, 5 + (r & 0xFFFF) % 245);
+                }
+                return writeNumber(out, 250 + (r & 0xFFFF) % 4750);
+            }
+            case VAR_PCT:
+                return writeNumber(out, r % 101);
+            case VAR_IP:
+                memcpy(out, "10.", 3);
+                out = writeNumber(out + 3, r & 255);
+                *out++ = '.';
+                out = writeNumber(out, (r >> 8) & 255);
+                *out++ = '.';
+                return writeNumber(out, 1 + (r >> 16) % 254);
+            case VAR_HEX: {
+                static const char HEX[] = "0123456789abcdef";
+                for (int i = 0; i < 16; i++) {
+                    out[i] = HEX[(r >> (i * 4)) & 15];
+                }
+                return out + 16;
+            }
+            case VAR_USER:
+                memcpy(out, "user-", 5);
+                return writeNumber(out + 5, r % 100000);
+        }
+        return out;
+    }
+
+    inline char* writeTemplate(char* out, const Template& t) {
+        for (int i = 0; i < t.count; i++) {
+            const Segment& segment = t.segments[i];
+            memcpy(out, segment.text, SEGMENT_BYTES);
+            out += segment.length;
+            if (segment.kind != VAR_NONE) {
+                out = writeVariable(out, segment.kind);
+            }
+        }
+        return out;
+    }
+
+    // Events to emit in one second at the given average rate
+    inline long long drawCount(double rate) {
+        double u = nextUnit();
+        if (rate < 1.0) {
+            return u < rate ? 1 : 0;
+        }
+        return (long long)(rate * (0.5 + u) + 0.5);
+    }
+
+    inline void startChunk() {
+        state = mix(config.seed ^ mix((unsigned long long)chunk + 0x632BE59BD9B4E019ULL));
+        long long first = chunk * (long long)config.chunkEntries;
+        chunkLeft = config.entries - first < config.chunkEntries ? config.entries - first : config.chunkEntries;
+        second = config.startEpoch + chunk * chunkSeconds;
+        chunkEnd = second + chunkSeconds - 1;
+        burst = false;
+        leftInSecond = drawCount(pace());
+        formatTimestamp(second, timestampText);
+    }
+
+    // Entries per second that finish the chunk on time
+    inline double pace() const {
+        return (double)chunkLeft / (double)(chunkEnd - second + 1);
+    }
+
+    // Move the clock to the second of the next entry
+    inline void advanceClock() {
+        bool moved = false;
+        while (leftInSecond <= 0) {
+            if (second >= chunkEnd) {
+                leftInSecond = 1;       // The chunk's span is used up: stay in its last second
+                break;
+            }
+            second++;
+            moved = true;
+            double toggle = nextUnit();
+            burst = burst ? toggle >= config.burstStop : toggle < config.burstStart;
+            leftInSecond = drawCount(pace() * (burst ? config.burstFactor : 1.0));
+        }
+        leftInSecond--;
+        if (moved) {
+            formatTimestamp(second, timestampText);
+        }
+    }
+
+    // Zipf rank of the next ERROR message
+    inline int drawErrorRank() {
+        double u = nextUnit();
+        int low = 0;
+        int high = config.errorMessages - 1;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (errorCdf[middle] < u) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    // Stack trace frames for an error rank, one "\tat ..." line each
+    inline char* writeStackTrace(char* out, int rank) {
+        int maxDepth = config.maxStackDepth < MAX_STACK_DEPTH ? config.maxStackDepth : MAX_STACK_DEPTH;
+        int depth = maxDepth / 2 + (int)((unsigned int)rank * 7u % (unsigned int)(maxDepth / 2 + 1));
+        for (int j = 0; j < depth; j++) {
+            int frame = (rank * 11 + j * 5) % FRAME_POOL;
+            memcpy(out, frameText[frame], FRAME_BYTES);
+            out = writeNumber(out + frameLength[frame], (unsigned long long)(20 + (rank * 31 + j * 17) % 900));
+            *out++ = ')';
+        }
+        return out;
+    }
+
+    // Write one entry (with its trace) ending in '\n'; returns the end
+    // levelStart and messageStart receive the field offsets.
+    inline char* writeEntry(char* out, size_t& levelStart, size_t& messageStart) {
+        char* begin = out;
+        advanceClock();
+        memcpy(out, timestampText, 19);
+        out[19] = ' ';
+        out += 20;
+        levelStart = (size_t)(out - begin);
+
+        double u = nextUnit();
+        double errorLimit = errorBase * (burst ? config.burstFactor : 1.0);
+        if (errorLimit > 0.5) {
+            errorLimit = 0.5;
+        }
+        if (u < errorLimit) {
+            memcpy(out, "ERROR ", 6);
+            out += 6;
+            messageStart = (size_t)(out - begin);
+            int rank = drawErrorRank();
+            out = writeTemplate(out, errorTemplates[rank % ERROR_TEMPLATES]);
+            if (rank >= ERROR_TEMPLATES) {
+                // Ranks beyond the built-in templates differ by an error code
+                memcpy(out, " [E", 3);
+                out = writeNumber(out + 3, (unsigned long long)(1000 + rank));
+                *out++ = ']';
+            }
+            if (nextUnit() < config.stackTraceShare) {
+                out = writeStackTrace(out, rank);
+            }
+        } else if (u < errorLimit + warningBase) {
+            memcpy(out, "WARNING ", 8);
+            out += 8;
+            messageStart = (size_t)(out - begin);
+            out = writeTemplate(out, warningTemplates[nextRandom() % WARNING_TEMPLATES]);
+        } else if (u < errorLimit + warningBase + debugBase) {
+            memcpy(out, "DEBUG ", 6);
+            out += 6;
+            messageStart = (size_t)(out - begin);
+            out = writeTemplate(out, debugTemplates[nextRandom() % DEBUG_TEMPLATES]);
+        } else {
+            memcpy(out, "INFO ", 5);
+            out += 5;
+            messageStart = (size_t)(out - begin);
+            out = writeTemplate(out, infoTemplates[nextRandom() % INFO_TEMPLATES]);
+        }
+        *out++ = '\n';
+
+        generated++;
+        bytes += out - begin;
+        if (--chunkLeft == 0) {
+            chunk++;
+            if (chunk < lastChunk) {
+                startChunk();
+            }
+        }
+        return out;
+    }
+
+    inline void setup(long long firstChunk, long long chunkCount) {
+        static const char* const INFO[INFO_TEMPLATES] = {
+            "User {user} logged in from {ip}",
+            "GET /api/v1/orders/{id} 200 {ms}ms",
+            "POST /api/v1/cart/{id}/items 201 {ms}ms",
+            "Processing request {hex} for tenant {small}",
+            "Cache hit ratio {pct}% on shard {small}",
+            "Scheduled job report-{small} finished in {ms} ms",
+            "Connection pool size {small}, idle {small}",
+            "Order {id} shipped to warehouse {small}",
+            "Session {hex} refreshed for {user}",
+            "Served GET /static/app-{small}.js in {ms} ms"
+        };
+        static const char* const WARNING[WARNING_TEMPLATES] = {
+            "High memory usage detected: {pct}%",
+            "Slow query took {ms} ms on table orders_{small}",
+            "Retrying connection to db-{small} (attempt {small})",
+            "Disk space below {pct}% on volume {small}",
+            "Rate limit close for {user}: {pct}% of quota",
+            "Deprecated API /api/v0/items/{id} called by {ip}"
+        };
+        static const char* const DEBUG[DEBUG_TEMPLATES] = {
+            "Payload size {id} bytes for request {hex}",
+            "Cache miss for key item:{id}",
+            "Acquired lock {hex} after {ms} ms",
+            "Parsed config section {small} in {ms} ms",
+            "Heartbeat from node-{small} at {ip}",
+            "Query plan for orders_{small}: index scan, cost {id}"
+        };
+        static const char* const ERROR[ERROR_TEMPLATES] = {
+            "Failed to connect to database db-{small}",
+            "Request timeout after 30000 ms calling inventory-service",
+            "NullPointerException in OrderService.load",
+            "Payment gateway returned status 502 for order {id}",
+            "File not found: /var/data/export-{small}.csv",
+            "Authentication failed for {user} from {ip}",
+            "Disk quota exceeded on volume {small}",
+            "Cache node redis-{small} unreachable",
+            "Deadlock detected on table orders_{small}",
+            "Message queue consumer {small} crashed",
+            "SSL handshake failed with {ip}",
+            "Out of memory while building report {small}",
+            "Invalid JSON in request body at offset {id}",
+            "Connection reset by peer {ip}",
+            "Transaction {hex} rolled back",
+            "Failed to send email to {user}",
+            "Search index shard {small} is read-only",
+            "Config key feature.flag.{small} missing",
+            "Upstream returned 503 for /api/v1/orders/{id}",
+            "Too many open files in worker {small}",
+            "Checksum mismatch in block {id}",
+            "Scheduler missed {small} runs of job cleanup",
+            "Lock {hex} held longer than 5000 ms",
+            "Failed to parse date in record {id}"
+        };
+        for (int i = 0; i < INFO_TEMPLATES; i++) {
+            compile(INFO[i], infoTemplates[i]);
+        }
+        for (int i = 0; i < WARNING_TEMPLATES; i++) {
+            compile(WARNING[i], warningTemplates[i]);
+        }
+        for (int i = 0; i < DEBUG_TEMPLATES; i++) {
+            compile(DEBUG[i], debugTemplates[i]);
+        }
+        static const char* const FRAMES[FRAME_POOL] = {
+            "com.acme.db.ConnectionPool.acquire(ConnectionPool.java:",
+            "com.acme.db.JdbcTemplate.query(JdbcTemplate.java:",
+            "com.acme.orders.OrderRepository.findById(OrderRepository.java:",
+            "com.acme.orders.OrderService.load(OrderService.java:",
+            "com.acme.orders.OrderController.get(OrderController.java:",
+            "com.acme.payments.GatewayClient.charge(GatewayClient.java:",
+            "com.acme.payments.PaymentService.capture(PaymentService.java:",
+            "com.acme.http.RetryingClient.execute(RetryingClient.java:",
+            "com.acme.http.HttpClient.send(HttpClient.java:",
+            "com.acme.cache.RedisCache.get(RedisCache.java:",
+            "com.acme.cache.CacheLoader.load(CacheLoader.java:",
+            "com.acme.auth.TokenVerifier.verify(TokenVerifier.java:",
+            "com.acme.auth.AuthFilter.doFilter(AuthFilter.java:",
+            "com.acme.web.RequestDispatcher.dispatch(RequestDispatcher.java:",
+            "com.acme.web.Router.route(Router.java:",
+            "com.acme.queue.Consumer.poll(Consumer.java:",
+            "com.acme.queue.MessageHandler.handle(MessageHandler.java:",
+            "com.acme.storage.BlobStore.read(BlobStore.java:",
+            "com.acme.storage.FileSystemStore.open(FileSystemStore.java:",
+            "com.acme.search.IndexReader.search(IndexReader.java:",
+            "com.acme.users.UserService.profile(UserService.java:",
+            "com.acme.users.UserRepository.load(UserRepository.java:",
+            "com.acme.inventory.StockService.reserve(StockService.java:",
+            "com.acme.inventory.WarehouseClient.call(WarehouseClient.java:",
+            "com.acme.scheduler.JobRunner.run(JobRunner.java:",
+            "com.acme.scheduler.CronTrigger.fire(CronTrigger.java:",
+            "com.acme.metrics.Reporter.flush(Reporter.java:",
+            "com.acme.config.ConfigLoader.parse(ConfigLoader.java:",
+            "com.acme.json.JsonMapper.read(JsonMapper.java:",
+            "com.acme.json.JsonMapper.write(JsonMapper.java:",
+            "com.acme.mail.SmtpSender.send(SmtpSender.java:",
+            "com.acme.util.Futures.get(Futures.java:",
+            "java.util.concurrent.FutureTask.run(FutureTask.java:",
+            "java.util.concurrent.ThreadPoolExecutor.runWorker(ThreadPoolExecutor.java:",
+            "java.util.concurrent.ThreadPoolExecutor$Worker.run(ThreadPoolExecutor.java:",
+            "java.lang.Thread.run(Thread.java:",
+            "java.net.SocketInputStream.read(SocketInputStream.java:",
+            "java.net.Socket.connect(Socket.java:",
+            "java.io.BufferedInputStream.fill(BufferedInputStream.java:",
+            "java.io.FileInputStream.open(FileInputStream.java:",
+            "org.postgresql.core.PGStream.receive(PGStream.java:",
+            "org.postgresql.jdbc.PgStatement.execute(PgStatement.java:",
+            "io.netty.channel.nio.NioEventLoop.run(NioEventLoop.java:",
+            "io.netty.handler.codec.ByteToMessageDecoder.channelRead(ByteToMessageDecoder.java:",
+            "org.eclipse.jetty.server.HttpChannel.handle(HttpChannel.java:",
+            "org.eclipse.jetty.server.Server.handle(Server.java:",
+            "org.eclipse.jetty.util.thread.QueuedThreadPool.runJob(QueuedThreadPool.java:",
+            "sun.nio.ch.SocketChannelImpl.read(SocketChannelImpl.java:"
+        };
+        for (int i = 0; i < ERROR_TEMPLATES; i++) {
+            compile(ERROR[i], errorTemplates[i]);
+        }
+        for (int i = 0; i < FRAME_POOL; i++) {
+            memset(frameText[i], 0, FRAME_BYTES);
+            memcpy(frameText[i], "\n\tat ", 5);
+            strncpy(frameText[i] + 5, FRAMES[i], FRAME_BYTES - 6);
+            frameLength[i] = (unsigned char)strlen(frameText[i]);
+        }
+
+        if (config.errorMessages < 1) {
+            config.errorMessages = 1;
+        }
+        if (config.chunkEntries < 1) {
+            config.chunkEntries = 1;
+        }
+        errorCdf = new double[config.errorMessages];
+        double sum = 0.0;
+        for (int r = 0; r < config.errorMessages; r++) {
+            sum += 1.0 / pow((double)(r + 1), config.zipfExponent);
+            errorCdf[r] = sum;
+        }
+        for (int r = 0; r < config.errorMessages; r++) {
+            errorCdf[r] /= sum;
+        }
+
+        double rate = config.entriesPerSecond > 0.0 ? config.entriesPerSecond : 1.0;
+        chunkSeconds = (long long)ceil(config.chunkEntries / rate);
+        if (chunkSeconds < 1) {
+            chunkSeconds = 1;
+        }
+        errorBase = config.errorShare;
+        warningBase = config.warningShare;
+        debugBase = config.debugShare;
+
+        long long chunks = (config.entries + config.chunkEntries - 1) / config.chunkEntries;
+        chunk = firstChunk;
+        lastChunk = chunkCount < 0 || firstChunk + chunkCount > chunks ? chunks : firstChunk + chunkCount;
+        generated = 0;
+        bytes = 0;
+        chunkLeft = 0;
+        if (chunk < lastChunk) {
+            startChunk();
+        }
+        entryText = new char[MAX_ENTRY_BYTES];
+    }
+
+public:
+    // Generate the whole stream, or chunks [firstChunk, firstChunk + chunkCount)
+    inline explicit LogGenerator(const GeneratorConfig& generatorConfig, long long firstChunk = 0,
+                                 long long chunkCount = -1) : config(generatorConfig) {
+        setup(firstChunk, chunkCount);
+    }
+
+    inline ~LogGenerator() {
+        delete[] errorCdf;
+        delete[] entryText;
+    }
+
+    // Append whole lines to buffer; returns the bytes written, 0 when done
+    // Needs capacity >= MAX_ENTRY_BYTES to make progress.
+    inline size_t fill(char* buffer, size_t capacity) {
+        char* out = buffer;
+        size_t levelStart;
+        size_t messageStart;
+        while (!done() && (size_t)(out - buffer) + MAX_ENTRY_BYTES <= capacity) {
+            out = writeEntry(out, levelStart, messageStart);
+        }
+        return (size_t)(out - buffer);
+    }
+
+    // Next entry as separate fields; false when done
+    inline bool next(GeneratedEntry& entry) {
+        if (done()) {
+            return false;
+        }
+        size_t levelStart;
+        size_t messageStart;
+        char* end = writeEntry(entryText, levelStart, messageStart);
+        end[-1] = '\0';
+        entryText[19] = '\0';
+        entryText[messageStart - 1] = '\0';
+        entry.timestamp = entryText;
+        entry.level = entryText + levelStart;
+        entry.message = entryText + messageStart;
+        return true;
+    }
+
+    inline bool done() const {
+        return chunk >= lastChunk;
+    }
+
+    // Number of chunks the configured stream has
+    inline long long getChunkCount() const {
+        return (config.entries + config.chunkEntries - 1) / config.chunkEntries;
+    }
+
+    inline long long getGenerated() const {
+        return generated;
+    }
+
+    inline long long getBytes() const {
+        return bytes;
+    }
+
+private:
+    // Copying is not supported
+    LogGenerator(const LogGenerator&);
+    LogGenerator& operator=(const LogGenerator&);
+};
+
+#endif // LOG_GENERATOR_H
@@ -0,0 +1,776 @@
+#ifndef LOG_INGEST_H
+#define LOG_INGEST_H
+
+#include "line_reader.h"
+#include "log_parser.h"
+#include "json_lines.h"
+#include "async_reader.h"
+#include "metrics.h"
+#include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <cerrno>
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+// Multi-file ingestion settings
+struct IngestConfig {
+    int readerThreads;          // Parallel file readers (0 = hardware concurrency)
+    int reorderWindow;          // Entries held per file to repair local timestamp disorder
+    int batchSize;              // Entries per hand-off from a reader to the merge
+    int queueDepth;             // Batches buffered per file ahead of the merge
+    long long bufferedEntries;  // Cap on batched entries across all files (shrinks batches)
+    size_t readBufferSize;      // Initial read buffer per open file
+    AsyncIoBackend ioBackend;   // Read files through AsyncFileReader (ASYNC_IO_NONE = blocking reads)
+    int ioQueueDepth;           // Opens and reads kept in flight by the async reader
+    const JsonFormat* jsonFormat;  // Parse lines holding a JSON object with this key mapping (nullptr = text only)
+    Metrics* metrics;           // Receives batch read and merge wait timings (nullptr = none)
+
+    inline IngestConfig() {
+        readerThreads = 0;
+        reorderWindow = 1024;
+        batchSize = 512;
+        queueDepth = 4;
+        bufferedEntries = 1 << 20;
+        readBufferSize = 256 * 1024;
+        ioBackend = ASYNC_IO_NONE;
+        ioQueueDepth = 256;
+        jsonFormat = nullptr;
+        metrics = nullptr;
+    }
+};
+
+// What an ingestion run did
+struct IngestStats {
+    int files;                  // Files matched
+    int failedFiles;            // Files that could not be opened
+    long long bytes;
+    long long entries;          // Entries delivered to the sink
+    long long continuationLines;// Lines folded into the entry before them
+    long long outOfOrder;       // Entries delivered with an earlier timestamp than the one before
+    double seconds;
+    const char* ioBackend;      // How files were read
+};
+
+// Receives merged entries in timestamp order
+typedef void (*IngestSink)(void* context, const char* timestamp, const char* level, const char* message);
+
+// Receives merged entries as their original text (first line and
+// continuation lines joined with '\n') with the timestamp they sort by
+typedef void (*IngestRawSink)(void* context, long long sortKey, const char* text, size_t length);
+
+// Called after a group of entries has gone to the sink (e.g. to commit them together)
+typedef void (*IngestFlush)(void* context);
+
+// Parallel multi-file ingestion with a k-way timestamp merge
+//
+// Reader threads parse files into entries. Each file passes its entries
+// through a reorder buffer: a min-heap of up to reorderWindow entries that
+// releases the earliest one as each new entry arrives, so lines displaced by
+// fewer than reorderWindow positions come out in order. Released entries are
+// handed to the merge in batches through a bounded per-file queue.
+//
+// The merge runs on the calling thread: a min-heap of files keyed by the
+// timestamp of each file's next entry. It pops the earliest entry, passes it
+// to the sink and refills from the same file, so input is streamed and never
+// loaded whole. Readers only run ahead of the merge by queueDepth batches per
+// file; a file the merge is waiting on is moved to the front of the work queue.
+//
+// Entries without a timestamp sort with the entry before them in their file.
+// Ties keep file order, then line order.
+//
+// With an async I/O backend the readers parse data an AsyncFileReader has
+// already fetched (many opens and reads in flight) instead of blocking in
+// open() and read() themselves, which pays off for many small files.
+class LogIngestor {
+private:
+    // One entry owned by the pipeline: "timestamp\0level\0message\0", then
+    // the original lines when raw text is delivered
+    struct Entry {
+        long long sortKey;
+        long long order;            // Position within its file
+        unsigned int levelOffset;
+        unsigned int messageOffset;
+        unsigned int rawOffset;
+        unsigned int rawLength;
+        char text[1];
+    };
+
+    struct Batch {
+        Entry** entries;
+        int count;
+    };
+
+    // Per-file state; reader fields are only touched by the worker holding the file
+    // LineSource context for reading a file through the async reader
+    struct AsyncSource {
+        AsyncFileReader* reader;
+        int index;
+    };
+
+    struct FileStream {
+        char* path;
+        AsyncSource source;
+        // Reader side
+        int fd;
+        LineReader* reader;
+        LogLineAssembler* assembler;
+        JsonLineParser* json;       // nullptr for plain text input
+        Entry** heap;               // Reorder buffer
+        int heapSize;
+        int heapCapacity;
+        long long lastKey;          // Sort key inherited by entries without a timestamp
+        long long order;
+        bool endOfInput;
+        bool failed;
+        long long bytes;
+        long long continuationLines;
+        // Hand-off queue (guarded by the ingestor lock)
+        Batch** queue;
+        int queueHead;
+        int queueCount;
+        bool finished;              // No more batches will be queued
+        bool scheduled;             // In the work queue or being read
+        // Merge side
+        Batch* current;
+        int position;
+    };
+
+    IngestConfig config;
+    int batchSize;
+    FileStream* streams;
+    int streamCount;
+    size_t readBufferSize;      // Per open file, scaled down for many files
+    AsyncFileReader* asyncReader;
+    IngestRawSink rawSink;      // Set by runRaw()
+
+    std::mutex lock;
+    std::condition_variable workSignal;     // Readers wait for work
+    std::condition_variable batchSignal;    // The merge waits for batches
+    int* work;                  // Ring of files to read (at most one slot per file)
+    int workHead;
+    int workCount;
+    bool stopping;
+
+    inline static bool entryBefore(const Entry* a, const Entry* b) {
+        if (a->sortKey != b->sortKey) {
+            return a->sortKey < b->sortKey;
+        }
+        return a->order < b->order;
+    }
+
+    inline static void freeEntry(Entry* entry) {
+        delete[] (char*)entry;
+    }
+
+    inline static Entry* makeEntry(const AssembledEntry& source, long long sortKey, long long order) {
+        size_t timestampLength = strlen(source.timestamp) + 1;
+        size_t levelLength = strlen(source.level) + 1;
+        size_t rawLength = source.raw != nullptr ? source.rawLength : 0;
+        size_t size = offsetof(Entry, text) + timestampLength + levelLength + source.messageLength + 1 + rawLength;
+        Entry* entry = (Entry*)new char[size];
+        entry->sortKey = sortKey;
+        entry->order = order;
+        entry->levelOffset = (unsigned int)timestampLength;
+        entry->messageOffset = (unsigned int)(timestampLength + levelLength);
+        entry->rawOffset = (unsigned int)(entry->messageOffset + source.messageLength + 1);
+        entry->rawLength = (unsigned int)rawLength;
+        memcpy(entry->text, source.timestamp, timestampLength);
+        memcpy(entry->text + entry->levelOffset, source.level, levelLength);
+        memcpy(entry->text + entry->messageOffset, source.message, source.messageLength);
+        entry->text[entry->messageOffset + source.messageLength] = '\0';
+        if (rawLength > 0) {
+            memcpy(entry->text + entry->rawOffset, source.raw, rawLength);
+        }
+        return entry;
+    }
+
+    // ---- Reader side ----
+
+    inline static void heapPush(FileStream& s, Entry* entry) {
+        if (s.heapSize == s.heapCapacity) {
+            int capacity = s.heapCapacity == 0 ? 64 : s.heapCapacity * 2;
+            Entry** grown = new Entry*[capacity];
+            for (int i = 0; i < s.heapSize; i++) {
+                grown[i] = s.heap[i];
+            }
+            delete[] s.heap;
+            s.heap = grown;
+            s.heapCapacity = capacity;
+        }
+        int i = s.heapSize++;
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!entryBefore(entry, s.heap[parent])) {
+                break;
+            }
+            s.heap[i] = s.heap[parent];
+            i = parent;
+        }
+        s.heap[i] = entry;
+    }
+
+    inline static Entry* heapPop(FileStream& s) {
+        Entry* top = s.heap[0];
+        Entry* last = s.heap[--s.heapSize];
+        int i = 0;
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= s.heapSize) {
+                break;
+            }
+            if (child + 1 < s.heapSize && entryBefore(s.heap[child + 1], s.heap[child])) {
+                child++;
+            }
+            if (!entryBefore(s.heap[child], last)) {
+                break;
+            }
+            s.heap[i] = s.heap[child];
+            i = child;
+        }
+        if (s.heapSize > 0) {
+            s.heap[i] = last;
+        }
+        return top;
+    }
+
+    inline static void addCompleted(FileStream& s) {
+        const AssembledEntry& assembled = s.assembler->entry();
+        if (assembled.epoch != INVALID_EPOCH) {
+            s.lastKey = assembled.epoch;
+        }
+        heapPush(s, makeEntry(assembled, s.lastKey, s.order++));
+    }
+
+    inline static ssize_t readAsync(void* context, char* into, size_t size) {
+        AsyncSource* source = (AsyncSource*)context;
+        return source->reader->read(source->index, into, size);
+    }
+
+    inline void openStream(FileStream& s) {
+        if (config.jsonFormat != nullptr) {
+            s.json = new JsonLineParser(*config.jsonFormat);
+            s.assembler = new LogLineAssembler(JsonLineParser::parseLine, s.json);
+        } else {
+            s.assembler = new LogLineAssembler();
+        }
+        s.assembler->setKeepRawText(rawSink != nullptr);
+        if (asyncReader != nullptr) {
+            s.reader = new LineReader(readAsync, &s.source, readBufferSize);
+            return;
+        }
+        s.fd = ::open(s.path, O_RDONLY);
+        if (s.fd < 0) {
+            std::cerr << "Cannot open " << s.path << ": " << strerror(errno) << "\n";
+            s.failed = true;
+            s.endOfInput = true;
+            return;
+        }
+        s.reader = new LineReader(s.fd, readBufferSize);
+    }
+
+    inline void closeStream(FileStream& s) {
+        if (s.reader != nullptr) {
+            s.bytes = s.reader->getBytesRead();
+            delete s.reader;
+            s.reader = nullptr;
+        }
+        if (s.fd >= 0) {
+            ::close(s.fd);
+            s.fd = -1;
+        }
+    }
+
+    // Read until one batch of reordered entries is ready (nullptr if none are left)
+    inline Batch* readBatch(FileStream& s) {
+        if (s.reader == nullptr && !s.endOfInput) {
+            openStream(s);
+        }
+        Batch* batch = new Batch;
+        batch->entries = new Entry*[batchSize];
+        batch->count = 0;
+        int window = config.reorderWindow > 0 ? config.reorderWindow : 0;
+        while (batch->count < batchSize) {
+            if (s.heapSize > window || (s.endOfInput && s.heapSize > 0)) {
+                batch->entries[batch->count++] = heapPop(s);
+                continue;
+            }
+            if (s.endOfInput) {
+                break;
+            }
+            char* line;
+            size_t length;
+            if (s.reader->next(line, length)) {
+                if (s.assembler->addLine(line, length)) {
+                    addCompleted(s);
+                }
+            } else {
+                if (s.assembler->finish()) {
+                    addCompleted(s);
+                }
+                s.endOfInput = true;
+                s.continuationLines = s.assembler->getContinuationLines();
+                closeStream(s);
+                if (asyncReader != nullptr && asyncReader->getError(s.source.index) != 0) {
+                    std::cerr << "Cannot read " << s.path << ": "
+                              << strerror(asyncReader->getError(s.source.index)) << "\n";
+                    s.failed = true;
+                }
+            }
+        }
+        if (s.endOfInput && s.heapSize == 0) {
+            delete s.assembler;
+            s.assembler = nullptr;
+            delete s.json;
+            s.json = nullptr;
+            delete[] s.heap;
+            s.heap = nullptr;
+            s.heapCapacity = 0;
+        }
+        if (batch->count == 0) {
+            delete[] batch->entries;
+            delete batch;
+            return nullptr;
+        }
+        return batch;
+    }
+
+    // Work queue ring (caller holds lock)
+    inline void pushWork(int index, bool urgent) {
+        if (urgent) {
+            workHead = (workHead + streamCount - 1) % streamCount;
+            work[workHead] = index;
+        } else {
+            work[(workHead + workCount) % streamCount] = index;
+        }
+        workCount++;
+        streams[index].scheduled = true;
+    }
+
+    // Move a queued file to the front of the work queue (caller holds lock)
+    inline void promoteWork(int index) {
+        for (int i = 0; i < workCount; i++) {
+            int slot = (workHead + i) % streamCount;
+            if (work[slot] != index) {
+                continue;
+            }
+            for (int j = i; j > 0; j--) {
+                work[(workHead + j) % streamCount] = work[(workHead + j - 1) % streamCount];
+            }
+            work[workHead] = index;
+            return;
+        }
+    }
+
+    inline void readerLoop() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            while (workCount == 0 && !stopping) {
+                workSignal.wait(guard);
+            }
+            if (workCount == 0) {
+                return;
+            }
+            int index = work[workHead];
+            workHead = (workHead + 1) % streamCount;
+            workCount--;
+            FileStream& s = streams[index];
+            guard.unlock();
+
+            Batch* batch;
+            {
+                METRIC_SCOPE(config.metrics, TIMER_INGEST_READ_BATCH);
+                batch = readBatch(s);
+            }
+            METRIC_COUNT(config.metrics, COUNTER_INGEST_BATCHES, 1);
+
+            guard.lock();
+            if (batch != nullptr) {
+                s.queue[(s.queueHead + s.queueCount) % config.queueDepth] = batch;
+                s.queueCount++;
+            }
+            if (s.endOfInput && s.heapSize == 0) {
+                s.finished = true;
+            }
+            s.scheduled = false;
+            if (!s.finished && s.queueCount < config.queueDepth) {
+                pushWork(index, false);
+            }
+            batchSignal.notify_all();
+        }
+    }
+
+    // ---- Merge side ----
+
+    // Advance a file to its next entry; false when the file is exhausted
+    inline bool advance(int index) {
+        FileStream& s = streams[index];
+        if (s.current != nullptr && ++s.position < s.current->count) {
+            return true;
+        }
+        if (s.current != nullptr) {
+            delete[] s.current->entries;
+            delete s.current;
+            s.current = nullptr;
+        }
+        std::unique_lock<std::mutex> guard(lock);
+        if (s.queueCount == 0 && !s.finished) {
+            METRIC_SCOPE(config.metrics, TIMER_INGEST_MERGE_WAIT);
+            while (s.queueCount == 0 && !s.finished) {
+                if (s.scheduled) {
+                    promoteWork(index);
+                } else {
+                    pushWork(index, true);
+                    workSignal.notify_one();
+                }
+                batchSignal.wait(guard);
+            }
+        }
+        if (s.queueCount == 0) {
+            return false;
+        }
+        bool wasFull = s.queueCount == config.queueDepth;
+        s.current = s.queue[s.queueHead];
+        s.queueHead = (s.queueHead + 1) % config.queueDepth;
+        s.queueCount--;
+        s.position = 0;
+        if (wasFull && !s.scheduled && !s.finished) {
+            pushWork(index, false);
+            workSignal.notify_one();
+        }
+        return true;
+    }
+
+    inline const Entry* head(int index) const {
+        return streams[index].current->entries[streams[index].position];
+    }
+
+    inline bool fileBefore(int a, int b) const {
+        const Entry* x = head(a);
+        const Entry* y = head(b);
+        if (x->sortKey != y->sortKey) {
+            return x->sortKey < y->sortKey;
+        }
+        return a < b;
+    }
+
+    inline void siftDown(int* merge, int size, int i) const {
+        int item = merge[i];
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= size) {
+                break;
+            }
+            if (child + 1 < size && fileBefore(merge[child + 1], merge[child])) {
+                child++;
+            }
+            if (!fileBefore(merge[child], item)) {
+                break;
+            }
+            merge[i] = merge[child];
+            i = child;
+        }
+        merge[i] = item;
+    }
+
+    // ---- Setup ----
+
+    inline static int comparePaths(const void* a, const void* b) {
+        return strcmp(*(char* const*)a, *(char* const*)b);
+    }
+
+    inline static bool isRegularFile(const char* path) {
+        struct stat info;
+        return stat(path, &info) == 0 && S_ISREG(info.st_mode);
+    }
+
+    inline static char* copyString(const char* text) {
+        char* copy = new char[strlen(text) + 1];
+        strcpy(copy, text);
+        return copy;
+    }
+
+    // Expand a directory (its regular files) or a glob pattern into sorted paths
+    inline static int expandPattern(const char* pattern, char**& paths) {
+        paths = nullptr;
+        int count = 0;
+        struct stat info;
+        if (stat(pattern, &info) == 0 && S_ISDIR(info.st_mode)) {
+            DIR* dir = opendir(pattern);
+            if (dir == nullptr) {
+                return 0;
+            }
+            int capacity = 0;
+            size_t prefix = strlen(pattern);
+            struct dirent* item;
+            while ((item = readdir(dir)) != nullptr) {
+                if (item->d_name[0] == '.') {
+                    continue;
+                }
+                char* path = new char[prefix + strlen(item->d_name) + 2];
+                strcpy(path, pattern);
+                if (prefix > 0 && pattern[prefix - 1] != '/') {
+                    strcat(path, "/");
+                }
+                strcat(path, item->d_name);
+                if (!isRegularFile(path)) {
+                    delete[] path;
+                    continue;
+                }
+                if (count == capacity) {
+                    capacity = capacity == 0 ? 16 : capacity * 2;
+                    char** grown = new char*[capacity];
+                    for (int i = 0; i < count; i++) {
+                        grown[i] = paths[i];
+                    }
+                    delete[] paths;
+                    paths = grown;
+                }
+                paths[count++] = path;
+            }
+            closedir(dir);
+            qsort(paths, count, sizeof(char*), comparePaths);
+            return count;
+        }
+
+        glob_t matches;
+        if (glob(pattern, 0, nullptr, &matches) != 0) {
+            return 0;
+        }
+        paths = new char*[matches.gl_pathc > 0 ? matches.gl_pathc : 1];
+        for (size_t i = 0; i < matches.gl_pathc; i++) {
+            if (isRegularFile(matches.gl_pathv[i])) {
+                paths[count++] = copyString(matches.gl_pathv[i]);
+            }
+        }
+        globfree(&matches);
+        return count;
+    }
+
+    // Many files stay open at once; allow as many descriptors as the hard limit
+    inline static void raiseFileLimit() {
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    inline void release() {
+        delete asyncReader;     // Stops its I/O threads before the paths go away
+        asyncReader = nullptr;
+        for (int i = 0; i < streamCount; i++) {
+            FileStream& s = streams[i];
+            closeStream(s);
+            delete s.assembler;
+            delete s.json;
+            for (int j = 0; j < s.heapSize; j++) {
+                freeEntry(s.heap[j]);
+            }
+            delete[] s.heap;
+            for (int j = 0; j < s.queueCount; j++) {
+                Batch* batch = s.queue[(s.queueHead + j) % config.queueDepth];
+                for (int k = 0; k < batch->count; k++) {
+                    freeEntry(batch->entries[k]);
+                }
+                delete[] batch->entries;
+                delete batch;
+            }
+            delete[] s.queue;
+            if (s.current != nullptr) {
+                for (int k = s.position; k < s.current->count; k++) {
+                    freeEntry(s.current->entries[k]);
+                }
+                delete[] s.current->entries;
+                delete s.current;
+            }
+            delete[] s.path;
+        }
+        delete[] streams;
+        delete[] work;
+        streams = nullptr;
+        work = nullptr;
+        streamCount = 0;
+    }
+
+public:
+    inline explicit LogIngestor(const IngestConfig& ingestConfig = IngestConfig()) {
+        config = ingestConfig;
+        if (config.queueDepth < 1) {
+            config.queueDepth = 1;
+        }
+        if (config.batchSize < 1) {
+            config.batchSize = 1;
+        }
+        batchSize = config.batchSize;
+        streams = nullptr;
+        streamCount = 0;
+        readBufferSize = config.readBufferSize;
+        asyncReader = nullptr;
+        rawSink = nullptr;
+        work = nullptr;
+        workHead = 0;
+        workCount = 0;
+        stopping = false;
+    }
+
+    inline ~LogIngestor() {
+        release();
+    }
+
+    // Ingest every file matching pattern (a directory or a glob), delivering
+    // entries to sink in timestamp order; returns the number of entries
+    inline long long run(const char* pattern, IngestSink sink, void* context, IngestStats& stats) {
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        memset(&stats, 0, sizeof(stats));
+        release();
+
+        char** paths;
+        streamCount = expandPattern(pattern, paths);
+        stats.files = streamCount;
+        if (streamCount == 0) {
+            delete[] paths;
+            return 0;
+        }
+        raiseFileLimit();
+
+        // Keep the batched entries of all files within the configured budget
+        long long perFile = config.bufferedEntries / ((long long)streamCount * config.queueDepth);
+        batchSize = (int)(perFile < config.batchSize ? perFile : config.batchSize);
+        if (batchSize < 16) {
+            batchSize = 16;
+        }
+
+        streams = new FileStream[streamCount];
+        work = new int[streamCount];
+        workHead = 0;
+        workCount = 0;
+        stopping = false;
+        for (int i = 0; i < streamCount; i++) {
+            FileStream& s = streams[i];
+            memset(&s, 0, sizeof(s));
+            s.path = paths[i];
+            s.source.index = i;
+            s.fd = -1;
+            s.lastKey = INVALID_EPOCH;
+            s.queue = new Batch*[config.queueDepth];
+            work[i] = i;
+            s.scheduled = true;
+        }
+        workCount = streamCount;
+
+        // Many open files share the read buffer budget
+        readBufferSize = (size_t)(32 << 20) / (size_t)streamCount;
+        if (readBufferSize > config.readBufferSize) {
+            readBufferSize = config.readBufferSize;
+        }
+        if (readBufferSize < 4096) {
+            readBufferSize = 4096;
+        }
+        if (config.ioBackend != ASYNC_IO_NONE) {
+            asyncReader = new AsyncFileReader(paths, streamCount, config.ioBackend, readBufferSize,
+                                              config.ioQueueDepth);
+            asyncReader->start();
+            for (int i = 0; i < streamCount; i++) {
+                streams[i].source.reader = asyncReader;
+            }
+        }
+        stats.ioBackend = AsyncFileReader::backendName(asyncReader != nullptr ? asyncReader->getBackend()
+                                                                               : ASYNC_IO_NONE);
+        delete[] paths;
+
+        int threads = config.readerThreads > 0 ? config.readerThreads : (int)std::thread::hardware_concurrency();
+        if (threads < 1) {
+            threads = 1;
+        }
+        if (threads > streamCount) {
+            threads = streamCount;
+        }
+        std::thread* readers = new std::thread[threads];
+        for (int t = 0; t < threads; t++) {
+            readers[t] = std::thread(&LogIngestor::readerLoop, this);
+        }
+
+        // Prime the merge heap with each file's first entry
+        int* merge = new int[streamCount];
+        int mergeSize = 0;
+        for (int i = 0; i < streamCount; i++) {
+            if (advance(i)) {
+                merge[mergeSize++] = i;
+            }
+        }
+        for (int i = mergeSize / 2 - 1; i >= 0; i--) {
+            siftDown(merge, mergeSize, i);
+        }
+
+        long long previousKey = INVALID_EPOCH;
+        while (mergeSize > 0) {
+            int index = merge[0];
+            FileStream& s = streams[index];
+            Entry* entry = s.current->entries[s.position];
+            if (entry->sortKey < previousKey) {
+                stats.outOfOrder++;
+            }
+            previousKey = entry->sortKey;
+            if (rawSink != nullptr) {
+                rawSink(context, entry->sortKey, entry->text + entry->rawOffset, entry->rawLength);
+            } else {
+                sink(context, entry->text, entry->text + entry->levelOffset, entry->text + entry->messageOffset);
+            }
+            freeEntry(entry);
+            stats.entries++;
+            if (!advance(index)) {
+                merge[0] = merge[--mergeSize];
+            }
+            if (mergeSize > 0) {
+                siftDown(merge, mergeSize, 0);
+            }
+        }
+        delete[] merge;
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        workSignal.notify_all();
+        for (int t = 0; t < threads; t++) {
+            readers[t].join();
+        }
+        delete[] readers;
+
+        for (int i = 0; i < streamCount; i++) {
+            stats.bytes += streams[i].bytes;
+            stats.continuationLines += streams[i].continuationLines;
+            if (streams[i].failed) {
+                stats.failedFiles++;
+            }
+        }
+        release();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return stats.entries;
+    }
+
+    // Like run(), but deliver each entry as the text it was read from
+    inline long long runRaw(const char* pattern, IngestRawSink sink, void* context, IngestStats& stats) {
+        rawSink = sink;
+        long long entries = run(pattern, nullptr, context, stats);
+        rawSink = nullptr;
+        return entries;
+    }
+
+private:
+    // Copying is not supported
+    LogIngestor(const LogIngestor&);
+    LogIngestor& operator=(const LogIngestor&);
+};
+
+#endif // LOG_INGEST_H
@@ -4,110 +4,307 @@
 #include <cstring>
 #include <iostream>
 #include <cstdlib>
+#include <atomic>
+#include "string_pool.h"
 
-// Structure to represent a log entry
+// View of one stored log entry
+// Text fields point into the StringPool and stay valid until the list is cleared.
 struct LogEntry {
-    char* timestamp;    // Format: "YYYY-MM-DD HH:MM:SS"
-    char* log_level;   // "INFO", "WARNING", "ERROR", "DEBUG"
-    char* message;     // Log message content
-    
-    LogEntry* next;    // Pointer to next entry in linked list
-    
-    // Constructor
-    inline LogEntry(const char* ts, const char* level, const char* msg) {
-        // Allocate memory and copy timestamp
-        timestamp = new char[strlen(ts) + 1];
-        strcpy(timestamp, ts);
-        
-        // Allocate memory and copy log level
-        log_level = new char[strlen(level) + 1];
-        strcpy(log_level, level);
-        
-        // Allocate memory and copy message
-        message = new char[strlen(msg) + 1];
-        strcpy(message, msg);
-        
-        next = nullptr;
-    }
-    
-    // Destructor
-    inline ~LogEntry() {
-        delete[] timestamp;
-        delete[] log_level;
-        delete[] message;
-    }
+    const char* timestamp;   // Format: "YYYY-MM-DD HH:MM:SS" (interned)
+    const char* log_level;   // "INFO", "WARNING", "ERROR", "DEBUG" (interned)
+    const char* message;     // Log message content (interned)
+    unsigned int timestampId;  // String pool ID of timestamp
+    unsigned int levelId;      // String pool ID of log_level
+    unsigned int messageId;    // String pool ID of message
+    unsigned int templateId;   // Mined message template ID
+    long long epoch;           // Parsed timestamp (INVALID_EPOCH if unparseable)
+};
+
+// A fixed-size block of rows stored column by column
+// Scans read one column at a time as a contiguous array.
+struct LogBlock {
+    unsigned int* timestampIds;
+    unsigned int* levelIds;
+    unsigned int* messageIds;
+    unsigned int* templateIds;
+    long long* epochs;
+    int count;               // Rows filled in this block
+    bool external;           // Columns are borrowed (e.g. a mapped snapshot), not owned
 };
 
-// Linked List class to store log entries
+// Append-only columnar store of log entries
+// Rows are numbered in insertion order (row 0 is the oldest) and grouped into
+// blocks of BLOCK_ROWS. Appends need a single writer; readers may scan rows
+// below getSize() concurrently because blocks never move once published.
 class LogList {
+public:
+    static const int BLOCK_BITS = 12;
+    static const int BLOCK_ROWS = 1 << BLOCK_BITS;     // Rows per block
+
 private:
-    LogEntry* head;    // Head of the linked list
-    int size;          // Number of entries in the list
-    
+    static const int DIRECTORY_BITS = 10;
+    static const int DIRECTORY_SIZE = 1 << DIRECTORY_BITS;  // Blocks per directory chunk
+
+    StringPool& pool;                                   // Resolves text columns
+    std::atomic<LogBlock**> directory[DIRECTORY_SIZE];  // Two-level block directory
+    std::atomic<int> size;                              // Published row count
+    int blockCount;                                     // Blocks allocated
+
+    inline LogBlock* blockAt(int index) const {
+        LogBlock** chunk = directory[index >> DIRECTORY_BITS].load(std::memory_order_acquire);
+        return chunk[index & (DIRECTORY_SIZE - 1)];
+    }
+
+    inline void publishBlock(LogBlock* block) {
+        int chunkIndex = blockCount >> DIRECTORY_BITS;
+        LogBlock** chunk = directory[chunkIndex].load(std::memory_order_relaxed);
+        if (chunk == nullptr) {
+            chunk = new LogBlock*[DIRECTORY_SIZE];
+            directory[chunkIndex].store(chunk, std::memory_order_release);
+        }
+        chunk[blockCount & (DIRECTORY_SIZE - 1)] = block;
+        blockCount++;
+    }
+
+    static inline LogBlock* newBlock() {
+        LogBlock* block = new LogBlock;
+        block->timestampIds = new unsigned int[BLOCK_ROWS];
+        block->levelIds = new unsigned int[BLOCK_ROWS];
+        block->messageIds = new unsigned int[BLOCK_ROWS];
+        block->templateIds = new unsigned int[BLOCK_ROWS];
+        block->epochs = new long long[BLOCK_ROWS];
+        block->count = 0;
+        block->external = false;
+        return block;
+    }
+
+    static inline void deleteBlock(LogBlock* block) {
+        if (!block->external) {
+            delete[] block->timestampIds;
+            delete[] block->levelIds;
+            delete[] block->messageIds;
+            delete[] block->templateIds;
+            delete[] block->epochs;
+        }
+        delete block;
+    }
+
 public:
     // Constructor
-    inline LogList() {
-        head = nullptr;
-        size = 0;
+    inline LogList(StringPool& stringPool) : pool(stringPool) {
+        for (int i = 0; i < DIRECTORY_SIZE; i++) {
+            directory[i].store(nullptr, std::memory_order_relaxed);
+        }
+        size.store(0, std::memory_order_relaxed);
+        blockCount = 0;
     }
-    
+
     // Destructor
     inline ~LogList() {
         clear();
     }
-    
-    // Add a new log entry to the list
-    inline void addEntry(const char* timestamp, const char* log_level, const char* message) {
-        LogEntry* newEntry = new LogEntry(timestamp, log_level, message);
-        
-        // Insert at the beginning for O(1) insertion
-        newEntry->next = head;
-        head = newEntry;
-        size++;
-    }
-    
-    // Get the head of the list
-    inline LogEntry* getHead() const {
-        return head;
-    }
-    
+
+    // Append a new log entry (single writer; IDs must come from the list's pool)
+    inline void addEntry(unsigned int timestampId, long long epoch, unsigned int levelId,
+                         unsigned int messageId, unsigned int templateId) {
+        int row = size.load(std::memory_order_relaxed);
+        if ((row & (BLOCK_ROWS - 1)) == 0 && (row >> BLOCK_BITS) == blockCount) {
+            publishBlock(newBlock());
+        }
+        LogBlock* block = blockAt(row >> BLOCK_BITS);
+        int offset = row & (BLOCK_ROWS - 1);
+        block->timestampIds[offset] = timestampId;
+        block->levelIds[offset] = levelId;
+        block->messageIds[offset] = messageId;
+        block->templateIds[offset] = templateId;
+        block->epochs[offset] = epoch;
+        block->count = offset + 1;
+
+        // Publish the row to readers
+        size.store(row + 1, std::memory_order_release);
+    }
+
+    // Append a whole block of borrowed columns (used when loading snapshots)
+    // Only valid while the row count is a multiple of BLOCK_ROWS. A partial
+    // block is copied, since later appends write into it.
+    inline void adoptBlock(LogBlock* block) {
+        if (block->count < BLOCK_ROWS) {
+            LogBlock* copy = newBlock();
+            memcpy(copy->timestampIds, block->timestampIds, sizeof(unsigned int) * block->count);
+            memcpy(copy->levelIds, block->levelIds, sizeof(unsigned int) * block->count);
+            memcpy(copy->messageIds, block->messageIds, sizeof(unsigned int) * block->count);
+            memcpy(copy->templateIds, block->templateIds, sizeof(unsigned int) * block->count);
+            memcpy(copy->epochs, block->epochs, sizeof(long long) * block->count);
+            copy->count = block->count;
+            deleteBlock(block);
+            block = copy;
+        }
+        publishBlock(block);
+        size.store((int)(blockCount - 1) * BLOCK_ROWS + block->count, std::memory_order_release);
+    }
+
+    // Write the row count and then each column as one contiguous array
+    inline void saveTo(SnapshotWriter& writer) const {
+        int total = getSize();
+        int blocks = (total + BLOCK_ROWS - 1) >> BLOCK_BITS;
+        writer.writeU64((unsigned long long)total);
+        for (int column = 0; column < 5; column++) {
+            size_t width = column < 4 ? sizeof(unsigned int) : sizeof(long long);
+            for (int b = 0; b < blocks; b++) {
+                const LogBlock* block = blockAt(b);
+                int rows = b == blocks - 1 ? total - b * BLOCK_ROWS : BLOCK_ROWS;
+                const void* data = column == 0 ? (const void*)block->timestampIds
+                                 : column == 1 ? (const void*)block->levelIds
+                                 : column == 2 ? (const void*)block->messageIds
+                                 : column == 3 ? (const void*)block->templateIds
+                                 : (const void*)block->epochs;
+                writer.write(data, width * rows);
+            }
+            static const char zeros[8] = { 0 };
+            if ((width * total) % 8 != 0) {
+                writer.write(zeros, 8 - (width * total) % 8);
+            }
+        }
+    }
+
+    // Load rows saved by saveTo() into an empty list
+    // Full blocks point straight into the mapped columns; nothing is copied per row.
+    // Every string ID must be in the pool and every template ID below templateCount.
+    inline bool loadFrom(SnapshotCursor& cursor, int templateCount) {
+        unsigned long long total = cursor.readU64();
+        if (total > 0x7FFFFFFFULL || getSize() != 0) {
+            cursor.fail();
+            return false;
+        }
+        const unsigned int* timestampIds = (const unsigned int*)cursor.readArray(sizeof(unsigned int) * total);
+        const unsigned int* levelIds = (const unsigned int*)cursor.readArray(sizeof(unsigned int) * total);
+        const unsigned int* messageIds = (const unsigned int*)cursor.readArray(sizeof(unsigned int) * total);
+        const unsigned int* templateIds = (const unsigned int*)cursor.readArray(sizeof(unsigned int) * total);
+        const long long* epochs = (const long long*)cursor.readArray(sizeof(long long) * total);
+        if (cursor.hasFailed()) {
+            return false;
+        }
+        for (unsigned long long row = 0; row < total; row++) {
+            if (!pool.contains(timestampIds[row]) || !pool.contains(levelIds[row]) ||
+                !pool.contains(messageIds[row]) || templateIds[row] >= (unsigned int)templateCount) {
+                cursor.fail();
+                return false;
+            }
+        }
+        for (unsigned long long first = 0; first < total; first += BLOCK_ROWS) {
+            LogBlock* block = new LogBlock;
+            block->timestampIds = (unsigned int*)timestampIds + first;
+            block->levelIds = (unsigned int*)levelIds + first;
+            block->messageIds = (unsigned int*)messageIds + first;
+            block->templateIds = (unsigned int*)templateIds + first;
+            block->epochs = (long long*)epochs + first;
+            block->count = total - first < (unsigned long long)BLOCK_ROWS ? (int)(total - first) : BLOCK_ROWS;
+            block->external = true;
+            adoptBlock(block);
+        }
+        return true;
+    }
+
     // Get the size of the list
     inline int getSize() const {
-        return size;
+        return size.load(std::memory_order_acquire);
     }
-    
-    // Display all log entries
+
+    // Number of blocks holding published rows
+    inline int getBlockCount() const {
+        return (getSize() + BLOCK_ROWS - 1) >> BLOCK_BITS;
+    }
+
+    // Add the memory held by the column blocks and the block directory
+    // Payload is the filled rows of each column; empty rows of the last block
+    // and unused directory entries are fragmentation. Borrowed blocks count as mapped.
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        for (int b = 0; b < blockCount; b++) {
+            const LogBlock* block = blockAt(b);
+            usage.addHeap(sizeof(LogBlock), 0, sizeof(LogBlock));
+            size_t rows = (size_t)block->count;
+            if (block->external) {
+                usage.mapped += (long long)((sizeof(unsigned int) * 4 + sizeof(long long)) * rows);
+                continue;
+            }
+            usage.addHeap(sizeof(unsigned int) * BLOCK_ROWS, sizeof(unsigned int) * rows, 0, 4);
+            usage.addHeap(sizeof(long long) * BLOCK_ROWS, sizeof(long long) * rows, 0);
+        }
+        for (int i = 0; i < DIRECTORY_SIZE; i++) {
+            if (directory[i].load(std::memory_order_relaxed) == nullptr) {
+                continue;
+            }
+            int filled = blockCount - i * DIRECTORY_SIZE;
+            if (filled > DIRECTORY_SIZE) {
+                filled = DIRECTORY_SIZE;
+            }
+            usage.addHeap(sizeof(LogBlock*) * DIRECTORY_SIZE, 0, sizeof(LogBlock*) * (size_t)filled);
+        }
+    }
+
+    // Get a block for columnar scans (rows below getSize() are stable)
+    inline const LogBlock* getBlock(int index) const {
+        return blockAt(index);
+    }
+
+    // Get a row view (row 0 is the oldest entry)
+    inline void getEntry(int row, LogEntry& entry) const {
+        const LogBlock* block = blockAt(row >> BLOCK_BITS);
+        int offset = row & (BLOCK_ROWS - 1);
+        entry.timestampId = block->timestampIds[offset];
+        entry.levelId = block->levelIds[offset];
+        entry.messageId = block->messageIds[offset];
+        entry.templateId = block->templateIds[offset];
+        entry.epoch = block->epochs[offset];
+        entry.timestamp = pool.lookup(entry.timestampId);
+        entry.log_level = pool.lookup(entry.levelId);
+        entry.message = pool.lookup(entry.messageId);
+    }
+
+    // Get the message text of a row
+    inline const char* getMessage(int row) const {
+        return pool.lookup(blockAt(row >> BLOCK_BITS)->messageIds[row & (BLOCK_ROWS - 1)]);
+    }
+
+    // Display all log entries (newest first)
     inline void displayAll() const {
-        LogEntry* current = head;
-        int index = 1;
-        
-        if (current == nullptr) {
+        int total = getSize();
+
+        if (total == 0) {
             std::cout << "No log entries found.\n";
             return;
         }
-        
+
         std::cout << "\n=== All Log Entries ===\n";
-        while (current != nullptr) {
-            std::cout << "[" << index << "] " << current->timestamp 
-                      << " [" << current->log_level << "] " 
-                      << current->message << "\n";
-            current = current->next;
+        LogEntry entry;
+        int index = 1;
+        for (int row = total - 1; row >= 0; row--) {
+            getEntry(row, entry);
+            std::cout << "[" << index << "] " << entry.timestamp
+                      << " [" << entry.log_level << "] "
+                      << entry.message << "\n";
             index++;
         }
-        std::cout << "\nTotal entries: " << size << "\n";
+        std::cout << "\nTotal entries: " << total << "\n";
     }
-    
+
     // Clear all entries
     inline void clear() {
-        LogEntry* current = head;
-        while (current != nullptr) {
-            LogEntry* next = current->next;
-            delete current;
-            current = next;
+        for (int i = 0; i < blockCount; i++) {
+            deleteBlock(blockAt(i));
         }
-        head = nullptr;
-        size = 0;
+        for (int i = 0; i < DIRECTORY_SIZE; i++) {
+            delete[] directory[i].load(std::memory_order_relaxed);
+            directory[i].store(nullptr, std::memory_order_relaxed);
+        }
+        blockCount = 0;
+        size.store(0, std::memory_order_release);
     }
+
+private:
+    // Copying is not supported
+    LogList(const LogList&);
+    LogList& operator=(const LogList&);
 };
 
-#endif // LOG_LIST_H
\ No newline at end of file
+#endif // LOG_LIST_H
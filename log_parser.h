@@ -0,0 +1,313 @@
+#ifndef LOG_PARSER_H
+#define LOG_PARSER_H
+
+#include "timestamp.h"
+#include <cstring>
+#include <cctype>
+
+// Level assigned to lines that start with a timestamp but no known level
+const char* const UNKNOWN_LEVEL = "UNKNOWN";
+
+// One log line split into fields (pointers into the caller's line buffer)
+struct ParsedLine {
+    const char* timestamp;
+    const char* level;
+    const char* message;
+    size_t messageLength;
+    long long epoch;
+};
+
+// Canonical name of a level word (case-insensitive), or nullptr if the word
+// is not a level. Aliases map the way syslogLevelName() maps severities, so
+// ERR, CRITICAL, FATAL and friends are counted as errors.
+inline const char* canonicalLevel(const char* word, size_t length) {
+    static const char* const WORDS[] = {
+        "TRACE", "DEBUG", "INFO", "NOTICE", "WARN", "WARNING",
+        "ERROR", "ERR", "CRITICAL", "CRIT", "FATAL", "SEVERE"
+    };
+    static const char* const NAMES[] = {
+        "DEBUG", "DEBUG", "INFO", "INFO", "WARNING", "WARNING",
+        "ERROR", "ERROR", "ERROR", "ERROR", "ERROR", "ERROR"
+    };
+    for (size_t i = 0; i < sizeof(WORDS) / sizeof(WORDS[0]); i++) {
+        if (strlen(WORDS[i]) != length) {
+            continue;
+        }
+        size_t j = 0;
+        while (j < length && toupper((unsigned char)word[j]) == WORDS[i][j]) {
+            j++;
+        }
+        if (j == length) {
+            return NAMES[i];
+        }
+    }
+    return nullptr;
+}
+
+// Parse "TIMESTAMP LEVEL message" in place
+// Accepts "2024-01-15 08:00:00 INFO msg", "... [INFO] msg", "... | INFO | msg"
+// and ISO timestamps with fractions and zone suffixes. The level is reported
+// by its canonical name (see canonicalLevel()). Writes a NUL terminator
+// after the timestamp. Returns false if the line does not start with a
+// timestamp (a continuation line such as a stack trace frame).
+inline bool parseLogLine(char* line, size_t length, ParsedLine& out) {
+    if (length < 19) {
+        return false;
+    }
+    long long epoch = parseTimestamp(line);
+    if (epoch == INVALID_EPOCH) {
+        return false;
+    }
+
+    // Timestamp token: the 19 parsed characters plus any fraction and zone
+    char* p = line + 19;
+    char* end = line + length;
+    if (p < end && (*p == '.' || *p == ',')) {
+        p++;
+        while (p < end && isdigit((unsigned char)*p)) {
+            p++;
+        }
+    }
+    if (p < end && *p == 'Z') {
+        p++;
+    } else if (p + 2 < end && (*p == '+' || *p == '-') && isdigit((unsigned char)p[1])) {
+        p++;
+        while (p < end && (isdigit((unsigned char)*p) || *p == ':')) {
+            p++;
+        }
+    }
+    char* timestampEnd = p;
+
+    // Level: first word after separators, if it names a level
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '|' || *p == '[')) {
+        p++;
+    }
+    char* level = p;
+    while (p < end && isalpha((unsigned char)*p)) {
+        p++;
+    }
+    const char* levelName = canonicalLevel(level, (size_t)(p - level));
+    bool hasLevel = levelName != nullptr &&
+                    (p == end || *p == ' ' || *p == '\t' || *p == ']' || *p == '|' || *p == ':');
+    if (hasLevel) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ']' || *p == '|' || *p == ':')) {
+            p++;
+        }
+    } else {
+        p = level;
+    }
+
+    out.epoch = epoch;
+    out.timestamp = line;
+    out.message = p;
+    out.messageLength = (size_t)(end - p);
+    *timestampEnd = '\0';
+    out.level = hasLevel ? levelName : UNKNOWN_LEVEL;
+    return true;
+}
+
+// Parses lines of another format for LogLineAssembler (such as JSON lines);
+// returns false to let the line be parsed as plain text
+typedef bool (*LineParser)(void* context, char* line, size_t length, ParsedLine& out);
+
+// One complete log entry from LogLineAssembler
+struct AssembledEntry {
+    const char* timestamp;
+    const char* level;
+    const char* message;       // Continuation lines are joined with '\n'
+    size_t messageLength;
+    long long epoch;           // INVALID_EPOCH for text before the first timestamp
+    const char* raw;           // The entry's lines as read, joined with '\n' (nullptr unless kept)
+    size_t rawLength;
+};
+
+// Turns a stream of lines into log entries
+// A line that starts with a timestamp begins a new entry; any other line
+// (stack traces, wrapped text) is folded into the message of the entry
+// before it. Text before the first timestamped line becomes an entry with
+// an empty timestamp and level UNKNOWN. An optional LineParser is tried
+// first; every line it accepts is a complete entry of its own.
+// With setKeepRawText(true) each entry also carries its lines unparsed, for
+// callers that reorder whole entries (the file sort).
+class LogLineAssembler {
+private:
+    // Growable text buffer holding "timestamp\0level\0message\0"
+    struct EntryBuffer {
+        char* text;
+        size_t capacity;
+        size_t length;
+        size_t levelOffset;
+        size_t messageOffset;
+        long long epoch;
+        char* raw;             // Original lines (when raw text is kept)
+        size_t rawCapacity;
+        size_t rawLength;
+    };
+
+    EntryBuffer buffers[2];
+    int pending;               // Buffer being assembled
+    bool hasPending;
+    AssembledEntry completed;
+    long long continuationLines;
+    LineParser parser;
+    void* parserContext;
+    bool keepRaw;
+    char* rawLine;             // Copy of the current line (parsing edits it in place)
+    size_t rawLineCapacity;
+    size_t rawLineLength;
+
+    // Append to a NUL-terminated growable buffer
+    inline static void appendBytes(char*& text, size_t& capacity, size_t& length, const char* data,
+                                   size_t size) {
+        if (length + size + 1 > capacity) {
+            size_t grown = capacity > 0 ? capacity * 2 : 256;
+            while (grown < length + size + 1) {
+                grown *= 2;
+            }
+            char* bigger = new char[grown];
+            if (length > 0) {
+                memcpy(bigger, text, length);
+            }
+            delete[] text;
+            text = bigger;
+            capacity = grown;
+        }
+        memcpy(text + length, data, size);
+        length += size;
+        text[length] = '\0';
+    }
+
+    inline static void append(EntryBuffer& buffer, const char* text, size_t length) {
+        appendBytes(buffer.text, buffer.capacity, buffer.length, text, length);
+    }
+
+    inline void start(const char* timestamp, const char* level, const char* message,
+                      size_t messageLength, long long epoch) {
+        EntryBuffer& buffer = buffers[pending];
+        buffer.length = 0;
+        append(buffer, timestamp, strlen(timestamp) + 1);
+        buffer.levelOffset = buffer.length;
+        append(buffer, level, strlen(level) + 1);
+        buffer.messageOffset = buffer.length;
+        append(buffer, message, messageLength);
+        buffer.epoch = epoch;
+        buffer.rawLength = 0;
+        if (keepRaw) {
+            appendBytes(buffer.raw, buffer.rawCapacity, buffer.rawLength, rawLine, rawLineLength);
+        }
+        hasPending = true;
+    }
+
+    // Hand out the pending entry and switch to the other buffer
+    inline void complete() {
+        EntryBuffer& buffer = buffers[pending];
+        completed.timestamp = buffer.text;
+        completed.level = buffer.text + buffer.levelOffset;
+        completed.message = buffer.text + buffer.messageOffset;
+        completed.messageLength = buffer.length - buffer.messageOffset;
+        completed.epoch = buffer.epoch;
+        completed.raw = keepRaw ? buffer.raw : nullptr;
+        completed.rawLength = buffer.rawLength;
+        pending ^= 1;
+        hasPending = false;
+    }
+
+public:
+    inline explicit LogLineAssembler(LineParser lineParser = nullptr, void* context = nullptr) {
+        parser = lineParser;
+        parserContext = context;
+        for (int i = 0; i < 2; i++) {
+            buffers[i].capacity = 256;
+            buffers[i].text = new char[buffers[i].capacity];
+            buffers[i].length = 0;
+            buffers[i].raw = nullptr;
+            buffers[i].rawCapacity = 0;
+            buffers[i].rawLength = 0;
+        }
+        keepRaw = false;
+        rawLine = nullptr;
+        rawLineCapacity = 0;
+        rawLineLength = 0;
+        pending = 0;
+        hasPending = false;
+        continuationLines = 0;
+        memset(&completed, 0, sizeof(completed));
+    }
+
+    inline ~LogLineAssembler() {
+        delete[] buffers[0].text;
+        delete[] buffers[1].text;
+        delete[] buffers[0].raw;
+        delete[] buffers[1].raw;
+        delete[] rawLine;
+    }
+
+    // Keep each entry's original lines in AssembledEntry::raw (blank lines
+    // are kept inside an entry; those before the first entry are dropped)
+    inline void setKeepRawText(bool keep) {
+        keepRaw = keep;
+    }
+
+    // Feed one line (modified in place); returns true if it completed the
+    // previous entry, which entry() then returns until the next call
+    inline bool addLine(char* line, size_t length) {
+        ParsedLine parsed;
+        if (length == 0) {
+            if (keepRaw && hasPending) {
+                EntryBuffer& buffer = buffers[pending];
+                appendBytes(buffer.raw, buffer.rawCapacity, buffer.rawLength, "\n", 1);
+            }
+            return false;
+        }
+        if (keepRaw) {
+            rawLineLength = 0;
+            appendBytes(rawLine, rawLineCapacity, rawLineLength, line, length);
+        }
+        bool custom = parser != nullptr && parser(parserContext, line, length, parsed);
+        if (!custom && !parseLogLine(line, length, parsed)) {
+            if (hasPending) {
+                continuationLines++;
+                EntryBuffer& buffer = buffers[pending];
+                append(buffer, "\n", 1);
+                append(buffer, line, length);
+                if (keepRaw) {
+                    appendBytes(buffer.raw, buffer.rawCapacity, buffer.rawLength, "\n", 1);
+                    appendBytes(buffer.raw, buffer.rawCapacity, buffer.rawLength, rawLine, rawLineLength);
+                }
+                return false;
+            }
+            start("", UNKNOWN_LEVEL, line, length, INVALID_EPOCH);
+            return false;
+        }
+        bool done = hasPending;
+        if (done) {
+            complete();
+        }
+        start(parsed.timestamp, parsed.level, parsed.message, parsed.messageLength, parsed.epoch);
+        return done;
+    }
+
+    // Complete the last entry at end of input; false if there is none
+    inline bool finish() {
+        if (!hasPending) {
+            return false;
+        }
+        complete();
+        return true;
+    }
+
+    inline const AssembledEntry& entry() const {
+        return completed;
+    }
+
+    inline long long getContinuationLines() const {
+        return continuationLines;
+    }
+
+private:
+    // Copying is not supported
+    LogLineAssembler(const LogLineAssembler&);
+    LogLineAssembler& operator=(const LogLineAssembler&);
+};
+
+#endif // LOG_PARSER_H
@@ -1,24 +1,187 @@
 // Main entry point
-// Compile with: g++ -o analyzer main.cpp *.cpp
+// Build with: make (or g++ -Wall -std=c++11 -pthread -o analyzer main.cpp core.cpp ui_terminal.cpp)
 
 #include "core.h"
 #include "ui_terminal.h"
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
 
 int main(int argc, char* argv[]) {
     LogAnalyzer analyzer;
+    size_t sortMemory = (size_t)1024 << 20;
+    IngestConfig ingestConfig;
+    JsonFormat jsonFormat;
+    GeneratorConfig generatorConfig;
+    bool dumpStats = false;
+    bool dumpMemory = false;
+    const char* servePath = nullptr;
+    QueryServerConfig serverConfig;
+    SyslogConfig syslogConfig;
+    bool listenSyslog = false;
+    
+    // These apply wherever they appear (--stdin may exit early)
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            dumpStats = true;
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            dumpMemory = true;
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            servePath = argv[++i];
+        } else if (strcmp(argv[i], "--serve-threads") == 0 && i + 1 < argc) {
+            serverConfig.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--syslog") == 0 && i + 1 < argc) {
+            snprintf(syslogConfig.datagramPath, sizeof(syslogConfig.datagramPath), "%s", argv[++i]);
+            listenSyslog = true;
+        } else if (strcmp(argv[i], "--syslog-stream") == 0 && i + 1 < argc) {
+            snprintf(syslogConfig.streamPath, sizeof(syslogConfig.streamPath), "%s", argv[++i]);
+            listenSyslog = true;
+        } else if (strcmp(argv[i], "--syslog-udp") == 0 && i + 1 < argc) {
+            syslogConfig.udpPort = atoi(argv[++i]);
+            listenSyslog = syslogConfig.udpPort > 0 || listenSyslog;
+        }
+    }
     
     // Check command line arguments
-    if (argc > 1) {
-        if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             std::cout << "Usage: " << argv[0] << " [OPTIONS]\n";
             std::cout << "Options:\n";
             std::cout << "  --help, -h       Show this help message\n";
+            std::cout << "  --snapshot FILE  Load a saved snapshot before starting\n";
+            std::cout << "  --wal FILE       Durable ingestion: recover from FILE and FILE.snap,\n";
+            std::cout << "                   then log every new entry to FILE\n";
+            std::cout << "  --ingest PATTERN Ingest a directory or glob of log files, merged\n";
+            std::cout << "                   in timestamp order (quote globs)\n";
+            std::cout << "  --io MODE        How --ingest reads files: sync (default),\n";
+            std::cout << "                   uring (io_uring) or pool (pread thread pool)\n";
+            std::cout << "  --stdin          Ingest log lines piped to standard input\n";
+            std::cout << "                   (e.g. journalctl | ./analyzer --stdin); Ctrl+C ends\n";
+            std::cout << "                   an endless stream (journalctl -f), keeping what was read\n";
+            std::cout << "  --json           Parse lines holding a JSON object in later --ingest,\n";
+            std::cout << "                   --stdin and --sort options; other keys become key=value fields\n";
+            std::cout << "  --json-keys TS:LEVEL:MESSAGE\n";
+            std::cout << "                   JSON keys for the entry fields, each a comma list\n";
+            std::cout << "                   (default timestamp,time,ts,@timestamp:level,severity,...)\n";
+            std::cout << "  --generate N     Load N generated entries (realistic synthetic logs)\n";
+            std::cout << "  --seed S         Seed for later --generate options (default 1)\n";
+            std::cout << "  --stats          Print operation latencies and counters on exit\n";
+            std::cout << "  --memory         Print the memory used by each structure once loaded\n";
+            std::cout << "  --serve SOCKET   Load the data, then answer queries on a Unix socket\n";
+            std::cout << "                   until Ctrl+C instead of starting the menu\n";
+            std::cout << "                   (query with ./analyzer_client)\n";
+            std::cout << "  --serve-threads N  Query threads for --serve (default: one per core)\n";
+            std::cout << "  --syslog SOCKET  Once loaded, add syslog messages (RFC 5424/3164) sent to\n";
+            std::cout << "                   a Unix datagram socket until Ctrl+C, then continue\n";
+            std::cout << "  --syslog-stream SOCKET\n";
+            std::cout << "                   Also accept syslog over a Unix stream socket\n";
+            std::cout << "  --syslog-udp PORT  Also accept syslog over UDP on 127.0.0.1\n";
+            std::cout << "  --sort PATTERN OUTPUT\n";
+            std::cout << "                   Sort log files by timestamp into OUTPUT and exit\n";
+            std::cout << "                   (lines are written unchanged, each entry's continuation\n";
+            std::cout << "                   lines after it)\n";
+            std::cout << "  --sort-memory MB Memory limit for --sort (default 1024)\n";
             return 0;
         }
+        if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            if (!analyzer.loadSnapshot(argv[++i])) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--wal") == 0 && i + 1 < argc) {
+            const char* logPath = argv[++i];
+            char* snapshotPath = new char[strlen(logPath) + 6];
+            strcpy(snapshotPath, logPath);
+            strcat(snapshotPath, ".snap");
+            bool ok = analyzer.enableDurability(logPath, snapshotPath, WalConfig());
+            delete[] snapshotPath;
+            if (!ok) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--sort-memory") == 0 && i + 1 < argc) {
+            long long megabytes = atoll(argv[++i]);
+            sortMemory = (size_t)(megabytes > 0 ? megabytes : 1) << 20;
+        } else if (strcmp(argv[i], "--sort") == 0 && i + 2 < argc) {
+            bool ok = LogAnalyzer::sortLogFiles(argv[i + 1], argv[i + 2], sortMemory, ingestConfig.jsonFormat);
+            return ok ? 0 : 1;
+        } else if (strcmp(argv[i], "--stdin") == 0) {
+            analyzer.ingestStream(0, ingestConfig.jsonFormat);
+            // The menu needs a terminal once the pipe is drained
+            if (!isatty(0) && servePath == nullptr && !listenSyslog &&
+                freopen("/dev/tty", "r", stdin) == nullptr) {
+                std::cout << "Total Logs: " << analyzer.getTotalLogs()
+                          << ", Errors: " << analyzer.getErrorCount() << "\n";
+                if (dumpMemory) {
+                    analyzer.displayMemoryUsage();
+                }
+                if (dumpStats) {
+                    analyzer.displayMetrics();
+                }
+                return 0;
+            }
+            std::cin.clear();
+        } else if (strcmp(argv[i], "--json") == 0) {
+            ingestConfig.jsonFormat = &jsonFormat;
+        } else if (strcmp(argv[i], "--json-keys") == 0 && i + 1 < argc) {
+            // TS:LEVEL:MESSAGE; an empty part keeps the default list
+            char* lists[3] = { jsonFormat.timestampKeys, jsonFormat.levelKeys, jsonFormat.messageKeys };
+            const char* part = argv[++i];
+            for (int k = 0; k < 3 && part != nullptr; k++) {
+                const char* colon = strchr(part, ':');
+                size_t length = colon != nullptr ? (size_t)(colon - part) : strlen(part);
+                if (length > 0 && length < sizeof(jsonFormat.timestampKeys)) {
+                    memcpy(lists[k], part, length);
+                    lists[k][length] = '\0';
+                }
+                part = colon != nullptr ? colon + 1 : nullptr;
+            }
+            ingestConfig.jsonFormat = &jsonFormat;
+        } else if (strcmp(argv[i], "--io") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "uring") == 0) {
+                ingestConfig.ioBackend = ASYNC_IO_URING;
+            } else if (strcmp(mode, "pool") == 0) {
+                ingestConfig.ioBackend = ASYNC_IO_THREAD_POOL;
+            } else {
+                ingestConfig.ioBackend = ASYNC_IO_NONE;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            generatorConfig.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            long long entries = atoll(argv[++i]);
+            generatorConfig.entries = entries > 0 ? entries : 0;
+            analyzer.loadGeneratedData(generatorConfig);
+        } else if (strcmp(argv[i], "--ingest") == 0 && i + 1 < argc) {
+            IngestStats stats;
+            analyzer.ingestFiles(argv[++i], ingestConfig, stats);
+        } else if ((strcmp(argv[i], "--serve") == 0 || strcmp(argv[i], "--serve-threads") == 0 ||
+                    strcmp(argv[i], "--syslog") == 0 || strcmp(argv[i], "--syslog-stream") == 0 ||
+                    strcmp(argv[i], "--syslog-udp") == 0) && i + 1 < argc) {
+            i++;   // Taken above
+        }
     }
     
-    // Run terminal UI
-    return runTerminalUI(analyzer);
+    if (listenSyslog) {
+        SyslogStats syslogStats;
+        if (!analyzer.listenSyslog(syslogConfig, syslogStats)) {
+            return 1;
+        }
+    }
+    
+    if (dumpMemory) {
+        analyzer.displayMemoryUsage();
+    }
+    
+    int status;
+    if (servePath != nullptr) {
+        status = analyzer.serve(servePath, serverConfig) ? 0 : 1;
+    } else {
+        // Run terminal UI
+        status = runTerminalUI(analyzer);
+    }
+    if (dumpStats) {
+        analyzer.displayMetrics();
+    }
+    return status;
 }
@@ -0,0 +1,111 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+#include <cstring>
+
+// Heap allocator model used to estimate per-allocation cost
+// Matches glibc malloc on 64-bit targets: an 8-byte size header, 16-byte
+// granularity and a 32-byte minimum chunk.
+static const size_t HEAP_HEADER_BYTES = 8;
+static const size_t HEAP_ALIGNMENT = 16;
+static const size_t HEAP_MIN_CHUNK = 32;
+
+// Bytes the allocator spends on a request of size bytes
+inline size_t heapChunkSize(size_t bytes) {
+    size_t chunk = (bytes + HEAP_HEADER_BYTES + HEAP_ALIGNMENT - 1) & ~(HEAP_ALIGNMENT - 1);
+    return chunk < HEAP_MIN_CHUNK ? HEAP_MIN_CHUNK : chunk;
+}
+
+// Bytes held by a data structure, split by what they are for
+//   payload        the stored data itself (text, column values, counts)
+//   overhead       what finds and links it: indexes, pointers, headers,
+//                  empty hash slots kept for the load factor, and allocator headers
+//   fragmentation  allocated but holding nothing: spare capacity at the end of
+//                  blocks and arrays, struct padding and allocator rounding
+// Memory used in place from a mapped snapshot is counted separately.
+struct MemoryUsage {
+    long long payload;
+    long long overhead;
+    long long fragmentation;
+    long long mapped;          // Bytes read in place from a mapped file (not heap)
+    long long allocations;     // Live heap allocations
+
+    inline MemoryUsage() {
+        payload = 0;
+        overhead = 0;
+        fragmentation = 0;
+        mapped = 0;
+        allocations = 0;
+    }
+
+    // count heap allocations of bytes each, of which payloadBytes hold data
+    // and overheadBytes hold bookkeeping; the rest is fragmentation
+    inline void addHeap(size_t bytes, size_t payloadBytes, size_t overheadBytes, long long count = 1) {
+        size_t used = payloadBytes + overheadBytes;
+        size_t unused = heapChunkSize(bytes) - HEAP_HEADER_BYTES - (used < bytes ? used : bytes);
+        payload += (long long)payloadBytes * count;
+        overhead += (long long)(overheadBytes + HEAP_HEADER_BYTES) * count;
+        fragmentation += (long long)unused * count;
+        allocations += count;
+    }
+
+    // Bytes inside an enclosing object or allocation (no allocation of their own)
+    inline void addInline(size_t payloadBytes, size_t overheadBytes, size_t unusedBytes = 0) {
+        payload += (long long)payloadBytes;
+        overhead += (long long)overheadBytes;
+        fragmentation += (long long)unusedBytes;
+    }
+
+    inline void add(const MemoryUsage& other) {
+        payload += other.payload;
+        overhead += other.overhead;
+        fragmentation += other.fragmentation;
+        mapped += other.mapped;
+        allocations += other.allocations;
+    }
+
+    // Heap bytes (mapped bytes excluded)
+    inline long long total() const {
+        return payload + overhead + fragmentation;
+    }
+};
+
+// Memory of named parts of a larger structure
+struct MemoryReport {
+    static const int MAX_PARTS = 16;
+
+    const char* names[MAX_PARTS];
+    MemoryUsage parts[MAX_PARTS];
+    int partCount;
+    long long rows;            // Rows stored, for bytes per row
+
+    inline MemoryReport() {
+        partCount = 0;
+        rows = 0;
+    }
+
+    // Usage of a part, added on first use (name must outlive the report)
+    inline MemoryUsage& part(const char* name) {
+        for (int i = 0; i < partCount; i++) {
+            if (strcmp(names[i], name) == 0) {
+                return parts[i];
+            }
+        }
+        if (partCount == MAX_PARTS) {
+            return parts[MAX_PARTS - 1];
+        }
+        names[partCount] = name;
+        return parts[partCount++];
+    }
+
+    inline MemoryUsage total() const {
+        MemoryUsage sum;
+        for (int i = 0; i < partCount; i++) {
+            sum.add(parts[i]);
+        }
+        return sum;
+    }
+};
+
+#endif // MEMORY_USAGE_H
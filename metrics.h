@@ -0,0 +1,430 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Instrumentation is on by default; build with -DLOG_METRICS=0 to compile
+// every timer and counter out (the METRIC_* macros expand to nothing).
+#ifndef LOG_METRICS
+#define LOG_METRICS 1
+#endif
+
+#include "memory_usage.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+// Timed operations
+enum MetricTimer {
+    TIMER_ADD_LOG,
+    TIMER_SEARCH_KEYWORD,
+    TIMER_DISPLAY_KEYWORD,
+    TIMER_ERROR_FREQUENCY,
+    TIMER_TOP_ERRORS,
+    TIMER_SKETCH_ESTIMATES,
+    TIMER_LEVEL_COUNTS,
+    TIMER_ERROR_SPIKES,
+    TIMER_GROUP_BY,
+    TIMER_LOGS_WHERE,
+    TIMER_FIELD_STATS,
+    TIMER_LOGS_BY_TIME,
+    TIMER_SNAPSHOT_SAVE,
+    TIMER_SNAPSHOT_LOAD,
+    TIMER_CHECKPOINT,
+    TIMER_INGEST_FILES,
+    TIMER_INGEST_STREAM,
+    TIMER_INGEST_READ_BATCH,    // Reader thread: read, parse and reorder one batch
+    TIMER_INGEST_MERGE_WAIT,    // Merge blocked on a file's next batch
+    TIMER_FIND_KEYWORD,
+    TIMER_SERVE_QUERY,          // One query server request, on a pool thread
+    TIMER_SEARCH_PAGE,          // One page of a cursor search
+    TIMER_APPROXIMATE_SEARCH,   // One refinement of a sampled keyword count
+    TIMER_COUNT
+};
+
+// Event counters
+enum MetricCounter {
+    COUNTER_ENTRIES,
+    COUNTER_ERROR_ENTRIES,
+    COUNTER_MESSAGE_BYTES,
+    COUNTER_ROWS_SCANNED,       // Rows examined by keyword searches
+    COUNTER_KEYWORD_MATCHES,
+    COUNTER_INGEST_BYTES,
+    COUNTER_INGEST_BATCHES,
+    COUNTER_CONTINUATION_LINES,
+    COUNTER_SYSLOG_MESSAGES,    // Read by the syslog listener
+    COUNTER_SYSLOG_DROPPED,     // Dropped by the syslog listener or the kernel
+    COUNTER_QUERY_CACHE_HITS,   // Keyword queries extended from their cached result
+    COUNTER_QUERY_CACHE_NARROWED,  // Keyword queries filtered from a shorter keyword's result
+    COUNTER_COUNT
+};
+
+// Process-wide operation timers and counters
+//
+// Latencies go into HDR-style log-linear histograms: 16 linear sub-buckets
+// per power of two of nanoseconds, so any recorded value is known to within
+// 1/16 (6.25%) from 1 ns to about 18 minutes, in a fixed 5 KB per timer.
+//
+// Recording is contention-free: each thread writes its own shard (claimed
+// on first use), with plain relaxed loads and stores instead of atomic
+// read-modify-writes, and readers sum the shards. Threads beyond MAX_SHARDS
+// share the last shard through atomic adds. Snapshots taken while other
+// threads record are approximate but never torn per value. Very hot calls
+// can be timed on a sample of calls (METRIC_SCOPE_SAMPLED); counters are exact.
+class Metrics {
+public:
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int MAX_EXPONENT = 40;     // Values clamp at 2^41 ns
+    static const int BUCKETS = (MAX_EXPONENT - SUB_BITS + 2) * SUB_BUCKETS;
+    static const int MAX_SHARDS = 64;
+
+    // Summed view of one timer
+    struct TimerSummary {
+        unsigned long long count;
+        unsigned long long totalNanos;
+        unsigned long long minNanos;
+        unsigned long long maxNanos;
+        unsigned long long buckets[BUCKETS];
+    };
+
+    // Bucket of a duration
+    inline static int bucketOf(unsigned long long nanos) {
+        if (nanos < (unsigned long long)SUB_BUCKETS) {
+            return (int)nanos;
+        }
+        int exponent = 63 - __builtin_clzll(nanos);
+        if (exponent > MAX_EXPONENT) {
+            return BUCKETS - 1;
+        }
+        int sub = (int)((nanos >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+        return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    // Smallest duration in a bucket
+    inline static unsigned long long bucketStart(int bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return (unsigned long long)bucket;
+        }
+        int exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+        unsigned long long sub = (unsigned long long)(bucket % SUB_BUCKETS);
+        return (SUB_BUCKETS + sub) << (exponent - SUB_BITS);
+    }
+
+    // Value at quantile q (0-1) of a summary: the middle of its bucket
+    inline static unsigned long long percentile(const TimerSummary& summary, double q) {
+        if (summary.count == 0) {
+            return 0;
+        }
+        unsigned long long rank = (unsigned long long)(q * (double)summary.count);
+        if (rank >= summary.count) {
+            rank = summary.count - 1;
+        }
+        unsigned long long seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += summary.buckets[b];
+            if (seen > rank) {
+                unsigned long long low = bucketStart(b);
+                unsigned long long high = b + 1 < BUCKETS ? bucketStart(b + 1) : low;
+                unsigned long long middle = low + (high - low) / 2;
+                if (middle < summary.minNanos) {
+                    middle = summary.minNanos;
+                }
+                return middle > summary.maxNanos ? summary.maxNanos : middle;
+            }
+        }
+        return summary.maxNanos;
+    }
+
+private:
+    typedef std::atomic<unsigned long long> Cell;
+
+    struct TimerCells {
+        Cell totalNanos;
+        Cell minNanos;
+        Cell maxNanos;
+        Cell buckets[BUCKETS];
+    };
+
+    struct Shard {
+        TimerCells timers[TIMER_COUNT];
+        Cell counters[COUNTER_COUNT];
+    };
+
+    std::atomic<Shard*> shards[MAX_SHARDS];
+
+    // Per-thread ordinal shared by every Metrics instance
+    inline static int threadSlot() {
+        static std::atomic<int> nextSlot(0);
+        static thread_local int slot = -1;
+        if (slot < 0) {
+            int claimed = nextSlot.fetch_add(1);
+            slot = claimed < MAX_SHARDS ? claimed : MAX_SHARDS - 1;
+        }
+        return slot;
+    }
+
+    inline static void clearShard(Shard* shard) {
+        for (int t = 0; t < TIMER_COUNT; t++) {
+            TimerCells& cells = shard->timers[t];
+            cells.totalNanos.store(0, std::memory_order_relaxed);
+            cells.minNanos.store(~0ULL, std::memory_order_relaxed);
+            cells.maxNanos.store(0, std::memory_order_relaxed);
+            for (int b = 0; b < BUCKETS; b++) {
+                cells.buckets[b].store(0, std::memory_order_relaxed);
+            }
+        }
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            shard->counters[c].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    inline static Shard* newShard() {
+        Shard* shard = new Shard;
+        clearShard(shard);
+        return shard;
+    }
+
+    inline Shard* shardFor(int slot) {
+        Shard* shard = shards[slot].load(std::memory_order_acquire);
+        if (shard == nullptr) {
+            Shard* created = newShard();
+            if (shards[slot].compare_exchange_strong(shard, created, std::memory_order_acq_rel)) {
+                shard = created;
+            } else {
+                delete created;
+            }
+        }
+        return shard;
+    }
+
+    // Owner-only shards add with a load and a store; the shared shard adds atomically
+    inline static void add(Cell& cell, unsigned long long amount, bool shared) {
+        if (shared) {
+            cell.fetch_add(amount, std::memory_order_relaxed);
+        } else {
+            cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    inline Metrics() {
+        for (int i = 0; i < MAX_SHARDS; i++) {
+            shards[i].store(nullptr);
+        }
+    }
+
+    inline ~Metrics() {
+        for (int i = 0; i < MAX_SHARDS; i++) {
+            delete shards[i].load();
+        }
+    }
+
+    inline static bool enabled() {
+        return LOG_METRICS != 0;
+    }
+
+    // Record one duration; a sampled duration stands for weight calls
+    inline void record(MetricTimer timer, unsigned long long nanos, unsigned int weight = 1) {
+        int slot = threadSlot();
+        bool shared = slot == MAX_SHARDS - 1;
+        TimerCells& cells = shardFor(slot)->timers[timer];
+        add(cells.totalNanos, nanos * weight, shared);
+        add(cells.buckets[bucketOf(nanos)], weight, shared);
+        if (nanos < cells.minNanos.load(std::memory_order_relaxed)) {
+            unsigned long long seen = cells.minNanos.load(std::memory_order_relaxed);
+            while (nanos < seen && !cells.minNanos.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+            }
+        }
+        if (nanos > cells.maxNanos.load(std::memory_order_relaxed)) {
+            unsigned long long seen = cells.maxNanos.load(std::memory_order_relaxed);
+            while (nanos > seen && !cells.maxNanos.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    // True on every period-th call from a thread (period a power of two)
+    inline static bool sampleTick(unsigned int period) {
+        static thread_local unsigned int calls = 0;
+        return (++calls & (period - 1)) == 0;
+    }
+
+    inline void count(MetricCounter counter, unsigned long long amount) {
+        int slot = threadSlot();
+        add(shardFor(slot)->counters[counter], amount, slot == MAX_SHARDS - 1);
+    }
+
+    // Sum a timer over all shards
+    inline void summarize(MetricTimer timer, TimerSummary& summary) const {
+        memset(&summary, 0, sizeof(summary));
+        summary.minNanos = ~0ULL;
+        for (int i = 0; i < MAX_SHARDS; i++) {
+            const Shard* shard = shards[i].load(std::memory_order_acquire);
+            if (shard == nullptr) {
+                continue;
+            }
+            const TimerCells& cells = shard->timers[timer];
+            summary.totalNanos += cells.totalNanos.load(std::memory_order_relaxed);
+            unsigned long long low = cells.minNanos.load(std::memory_order_relaxed);
+            unsigned long long high = cells.maxNanos.load(std::memory_order_relaxed);
+            summary.minNanos = low < summary.minNanos ? low : summary.minNanos;
+            summary.maxNanos = high > summary.maxNanos ? high : summary.maxNanos;
+            // Count from the buckets so percentiles stay consistent with it
+            for (int b = 0; b < BUCKETS; b++) {
+                unsigned long long n = cells.buckets[b].load(std::memory_order_relaxed);
+                summary.buckets[b] += n;
+                summary.count += n;
+            }
+        }
+        if (summary.count == 0) {
+            summary.minNanos = 0;
+        }
+    }
+
+    inline unsigned long long getCounter(MetricCounter counter) const {
+        unsigned long long total = 0;
+        for (int i = 0; i < MAX_SHARDS; i++) {
+            const Shard* shard = shards[i].load(std::memory_order_acquire);
+            if (shard != nullptr) {
+                total += shard->counters[counter].load(std::memory_order_relaxed);
+            }
+        }
+        return total;
+    }
+
+    // Zero every timer and counter (values recorded meanwhile may survive)
+    inline void reset() {
+        for (int i = 0; i < MAX_SHARDS; i++) {
+            Shard* shard = shards[i].load(std::memory_order_acquire);
+            if (shard != nullptr) {
+                clearShard(shard);
+            }
+        }
+    }
+
+    // Add the memory held by the per-thread shards (all payload)
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        for (int i = 0; i < MAX_SHARDS; i++) {
+            if (shards[i].load(std::memory_order_acquire) != nullptr) {
+                usage.addHeap(sizeof(Shard), sizeof(Shard), 0);
+            }
+        }
+    }
+
+    inline static const char* timerName(MetricTimer timer) {
+        static const char* const NAMES[TIMER_COUNT] = {
+            "addLog", "searchKeyword", "displayLogsWithKeyword", "analyzeErrorFrequency", "topErrors",
+            "displaySketchEstimates", "displayLevelCounts", "displayErrorSpikes", "groupBy",
+            "displayLogsWhere", "displayFieldStats", "displayLogsByTime", "saveSnapshot",
+            "loadSnapshot", "checkpoint", "ingestFiles", "ingestStream", "ingest.readBatch",
+            "ingest.mergeWait", "findLogsWithKeyword", "server.query", "searchPage",
+            "refineApproximateSearch"
+        };
+        return NAMES[timer];
+    }
+
+    inline static const char* counterName(MetricCounter counter) {
+        static const char* const NAMES[COUNTER_COUNT] = {
+            "entries added", "ERROR entries", "message bytes", "rows scanned by searches",
+            "keyword matches", "ingested bytes", "ingest batches", "continuation lines folded",
+            "syslog messages", "syslog messages dropped", "query cache hits", "query cache narrowed"
+        };
+        return NAMES[counter];
+    }
+
+    // Table of every timer that ran, then the counters
+    inline void print(std::ostream& out) const {
+        if (!enabled()) {
+            out << "Metrics are compiled out (build without -DLOG_METRICS=0 to enable them)\n";
+            return;
+        }
+        TimerSummary* summary = new TimerSummary;
+        char line[192];
+        snprintf(line, sizeof(line), "%-24s %10s %11s %9s %9s %9s %9s %10s\n", "operation", "count",
+                 "total ms", "mean us", "p50 us", "p90 us", "p99 us", "max us");
+        out << line;
+        bool any = false;
+        for (int t = 0; t < TIMER_COUNT; t++) {
+            summarize((MetricTimer)t, *summary);
+            if (summary->count == 0) {
+                continue;
+            }
+            any = true;
+            snprintf(line, sizeof(line), "%-24s %10llu %11.2f %9.2f %9.2f %9.2f %9.2f %10.2f\n",
+                     timerName((MetricTimer)t), summary->count, summary->totalNanos / 1e6,
+                     summary->totalNanos / 1e3 / summary->count, percentile(*summary, 0.50) / 1e3,
+                     percentile(*summary, 0.90) / 1e3, percentile(*summary, 0.99) / 1e3,
+                     summary->maxNanos / 1e3);
+            out << line;
+        }
+        if (!any) {
+            out << "(no operations recorded)\n";
+        }
+        delete summary;
+        out << "Counters:\n";
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            out << "  " << counterName((MetricCounter)c) << ": " << getCounter((MetricCounter)c) << "\n";
+        }
+    }
+
+private:
+    // Copying is not supported
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+};
+
+// Records the lifetime of a scope into a timer (metrics may be nullptr)
+class ScopedMetricTimer {
+private:
+    Metrics* metrics;
+    MetricTimer timer;
+    unsigned int weight;
+    std::chrono::steady_clock::time_point started;
+
+public:
+    inline ScopedMetricTimer(Metrics* target, MetricTimer id, unsigned int sampleWeight = 1)
+        : metrics(target), timer(id), weight(sampleWeight) {
+        if (metrics != nullptr) {
+            started = std::chrono::steady_clock::now();
+        }
+    }
+
+    inline ~ScopedMetricTimer() {
+        if (metrics != nullptr) {
+            long long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - started).count();
+            metrics->record(timer, nanos > 0 ? (unsigned long long)nanos : 0, weight);
+        }
+    }
+
+private:
+    ScopedMetricTimer(const ScopedMetricTimer&);
+    ScopedMetricTimer& operator=(const ScopedMetricTimer&);
+};
+
+#define METRIC_CONCAT_(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_(a, b)
+
+#if LOG_METRICS
+// Time the rest of the enclosing scope; metrics is a Metrics* (may be nullptr)
+#define METRIC_SCOPE(metrics, timer) ScopedMetricTimer METRIC_CONCAT(metricTimer, __LINE__)((metrics), (timer))
+// Time every period-th run of a hot scope per thread (period a power of
+// two), weighting each sample by period; saves two clock reads per call
+#define METRIC_SCOPE_SAMPLED(metrics, timer, period) \
+    ScopedMetricTimer METRIC_CONCAT(metricTimer, __LINE__)( \
+        Metrics::sampleTick(period) ? (metrics) : nullptr, (timer), (period))
+// Add to a counter; metrics is a Metrics* (may be nullptr)
+#define METRIC_COUNT(metrics, counter, amount) \
+    do { \
+        Metrics* metricTarget = (metrics); \
+        if (metricTarget != nullptr) { \
+            metricTarget->count((counter), (unsigned long long)(amount)); \
+        } \
+    } while (0)
+#else
+#define METRIC_SCOPE(metrics, timer) do { } while (0)
+#define METRIC_SCOPE_SAMPLED(metrics, timer, period) do { } while (0)
+#define METRIC_COUNT(metrics, counter, amount) do { } while (0)
+#endif
+
+#endif // METRICS_H
@@ -0,0 +1,351 @@
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+
+#include "memory_usage.h"
+#include <cstring>
+#include <cctype>
+#include <mutex>
+
+// Rows whose message contains a keyword (oldest first) and the number of
+// keyword occurrences in them
+struct KeywordMatches {
+    int* rows;
+    int count;
+    int capacity;
+    long long occurrences;
+    int watermark;             // Rows [0, watermark) have been searched
+
+    inline KeywordMatches() {
+        rows = nullptr;
+        count = 0;
+        capacity = 0;
+        occurrences = 0;
+        watermark = 0;
+    }
+
+    inline ~KeywordMatches() {
+        delete[] rows;
+    }
+
+    inline void reserve(int needed) {
+        if (needed <= capacity) {
+            return;
+        }
+        int grown = capacity > 0 ? capacity * 2 : 64;
+        while (grown < needed) {
+            grown *= 2;
+        }
+        int* bigger = new int[grown];
+        if (count > 0) {
+            memcpy(bigger, rows, sizeof(int) * count);
+        }
+        delete[] rows;
+        rows = bigger;
+        capacity = grown;
+    }
+
+    inline void append(int row) {
+        if (count == capacity) {
+            reserve(count + 1);
+        }
+        rows[count++] = row;
+    }
+
+    inline void assign(const int* source, int sourceCount) {
+        count = 0;
+        reserve(sourceCount);
+        if (sourceCount > 0) {
+            memcpy(rows, source, sizeof(int) * sourceCount);
+        }
+        count = sourceCount;
+    }
+
+    inline void clear() {
+        count = 0;
+        occurrences = 0;
+        watermark = 0;
+    }
+
+private:
+    // Copying is not supported
+    KeywordMatches(const KeywordMatches&);
+    KeywordMatches& operator=(const KeywordMatches&);
+};
+
+// How a cached result answered a lookup
+enum QueryCacheOutcome {
+    QUERY_CACHE_MISS,          // Nothing usable: search every row
+    QUERY_CACHE_HIT,           // Same query: search only rows past the watermark
+    QUERY_CACHE_NARROWED       // A query for a substring of the keyword: search its
+                               // matching rows, then rows past its watermark
+};
+
+struct QueryCacheStats {
+    long long hits;
+    long long narrowed;
+    long long misses;
+    long long evictions;
+    int entries;
+    size_t bytes;
+};
+
+// LRU cache of keyword search results
+// An entry is keyed by the normalized keyword (lowercased for
+// case-insensitive queries), the case mode and the data generation, and
+// records the watermark: the number of rows it covers. Logs are only ever
+// appended, so a result stays correct for its rows and a repeated query
+// searches only the rows added since. Clearing or replacing the data starts
+// a new generation, which retires every entry.
+//
+// A keyword containing a cached keyword can only match rows that one
+// matched, so a narrowing query searches the cached rows instead of the
+// whole store. A case-insensitive entry narrows queries in either case mode;
+// a case-sensitive one only case-sensitive queries.
+//
+// Lookups copy what they need out under the lock and the search runs
+// outside it, so concurrent queries (query server threads) do not wait for
+// each other's scans. Entries are few, so they are found by a linear scan of
+// the recency list.
+class QueryCache {
+private:
+    struct Entry {
+        char* keyword;
+        size_t length;
+        bool caseSensitive;
+        long long generation;
+        KeywordMatches matches;
+        Entry* newer;
+        Entry* older;
+    };
+
+    int maxEntries;
+    size_t maxBytes;
+    bool enabled;
+    mutable std::mutex lock;
+    Entry* newest;
+    Entry* oldest;
+    int entryCount;
+    size_t byteCount;          // Keyword text and row arrays of every entry
+    QueryCacheStats stats;
+
+    static inline size_t entryBytes(const Entry* entry) {
+        return entry->length + 1 + sizeof(int) * (size_t)entry->matches.capacity;
+    }
+
+    inline void unlink(Entry* entry) {
+        if (entry->newer != nullptr) {
+            entry->newer->older = entry->older;
+        } else {
+            newest = entry->older;
+        }
+        if (entry->older != nullptr) {
+            entry->older->newer = entry->newer;
+        } else {
+            oldest = entry->newer;
+        }
+        entry->newer = nullptr;
+        entry->older = nullptr;
+    }
+
+    inline void pushNewest(Entry* entry) {
+        entry->older = newest;
+        entry->newer = nullptr;
+        if (newest != nullptr) {
+            newest->newer = entry;
+        } else {
+            oldest = entry;
+        }
+        newest = entry;
+    }
+
+    inline void destroy(Entry* entry) {
+        unlink(entry);
+        byteCount -= entryBytes(entry);
+        entryCount--;
+        delete[] entry->keyword;
+        delete entry;
+    }
+
+    inline Entry* find(const char* keyword, size_t length, bool caseSensitive, long long generation) const {
+        for (Entry* entry = newest; entry != nullptr; entry = entry->older) {
+            if (entry->generation == generation && entry->caseSensitive == caseSensitive &&
+                entry->length == length && memcmp(entry->keyword, keyword, length) == 0) {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    // Longest cached keyword contained in the query that can narrow it
+    inline Entry* findParent(const char* keyword, size_t length, bool caseSensitive, long long generation,
+                             const char* lowered) const {
+        Entry* best = nullptr;
+        for (Entry* entry = newest; entry != nullptr; entry = entry->older) {
+            if (entry->generation != generation || entry->length >= length ||
+                (entry->caseSensitive && !caseSensitive) ||
+                (best != nullptr && entry->length <= best->length)) {
+                continue;
+            }
+            const char* text = entry->caseSensitive ? keyword : lowered;
+            if (strstr(text, entry->keyword) != nullptr) {
+                best = entry;
+            }
+        }
+        return best;
+    }
+
+public:
+    inline QueryCache(int entries = 64, size_t bytes = (size_t)64 << 20) {
+        maxEntries = entries > 0 ? entries : 1;
+        maxBytes = bytes;
+        enabled = true;
+        newest = nullptr;
+        oldest = nullptr;
+        entryCount = 0;
+        byteCount = 0;
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    inline ~QueryCache() {
+        clear();
+    }
+
+    // Normalize a keyword for lookup (lowercase unless case-sensitive)
+    // key must hold strlen(keyword) + 1 bytes
+    static inline void normalize(const char* keyword, bool caseSensitive, char* key) {
+        size_t i = 0;
+        for (; keyword[i] != '\0'; i++) {
+            key[i] = caseSensitive ? keyword[i] : (char)tolower((unsigned char)keyword[i]);
+        }
+        key[i] = '\0';
+    }
+
+    // Start a search for a normalized keyword: copy the cached result (HIT)
+    // or the candidate rows of a narrower-matching parent query (NARROWED)
+    // into matches. The caller then searches what is left and calls store().
+    inline QueryCacheOutcome lookup(const char* key, bool caseSensitive, long long generation,
+                                    KeywordMatches& matches) {
+        size_t length = strlen(key);
+        std::lock_guard<std::mutex> guard(lock);
+        matches.clear();
+        if (!enabled) {
+            return QUERY_CACHE_MISS;
+        }
+        Entry* entry = find(key, length, caseSensitive, generation);
+        if (entry != nullptr) {
+            unlink(entry);
+            pushNewest(entry);
+            matches.assign(entry->matches.rows, entry->matches.count);
+            matches.occurrences = entry->matches.occurrences;
+            matches.watermark = entry->matches.watermark;
+            stats.hits++;
+            return QUERY_CACHE_HIT;
+        }
+        // A case-sensitive query may narrow from a case-insensitive parent,
+        // which is matched against the lowercased keyword
+        char* lowered = new char[length + 1];
+        normalize(key, false, lowered);
+        Entry* parent = findParent(key, length, caseSensitive, generation, lowered);
+        delete[] lowered;
+        if (parent != nullptr) {
+            unlink(parent);
+            pushNewest(parent);
+            matches.assign(parent->matches.rows, parent->matches.count);
+            matches.watermark = parent->matches.watermark;
+            stats.narrowed++;
+            return QUERY_CACHE_NARROWED;
+        }
+        stats.misses++;
+        return QUERY_CACHE_MISS;
+    }
+
+    // Remember a complete result (rows [0, matches.watermark) searched)
+    inline void store(const char* key, bool caseSensitive, long long generation, const KeywordMatches& matches) {
+        size_t length = strlen(key);
+        size_t bytes = length + 1 + sizeof(int) * (size_t)matches.count;
+        if (bytes > maxBytes) {
+            return;   // Larger than the whole cache
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        if (!enabled) {
+            return;
+        }
+        Entry* entry = find(key, length, caseSensitive, generation);
+        if (entry != nullptr) {
+            if (entry->matches.watermark >= matches.watermark) {
+                return;   // Another query stored a result at least as recent
+            }
+            destroy(entry);
+        }
+        // Retire entries of older generations and the least recently used
+        for (Entry* old = oldest; old != nullptr;) {
+            Entry* next = old->newer;
+            if (old->generation != generation) {
+                destroy(old);
+                stats.evictions++;
+            }
+            old = next;
+        }
+        while (oldest != nullptr && (entryCount >= maxEntries || byteCount + bytes > maxBytes)) {
+            destroy(oldest);
+            stats.evictions++;
+        }
+        entry = new Entry;
+        entry->keyword = new char[length + 1];
+        memcpy(entry->keyword, key, length + 1);
+        entry->length = length;
+        entry->caseSensitive = caseSensitive;
+        entry->generation = generation;
+        entry->matches.assign(matches.rows, matches.count);
+        entry->matches.occurrences = matches.occurrences;
+        entry->matches.watermark = matches.watermark;
+        entry->newer = nullptr;
+        entry->older = nullptr;
+        pushNewest(entry);
+        entryCount++;
+        byteCount += entryBytes(entry);
+    }
+
+    inline void clear() {
+        std::lock_guard<std::mutex> guard(lock);
+        while (oldest != nullptr) {
+            destroy(oldest);
+        }
+    }
+
+    // Turn caching off (entries are dropped) or back on
+    inline void setEnabled(bool on) {
+        if (!on) {
+            clear();
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        enabled = on;
+    }
+
+    inline void getStats(QueryCacheStats& out) const {
+        std::lock_guard<std::mutex> guard(lock);
+        out = stats;
+        out.entries = entryCount;
+        out.bytes = byteCount;
+    }
+
+    // Add the heap held by entries (keyword copies, row arrays, nodes)
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        std::lock_guard<std::mutex> guard(lock);
+        for (const Entry* entry = newest; entry != nullptr; entry = entry->older) {
+            usage.addHeap(sizeof(Entry), 0, sizeof(Entry));
+            usage.addHeap(entry->length + 1, entry->length + 1, 0);
+            if (entry->matches.rows != nullptr) {
+                usage.addHeap(sizeof(int) * (size_t)entry->matches.capacity,
+                              sizeof(int) * (size_t)entry->matches.count, 0);
+            }
+        }
+    }
+
+private:
+    // Copying is not supported
+    QueryCache(const QueryCache&);
+    QueryCache& operator=(const QueryCache&);
+};
+
+#endif // QUERY_CACHE_H
@@ -0,0 +1,271 @@
+#ifndef QUERY_PROTOCOL_H
+#define QUERY_PROTOCOL_H
+
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Wire format of the query server (all integers little-endian)
+//   request:  u32 length | u8 op | u8 flags | u16 limit | argument (length - 4 bytes)
+//   response: u32 length | u8 status | text (length - 1 bytes)
+// A connection carries any number of requests; responses come back in order.
+enum QueryOp {
+    QUERY_PING = 0,        // "pong"
+    QUERY_STATS = 1,       // "name value" lines: logs, errors, templates...
+    QUERY_SEARCH = 2,      // Occurrences of the argument in log messages
+    QUERY_LOGS = 3,        // "total N", then up to limit (default 20) logs containing
+                           // the argument, newest first
+    QUERY_ERRORS = 4,      // Up to limit (default 10) "count<TAB>text" ERROR lines,
+                           // most frequent first
+    QUERY_OP_COUNT
+};
+
+// Request flags
+static const unsigned char QUERY_CASE_INSENSITIVE = 1;  // SEARCH, LOGS
+static const unsigned char QUERY_BY_TEMPLATE = 2;       // ERRORS: group by message template
+static const unsigned char QUERY_APPROXIMATE = 4;       // ERRORS: fixed-memory heavy hitters
+
+enum QueryStatus {
+    QUERY_OK = 0,
+    QUERY_BAD_REQUEST = 1,  // Unknown op or missing argument; text says why
+    QUERY_FAILED = 2
+};
+
+static const int QUERY_HEADER_BYTES = 4;             // Length prefix
+static const int QUERY_REQUEST_FIXED = 4;            // op, flags, limit
+static const size_t QUERY_MAX_REQUEST = 64 * 1024;   // Longest request body accepted
+static const size_t QUERY_MAX_RESPONSE = 256u << 20;
+
+inline void queryPutU32(char* out, unsigned int value) {
+    out[0] = (char)(value & 0xFF);
+    out[1] = (char)((value >> 8) & 0xFF);
+    out[2] = (char)((value >> 16) & 0xFF);
+    out[3] = (char)((value >> 24) & 0xFF);
+}
+
+inline unsigned int queryGetU32(const char* in) {
+    const unsigned char* p = (const unsigned char*)in;
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) |
+           ((unsigned int)p[3] << 24);
+}
+
+// A decoded request; argument is NUL-terminated
+struct QueryRequest {
+    unsigned char op;
+    unsigned char flags;
+    int limit;
+    const char* argument;
+    size_t argumentLength;
+};
+
+// Growable byte buffer for frames and response text
+struct QueryBuffer {
+    char* data;
+    size_t size;
+    size_t capacity;
+
+    inline QueryBuffer() {
+        data = nullptr;
+        size = 0;
+        capacity = 0;
+    }
+
+    inline ~QueryBuffer() {
+        delete[] data;
+    }
+
+    inline void reserve(size_t needed) {
+        if (needed <= capacity) {
+            return;
+        }
+        size_t grown = capacity > 0 ? capacity * 2 : 256;
+        while (grown < needed) {
+            grown *= 2;
+        }
+        char* bigger = new char[grown];
+        if (size > 0) {
+            memcpy(bigger, data, size);
+        }
+        delete[] data;
+        data = bigger;
+        capacity = grown;
+    }
+
+    inline void append(const char* bytes, size_t length) {
+        reserve(size + length);
+        memcpy(data + size, bytes, length);
+        size += length;
+    }
+
+    inline void append(const char* text) {
+        append(text, strlen(text));
+    }
+
+    inline void appendNumber(long long value) {
+        char digits[24];
+        int length = 0;
+        unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+        do {
+            digits[length++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        if (value < 0) {
+            digits[length++] = '-';
+        }
+        reserve(size + length);
+        while (length > 0) {
+            data[size++] = digits[--length];
+        }
+    }
+
+    // Drop the first count bytes
+    inline void consume(size_t count) {
+        memmove(data, data + count, size - count);
+        size -= count;
+    }
+
+    inline void clear() {
+        size = 0;
+    }
+
+private:
+    // Copying is not supported
+    QueryBuffer(const QueryBuffer&);
+    QueryBuffer& operator=(const QueryBuffer&);
+};
+
+// Blocking client connection to a query server
+class QueryClient {
+private:
+    int fd;
+    QueryBuffer frame;
+
+    inline bool sendAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += sent;
+            size -= (size_t)sent;
+        }
+        return true;
+    }
+
+    inline bool receiveAll(char* data, size_t size) {
+        while (size > 0) {
+            ssize_t received = recv(fd, data, size, 0);
+            if (received <= 0) {
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += received;
+            size -= (size_t)received;
+        }
+        return true;
+    }
+
+public:
+    inline QueryClient() {
+        fd = -1;
+    }
+
+    inline ~QueryClient() {
+        disconnect();
+    }
+
+    inline bool connectTo(const char* socketPath) {
+        disconnect();
+        struct sockaddr_un address;
+        if (strlen(socketPath) >= sizeof(address.sun_path)) {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, socketPath);
+        if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+            int error = errno;
+            disconnect();
+            errno = error;
+            return false;
+        }
+        return true;
+    }
+
+    inline void disconnect() {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    // Send one request and wait for its response; text receives the response
+    // text (NUL-terminated) and status its status. Returns false if the
+    // connection failed.
+    inline bool query(unsigned char op, unsigned char flags, int limit, const char* argument,
+                      unsigned char& status, QueryBuffer& text) {
+        size_t argumentLength = argument != nullptr ? strlen(argument) : 0;
+        if (argumentLength + QUERY_REQUEST_FIXED > QUERY_MAX_REQUEST) {
+            return false;
+        }
+        if (limit < 0) {
+            limit = 0;
+        } else if (limit > 0xFFFF) {
+            limit = 0xFFFF;
+        }
+        char header[QUERY_HEADER_BYTES + QUERY_REQUEST_FIXED];
+        queryPutU32(header, (unsigned int)(QUERY_REQUEST_FIXED + argumentLength));
+        header[4] = (char)op;
+        header[5] = (char)flags;
+        header[6] = (char)(limit & 0xFF);
+        header[7] = (char)(limit >> 8);
+        frame.clear();
+        frame.append(header, sizeof(header));
+        frame.append(argument != nullptr ? argument : "", argumentLength);
+        if (!sendAll(frame.data, frame.size)) {
+            return false;
+        }
+
+        char length[QUERY_HEADER_BYTES];
+        if (!receiveAll(length, sizeof(length))) {
+            return false;
+        }
+        size_t bodyLength = queryGetU32(length);
+        if (bodyLength < 1 || bodyLength > QUERY_MAX_RESPONSE) {
+            return false;
+        }
+        char statusByte;
+        if (!receiveAll(&statusByte, 1)) {
+            return false;
+        }
+        status = (unsigned char)statusByte;
+        text.clear();
+        text.reserve(bodyLength);
+        if (!receiveAll(text.data, bodyLength - 1)) {
+            return false;
+        }
+        text.size = bodyLength - 1;
+        text.data[text.size] = '\0';
+        return true;
+    }
+
+private:
+    // Copying is not supported
+    QueryClient(const QueryClient&);
+    QueryClient& operator=(const QueryClient&);
+};
+
+#endif // QUERY_PROTOCOL_H
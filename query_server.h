@@ -0,0 +1,559 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include "query_protocol.h"
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <iostream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+
+// Runs one request and writes its response text; returns a QueryStatus
+// Called on pool threads, several at a time.
+typedef unsigned char (*QueryHandler)(void* context, const QueryRequest& request, QueryBuffer& response);
+
+struct QueryServerConfig {
+    int threads;             // Query threads (0 = one per core)
+    int maxConnections;      // Further clients are accepted and closed at once
+    int backlog;             // listen() backlog
+
+    inline QueryServerConfig() {
+        threads = 0;
+        maxConnections = 1024;
+        backlog = 128;
+    }
+};
+
+struct QueryServerStats {
+    long long connections;   // Clients accepted
+    long long rejected;      // Clients closed because maxConnections were open
+    long long requests;      // Requests answered
+    long long badFrames;     // Connections closed for an oversized or malformed frame
+};
+
+// Unix domain socket query server
+//
+// One thread runs an epoll loop that accepts clients, reads request frames
+// and writes responses; a pool of threads runs the handler. A connection has
+// at most one request with the pool: further pipelined requests wait in its
+// input buffer, and it is not polled for input meanwhile, so responses leave
+// in request order and a fast client cannot queue unbounded work. Workers
+// hand finished connections back through an eventfd. SIGINT and SIGTERM
+// (taken through a signalfd) or stop() end run().
+class QueryServer {
+private:
+    struct Connection {
+        int fd;
+        QueryBuffer input;           // Received bytes not yet dispatched
+        QueryBuffer argument;        // Argument of the request in flight
+        QueryRequest request;
+        QueryBuffer output;          // Response frame being written
+        size_t outputSent;
+        bool busy;                   // Request queued or running on the pool
+        bool closed;                 // Client gone; free once the pool returns it
+        unsigned int events;         // Registered epoll events
+        Connection* next;            // Task or completion queue link
+        Connection* prevOpen;        // Open connection list
+        Connection* nextOpen;
+    };
+
+    QueryServerConfig config;
+    QueryHandler handler;
+    void* context;
+    int listenFd;
+    int epollFd;
+    int wakeFd;                      // Workers -> loop: completions ready
+    int signalFd;
+    int openCount;
+    Connection* openList;
+    Connection* retired;             // Closed, freed after the current event batch
+    QueryServerStats stats;
+
+    // Pool state
+    std::mutex lock;
+    std::condition_variable taskSignal;
+    Connection* taskHead;
+    Connection* taskTail;
+    Connection* doneHead;            // Finished requests (order does not matter)
+    bool stopping;
+    std::thread** workers;
+    int workerCount;
+
+    inline void setEvents(Connection* connection, unsigned int events) {
+        if (connection->events == events) {
+            return;
+        }
+        struct epoll_event event;
+        event.events = events;
+        event.data.ptr = connection;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+
+    inline void closeConnection(Connection* connection) {
+        if (!connection->closed) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+            close(connection->fd);
+            connection->closed = true;
+            if (connection->prevOpen != nullptr) {
+                connection->prevOpen->nextOpen = connection->nextOpen;
+            } else {
+                openList = connection->nextOpen;
+            }
+            if (connection->nextOpen != nullptr) {
+                connection->nextOpen->prevOpen = connection->prevOpen;
+            }
+            openCount--;
+        }
+        if (!connection->busy) {
+            retire(connection);
+        }
+    }
+
+    // Free a closed connection once no event of the current batch can refer to it
+    inline void retire(Connection* connection) {
+        connection->next = retired;
+        retired = connection;
+    }
+
+    inline void freeRetired() {
+        while (retired != nullptr) {
+            Connection* next = retired->next;
+            delete retired;
+            retired = next;
+        }
+    }
+
+    inline void acceptClients() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;   // EAGAIN, or a client that gave up already
+            }
+            if (openCount >= config.maxConnections) {
+                close(fd);
+                stats.rejected++;
+                continue;
+            }
+            Connection* connection = new Connection;
+            connection->fd = fd;
+            connection->outputSent = 0;
+            connection->busy = false;
+            connection->closed = false;
+            connection->events = EPOLLIN;
+            connection->next = nullptr;
+            connection->prevOpen = nullptr;
+            connection->nextOpen = openList;
+            if (openList != nullptr) {
+                openList->prevOpen = connection;
+            }
+            openList = connection;
+            openCount++;
+            stats.connections++;
+
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = connection;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+
+    // Queue the next buffered request, if a whole frame has arrived
+    // Returns false if the connection sent a bad frame and was closed.
+    inline bool dispatch(Connection* connection) {
+        if (connection->busy || connection->outputSent < connection->output.size) {
+            return true;
+        }
+        QueryBuffer& input = connection->input;
+        if (input.size < (size_t)QUERY_HEADER_BYTES) {
+            return true;
+        }
+        size_t bodyLength = queryGetU32(input.data);
+        if (bodyLength < (size_t)QUERY_REQUEST_FIXED || bodyLength > QUERY_MAX_REQUEST) {
+            stats.badFrames++;
+            closeConnection(connection);
+            return false;
+        }
+        if (input.size < QUERY_HEADER_BYTES + bodyLength) {
+            return true;
+        }
+        const char* body = input.data + QUERY_HEADER_BYTES;
+        size_t argumentLength = bodyLength - QUERY_REQUEST_FIXED;
+        connection->argument.clear();
+        connection->argument.append(body + QUERY_REQUEST_FIXED, argumentLength);
+        connection->argument.append("", 1);
+        connection->request.op = (unsigned char)body[0];
+        connection->request.flags = (unsigned char)body[1];
+        connection->request.limit = (unsigned char)body[2] | ((unsigned char)body[3] << 8);
+        connection->request.argument = connection->argument.data;
+        connection->request.argumentLength = argumentLength;
+        input.consume(QUERY_HEADER_BYTES + bodyLength);
+
+        connection->busy = true;
+        setEvents(connection, 0);   // Hangups are still reported
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            connection->next = nullptr;
+            if (taskTail != nullptr) {
+                taskTail->next = connection;
+            } else {
+                taskHead = connection;
+            }
+            taskTail = connection;
+        }
+        taskSignal.notify_one();
+        return true;
+    }
+
+    inline void readInput(Connection* connection) {
+        QueryBuffer& input = connection->input;
+        while (true) {
+            input.reserve(input.size + 4096);
+            ssize_t received = recv(connection->fd, input.data + input.size, input.capacity - input.size, 0);
+            if (received > 0) {
+                input.size += (size_t)received;
+                if (input.size > QUERY_HEADER_BYTES + QUERY_MAX_REQUEST) {
+                    break;   // Dispatch (or reject) what is here before reading more
+                }
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            closeConnection(connection);   // End of stream or error
+            return;
+        }
+        dispatch(connection);
+    }
+
+    // Write pending output; when done, go back to reading requests
+    inline void writeOutput(Connection* connection) {
+        QueryBuffer& output = connection->output;
+        while (connection->outputSent < output.size) {
+            ssize_t sent = send(connection->fd, output.data + connection->outputSent,
+                                output.size - connection->outputSent, MSG_NOSIGNAL);
+            if (sent > 0) {
+                connection->outputSent += (size_t)sent;
+                continue;
+            }
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                setEvents(connection, EPOLLOUT);
+                return;
+            }
+            closeConnection(connection);
+            return;
+        }
+        output.clear();
+        connection->outputSent = 0;
+        setEvents(connection, EPOLLIN);
+        dispatch(connection);
+    }
+
+    // Take back connections whose requests finished
+    inline void collectCompleted() {
+        unsigned long long ignored;
+        if (read(wakeFd, &ignored, sizeof(ignored)) < 0) {
+            // Nothing pending (EAGAIN)
+        }
+        Connection* done;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            done = doneHead;
+            doneHead = nullptr;
+        }
+        while (done != nullptr) {
+            Connection* connection = done;
+            done = done->next;
+            connection->busy = false;
+            stats.requests++;
+            if (connection->closed) {
+                retire(connection);
+            } else {
+                writeOutput(connection);
+            }
+        }
+    }
+
+    inline void workerLoop() {
+        while (true) {
+            Connection* connection;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                while (taskHead == nullptr && !stopping) {
+                    taskSignal.wait(guard);
+                }
+                if (taskHead == nullptr) {
+                    return;
+                }
+                connection = taskHead;
+                taskHead = connection->next;
+                if (taskHead == nullptr) {
+                    taskTail = nullptr;
+                }
+            }
+
+            // Frame: length, status, text
+            QueryBuffer& output = connection->output;
+            output.clear();
+            output.append("\0\0\0\0\0", QUERY_HEADER_BYTES + 1);
+            unsigned char status;
+            if (connection->request.op >= QUERY_OP_COUNT) {
+                output.append("unknown request");
+                status = QUERY_BAD_REQUEST;
+            } else {
+                status = handler(context, connection->request, output);
+            }
+            queryPutU32(output.data, (unsigned int)(output.size - QUERY_HEADER_BYTES));
+            output.data[QUERY_HEADER_BYTES] = (char)status;
+            connection->outputSent = 0;
+
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                connection->next = doneHead;
+                doneHead = connection;
+            }
+            unsigned long long one = 1;
+            if (write(wakeFd, &one, sizeof(one)) < 0) {
+                // The counter is already non-zero; the loop will wake
+            }
+        }
+    }
+
+    static inline void runWorker(QueryServer* server) {
+        server->workerLoop();
+    }
+
+    // Create, bind and listen on the socket (replacing a stale socket file)
+    inline bool openSocket(const char* path) {
+        struct sockaddr_un address;
+        if (strlen(path) >= sizeof(address.sun_path)) {
+            std::cout << "Socket path too long: " << path << "\n";
+            return false;
+        }
+        struct stat info;
+        if (lstat(path, &info) == 0) {
+            if (!S_ISSOCK(info.st_mode)) {
+                std::cout << path << " exists and is not a socket\n";
+                return false;
+            }
+            unlink(path);
+        }
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            perror("socket");
+            return false;
+        }
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, path);
+        if (bind(listenFd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+            listen(listenFd, config.backlog) != 0) {
+            perror(path);
+            close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    inline void addWatch(int fd, void* tag) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = tag;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+public:
+    inline QueryServer(const QueryServerConfig& cfg) : config(cfg) {
+        handler = nullptr;
+        context = nullptr;
+        listenFd = -1;
+        epollFd = -1;
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        signalFd = -1;
+        openCount = 0;
+        openList = nullptr;
+        retired = nullptr;
+        memset(&stats, 0, sizeof(stats));
+        taskHead = nullptr;
+        taskTail = nullptr;
+        doneHead = nullptr;
+        stopping = false;
+        workers = nullptr;
+        workerCount = 0;
+        if (config.threads <= 0) {
+            config.threads = (int)std::thread::hardware_concurrency();
+            if (config.threads <= 0) {
+                config.threads = 4;
+            }
+        }
+        if (config.maxConnections < 1) {
+            config.maxConnections = 1;
+        }
+    }
+
+    inline ~QueryServer() {
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+    }
+
+    // Serve requests on socketPath until SIGINT/SIGTERM or stop()
+    // The socket file is removed on return. Returns false if it could not be opened.
+    inline bool run(const char* socketPath, QueryHandler queryHandler, void* handlerContext) {
+        handler = queryHandler;
+        context = handlerContext;
+        if (wakeFd < 0 || !openSocket(socketPath)) {
+            return false;
+        }
+
+        // Block the stop signals before starting threads, so only the signalfd sees them
+        sigset_t stopSignals;
+        sigset_t previousMask;
+        sigemptyset(&stopSignals);
+        sigaddset(&stopSignals, SIGINT);
+        sigaddset(&stopSignals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stopSignals, &previousMask);
+        signalFd = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        addWatch(listenFd, &listenFd);
+        addWatch(wakeFd, &wakeFd);
+        if (signalFd >= 0) {
+            addWatch(signalFd, &signalFd);
+        }
+
+        stopping = false;
+        workerCount = config.threads;
+        workers = new std::thread*[workerCount];
+        for (int i = 0; i < workerCount; i++) {
+            workers[i] = new std::thread(runWorker, this);
+        }
+
+        static const int MAX_EVENTS = 64;
+        struct epoll_event events[MAX_EVENTS];
+        bool running = true;
+        while (running) {
+            int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("epoll_wait");
+                break;
+            }
+            for (int i = 0; i < ready; i++) {
+                void* tag = events[i].data.ptr;
+                if (tag == &listenFd) {
+                    acceptClients();
+                } else if (tag == &wakeFd) {
+                    collectCompleted();
+                    std::lock_guard<std::mutex> guard(lock);
+                    running = running && !stopping;
+                } else if (tag == &signalFd) {
+                    // Consume the signal, or it is delivered when the mask is restored
+                    struct signalfd_siginfo info;
+                    if (read(signalFd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+                        running = false;
+                    }
+                } else {
+                    Connection* connection = (Connection*)tag;
+                    if (connection->closed) {
+                        continue;   // Closed earlier in this batch
+                    }
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                        // Pending responses are of no use to a client that hung up
+                        closeConnection(connection);
+                    } else if (events[i].events & EPOLLOUT) {
+                        writeOutput(connection);
+                    } else if (events[i].events & EPOLLIN) {
+                        readInput(connection);
+                    }
+                }
+            }
+            freeRetired();
+        }
+
+        // Let queued and running requests finish, then drop every client
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        taskSignal.notify_all();
+        for (int i = 0; i < workerCount; i++) {
+            workers[i]->join();
+            delete workers[i];
+        }
+        delete[] workers;
+        workers = nullptr;
+        collectCompleted();
+        while (taskHead != nullptr) {
+            // Dispatched after the workers stopped
+            Connection* connection = taskHead;
+            taskHead = connection->next;
+            connection->busy = false;
+            if (connection->closed) {
+                retire(connection);
+            }
+        }
+        taskTail = nullptr;
+        while (openList != nullptr) {
+            closeConnection(openList);
+        }
+        freeRetired();
+
+        close(epollFd);
+        epollFd = -1;
+        if (signalFd >= 0) {
+            close(signalFd);
+            signalFd = -1;
+        }
+        pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+        close(listenFd);
+        listenFd = -1;
+        unlink(socketPath);
+        return true;
+    }
+
+    // Make run() return (safe from any thread)
+    inline void stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        unsigned long long one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            // Already signalled
+        }
+    }
+
+    // Counters of the last run() (read after it returns)
+    inline const QueryServerStats& getStats() const {
+        return stats;
+    }
+
+private:
+    // Copying is not supported
+    QueryServer(const QueryServer&);
+    QueryServer& operator=(const QueryServer&);
+};
+
+#endif // QUERY_SERVER_H
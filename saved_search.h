@@ -0,0 +1,244 @@
+#ifndef SAVED_SEARCH_H
+#define SAVED_SEARCH_H
+
+#include "kmp.h"
+#include "memory_usage.h"
+#include <cstring>
+
+// Called for each new log a saved search matches, as it is stored
+typedef void (*SavedSearchCallback)(void* context, int searchId, int row, const char* timestamp,
+                                    const char* level, const char* message);
+
+// Current results of one saved search
+struct SavedSearchStatus {
+    static const int MAX_KEYWORD = 256;
+
+    char keyword[MAX_KEYWORD];   // As registered (lowercase if case-insensitive), truncated
+    bool caseSensitive;
+    long long occurrences;       // Keyword occurrences, as searchKeyword() counts them
+    long long matchingLogs;      // Logs containing the keyword
+    int lastRow;                 // Newest matching row (-1 if none)
+};
+
+// Standing keyword queries kept up to date as logs are stored
+// Each search holds a compiled KMP pattern, its counts and the rows it
+// matched in insertion order. New rows are matched once when stored, so
+// reading the results never rescans the log store. The caller serializes
+// every call (the analyzer holds its ingest lock).
+class SavedSearchSet {
+public:
+    static const int MAX_SEARCHES = 64;
+
+private:
+    struct Search {
+        bool active;
+        KMPPattern pattern;
+        long long occurrences;
+        int* rows;               // Matching rows, oldest first
+        int rowCount;
+        int rowCapacity;
+        SavedSearchCallback callback;
+        void* context;
+    };
+
+    Search searches[MAX_SEARCHES];
+    int activeCount;
+    int slotsInUse;              // Searches live in [0, slotsInUse)
+
+    static inline void appendRow(Search& search, int row) {
+        if (search.rowCount == search.rowCapacity) {
+            int capacity = search.rowCapacity > 0 ? search.rowCapacity * 2 : 64;
+            int* grown = new int[capacity];
+            if (search.rowCount > 0) {
+                memcpy(grown, search.rows, sizeof(int) * search.rowCount);
+            }
+            delete[] search.rows;
+            search.rows = grown;
+            search.rowCapacity = capacity;
+        }
+        search.rows[search.rowCount++] = row;
+    }
+
+    static inline void clearResults(Search& search) {
+        delete[] search.rows;
+        search.rows = nullptr;
+        search.rowCount = 0;
+        search.rowCapacity = 0;
+        search.occurrences = 0;
+    }
+
+public:
+    inline SavedSearchSet() {
+        for (int i = 0; i < MAX_SEARCHES; i++) {
+            searches[i].active = false;
+            searches[i].rows = nullptr;
+            searches[i].rowCount = 0;
+            searches[i].rowCapacity = 0;
+            searches[i].occurrences = 0;
+            searches[i].callback = nullptr;
+            searches[i].context = nullptr;
+        }
+        activeCount = 0;
+        slotsInUse = 0;
+    }
+
+    inline ~SavedSearchSet() {
+        clear();
+    }
+
+    // Register a search; returns its ID, or -1 if the keyword is empty or
+    // MAX_SEARCHES are registered. Existing rows are added with matchExisting().
+    inline int add(const char* keyword, bool caseSensitive, SavedSearchCallback callback, void* context) {
+        if (keyword == nullptr || keyword[0] == '\0') {
+            return -1;
+        }
+        int id = 0;
+        while (id < MAX_SEARCHES && searches[id].active) {
+            id++;
+        }
+        if (id == MAX_SEARCHES) {
+            return -1;
+        }
+        Search& search = searches[id];
+        search.pattern.compile(keyword, caseSensitive);
+        clearResults(search);
+        search.callback = callback;
+        search.context = context;
+        search.active = true;
+        activeCount++;
+        if (id >= slotsInUse) {
+            slotsInUse = id + 1;
+        }
+        return id;
+    }
+
+    inline bool remove(int id) {
+        if (!exists(id)) {
+            return false;
+        }
+        Search& search = searches[id];
+        search.active = false;
+        search.pattern.release();
+        clearResults(search);
+        search.callback = nullptr;
+        activeCount--;
+        while (slotsInUse > 0 && !searches[slotsInUse - 1].active) {
+            slotsInUse--;
+        }
+        return true;
+    }
+
+    // Remove every search
+    inline void clear() {
+        for (int i = 0; i < slotsInUse; i++) {
+            if (searches[i].active) {
+                remove(i);
+            }
+        }
+        slotsInUse = 0;
+    }
+
+    // Forget every result but keep the searches (the logs were cleared)
+    inline void reset() {
+        for (int i = 0; i < slotsInUse; i++) {
+            clearResults(searches[i]);
+        }
+    }
+
+    inline bool exists(int id) const {
+        return id >= 0 && id < slotsInUse && searches[id].active;
+    }
+
+    inline int getActiveCount() const {
+        return activeCount;
+    }
+
+    // Match a newly stored row against every search, calling the callbacks
+    // of those it matches
+    inline void matchNew(int row, const char* timestamp, const char* level, const char* message) {
+        for (int i = 0; i < slotsInUse; i++) {
+            Search& search = searches[i];
+            if (!search.active) {
+                continue;
+            }
+            int count = search.pattern.count(message);
+            if (count > 0) {
+                search.occurrences += count;
+                appendRow(search, row);
+                if (search.callback != nullptr) {
+                    search.callback(search.context, i, row, timestamp, level, message);
+                }
+            }
+        }
+    }
+
+    // Match an already stored row against one search (rows in increasing
+    // order, no callback); used when a search is added or results are rebuilt
+    inline void matchExisting(int id, int row, const char* message) {
+        if (!exists(id)) {
+            return;
+        }
+        Search& search = searches[id];
+        int count = search.pattern.count(message);
+        if (count > 0) {
+            search.occurrences += count;
+            appendRow(search, row);
+        }
+    }
+
+    // Counts and keyword of a search in O(1); false for an unknown ID
+    inline bool getStatus(int id, SavedSearchStatus& status) const {
+        if (!exists(id)) {
+            return false;
+        }
+        const Search& search = searches[id];
+        size_t length = (size_t)search.pattern.getLength();
+        if (length >= sizeof(status.keyword)) {
+            length = sizeof(status.keyword) - 1;
+        }
+        memcpy(status.keyword, search.pattern.getText(), length);
+        status.keyword[length] = '\0';
+        status.caseSensitive = search.pattern.isCaseSensitive();
+        status.occurrences = search.occurrences;
+        status.matchingLogs = search.rowCount;
+        status.lastRow = search.rowCount > 0 ? search.rows[search.rowCount - 1] : -1;
+        return true;
+    }
+
+    // Copy up to maxRows matching rows, newest first, skipping the newest
+    // `skip`; returns the number copied
+    inline int getRows(int id, int* rows, int maxRows, int skip = 0) const {
+        if (!exists(id) || skip < 0) {
+            return 0;
+        }
+        const Search& search = searches[id];
+        int copied = 0;
+        for (int i = search.rowCount - 1 - skip; i >= 0 && copied < maxRows; i--) {
+            rows[copied++] = search.rows[i];
+        }
+        return copied;
+    }
+
+    // Add the heap held by patterns and row lists
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        for (int i = 0; i < slotsInUse; i++) {
+            const Search& search = searches[i];
+            if (!search.active) {
+                continue;
+            }
+            size_t length = (size_t)search.pattern.getLength();
+            usage.addHeap(length + 1, length + 1, 0);
+            usage.addHeap(sizeof(int) * (length > 0 ? length : 1), 0, sizeof(int) * length);
+            if (search.rows != nullptr) {
+                usage.addHeap(sizeof(int) * (size_t)search.rowCapacity, sizeof(int) * (size_t)search.rowCount, 0);
+            }
+        }
+    }
+
+private:
+    // Copying is not supported
+    SavedSearchSet(const SavedSearchSet&);
+    SavedSearchSet& operator=(const SavedSearchSet&);
+};
+
+#endif // SAVED_SEARCH_H
@@ -0,0 +1,120 @@
+#ifndef SEARCH_CURSOR_H
+#define SEARCH_CURSOR_H
+
+#include "log_list.h"
+#include "kmp.h"
+
+// Position in a keyword search that is read a page at a time
+// Each page scans only until it is full, and the next page resumes where
+// the last one stopped, so the first page of a search costs time in
+// proportion to how far back its matches are, not to the size of the store.
+// Newest first covers the rows stored when the cursor was opened; oldest
+// first runs up to the newest row at each call, so logs added meanwhile
+// show up on later pages.
+class SearchCursor {
+private:
+    KMPPattern pattern;
+    bool newestFirst;
+    int next;                  // Next row to examine
+    bool exhausted;            // Every row has been examined (newest first)
+    long long generation;      // Data generation the rows belong to
+    long long scanned;         // Rows examined so far
+    long long pageScanned;     // Rows examined by the last page
+    long long matched;         // Matching rows returned so far
+
+public:
+    inline SearchCursor() {
+        newestFirst = true;
+        next = 0;
+        exhausted = true;
+        generation = 0;
+        scanned = 0;
+        pageScanned = 0;
+        matched = 0;
+    }
+
+    // Start a search over rowCount stored rows; false for an empty keyword
+    inline bool open(const char* keyword, bool caseSensitive, bool newest, int rowCount,
+                     long long dataGeneration) {
+        pattern.compile(keyword != nullptr ? keyword : "", caseSensitive);
+        newestFirst = newest;
+        next = newestFirst ? rowCount - 1 : 0;
+        exhausted = pattern.getLength() == 0 || (newestFirst && next < 0);
+        generation = dataGeneration;
+        scanned = 0;
+        pageScanned = 0;
+        matched = 0;
+        return pattern.getLength() > 0;
+    }
+
+    // Copy up to maxRows matching rows, in cursor order, into rows
+    // Returns the number copied (0 once no rows remain)
+    inline int nextPage(const LogList& logs, int* rows, int maxRows) {
+        int found = 0;
+        long long before = scanned;
+        pageScanned = 0;
+        if (exhausted || pattern.getLength() == 0) {
+            return 0;
+        }
+        if (newestFirst) {
+            while (next >= 0 && found < maxRows) {
+                if (pattern.count(logs.getMessage(next)) > 0) {
+                    rows[found++] = next;
+                }
+                next--;
+                scanned++;
+            }
+            exhausted = next < 0;
+        } else {
+            int total = logs.getSize();
+            while (next < total && found < maxRows) {
+                if (pattern.count(logs.getMessage(next)) > 0) {
+                    rows[found++] = next;
+                }
+                next++;
+                scanned++;
+            }
+        }
+        matched += found;
+        pageScanned = scanned - before;
+        return found;
+    }
+
+    // True when no rows are left to examine (oldest first: for now)
+    inline bool isDone(const LogList& logs) const {
+        return exhausted || (!newestFirst && next >= logs.getSize());
+    }
+
+    inline bool isNewestFirst() const {
+        return newestFirst;
+    }
+
+    inline long long getGeneration() const {
+        return generation;
+    }
+
+    inline long long getScanned() const {
+        return scanned;
+    }
+
+    inline long long getPageScanned() const {
+        return pageScanned;
+    }
+
+    inline long long getMatched() const {
+        return matched;
+    }
+
+    // Stop the search; later pages are empty
+    inline void close() {
+        pattern.release();
+        exhausted = true;
+    }
+
+private:
+    // Copying is not supported
+    SearchCursor(const SearchCursor&);
+    SearchCursor& operator=(const SearchCursor&);
+};
+
+#endif // SEARCH_CURSOR_H
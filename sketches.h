@@ -0,0 +1,468 @@
+#ifndef SKETCHES_H
+#define SKETCHES_H
+
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include "memory_usage.h"
+
+// 64-bit mix of a message's content hash (SplitMix64 finalizer)
+// Sketches are fed hashes of the message bytes (StringPool::hashBytes), not
+// pool IDs, so sketches built by other threads, processes or from a reloaded
+// snapshot count the same message as the same item and can be merged.
+inline unsigned long long sketchHash(unsigned long long value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+// HyperLogLog distinct counter (Flajolet et al.)
+// Uses 2^precision one-byte registers; relative standard error is
+// about 1.04 / sqrt(2^precision) (precision 12 = 4 KB, ~1.6%).
+class HyperLogLog {
+private:
+    int precision;
+    int registerCount;
+    unsigned char* registers;
+
+public:
+    // Constructor (precision is clamped to 4..18)
+    inline HyperLogLog(int p = 12) {
+        precision = p < 4 ? 4 : (p > 18 ? 18 : p);
+        registerCount = 1 << precision;
+        registers = new unsigned char[registerCount];
+        memset(registers, 0, registerCount);
+    }
+
+    // Destructor
+    inline ~HyperLogLog() {
+        delete[] registers;
+    }
+
+    // Add a hashed item
+    inline void add(unsigned long long hash) {
+        int index = (int)(hash >> (64 - precision));
+        unsigned long long rest = (hash << precision) | (1ULL << (precision - 1));
+        int rank = 1;
+        while ((rest & 0x8000000000000000ULL) == 0) {
+            rank++;
+            rest <<= 1;
+        }
+        if (rank > registers[index]) {
+            registers[index] = (unsigned char)rank;
+        }
+    }
+
+    // Estimate the number of distinct items added
+    inline double estimate() const {
+        double alpha;
+        if (registerCount == 16) {
+            alpha = 0.673;
+        } else if (registerCount == 32) {
+            alpha = 0.697;
+        } else if (registerCount == 64) {
+            alpha = 0.709;
+        } else {
+            alpha = 0.7213 / (1.0 + 1.079 / registerCount);
+        }
+        double sum = 0.0;
+        int zeros = 0;
+        for (int i = 0; i < registerCount; i++) {
+            sum += std::ldexp(1.0, -registers[i]);
+            if (registers[i] == 0) {
+                zeros++;
+            }
+        }
+        double raw = alpha * registerCount * registerCount / sum;
+        // Small-range correction: linear counting
+        if (raw <= 2.5 * registerCount && zeros > 0) {
+            return registerCount * std::log((double)registerCount / zeros);
+        }
+        return raw;
+    }
+
+    // Merge another counter of the same precision (register-wise max)
+    // Returns false if the precisions differ
+    inline bool merge(const HyperLogLog& other) {
+        if (other.precision != precision) {
+            return false;
+        }
+        for (int i = 0; i < registerCount; i++) {
+            if (other.registers[i] > registers[i]) {
+                registers[i] = other.registers[i];
+            }
+        }
+        return true;
+    }
+
+    inline int getPrecision() const {
+        return precision;
+    }
+
+    inline int getMemoryBytes() const {
+        return registerCount;
+    }
+
+    // Add the memory held by the registers (all payload)
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        usage.addHeap((size_t)registerCount, (size_t)registerCount, 0);
+    }
+
+    inline void clear() {
+        memset(registers, 0, registerCount);
+    }
+
+private:
+    // Copying is not supported
+    HyperLogLog(const HyperLogLog&);
+    HyperLogLog& operator=(const HyperLogLog&);
+};
+
+// Count-Min sketch frequency estimator (Cormode & Muthukrishnan)
+// With width = ceil(e / epsilon) and depth = ceil(ln(1 / delta)), an estimate
+// never undercounts and overcounts by at most epsilon * N with probability
+// at least 1 - delta, where N is the total count added.
+class CountMinSketch {
+private:
+    int width;
+    int depth;
+    long long* counts;    // depth rows of width counters
+    long long total;
+
+    // Column for a row, derived from two halves of the hash (Kirsch-Mitzenmacher)
+    inline int column(unsigned long long hash, int row) const {
+        unsigned long long h1 = hash & 0xFFFFFFFFULL;
+        unsigned long long h2 = hash >> 32;
+        return (int)((h1 + (unsigned long long)row * h2) % (unsigned long long)width);
+    }
+
+public:
+    // Constructor from accuracy parameters
+    inline CountMinSketch(double epsilon = 0.001, double delta = 0.01) {
+        if (epsilon <= 0.0) {
+            epsilon = 0.001;
+        }
+        if (delta <= 0.0 || delta >= 1.0) {
+            delta = 0.01;
+        }
+        width = (int)std::ceil(std::exp(1.0) / epsilon);
+        depth = (int)std::ceil(std::log(1.0 / delta));
+        if (depth < 1) {
+            depth = 1;
+        }
+        counts = new long long[(size_t)width * depth];
+        memset(counts, 0, sizeof(long long) * (size_t)width * depth);
+        total = 0;
+    }
+
+    // Destructor
+    inline ~CountMinSketch() {
+        delete[] counts;
+    }
+
+    // Add count occurrences of a hashed item
+    inline void add(unsigned long long hash, long long count = 1) {
+        for (int row = 0; row < depth; row++) {
+            counts[(size_t)row * width + column(hash, row)] += count;
+        }
+        total += count;
+    }
+
+    // Estimated count of a hashed item (never below the true count)
+    inline long long estimate(unsigned long long hash) const {
+        long long best = -1;
+        for (int row = 0; row < depth; row++) {
+            long long value = counts[(size_t)row * width + column(hash, row)];
+            if (best < 0 || value < best) {
+                best = value;
+            }
+        }
+        return best;
+    }
+
+    // Merge another sketch of the same shape (cell-wise sum)
+    // Returns false if the dimensions differ
+    inline bool merge(const CountMinSketch& other) {
+        if (other.width != width || other.depth != depth) {
+            return false;
+        }
+        for (size_t i = 0; i < (size_t)width * depth; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        return true;
+    }
+
+    // Maximum expected overcount: epsilon * N
+    inline long long errorBound() const {
+        return (long long)std::ceil(std::exp(1.0) / width * total);
+    }
+
+    inline long long getTotal() const {
+        return total;
+    }
+
+    inline int getWidth() const {
+        return width;
+    }
+
+    inline int getDepth() const {
+        return depth;
+    }
+
+    inline long long getMemoryBytes() const {
+        return (long long)sizeof(long long) * width * depth;
+    }
+
+    // Add the memory held by the counters (all payload)
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        size_t bytes = sizeof(long long) * (size_t)width * depth;
+        usage.addHeap(bytes, bytes, 0);
+    }
+
+    inline void clear() {
+        memset(counts, 0, sizeof(long long) * (size_t)width * depth);
+        total = 0;
+    }
+
+private:
+    // Copying is not supported
+    CountMinSketch(const CountMinSketch&);
+    CountMinSketch& operator=(const CountMinSketch&);
+};
+
+// Accuracy settings for LogSketches
+struct SketchConfig {
+    int hllPrecision;     // HyperLogLog registers = 2^hllPrecision
+    double cmsEpsilon;    // Count-Min overcount bound as a fraction of N
+    double cmsDelta;      // Probability of exceeding the bound
+    int windowSeconds;    // Length of a distinct-count time window
+    int windowCount;      // Newest windows kept (0 = no per-window counts)
+
+    inline SketchConfig() {
+        hllPrecision = 12;
+        cmsEpsilon = 0.001;
+        cmsDelta = 0.01;
+        windowSeconds = 3600;
+        windowCount = 24;
+    }
+};
+
+// Fixed-memory sketches over a stream of log messages
+// One HyperLogLog per level (plus one for all levels) estimates distinct
+// messages; one Count-Min sketch estimates per-message frequency. A ring of
+// windowCount HyperLogLogs estimates distinct messages per time window of
+// windowSeconds; a slot is reused when a newer window reaches it, and logs
+// older than the kept windows only count toward the totals.
+// Items are content hashes, so sets built with the same config merge across
+// threads, processes and snapshots, and windows merge window by window.
+class LogSketches {
+public:
+    enum Level { LEVEL_INFO = 0, LEVEL_WARNING, LEVEL_ERROR, LEVEL_DEBUG, LEVEL_OTHER, LEVEL_COUNT };
+
+private:
+    SketchConfig config;
+    HyperLogLog* distinctByLevel[LEVEL_COUNT];
+    HyperLogLog distinctAll;
+    CountMinSketch frequency;
+    HyperLogLog** windows;     // Ring of per-window counters
+    long long* windowIndex;    // Window (epoch / windowSeconds) held by each slot, -1 = empty
+
+    // Counter for the window holding epoch, claiming its slot if the window
+    // is newer than the one there; nullptr if the window is no longer kept
+    inline HyperLogLog* windowFor(long long epoch) {
+        if (config.windowCount == 0 || epoch < 0) {
+            return nullptr;
+        }
+        long long index = epoch / config.windowSeconds;
+        int slot = (int)(index % config.windowCount);
+        if (windowIndex[slot] != index) {
+            if (windowIndex[slot] > index) {
+                return nullptr;
+            }
+            windows[slot]->clear();
+            windowIndex[slot] = index;
+        }
+        return windows[slot];
+    }
+
+public:
+    // Constructor
+    inline LogSketches(const SketchConfig& cfg)
+        : config(cfg), distinctAll(cfg.hllPrecision), frequency(cfg.cmsEpsilon, cfg.cmsDelta) {
+        if (config.windowSeconds < 1) {
+            config.windowSeconds = 3600;
+        }
+        if (config.windowCount < 0) {
+            config.windowCount = 0;
+        }
+        for (int i = 0; i < LEVEL_COUNT; i++) {
+            distinctByLevel[i] = new HyperLogLog(cfg.hllPrecision);
+        }
+        windows = new HyperLogLog*[config.windowCount > 0 ? config.windowCount : 1];
+        windowIndex = new long long[config.windowCount > 0 ? config.windowCount : 1];
+        for (int i = 0; i < config.windowCount; i++) {
+            windows[i] = new HyperLogLog(cfg.hllPrecision);
+            windowIndex[i] = -1;
+        }
+    }
+
+    // Destructor
+    inline ~LogSketches() {
+        for (int i = 0; i < LEVEL_COUNT; i++) {
+            delete distinctByLevel[i];
+        }
+        for (int i = 0; i < config.windowCount; i++) {
+            delete windows[i];
+        }
+        delete[] windows;
+        delete[] windowIndex;
+    }
+
+    // Record one message occurrence at a level and time (epoch seconds, -1
+    // if unknown); messageHash is the hash of the message text
+    inline void add(Level level, unsigned long long messageHash, long long epoch) {
+        unsigned long long hash = sketchHash(messageHash);
+        distinctByLevel[level]->add(hash);
+        distinctAll.add(hash);
+        frequency.add(hash);
+        HyperLogLog* window = windowFor(epoch);
+        if (window != nullptr) {
+            window->add(hash);
+        }
+    }
+
+    // Estimated distinct messages at a level
+    inline double distinctMessages(Level level) const {
+        return distinctByLevel[level]->estimate();
+    }
+
+    // Estimated distinct messages across all levels
+    inline double distinctMessages() const {
+        return distinctAll.estimate();
+    }
+
+    // Kept windows, oldest first: the start of each (epoch seconds) and its
+    // estimated distinct messages. Returns the number copied (up to max).
+    inline int getWindows(long long* starts, double* estimates, int max) const {
+        int found = 0;
+        long long last = -1;
+        // Slots are few, so take the next oldest window on each pass
+        while (found < max) {
+            int best = -1;
+            for (int i = 0; i < config.windowCount; i++) {
+                if (windowIndex[i] > last && (best < 0 || windowIndex[i] < windowIndex[best])) {
+                    best = i;
+                }
+            }
+            if (best < 0) {
+                break;
+            }
+            last = windowIndex[best];
+            starts[found] = last * config.windowSeconds;
+            estimates[found] = windows[best]->estimate();
+            found++;
+        }
+        return found;
+    }
+
+    // Estimated distinct messages in the kept windows overlapping [from, to)
+    inline double distinctMessagesBetween(long long from, long long to) const {
+        HyperLogLog combined(config.hllPrecision);
+        for (int i = 0; i < config.windowCount; i++) {
+            long long start = windowIndex[i] * config.windowSeconds;
+            if (windowIndex[i] >= 0 && start < to && start + config.windowSeconds > from) {
+                combined.merge(*windows[i]);
+            }
+        }
+        return combined.estimate();
+    }
+
+    // Estimated occurrences of a message, by the hash of its text (upper bound)
+    inline long long messageFrequency(unsigned long long messageHash) const {
+        return frequency.estimate(sketchHash(messageHash));
+    }
+
+    inline long long frequencyErrorBound() const {
+        return frequency.errorBound();
+    }
+
+    // Merge another set built with the same config
+    // Windows merge with the same window; where the other set holds a newer
+    // window than a slot here, it replaces the older one.
+    inline bool merge(const LogSketches& other) {
+        if (other.config.windowSeconds != config.windowSeconds || other.config.windowCount != config.windowCount ||
+            !distinctAll.merge(other.distinctAll) || !frequency.merge(other.frequency)) {
+            return false;
+        }
+        for (int i = 0; i < LEVEL_COUNT; i++) {
+            distinctByLevel[i]->merge(*other.distinctByLevel[i]);
+        }
+        for (int i = 0; i < config.windowCount; i++) {
+            if (other.windowIndex[i] < 0 || other.windowIndex[i] < windowIndex[i]) {
+                continue;
+            }
+            if (other.windowIndex[i] > windowIndex[i]) {
+                windows[i]->clear();
+                windowIndex[i] = other.windowIndex[i];
+            }
+            windows[i]->merge(*other.windows[i]);
+        }
+        return true;
+    }
+
+    inline const SketchConfig& getConfig() const {
+        return config;
+    }
+
+    inline long long getMemoryBytes() const {
+        return (long long)distinctAll.getMemoryBytes() * (LEVEL_COUNT + 1 + config.windowCount) +
+               (long long)sizeof(long long) * config.windowCount + frequency.getMemoryBytes();
+    }
+
+    // Add the memory held by every sketch (not counting this object)
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        for (int i = 0; i < LEVEL_COUNT; i++) {
+            usage.addHeap(sizeof(HyperLogLog), 0, sizeof(HyperLogLog));
+            distinctByLevel[i]->addMemoryUsage(usage);
+        }
+        distinctAll.addMemoryUsage(usage);
+        frequency.addMemoryUsage(usage);
+        if (config.windowCount > 0) {
+            usage.addHeap(sizeof(HyperLogLog*) * (size_t)config.windowCount, 0,
+                          sizeof(HyperLogLog*) * (size_t)config.windowCount);
+            usage.addHeap(sizeof(long long) * (size_t)config.windowCount, 0,
+                          sizeof(long long) * (size_t)config.windowCount);
+        }
+        for (int i = 0; i < config.windowCount; i++) {
+            usage.addHeap(sizeof(HyperLogLog), 0, sizeof(HyperLogLog));
+            windows[i]->addMemoryUsage(usage);
+        }
+    }
+
+    inline static const char* levelName(Level level) {
+        static const char* names[LEVEL_COUNT] = { "INFO", "WARNING", "ERROR", "DEBUG", "OTHER" };
+        return names[level];
+    }
+
+    inline void clear() {
+        for (int i = 0; i < LEVEL_COUNT; i++) {
+            distinctByLevel[i]->clear();
+        }
+        distinctAll.clear();
+        frequency.clear();
+        for (int i = 0; i < config.windowCount; i++) {
+            windows[i]->clear();
+            windowIndex[i] = -1;
+        }
+    }
+
+private:
+    // Copying is not supported
+    LogSketches(const LogSketches&);
+    LogSketches& operator=(const LogSketches&);
+};
+
+#endif // SKETCHES_H
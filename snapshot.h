@@ -0,0 +1,428 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Binary snapshot file layout (all integers little-endian, native layout)
+//
+//   header      SnapshotHeader, 64 bytes
+//   sections    one per structure, each 8-byte aligned
+//   directory   sectionCount x SnapshotSectionEntry
+//
+// A section is a sequence of u64 fields and raw arrays (padded to 8 bytes),
+// laid out by the structure that owns it. Arrays are used in place from the
+// mapped file where possible, so loading does no per-row work.
+const char SNAPSHOT_MAGIC[8] = { 'S', 'L', 'A', 'S', 'N', 'A', 'P', '1' };
+const unsigned int SNAPSHOT_VERSION = 2;
+const unsigned int SNAPSHOT_BYTE_ORDER = 0x01020304u;
+
+// Section tags
+enum SnapshotTag {
+    SNAPSHOT_STRING_POOL = 1,
+    SNAPSHOT_LOG_STORE = 2,
+    SNAPSHOT_TEMPLATES = 3,
+    SNAPSHOT_ERROR_COUNTS = 4,
+    SNAPSHOT_TEMPLATE_ERROR_COUNTS = 5,
+    SNAPSHOT_HEAVY_HITTERS = 6,
+    SNAPSHOT_TIME_HISTOGRAM = 7,
+    SNAPSHOT_WAL_POSITION = 8
+};
+
+// Resolves the label of a restored key (tables store labels as pointers,
+// which are rebuilt from the string pool or template miner on load)
+// Returns nullptr for an ID the source does not know; the load then fails.
+typedef const char* (*SnapshotLabelFunction)(const void* context, unsigned int id);
+
+struct SnapshotHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int byteOrder;
+    unsigned long long directoryOffset;
+    unsigned long long sectionCount;
+    unsigned long long fileSize;
+    unsigned long long reserved[3];
+};
+
+struct SnapshotSectionEntry {
+    unsigned int tag;
+    unsigned int reserved;
+    unsigned long long offset;
+    unsigned long long length;
+};
+
+// fsync the directory holding path, so a file created or renamed there
+// survives a crash
+inline bool syncParentDirectory(const char* path) {
+    char directory[1024];
+    const char* slash = strrchr(path, '/');
+    if (slash == nullptr) {
+        strcpy(directory, ".");
+    } else if (slash == path) {
+        strcpy(directory, "/");
+    } else if ((size_t)(slash - path) < sizeof(directory)) {
+        memcpy(directory, path, (size_t)(slash - path));
+        directory[slash - path] = '\0';
+    } else {
+        return false;
+    }
+    int fd = ::open(directory, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// Writes a snapshot with large sequential writes
+// Data is staged in a BUFFER_SIZE buffer; arrays larger than the buffer go
+// straight to the file. The file is written under a temporary name and
+// renamed into place by finish(), so a crash never leaves a torn snapshot.
+class SnapshotWriter {
+private:
+    static const int BUFFER_SIZE = 4 * 1024 * 1024;
+    static const int MAX_SECTIONS = 32;
+    static const int MAX_PATH = 1024;
+
+    int fd;
+    char* buffer;
+    int buffered;
+    unsigned long long offset;         // File offset of the next byte
+    bool failed;
+    SnapshotSectionEntry sections[MAX_SECTIONS];
+    int sectionCount;
+    char path[MAX_PATH];
+    char tempPath[MAX_PATH + 8];
+
+    inline void writeRaw(const char* data, size_t length) {
+        while (length > 0 && !failed) {
+            ssize_t written = ::write(fd, data, length);
+            if (written <= 0) {
+                failed = true;
+                return;
+            }
+            data += written;
+            length -= (size_t)written;
+        }
+    }
+
+    inline void flush() {
+        writeRaw(buffer, (size_t)buffered);
+        buffered = 0;
+    }
+
+public:
+    // Constructor
+    inline SnapshotWriter() {
+        fd = -1;
+        buffer = nullptr;
+        buffered = 0;
+        offset = 0;
+        failed = false;
+        sectionCount = 0;
+        path[0] = '\0';
+        tempPath[0] = '\0';
+    }
+
+    // Destructor (abandons an unfinished snapshot)
+    inline ~SnapshotWriter() {
+        if (fd >= 0) {
+            ::close(fd);
+            unlink(tempPath);
+        }
+        delete[] buffer;
+    }
+
+    // Start writing a snapshot to filePath; returns false on error
+    inline bool open(const char* filePath) {
+        if (strlen(filePath) >= (size_t)MAX_PATH) {
+            return false;
+        }
+        strcpy(path, filePath);
+        strcpy(tempPath, filePath);
+        strcat(tempPath, ".tmp");
+        fd = ::open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        buffer = new char[BUFFER_SIZE];
+
+        // Placeholder header, rewritten by finish()
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        write(&header, sizeof(header));
+        return true;
+    }
+
+    // Append bytes (buffered; large blocks are written directly)
+    inline void write(const void* data, size_t length) {
+        if (buffered + length > (size_t)BUFFER_SIZE) {
+            flush();
+        }
+        if (length >= (size_t)BUFFER_SIZE) {
+            writeRaw((const char*)data, length);
+        } else {
+            memcpy(buffer + buffered, data, length);
+            buffered += (int)length;
+        }
+        offset += length;
+    }
+
+    inline void writeU64(unsigned long long value) {
+        write(&value, sizeof(value));
+    }
+
+    // Append an array, padded to a multiple of 8 bytes
+    inline void writeArray(const void* data, size_t length) {
+        write(data, length);
+        static const char zeros[8] = { 0 };
+        if (length % 8 != 0) {
+            write(zeros, 8 - length % 8);
+        }
+    }
+
+    // Sections must not nest
+    inline void beginSection(SnapshotTag tag) {
+        if (sectionCount == MAX_SECTIONS) {
+            failed = true;
+            return;
+        }
+        sections[sectionCount].tag = (unsigned int)tag;
+        sections[sectionCount].reserved = 0;
+        sections[sectionCount].offset = offset;
+        sections[sectionCount].length = 0;
+    }
+
+    inline void endSection() {
+        if (sectionCount < MAX_SECTIONS) {
+            sections[sectionCount].length = offset - sections[sectionCount].offset;
+            sectionCount++;
+        }
+    }
+
+    // Write the directory and header, sync and rename into place, then sync
+    // the parent directory so the rename itself is durable
+    // sync = false skips both fsyncs (faster, but not crash-safe)
+    inline bool finish(bool sync = true) {
+        if (fd < 0) {
+            return false;
+        }
+        unsigned long long directoryOffset = offset;
+        write(sections, sizeof(SnapshotSectionEntry) * sectionCount);
+        flush();
+
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.directoryOffset = directoryOffset;
+        header.sectionCount = (unsigned long long)sectionCount;
+        header.fileSize = offset;
+        if (!failed && pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            failed = true;
+        }
+        if (!failed && sync && fsync(fd) != 0) {
+            failed = true;
+        }
+        ::close(fd);
+        fd = -1;
+        if (failed || rename(tempPath, path) != 0) {
+            unlink(tempPath);
+            return false;
+        }
+        return !sync || syncParentDirectory(path);
+    }
+
+    inline bool hasFailed() const {
+        return failed;
+    }
+
+    inline unsigned long long getBytesWritten() const {
+        return offset;
+    }
+
+private:
+    // Copying is not supported
+    SnapshotWriter(const SnapshotWriter&);
+    SnapshotWriter& operator=(const SnapshotWriter&);
+};
+
+// Sequential reader over one mapped section
+// Reads past the end of the section set failed and return zeros / nullptr.
+class SnapshotCursor {
+private:
+    const char* data;
+    unsigned long long length;
+    unsigned long long position;
+    bool failed;
+
+public:
+    inline SnapshotCursor() {
+        data = nullptr;
+        length = 0;
+        position = 0;
+        failed = true;
+    }
+
+    inline void reset(const char* sectionData, unsigned long long sectionLength) {
+        data = sectionData;
+        length = sectionLength;
+        position = 0;
+        failed = false;
+    }
+
+    inline unsigned long long readU64() {
+        if (failed || length - position < sizeof(unsigned long long)) {
+            failed = true;
+            return 0;
+        }
+        unsigned long long value;
+        memcpy(&value, data + position, sizeof(value));
+        position += sizeof(value);
+        return value;
+    }
+
+    // Pointer to an array of `bytes` bytes inside the mapping (8-byte aligned)
+    inline const void* readArray(unsigned long long bytes) {
+        unsigned long long padded = (bytes + 7) & ~7ULL;
+        if (failed || padded < bytes || length - position < padded) {
+            failed = true;
+            return nullptr;
+        }
+        const void* array = data + position;
+        position += padded;
+        return array;
+    }
+
+    inline bool hasFailed() const {
+        return failed;
+    }
+
+    // Mark the section as malformed (used by loaders for bad field values)
+    inline void fail() {
+        failed = true;
+    }
+};
+
+// Read-only mapping of a snapshot file
+// The mapping stays alive until close(), so loaded structures may keep
+// pointers into it.
+class SnapshotReader {
+private:
+    const char* base;
+    size_t mappedSize;
+    const SnapshotSectionEntry* directory;
+    unsigned long long sectionCount;
+
+public:
+    // Constructor
+    inline SnapshotReader() {
+        base = nullptr;
+        mappedSize = 0;
+        directory = nullptr;
+        sectionCount = 0;
+    }
+
+    // Destructor
+    inline ~SnapshotReader() {
+        close();
+    }
+
+    // Map and validate a snapshot; on failure prints the reason and returns false
+    inline bool open(const char* filePath) {
+        close();
+        int fd = ::open(filePath, O_RDONLY);
+        if (fd < 0) {
+            std::cout << "Cannot open snapshot " << filePath << "\n";
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            std::cout << "Snapshot is truncated.\n";
+            return false;
+        }
+        void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cout << "Cannot map snapshot " << filePath << "\n";
+            return false;
+        }
+        base = (const char*)mapped;
+        mappedSize = (size_t)info.st_size;
+
+        const SnapshotHeader* header = (const SnapshotHeader*)base;
+        const char* problem = nullptr;
+        if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+            problem = "not a snapshot file";
+        } else if (header->version != SNAPSHOT_VERSION) {
+            problem = "unsupported snapshot version";
+        } else if (header->byteOrder != SNAPSHOT_BYTE_ORDER) {
+            problem = "snapshot written on a machine with a different byte order";
+        } else if (header->fileSize != mappedSize || header->directoryOffset > mappedSize ||
+                   header->sectionCount > (mappedSize - header->directoryOffset) / sizeof(SnapshotSectionEntry)) {
+            problem = "snapshot is truncated or corrupt";
+        }
+        if (problem == nullptr) {
+            directory = (const SnapshotSectionEntry*)(base + header->directoryOffset);
+            sectionCount = header->sectionCount;
+            for (unsigned long long i = 0; i < sectionCount; i++) {
+                if (directory[i].offset > mappedSize || directory[i].length > mappedSize - directory[i].offset) {
+                    problem = "snapshot section out of bounds";
+                    break;
+                }
+            }
+        }
+        if (problem != nullptr) {
+            std::cout << "Cannot load snapshot: " << problem << "\n";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Position a cursor at the start of a section; false if it is missing
+    inline bool openSection(SnapshotTag tag, SnapshotCursor& cursor) const {
+        for (unsigned long long i = 0; i < sectionCount; i++) {
+            if (directory[i].tag == (unsigned int)tag) {
+                cursor.reset(base + directory[i].offset, directory[i].length);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline bool isOpen() const {
+        return base != nullptr;
+    }
+
+    inline size_t getMappedSize() const {
+        return mappedSize;
+    }
+
+    // Unmap the file (pointers into it become invalid)
+    inline void close() {
+        if (base != nullptr) {
+            munmap((void*)base, mappedSize);
+        }
+        base = nullptr;
+        mappedSize = 0;
+        directory = nullptr;
+        sectionCount = 0;
+    }
+
+private:
+    // Copying is not supported
+    SnapshotReader(const SnapshotReader&);
+    SnapshotReader& operator=(const SnapshotReader&);
+};
+
+#endif // SNAPSHOT_H
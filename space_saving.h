@@ -0,0 +1,256 @@
+#ifndef SPACE_SAVING_H
+#define SPACE_SAVING_H
+
+#include "int_hash_map.h"
+#include "snapshot.h"
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+
+// One reported heavy hitter
+struct TopKEntry {
+    unsigned int id;    // Interned key ID
+    const char* key;    // Key text (owned by the string pool)
+    long long count;    // Reported count (upper bound in approximate mode)
+    long long error;    // Maximum overestimation (0 in exact mode)
+    bool guaranteed;    // True if the entry is certainly among the true top-k
+};
+
+// Space-Saving heavy-hitters summary (Metwally et al.)
+// Tracks at most `capacity` keys in fixed memory. When a new key arrives and
+// the summary is full, the key with the smallest count is evicted and the new
+// key inherits that count as its error. For every tracked key:
+//     count - error <= true frequency <= count
+// and every key whose true frequency exceeds N / capacity is tracked.
+class SpaceSaving {
+private:
+    struct Counter {
+        unsigned int id;
+        const char* key;
+        long long count;
+        long long error;
+    };
+
+    Counter* heap;           // Min-heap of counters ordered by count
+    int capacity;
+    int size;
+    long long totalCount;    // N: number of offered items
+    IntHashMap position;     // Key ID -> heap index
+
+    inline void swapCounters(int a, int b) {
+        Counter tmp = heap[a];
+        heap[a] = heap[b];
+        heap[b] = tmp;
+        position.put(heap[a].id, a);
+        position.put(heap[b].id, b);
+    }
+
+    inline void siftDown(int i) {
+        while (true) {
+            int smallest = i;
+            int left = 2 * i + 1;
+            int right = left + 1;
+            if (left < size && heap[left].count < heap[smallest].count) {
+                smallest = left;
+            }
+            if (right < size && heap[right].count < heap[smallest].count) {
+                smallest = right;
+            }
+            if (smallest == i) {
+                return;
+            }
+            swapCounters(i, smallest);
+            i = smallest;
+        }
+    }
+
+    inline void siftUp(int i) {
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (heap[parent].count <= heap[i].count) {
+                return;
+            }
+            swapCounters(i, parent);
+            i = parent;
+        }
+    }
+
+public:
+    // Constructor (memory is fixed at `maxCounters` counters)
+    inline SpaceSaving(int maxCounters = 1024) : position(64) {
+        capacity = maxCounters > 0 ? maxCounters : 1;
+        heap = new Counter[capacity];
+        size = 0;
+        totalCount = 0;
+    }
+
+    // Destructor
+    inline ~SpaceSaving() {
+        delete[] heap;
+    }
+
+    // Record one occurrence of a key (O(log capacity))
+    inline void offer(unsigned int id, const char* key) {
+        totalCount++;
+        long long index;
+        if (position.get(id, index)) {
+            heap[index].count++;
+            siftDown((int)index);
+            return;
+        }
+        if (size < capacity) {
+            heap[size].id = id;
+            heap[size].key = key;
+            heap[size].count = 1;
+            heap[size].error = 0;
+            position.put(id, size);
+            size++;
+            siftUp(size - 1);
+            return;
+        }
+        // Replace the minimum counter; the newcomer inherits its count as error
+        position.remove(heap[0].id);
+        heap[0].error = heap[0].count;
+        heap[0].count++;
+        heap[0].id = id;
+        heap[0].key = key;
+        position.put(id, 0);
+        siftDown(0);
+    }
+
+    // Report the k keys with the highest counts, in descending order
+    // out must hold k entries. Returns the number written.
+    inline int topK(int k, TopKEntry* out) const {
+        if (k > size) {
+            k = size;
+        }
+        if (k <= 0) {
+            return 0;
+        }
+        // Partial selection sort over the fixed-size summary (k is small)
+        bool* taken = new bool[size];
+        for (int i = 0; i < size; i++) {
+            taken[i] = false;
+        }
+        for (int r = 0; r < k; r++) {
+            int best = -1;
+            for (int i = 0; i < size; i++) {
+                if (!taken[i] && (best < 0 || heap[i].count > heap[best].count)) {
+                    best = i;
+                }
+            }
+            taken[best] = true;
+            out[r].id = heap[best].id;
+            out[r].key = heap[best].key;
+            out[r].count = heap[best].count;
+            out[r].error = heap[best].error;
+        }
+
+        // An entry is guaranteed if its lower bound beats every untaken upper bound
+        long long nextCount = 0;
+        for (int i = 0; i < size; i++) {
+            if (!taken[i] && heap[i].count > nextCount) {
+                nextCount = heap[i].count;
+            }
+        }
+        if (size == capacity && heap[0].count > nextCount) {
+            nextCount = heap[0].count;  // Untracked keys may have up to the minimum count
+        }
+        for (int r = 0; r < k; r++) {
+            out[r].guaranteed = out[r].count - out[r].error >= nextCount;
+        }
+        delete[] taken;
+        return k;
+    }
+
+    // Maximum overestimation of any reported count: N / capacity
+    inline long long errorBound() const {
+        return totalCount / capacity;
+    }
+
+    inline long long getTotalCount() const {
+        return totalCount;
+    }
+
+    inline int getCapacity() const {
+        return capacity;
+    }
+
+    // Add the memory held by the counters and the position map
+    // Unused counters are reserved up front and count as fragmentation.
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        size_t used = (size_t)size;
+        usage.addHeap(sizeof(Counter) * capacity, (sizeof(unsigned int) + 2 * sizeof(long long)) * used,
+                      sizeof(const char*) * used);
+        position.addMemoryUsage(usage);
+    }
+
+    // Write the counters (heap order) to a snapshot
+    inline void saveTo(SnapshotWriter& writer) const {
+        writer.writeU64((unsigned long long)size);
+        writer.writeU64((unsigned long long)totalCount);
+        for (int i = 0; i < size; i++) {
+            writer.writeU64(heap[i].id);
+            writer.writeU64((unsigned long long)heap[i].count);
+            writer.writeU64((unsigned long long)heap[i].error);
+        }
+    }
+
+    // Load counters saved by saveTo(); labels are resolved through label()
+    // Counters beyond this summary's capacity are dropped (smallest first).
+    inline bool loadFrom(SnapshotCursor& cursor, SnapshotLabelFunction label, const void* context) {
+        clear();
+        unsigned long long savedSize = cursor.readU64();
+        totalCount = (long long)cursor.readU64();
+        if (savedSize > 0x7FFFFFFFULL) {
+            cursor.fail();
+            return false;
+        }
+        for (unsigned long long i = 0; i < savedSize && !cursor.hasFailed(); i++) {
+            unsigned int id = (unsigned int)cursor.readU64();
+            long long count = (long long)cursor.readU64();
+            long long error = (long long)cursor.readU64();
+            const char* key = label(context, id);
+            long long existing;
+            if (key == nullptr || position.get(id, existing)) {
+                cursor.fail();
+                return false;
+            }
+            if (size == capacity) {
+                if (count <= heap[0].count) {
+                    continue;
+                }
+                position.remove(heap[0].id);
+                heap[0].id = id;
+                heap[0].key = key;
+                heap[0].count = count;
+                heap[0].error = error;
+                position.put(id, 0);
+                siftDown(0);
+                continue;
+            }
+            heap[size].id = id;
+            heap[size].key = key;
+            heap[size].count = count;
+            heap[size].error = error;
+            position.put(id, size);
+            size++;
+            siftUp(size - 1);
+        }
+        return !cursor.hasFailed();
+    }
+
+    // Remove all counters
+    inline void clear() {
+        size = 0;
+        totalCount = 0;
+        position.clear();
+    }
+
+private:
+    // Copying is not supported
+    SpaceSaving(const SpaceSaving&);
+    SpaceSaving& operator=(const SpaceSaving&);
+};
+
+#endif // SPACE_SAVING_H
@@ -0,0 +1,535 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include "snapshot.h"
+#include "memory_usage.h"
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+
+// Statistics reported by the string pool
+struct PoolStats {
+    long long internCalls;      // Number of intern() calls
+    long long uniqueStrings;    // Number of distinct strings stored
+    long long bytesRequested;   // Bytes that private copies would have used
+    long long bytesStored;      // Bytes of distinct string text actually stored
+    long long overheadBytes;    // Index, directory and arena slack
+
+    // Ratio of requested bytes to stored bytes (1.0 = no duplicates)
+    inline double dedupRatio() const {
+        return bytesStored > 0 ? (double)bytesRequested / (double)bytesStored : 1.0;
+    }
+
+    // Bytes saved compared to one private heap copy per row
+    inline long long bytesSaved() const {
+        return bytesRequested - bytesStored - overheadBytes;
+    }
+};
+
+// Concurrent string interning pool
+// Each distinct string is stored once and identified by a 32-bit ID.
+// The pool is split into shards (selected by hash) so that threads interning
+// different strings rarely contend on the same lock. Lookups by ID are lock-free.
+class StringPool {
+public:
+    static const unsigned int INVALID_ID = 0xFFFFFFFFu;
+
+    // 64-bit FNV-1a hash with a final mix
+    // Depends only on the bytes, so it is the same in every process and
+    // after a reload (unlike IDs); sketches are keyed by it.
+    static inline unsigned long long hashBytes(const char* text, size_t length) {
+        unsigned long long hash = 1469598103934665603ULL;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char)text[i];
+            hash *= 1099511628211ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+private:
+    static const int SHARD_BITS = 4;
+    static const int SHARD_COUNT = 1 << SHARD_BITS;
+    static const int SEGMENT_BASE_BITS = 6;          // First directory segment holds 64 strings
+    static const int MAX_SEGMENTS = 22;              // 64 * (2^22 - 1) strings per shard
+    static const int ARENA_MIN_BLOCK = 1024;         // First arena block for string text
+    static const int ARENA_BLOCK_SIZE = 64 * 1024;   // Largest regular arena block
+    static const int INITIAL_SLOTS = 64;             // Initial open-addressing table size
+
+    // Arena block holding length-prefixed string text
+    struct ArenaBlock {
+        char* data;
+        int used;
+        int capacity;
+        bool external;       // Text borrowed from a mapped snapshot; full, not owned
+        ArenaBlock* next;
+    };
+
+    // Hash index slot (localIndex + 1, 0 = empty)
+    struct Slot {
+        unsigned int hashTag;
+        unsigned int localPlusOne;
+    };
+
+    // One shard of the pool
+    struct Shard {
+        std::mutex lock;
+        Slot* slots;                                   // Open-addressing hash index
+        int slotCount;                                 // Power of two
+        int count;                                     // Strings stored in this shard
+        int mappedCount;                               // Of which text is in a mapped snapshot
+        std::atomic<const char**> segments[MAX_SEGMENTS];  // ID -> text directory
+        ArenaBlock* arena;                             // Current arena block (head of list)
+        long long internCalls;
+        long long bytesRequested;
+        long long bytesStored;
+        long long arenaBytes;
+    };
+
+    Shard shards[SHARD_COUNT];
+
+    // Floor of log2 for a positive value
+    static inline int floorLog2(unsigned int value) {
+#if defined(__GNUC__)
+        return 31 - __builtin_clz(value);
+#else
+        int result = 0;
+        while (value >>= 1) {
+            result++;
+        }
+        return result;
+#endif
+    }
+
+    // Map a shard-local index to its directory segment and offset
+    static inline void locate(unsigned int local, int& segment, unsigned int& offset) {
+        unsigned int v = local + (1u << SEGMENT_BASE_BITS);
+        segment = floorLog2(v) - SEGMENT_BASE_BITS;
+        offset = v - (1u << (segment + SEGMENT_BASE_BITS));
+    }
+
+    // Read the text stored for a shard-local index
+    inline const char* textAt(const Shard& shard, unsigned int local) const {
+        int segment;
+        unsigned int offset;
+        locate(local, segment, offset);
+        const char** block = shard.segments[segment].load(std::memory_order_acquire);
+        return block[offset];
+    }
+
+    // Length of a stored string (stored as a prefix in the arena)
+    static inline unsigned int storedLength(const char* text) {
+        unsigned int length;
+        memcpy(&length, text - sizeof(unsigned int), sizeof(unsigned int));
+        return length;
+    }
+
+    // Copy string text into the shard arena (caller holds the shard lock)
+    inline const char* storeText(Shard& shard, const char* text, size_t length) {
+        int needed = (int)(sizeof(unsigned int) + length + 1);
+        if (shard.arena == nullptr || shard.arena->capacity - shard.arena->used < needed) {
+            // Blocks double in size up to ARENA_BLOCK_SIZE; huge strings get their own
+            int capacity = shard.arena == nullptr || shard.arena->external ? ARENA_MIN_BLOCK
+                                                                            : shard.arena->capacity * 2;
+            if (capacity > ARENA_BLOCK_SIZE) {
+                capacity = ARENA_BLOCK_SIZE;
+            }
+            if (needed > capacity) {
+                capacity = needed;
+            }
+            ArenaBlock* block = new ArenaBlock;
+            block->data = new char[capacity];
+            block->used = 0;
+            block->capacity = capacity;
+            block->external = false;
+            block->next = shard.arena;
+            shard.arena = block;
+            shard.arenaBytes += capacity;
+        }
+        char* dest = shard.arena->data + shard.arena->used;
+        unsigned int storedLen = (unsigned int)length;
+        memcpy(dest, &storedLen, sizeof(unsigned int));
+        memcpy(dest + sizeof(unsigned int), text, length);
+        dest[sizeof(unsigned int) + length] = '\0';
+        shard.arena->used += needed;
+        return dest + sizeof(unsigned int);
+    }
+
+    // Append text to the ID directory (caller holds the shard lock)
+    inline unsigned int appendToDirectory(Shard& shard, const char* stored) {
+        unsigned int local = (unsigned int)shard.count;
+        int segment;
+        unsigned int offset;
+        locate(local, segment, offset);
+        const char** block = shard.segments[segment].load(std::memory_order_relaxed);
+        if (block == nullptr) {
+            block = new const char*[(size_t)1 << (segment + SEGMENT_BASE_BITS)];
+            shard.segments[segment].store(block, std::memory_order_release);
+        }
+        block[offset] = stored;
+        shard.count++;
+        return local;
+    }
+
+    // Check a loaded hash index: every slot names a string below count and
+    // exactly count slots are occupied (so probing always finds an empty slot)
+    static inline bool validSlots(const Slot* slots, unsigned long long slotCount, unsigned long long count) {
+        unsigned long long occupied = 0;
+        for (unsigned long long i = 0; i < slotCount; i++) {
+            if (slots[i].localPlusOne > count) {
+                return false;
+            }
+            occupied += slots[i].localPlusOne != 0;
+        }
+        return occupied == count;
+    }
+
+    // Check loaded string offsets: each length prefix, its text and the
+    // terminator lie inside the heap
+    static inline bool validOffsets(const char* heap, unsigned long long heapBytes,
+                                    const unsigned long long* offsets, unsigned long long count) {
+        for (unsigned long long local = 0; local < count; local++) {
+            unsigned long long offset = offsets[local];
+            if (offset < sizeof(unsigned int) || offset >= heapBytes) {
+                return false;
+            }
+            unsigned long long length = storedLength(heap + offset);
+            if (length >= heapBytes - offset || heap[offset + length] != '\0') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Double the hash index (caller holds the shard lock)
+    inline void growSlots(Shard& shard) {
+        int newCount = shard.slotCount * 2;
+        Slot* newSlots = new Slot[newCount];
+        memset(newSlots, 0, sizeof(Slot) * newCount);
+        for (int i = 0; i < shard.slotCount; i++) {
+            if (shard.slots[i].localPlusOne == 0) {
+                continue;
+            }
+            int pos = (int)(shard.slots[i].hashTag & (unsigned int)(newCount - 1));
+            while (newSlots[pos].localPlusOne != 0) {
+                pos = (pos + 1) & (newCount - 1);
+            }
+            newSlots[pos] = shard.slots[i];
+        }
+        delete[] shard.slots;
+        shard.slots = newSlots;
+        shard.slotCount = newCount;
+    }
+
+    // Release all memory held by a shard
+    inline void releaseShard(Shard& shard) {
+        ArenaBlock* block = shard.arena;
+        while (block != nullptr) {
+            ArenaBlock* next = block->next;
+            if (!block->external) {
+                delete[] block->data;
+            }
+            delete block;
+            block = next;
+        }
+        shard.arena = nullptr;
+        for (int s = 0; s < MAX_SEGMENTS; s++) {
+            delete[] shard.segments[s].load(std::memory_order_relaxed);
+            shard.segments[s].store(nullptr, std::memory_order_relaxed);
+        }
+        delete[] shard.slots;
+        shard.slots = nullptr;
+    }
+
+    // Reset a shard to its empty state
+    inline void initShard(Shard& shard) {
+        shard.slotCount = INITIAL_SLOTS;
+        shard.slots = new Slot[INITIAL_SLOTS];
+        memset(shard.slots, 0, sizeof(Slot) * INITIAL_SLOTS);
+        shard.count = 0;
+        shard.mappedCount = 0;
+        for (int s = 0; s < MAX_SEGMENTS; s++) {
+            shard.segments[s].store(nullptr, std::memory_order_relaxed);
+        }
+        shard.arena = nullptr;
+        shard.internCalls = 0;
+        shard.bytesRequested = 0;
+        shard.bytesStored = 0;
+        shard.arenaBytes = 0;
+    }
+
+public:
+    // Constructor
+    inline StringPool() {
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            initShard(shards[i]);
+        }
+    }
+
+    // Destructor
+    inline ~StringPool() {
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            releaseShard(shards[i]);
+        }
+    }
+
+    // Intern a string and return its ID (thread-safe); hash receives
+    // hashBytes() of the text, which interning computes anyway
+    inline unsigned int intern(const char* text, size_t length, unsigned long long& hash) {
+        hash = hashBytes(text, length);
+        int shardIndex = (int)(hash >> (64 - SHARD_BITS));
+        unsigned int tag = (unsigned int)hash;
+        Shard& shard = shards[shardIndex];
+
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.internCalls++;
+        shard.bytesRequested += (long long)length + 1;
+
+        // Probe the open-addressing index for an existing copy
+        int mask = shard.slotCount - 1;
+        int pos = (int)(tag & (unsigned int)mask);
+        while (shard.slots[pos].localPlusOne != 0) {
+            if (shard.slots[pos].hashTag == tag) {
+                unsigned int local = shard.slots[pos].localPlusOne - 1;
+                const char* stored = textAt(shard, local);
+                if (storedLength(stored) == length && memcmp(stored, text, length) == 0) {
+                    return (local << SHARD_BITS) | (unsigned int)shardIndex;
+                }
+            }
+            pos = (pos + 1) & mask;
+        }
+
+        // Not found: store the text and publish it in the directory
+        const char* stored = storeText(shard, text, length);
+        unsigned int local = appendToDirectory(shard, stored);
+        shard.slots[pos].hashTag = tag;
+        shard.slots[pos].localPlusOne = local + 1;
+        shard.bytesStored += (long long)length + 1;
+
+        // Keep the load factor at or below one half
+        if (shard.count * 2 > shard.slotCount) {
+            growSlots(shard);
+        }
+        return (local << SHARD_BITS) | (unsigned int)shardIndex;
+    }
+
+    inline unsigned int intern(const char* text, size_t length) {
+        unsigned long long hash;
+        return intern(text, length, hash);
+    }
+
+    inline unsigned int intern(const char* text) {
+        return intern(text, strlen(text));
+    }
+
+    // Find the ID of a string without storing it; INVALID_ID if absent
+    inline unsigned int find(const char* text) {
+        size_t length = strlen(text);
+        unsigned long long hash = hashBytes(text, length);
+        int shardIndex = (int)(hash >> (64 - SHARD_BITS));
+        unsigned int tag = (unsigned int)hash;
+        Shard& shard = shards[shardIndex];
+
+        std::lock_guard<std::mutex> guard(shard.lock);
+        int mask = shard.slotCount - 1;
+        int pos = (int)(tag & (unsigned int)mask);
+        while (shard.slots[pos].localPlusOne != 0) {
+            if (shard.slots[pos].hashTag == tag) {
+                unsigned int local = shard.slots[pos].localPlusOne - 1;
+                const char* stored = textAt(shard, local);
+                if (storedLength(stored) == length && memcmp(stored, text, length) == 0) {
+                    return (local << SHARD_BITS) | (unsigned int)shardIndex;
+                }
+            }
+            pos = (pos + 1) & mask;
+        }
+        return INVALID_ID;
+    }
+
+    // Get the text for an ID (lock-free)
+    inline const char* lookup(unsigned int id) const {
+        return textAt(shards[id & (SHARD_COUNT - 1)], id >> SHARD_BITS);
+    }
+
+    // Check that an ID was handed out by this pool (used to validate loaded
+    // snapshots; not safe while other threads are interning)
+    inline bool contains(unsigned int id) const {
+        return (id >> SHARD_BITS) < (unsigned int)shards[id & (SHARD_COUNT - 1)].count;
+    }
+
+    // Get the length of the text for an ID (lock-free)
+    inline unsigned int lengthOf(unsigned int id) const {
+        return storedLength(lookup(id));
+    }
+
+    // Collect pool statistics
+    inline void getStats(PoolStats& stats) {
+        stats.internCalls = 0;
+        stats.uniqueStrings = 0;
+        stats.bytesRequested = 0;
+        stats.bytesStored = 0;
+        stats.overheadBytes = 0;
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            stats.internCalls += shard.internCalls;
+            stats.uniqueStrings += shard.count;
+            stats.bytesRequested += shard.bytesRequested;
+            stats.bytesStored += shard.bytesStored;
+
+            long long overhead = (long long)sizeof(Slot) * shard.slotCount;
+            overhead += shard.arenaBytes - shard.bytesStored;  // Length prefixes and slack
+            for (int s = 0; s < MAX_SEGMENTS; s++) {
+                if (shard.segments[s].load(std::memory_order_relaxed) != nullptr) {
+                    overhead += (long long)sizeof(const char*) << (s + SEGMENT_BASE_BITS);
+                }
+            }
+            stats.overheadBytes += overhead;
+        }
+    }
+
+    // Add the memory held by the pool (not counting the pool object itself)
+    // Payload is string text; length prefixes, the hash index and the ID
+    // directory are overhead; unused arena and directory space is fragmentation.
+    inline void addMemoryUsage(MemoryUsage& usage) {
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            long long ownedBytes = 0;
+            for (ArenaBlock* block = shard.arena; block != nullptr; block = block->next) {
+                usage.addHeap(sizeof(ArenaBlock), 0, sizeof(ArenaBlock));
+                if (!block->external) {
+                    usage.addHeap((size_t)block->capacity, (size_t)block->used, 0);
+                    ownedBytes += block->capacity;
+                }
+            }
+            // Owned arena bytes counted as payload above include the prefixes
+            long long prefixes = (long long)sizeof(unsigned int) * (shard.count - shard.mappedCount);
+            usage.payload -= prefixes;
+            usage.overhead += prefixes;
+            usage.mapped += shard.arenaBytes - ownedBytes;
+
+            usage.addHeap(sizeof(Slot) * shard.slotCount, 0, sizeof(Slot) * shard.slotCount);
+            for (int s = 0; s < MAX_SEGMENTS; s++) {
+                if (shard.segments[s].load(std::memory_order_relaxed) == nullptr) {
+                    continue;
+                }
+                long long first = ((1LL << (s + SEGMENT_BASE_BITS)) - (1LL << SEGMENT_BASE_BITS));
+                long long entries = 1LL << (s + SEGMENT_BASE_BITS);
+                long long filled = shard.count - first;
+                if (filled > entries) {
+                    filled = entries;
+                }
+                usage.addHeap(sizeof(const char*) * (size_t)entries, 0, sizeof(const char*) * (size_t)filled);
+            }
+        }
+    }
+
+    // Write every shard to a snapshot: counters, the hash index, the string
+    // heap in ID order and each string's heap offset
+    inline void saveTo(SnapshotWriter& writer) {
+        writer.writeU64(SHARD_COUNT);
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            writer.writeU64((unsigned long long)shard.count);
+            writer.writeU64((unsigned long long)shard.slotCount);
+            writer.writeU64((unsigned long long)shard.internCalls);
+            writer.writeU64((unsigned long long)shard.bytesRequested);
+            writer.writeU64((unsigned long long)shard.bytesStored);
+            writer.writeArray(shard.slots, sizeof(Slot) * shard.slotCount);
+
+            // Heap: length prefix, text and terminator of each string
+            unsigned long long heapBytes = (unsigned long long)shard.bytesStored +
+                                           sizeof(unsigned int) * (unsigned long long)shard.count;
+            writer.writeU64(heapBytes);
+            for (int local = 0; local < shard.count; local++) {
+                const char* text = textAt(shard, (unsigned int)local);
+                writer.write(text - sizeof(unsigned int), sizeof(unsigned int) + storedLength(text) + 1);
+            }
+            static const char zeros[8] = { 0 };
+            if (heapBytes % 8 != 0) {
+                writer.write(zeros, 8 - heapBytes % 8);
+            }
+
+            unsigned long long offset = 0;
+            for (int local = 0; local < shard.count; local++) {
+                writer.writeU64(offset + sizeof(unsigned int));
+                offset += sizeof(unsigned int) + storedLength(textAt(shard, (unsigned int)local)) + 1;
+            }
+        }
+    }
+
+    // Load strings saved by saveTo() into an empty pool
+    // Text stays in the mapped snapshot (IDs are unchanged); only the hash index
+    // is copied and the ID directory rebuilt from the offset table.
+    inline bool loadFrom(SnapshotCursor& cursor) {
+        if (cursor.readU64() != (unsigned long long)SHARD_COUNT) {
+            cursor.fail();
+            return false;
+        }
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            unsigned long long count = cursor.readU64();
+            unsigned long long slotCount = cursor.readU64();
+            unsigned long long internCalls = cursor.readU64();
+            unsigned long long bytesRequested = cursor.readU64();
+            unsigned long long bytesStored = cursor.readU64();
+            if (slotCount < (unsigned long long)INITIAL_SLOTS || slotCount > (1ULL << 31) ||
+                (slotCount & (slotCount - 1)) != 0 || count * 2 > slotCount ||
+                count > (0xFFFFFFFFULL >> SHARD_BITS) || shard.count != 0) {
+                cursor.fail();
+                return false;
+            }
+            const Slot* slots = (const Slot*)cursor.readArray(sizeof(Slot) * slotCount);
+            unsigned long long heapBytes = cursor.readU64();
+            const char* heap = (const char*)cursor.readArray(heapBytes);
+            const unsigned long long* offsets =
+                (const unsigned long long*)cursor.readArray(sizeof(unsigned long long) * count);
+            if (cursor.hasFailed() || !validSlots(slots, slotCount, count) ||
+                !validOffsets(heap, heapBytes, offsets, count)) {
+                cursor.fail();
+                return false;
+            }
+
+            delete[] shard.slots;
+            shard.slots = new Slot[slotCount];
+            memcpy(shard.slots, slots, sizeof(Slot) * slotCount);
+            shard.slotCount = (int)slotCount;
+            shard.internCalls = (long long)internCalls;
+            shard.bytesRequested = (long long)bytesRequested;
+            shard.bytesStored = (long long)bytesStored;
+
+            ArenaBlock* block = new ArenaBlock;
+            block->data = (char*)heap;
+            block->used = 0;
+            block->capacity = 0;
+            block->external = true;
+            block->next = shard.arena;
+            shard.arena = block;
+            shard.arenaBytes += (long long)heapBytes;
+
+            for (unsigned long long local = 0; local < count; local++) {
+                appendToDirectory(shard, heap + offsets[local]);
+            }
+            shard.mappedCount = shard.count;
+        }
+        return true;
+    }
+
+    // Remove all strings (not safe while other threads are interning)
+    inline void clear() {
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            releaseShard(shards[i]);
+            initShard(shards[i]);
+        }
+    }
+};
+
+#endif // STRING_POOL_H
@@ -0,0 +1,705 @@
+#ifndef SYSLOG_LISTENER_H
+#define SYSLOG_LISTENER_H
+
+#include "syslog_parser.h"
+#include "log_ingest.h"
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+
+struct SyslogConfig {
+    char datagramPath[108];     // Unix datagram socket, like /dev/log ("" = off)
+    char streamPath[108];       // Unix stream socket ("" = off)
+    int udpPort;                // UDP on 127.0.0.1 (0 = off)
+    int batchMessages;          // Datagrams per recvmmsg() call
+    int maxMessageBytes;        // Longer messages are truncated
+    int queueBatches;           // Parsed batches waiting for ingestion; beyond it messages drop
+    int receiveBufferBytes;     // SO_RCVBUF of datagram sockets
+
+    inline SyslogConfig() {
+        datagramPath[0] = '\0';
+        streamPath[0] = '\0';
+        udpPort = 0;
+        batchMessages = 64;
+        maxMessageBytes = 8192;
+        queueBatches = 64;
+        receiveBufferBytes = 8 << 20;
+    }
+};
+
+struct SyslogStats {
+    long long received;         // Messages read from the sockets
+    long long ingested;         // Messages passed to the sink
+    long long malformed;        // Messages without a <PRI> header (skipped)
+    long long dropped;          // Messages dropped because the ingest queue was full
+    long long kernelDropped;    // UDP datagrams the kernel dropped (SO_RXQ_OVFL)
+    long long truncated;        // Messages cut at maxMessageBytes
+    long long connections;      // Stream clients accepted
+    long long bytes;            // Bytes received
+    double seconds;
+};
+
+// Receives syslog messages pushed by applications and feeds them to an
+// ingest sink
+//
+// The calling thread runs an epoll loop over a Unix datagram socket, a Unix
+// stream socket and its clients, and a loopback UDP socket (each optional).
+// Datagrams are read in batches with recvmmsg(); stream clients may send
+// octet-counted (RFC 6587) or newline-delimited messages. Messages are
+// parsed on the spot into fixed-size batches that a separate thread passes
+// to the sink, so receiving continues while entries are stored. When every
+// batch is waiting for the sink, new messages are dropped and counted rather
+// than making senders wait. SIGINT and SIGTERM (through a signalfd) or
+// stop() end run() after the queued batches are ingested.
+class SyslogListener {
+private:
+    static const int BATCH_ENTRIES = 512;
+    static const int MAX_STREAMS = 256;
+
+    // Parsed messages on their way to the sink
+    struct Batch {
+        int count;
+        char (*timestamps)[20];
+        const char** levels;
+        size_t* messages;           // Offsets into text
+        char* text;
+        size_t used;
+        size_t capacity;
+        Batch* next;
+    };
+
+    // A stream client and its partial frame
+    struct Stream {
+        int fd;
+        char* buffer;
+        size_t size;
+        size_t capacity;
+        size_t skip;                // Bytes of a truncated octet-counted frame still to discard
+        bool skipLine;              // Discard through the next newline (truncated line)
+    };
+
+    SyslogConfig config;
+    SyslogParser parser;
+    SyslogStats stats;
+    int datagramFd;
+    int streamFd;
+    int udpFd;
+    unsigned int datagramDrops;     // Last SO_RXQ_OVFL total seen on each socket
+    unsigned int udpDrops;
+    int epollFd;
+    int signalFd;
+    int wakeFd;
+    Stream* streams[MAX_STREAMS];
+
+    // recvmmsg() buffers
+    char* receiveBuffer;
+    struct mmsghdr* headers;
+    struct iovec* vectors;
+    char* controls;
+    size_t controlSize;
+
+    // Batch queue (receiver -> ingest thread) and free list
+    std::mutex lock;
+    std::condition_variable queueSignal;
+    Batch* queueHead;
+    Batch* queueTail;
+    Batch* freeList;
+    Batch* current;                 // Batch being filled by the receiver
+    bool stopping;
+    IngestSink sink;
+    IngestFlush sinkFlush;          // Optional, after each batch
+    void* sinkContext;
+    long long ingested;             // Written by the ingest thread, under lock
+
+    inline Batch* newBatch() {
+        Batch* batch = new Batch;
+        batch->count = 0;
+        batch->timestamps = new char[BATCH_ENTRIES][20];
+        batch->levels = new const char*[BATCH_ENTRIES];
+        batch->messages = new size_t[BATCH_ENTRIES];
+        batch->capacity = (size_t)(config.maxMessageBytes + 1) * 64;
+        batch->text = new char[batch->capacity];
+        batch->used = 0;
+        batch->next = nullptr;
+        return batch;
+    }
+
+    static inline void deleteBatch(Batch* batch) {
+        delete[] batch->timestamps;
+        delete[] batch->levels;
+        delete[] batch->messages;
+        delete[] batch->text;
+        delete batch;
+    }
+
+    // Hand the batch being filled to the ingest thread
+    inline void flush() {
+        if (current == nullptr || current->count == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            current->next = nullptr;
+            if (queueTail != nullptr) {
+                queueTail->next = current;
+            } else {
+                queueHead = current;
+            }
+            queueTail = current;
+            current = nullptr;
+        }
+        queueSignal.notify_one();
+    }
+
+    // Parse one message into the current batch (or drop it when none is free)
+    inline void accept(const char* data, size_t length) {
+        stats.received++;
+        stats.bytes += (long long)length;
+        if (current == nullptr) {
+            std::lock_guard<std::mutex> guard(lock);
+            current = freeList;
+            if (current != nullptr) {
+                freeList = current->next;
+            }
+        }
+        if (current == nullptr) {
+            stats.dropped++;
+            return;
+        }
+        if (length > (size_t)config.maxMessageBytes) {
+            length = (size_t)config.maxMessageBytes;
+            stats.truncated++;
+        }
+        SyslogEntry entry;
+        entry.message = current->text + current->used;
+        entry.messageCapacity = (size_t)config.maxMessageBytes + 1;
+        if (!parser.parse(data, length, entry)) {
+            stats.malformed++;
+            return;
+        }
+        int index = current->count++;
+        memcpy(current->timestamps[index], entry.timestamp, 20);
+        current->levels[index] = entry.level;
+        current->messages[index] = current->used;
+        current->used += entry.messageLength + 1;
+        if (current->count == BATCH_ENTRIES ||
+            current->capacity - current->used < (size_t)config.maxMessageBytes + 1) {
+            flush();
+        }
+    }
+
+    inline void ingestLoop() {
+        while (true) {
+            Batch* batch;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                while (queueHead == nullptr && !stopping) {
+                    queueSignal.wait(guard);
+                }
+                if (queueHead == nullptr) {
+                    return;
+                }
+                batch = queueHead;
+                queueHead = batch->next;
+                if (queueHead == nullptr) {
+                    queueTail = nullptr;
+                }
+            }
+            for (int i = 0; i < batch->count; i++) {
+                sink(sinkContext, batch->timestamps[i], batch->levels[i], batch->text + batch->messages[i]);
+            }
+            if (sinkFlush != nullptr) {
+                sinkFlush(sinkContext);
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            ingested += batch->count;
+            batch->count = 0;
+            batch->used = 0;
+            batch->next = freeList;
+            freeList = batch;
+        }
+    }
+
+    static inline void runIngest(SyslogListener* listener) {
+        listener->ingestLoop();
+    }
+
+    // Read every datagram waiting on fd, a batch per system call
+    inline void receiveDatagrams(int fd) {
+        int batch = config.batchMessages;
+        size_t slot = (size_t)config.maxMessageBytes + 1;
+        while (true) {
+            for (int i = 0; i < batch; i++) {
+                vectors[i].iov_base = receiveBuffer + slot * i;
+                vectors[i].iov_len = slot;
+                memset(&headers[i].msg_hdr, 0, sizeof(headers[i].msg_hdr));
+                headers[i].msg_hdr.msg_iov = &vectors[i];
+                headers[i].msg_hdr.msg_iovlen = 1;
+                headers[i].msg_hdr.msg_control = controls + controlSize * i;
+                headers[i].msg_hdr.msg_controllen = controlSize;
+            }
+            int count = recvmmsg(fd, headers, (unsigned int)batch, MSG_DONTWAIT, nullptr);
+            if (count <= 0) {
+                return;   // EAGAIN (or an error; epoll reports the socket again)
+            }
+            parser.setReceiveTime((long long)time(nullptr));
+            for (int i = 0; i < count; i++) {
+                size_t length = headers[i].msg_len;
+                if (headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                    length = (size_t)config.maxMessageBytes + 1;   // Counted as truncated
+                }
+                accept(receiveBuffer + slot * i, length);
+                for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&headers[i].msg_hdr); cmsg != nullptr;
+                     cmsg = CMSG_NXTHDR(&headers[i].msg_hdr, cmsg)) {
+                    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+                        // A running (wrapping) total for this socket; add what it grew by
+                        unsigned int drops;
+                        memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                        unsigned int& last = fd == udpFd ? udpDrops : datagramDrops;
+                        stats.kernelDropped += (long long)(unsigned int)(drops - last);
+                        last = drops;
+                    }
+                }
+            }
+            if (count < batch) {
+                return;
+            }
+        }
+    }
+
+    // Split complete frames off a stream buffer
+    inline void splitFrames(Stream* stream) {
+        size_t start = 0;
+        while (start < stream->size) {
+            char* data = stream->buffer + start;
+            size_t available = stream->size - start;
+            if (stream->skip > 0) {
+                size_t skipped = available < stream->skip ? available : stream->skip;
+                stream->skip -= skipped;
+                start += skipped;
+                continue;
+            }
+            if (stream->skipLine) {
+                char* newline = (char*)memchr(data, '\n', available);
+                if (newline == nullptr) {
+                    start = stream->size;
+                    break;
+                }
+                stream->skipLine = false;
+                start += (size_t)(newline - data) + 1;
+                continue;
+            }
+            if (*data >= '1' && *data <= '9') {
+                // Octet counting: "LENGTH SP MESSAGE"
+                size_t digits = 0;
+                size_t length = 0;
+                while (digits < available && digits < 9 && data[digits] >= '0' && data[digits] <= '9') {
+                    length = length * 10 + (size_t)(data[digits] - '0');
+                    digits++;
+                }
+                if (digits == available) {
+                    break;   // Length not complete yet
+                }
+                if (data[digits] == ' ') {
+                    if (available - digits - 1 >= length) {
+                        accept(data + digits + 1, length);
+                        start += digits + 1 + length;
+                        continue;
+                    }
+                    if (digits + 1 + length > stream->capacity && available == stream->capacity) {
+                        // Longer than the buffer: keep the start (accept() counts the
+                        // truncation), discard the rest
+                        accept(data + digits + 1, available - digits - 1);
+                        stream->skip = length - (available - digits - 1);
+                        start = stream->size;
+                    }
+                    break;
+                }
+            }
+            char* newline = (char*)memchr(data, '\n', available);
+            if (newline == nullptr) {
+                if (available == stream->capacity) {
+                    accept(data, available);   // Counted as truncated by accept()
+                    stream->skipLine = true;
+                    start = stream->size;
+                }
+                break;
+            }
+            if (newline > data) {
+                accept(data, (size_t)(newline - data));
+            }
+            start += (size_t)(newline - data) + 1;
+        }
+        memmove(stream->buffer, stream->buffer + start, stream->size - start);
+        stream->size -= start;
+    }
+
+    inline void closeStream(int index) {
+        Stream* stream = streams[index];
+        if (stream->size > 0 && stream->skip == 0 && !stream->skipLine) {
+            accept(stream->buffer, stream->size);   // Last message without a newline
+        }
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, stream->fd, nullptr);
+        close(stream->fd);
+        delete[] stream->buffer;
+        delete stream;
+        streams[index] = nullptr;
+    }
+
+    inline void readStream(int index) {
+        Stream* stream = streams[index];
+        parser.setReceiveTime((long long)time(nullptr));
+        while (true) {
+            ssize_t received = recv(stream->fd, stream->buffer + stream->size, stream->capacity - stream->size,
+                                    MSG_DONTWAIT);
+            if (received > 0) {
+                stream->size += (size_t)received;
+                splitFrames(stream);
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            }
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            closeStream(index);
+            return;
+        }
+    }
+
+    inline void acceptStreams() {
+        while (true) {
+            int fd = accept4(streamFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            int index = 0;
+            while (index < MAX_STREAMS && streams[index] != nullptr) {
+                index++;
+            }
+            if (index == MAX_STREAMS) {
+                close(fd);
+                continue;
+            }
+            Stream* stream = new Stream;
+            stream->fd = fd;
+            stream->capacity = (size_t)config.maxMessageBytes + 16;
+            stream->buffer = new char[stream->capacity];
+            stream->size = 0;
+            stream->skip = 0;
+            stream->skipLine = false;
+            streams[index] = stream;
+            stats.connections++;
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.u64 = (unsigned long long)(4 + index);
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+
+    // Bind a Unix socket, replacing a stale socket file
+    inline int openUnix(const char* path, int type) {
+        struct sockaddr_un address;
+        if (strlen(path) >= sizeof(address.sun_path)) {
+            std::cout << "Socket path too long: " << path << "\n";
+            return -1;
+        }
+        struct stat info;
+        if (lstat(path, &info) == 0) {
+            if (!S_ISSOCK(info.st_mode)) {
+                std::cout << path << " exists and is not a socket\n";
+                return -1;
+            }
+            unlink(path);
+        }
+        int fd = socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            perror("socket");
+            return -1;
+        }
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, path);
+        if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+            (type == SOCK_STREAM && listen(fd, 128) != 0)) {
+            perror(path);
+            close(fd);
+            return -1;
+        }
+        chmod(path, 0666);   // Any local application may log, as with /dev/log
+        return fd;
+    }
+
+    inline int openUdp(int port) {
+        int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            perror("socket");
+            return -1;
+        }
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((unsigned short)port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+            perror("bind");
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    inline void tuneDatagramSocket(int fd) {
+        int size = config.receiveBufferBytes;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+    }
+
+    inline void watch(int fd, unsigned long long tag) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = tag;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    inline void closeSockets() {
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            if (streams[i] != nullptr) {
+                closeStream(i);
+            }
+        }
+        if (datagramFd >= 0) {
+            close(datagramFd);
+            unlink(config.datagramPath);
+            datagramFd = -1;
+        }
+        if (streamFd >= 0) {
+            close(streamFd);
+            unlink(config.streamPath);
+            streamFd = -1;
+        }
+        if (udpFd >= 0) {
+            close(udpFd);
+            udpFd = -1;
+        }
+    }
+
+public:
+    inline SyslogListener(const SyslogConfig& cfg) : config(cfg) {
+        if (config.batchMessages < 1) {
+            config.batchMessages = 1;
+        } else if (config.batchMessages > 1024) {
+            config.batchMessages = 1024;
+        }
+        if (config.maxMessageBytes < 480) {
+            config.maxMessageBytes = 480;   // RFC 3164 and 5424 minimum
+        }
+        if (config.queueBatches < 1) {
+            config.queueBatches = 1;
+        }
+        memset(&stats, 0, sizeof(stats));
+        datagramDrops = 0;
+        udpDrops = 0;
+        datagramFd = -1;
+        streamFd = -1;
+        udpFd = -1;
+        epollFd = -1;
+        signalFd = -1;
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            streams[i] = nullptr;
+        }
+        size_t slot = (size_t)config.maxMessageBytes + 1;
+        receiveBuffer = new char[slot * config.batchMessages];
+        headers = new struct mmsghdr[config.batchMessages];
+        vectors = new struct iovec[config.batchMessages];
+        controlSize = CMSG_SPACE(sizeof(unsigned int));
+        controls = new char[controlSize * config.batchMessages];
+        queueHead = nullptr;
+        queueTail = nullptr;
+        freeList = nullptr;
+        for (int i = 0; i < config.queueBatches + 1; i++) {
+            Batch* batch = newBatch();
+            batch->next = freeList;
+            freeList = batch;
+        }
+        current = nullptr;
+        stopping = false;
+        sink = nullptr;
+        sinkFlush = nullptr;
+        sinkContext = nullptr;
+        ingested = 0;
+    }
+
+    inline ~SyslogListener() {
+        closeSockets();
+        while (freeList != nullptr) {
+            Batch* next = freeList->next;
+            deleteBatch(freeList);
+            freeList = next;
+        }
+        if (current != nullptr) {
+            deleteBatch(current);
+        }
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+        delete[] receiveBuffer;
+        delete[] headers;
+        delete[] vectors;
+        delete[] controls;
+    }
+
+    // Receive and ingest messages until SIGINT/SIGTERM or stop()
+    // ingestFlush (optional) is called after each batch of entries has gone to the sink.
+    // Socket files are removed on return. Returns false if no socket could be opened.
+    inline bool run(IngestSink ingestSink, void* context, IngestFlush ingestFlush = nullptr) {
+        sink = ingestSink;
+        sinkFlush = ingestFlush;
+        sinkContext = context;
+        if (config.datagramPath[0] != '\0') {
+            datagramFd = openUnix(config.datagramPath, SOCK_DGRAM);
+        }
+        if (config.streamPath[0] != '\0') {
+            streamFd = openUnix(config.streamPath, SOCK_STREAM);
+        }
+        if (config.udpPort > 0) {
+            udpFd = openUdp(config.udpPort);
+        }
+        if ((config.datagramPath[0] != '\0' && datagramFd < 0) || (config.streamPath[0] != '\0' && streamFd < 0) ||
+            (config.udpPort > 0 && udpFd < 0) || (datagramFd < 0 && streamFd < 0 && udpFd < 0) || wakeFd < 0) {
+            closeSockets();
+            return false;
+        }
+
+        sigset_t stopSignals;
+        sigset_t previousMask;
+        sigemptyset(&stopSignals);
+        sigaddset(&stopSignals, SIGINT);
+        sigaddset(&stopSignals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stopSignals, &previousMask);
+        signalFd = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+        // Tags: 0 datagram, 1 stream listener, 2 UDP, 3 signal or wake, 4+ stream clients
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (datagramFd >= 0) {
+            tuneDatagramSocket(datagramFd);
+            watch(datagramFd, 0);
+        }
+        if (streamFd >= 0) {
+            watch(streamFd, 1);
+        }
+        if (udpFd >= 0) {
+            tuneDatagramSocket(udpFd);
+            watch(udpFd, 2);
+        }
+        if (signalFd >= 0) {
+            watch(signalFd, 3);
+        }
+        watch(wakeFd, 3);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        stopping = false;
+        std::thread ingestThread(runIngest, this);
+        static const int MAX_EVENTS = 64;
+        struct epoll_event events[MAX_EVENTS];
+        bool running = true;
+        while (running) {
+            int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("epoll_wait");
+                break;
+            }
+            for (int i = 0; i < ready && running; i++) {
+                unsigned long long tag = events[i].data.u64;
+                if (tag == 0) {
+                    receiveDatagrams(datagramFd);
+                } else if (tag == 1) {
+                    acceptStreams();
+                } else if (tag == 2) {
+                    receiveDatagrams(udpFd);
+                } else if (tag == 3) {
+                    running = false;
+                } else if (streams[tag - 4] != nullptr) {
+                    readStream((int)(tag - 4));
+                }
+            }
+            // Whatever arrived in this round goes to the sink now
+            flush();
+        }
+
+        if (signalFd >= 0) {
+            struct signalfd_siginfo info;
+            while (read(signalFd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+                // Consume the signal, or it is delivered when the mask is restored
+            }
+        }
+        closeSockets();
+        flush();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        queueSignal.notify_all();
+        ingestThread.join();
+        stats.ingested = ingested;
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        close(epollFd);
+        epollFd = -1;
+        if (signalFd >= 0) {
+            close(signalFd);
+            signalFd = -1;
+        }
+        pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+        return true;
+    }
+
+    // Make run() return (safe from any thread)
+    inline void stop() {
+        unsigned long long one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            // Already signalled
+        }
+    }
+
+    // Counters of the last run() (read after it returns)
+    inline const SyslogStats& getStats() const {
+        return stats;
+    }
+
+private:
+    // Copying is not supported
+    SyslogListener(const SyslogListener&);
+    SyslogListener& operator=(const SyslogListener&);
+};
+
+#endif // SYSLOG_LISTENER_H
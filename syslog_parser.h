@@ -0,0 +1,341 @@
+#ifndef SYSLOG_PARSER_H
+#define SYSLOG_PARSER_H
+
+#include "timestamp.h"
+#include <cstring>
+#include <cstdlib>
+
+// Syslog severities (the low three bits of PRI) mapped to analyzer levels
+inline const char* syslogLevelName(int severity) {
+    static const char* const NAMES[8] = {
+        "ERROR", "ERROR", "ERROR", "ERROR",   // emerg, alert, crit, err
+        "WARNING", "INFO", "INFO", "DEBUG"    // warning, notice, info, debug
+    };
+    return NAMES[severity & 7];
+}
+
+// One parsed syslog message
+// timestamp is "YYYY-MM-DD HH:MM:SS" in UTC. message holds "APP: MSG", then
+// RFC 5424 structured data parameters and the process ID as " key=value"
+// (like extra JSON keys, so numeric ones can be queried with field filters).
+struct SyslogEntry {
+    char timestamp[20];
+    const char* level;
+    char* message;             // Caller-provided buffer
+    size_t messageLength;
+    size_t messageCapacity;
+
+    // Append text, truncating at the capacity
+    inline void append(const char* text, size_t length) {
+        size_t room = messageCapacity - 1 - messageLength;
+        if (length > room) {
+            length = room;
+        }
+        memcpy(message + messageLength, text, length);
+        messageLength += length;
+    }
+};
+
+// Parser for RFC 5424 and RFC 3164 (BSD) syslog messages
+// Messages without a usable timestamp get the receive time. RFC 3164
+// timestamps have no year; the year of the receive time is used, or the
+// previous one for a month more than one ahead of it.
+class SyslogParser {
+private:
+    long long receivedEpoch;
+    char receivedText[20];
+    int receivedYear;
+    int receivedMonth;
+
+    static inline int monthIndex(const char* p) {
+        static const char NAMES[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        for (int m = 0; m < 12; m++) {
+            if (p[0] == NAMES[m * 3] && p[1] == NAMES[m * 3 + 1] && p[2] == NAMES[m * 3 + 2]) {
+                return m + 1;
+            }
+        }
+        return 0;
+    }
+
+    // Next space-delimited field of [p, end); p moves past the space
+    static inline bool nextField(const char*& p, const char* end, const char*& field, size_t& length) {
+        field = p;
+        while (p < end && *p != ' ') {
+            p++;
+        }
+        length = (size_t)(p - field);
+        if (p < end) {
+            p++;
+        }
+        return length > 0;
+    }
+
+    static inline bool isNil(const char* field, size_t length) {
+        return length == 1 && field[0] == '-';
+    }
+
+    // "2024-01-15T10:30:00.123+02:00" -> UTC "2024-01-15 08:30:00"
+    inline bool parseIsoTimestamp(const char* field, size_t length, char* out) const {
+        if (length < 19) {
+            return false;
+        }
+        char text[20];
+        memcpy(text, field, 19);
+        text[19] = '\0';
+        long long epoch = parseTimestamp(text);
+        if (epoch == INVALID_EPOCH) {
+            return false;
+        }
+        const char* p = field + 19;
+        const char* end = field + length;
+        if (p < end && *p == '.') {
+            p++;
+            while (p < end && *p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+        if (end - p == 6 && (*p == '+' || *p == '-') && p[3] == ':') {
+            const char* digits = p + 1;
+            int hours;
+            int minutes;
+            if (!readDigits(digits, 2, hours)) {
+                return false;
+            }
+            digits++;
+            if (!readDigits(digits, 2, minutes)) {
+                return false;
+            }
+            long long offset = hours * 3600LL + minutes * 60LL;
+            epoch += *p == '+' ? -offset : offset;
+            formatTimestamp(epoch, out);
+            return true;
+        }
+        memcpy(out, text, 20);
+        out[10] = ' ';
+        return true;
+    }
+
+    // "Jan 15 10:30:00" (day may be space-padded) -> "YYYY-01-15 10:30:00"
+    inline bool parseBsdTimestamp(const char*& p, const char* end, char* out) const {
+        if (end - p < 15 || p[3] != ' ' || p[6] != ' ' || p[9] != ':' || p[12] != ':') {
+            return false;
+        }
+        int month = monthIndex(p);
+        if (month == 0) {
+            return false;
+        }
+        int day = (p[4] == ' ' ? 0 : (p[4] - '0') * 10) + (p[5] - '0');
+        const char* clock = p + 7;
+        int hour;
+        int minute;
+        int second;
+        if (!readDigits(clock, 2, hour) || *clock++ != ':' || !readDigits(clock, 2, minute) ||
+            *clock++ != ':' || !readDigits(clock, 2, second) || day < 1 || day > 31) {
+            return false;
+        }
+        int year = month > receivedMonth + 1 ? receivedYear - 1 : receivedYear;
+        formatTimestamp(daysFromCivil(year, month, day) * 86400LL + hour * 3600LL + minute * 60LL + second, out);
+        p += 15;
+        if (p < end && *p == ' ') {
+            p++;
+        }
+        return true;
+    }
+
+    // Skip "[id k="v" k2="v2"][id2 ...]", copying parameters to entry (when
+    // given) as " k=v"; returns the text after it
+    static inline const char* appendStructuredData(const char* p, const char* end, SyslogEntry* entry) {
+        while (p < end && *p == '[') {
+            p++;
+            while (p < end && *p != ' ' && *p != ']') {
+                p++;   // SD-ID
+            }
+            while (p < end && *p == ' ') {
+                p++;
+                const char* name = p;
+                while (p < end && *p != '=') {
+                    p++;
+                }
+                size_t nameLength = (size_t)(p - name);
+                if (p + 1 >= end || p[1] != '"') {
+                    return end;
+                }
+                p += 2;
+                if (entry != nullptr) {
+                    entry->append(" ", 1);
+                    entry->append(name, nameLength);
+                    entry->append("=", 1);
+                }
+                // Value with \" \\ \] escapes
+                const char* run = p;
+                while (p < end && *p != '"') {
+                    if (*p == '\\' && p + 1 < end) {
+                        if (entry != nullptr) {
+                            entry->append(run, (size_t)(p - run));
+                        }
+                        p++;
+                        run = p;
+                    }
+                    p++;
+                }
+                if (entry != nullptr) {
+                    entry->append(run, (size_t)(p - run));
+                }
+                if (p < end) {
+                    p++;   // Closing quote
+                }
+            }
+            if (p < end && *p == ']') {
+                p++;
+            }
+        }
+        if (p < end && *p == ' ') {
+            p++;
+        }
+        return p;
+    }
+
+    // Drop a UTF-8 byte order mark, trailing newlines and NULs
+    static inline void trimMessage(const char*& p, const char*& end) {
+        if (end - p >= 3 && (unsigned char)p[0] == 0xEF && (unsigned char)p[1] == 0xBB &&
+            (unsigned char)p[2] == 0xBF) {
+            p += 3;
+        }
+        while (end > p && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == '\0')) {
+            end--;
+        }
+    }
+
+public:
+    inline SyslogParser() {
+        receivedEpoch = INVALID_EPOCH;
+        setReceiveTime(0);
+    }
+
+    // Time messages without a timestamp get (seconds since the epoch)
+    inline void setReceiveTime(long long epoch) {
+        if (epoch == receivedEpoch) {
+            return;
+        }
+        receivedEpoch = epoch;
+        formatTimestamp(epoch, receivedText);
+        receivedYear = atoi(receivedText);
+        receivedMonth = (receivedText[5] - '0') * 10 + (receivedText[6] - '0');
+    }
+
+    // Parse one message; entry.message must be set to a buffer of
+    // entry.messageCapacity bytes. Returns false if there is no <PRI> header.
+    inline bool parse(const char* data, size_t length, SyslogEntry& entry) const {
+        const char* p = data;
+        const char* end = data + length;
+        if (p >= end || *p != '<') {
+            return false;
+        }
+        int priority = 0;
+        p++;
+        while (p < end && *p >= '0' && *p <= '9' && priority < 1000) {
+            priority = priority * 10 + (*p++ - '0');
+        }
+        if (p >= end || *p != '>' || priority > 191) {
+            return false;
+        }
+        p++;
+        entry.level = syslogLevelName(priority & 7);
+        entry.messageLength = 0;
+
+        const char* field;
+        size_t fieldLength;
+        if (end - p >= 2 && p[0] == '1' && p[1] == ' ') {
+            // RFC 5424: VERSION TIMESTAMP HOSTNAME APP-NAME PROCID MSGID SD MSG
+            p += 2;
+            nextField(p, end, field, fieldLength);
+            if (isNil(field, fieldLength) || !parseIsoTimestamp(field, fieldLength, entry.timestamp)) {
+                memcpy(entry.timestamp, receivedText, 20);
+            }
+            const char* app;
+            size_t appLength;
+            const char* procId;
+            size_t procIdLength;
+            nextField(p, end, field, fieldLength);   // HOSTNAME
+            nextField(p, end, app, appLength);
+            nextField(p, end, procId, procIdLength);
+            nextField(p, end, field, fieldLength);   // MSGID
+            if (appLength > 0 && !isNil(app, appLength)) {
+                entry.append(app, appLength);
+                entry.append(": ", 2);
+            }
+            // The message follows the structured data; parameters go after it
+            const char* sd = p;
+            const char* message = p;
+            if (message < end && *message == '-') {
+                message += message + 1 < end ? 2 : 1;
+            } else {
+                message = appendStructuredData(message, end, nullptr);
+            }
+            const char* messageEnd = end;
+            trimMessage(message, messageEnd);
+            entry.append(message, (size_t)(messageEnd - message));
+            if (sd < end && *sd == '[') {
+                appendStructuredData(sd, end, &entry);
+            }
+            if (procIdLength > 0 && !isNil(procId, procIdLength)) {
+                entry.append(" pid=", 5);
+                entry.append(procId, procIdLength);
+            }
+        } else {
+            // RFC 3164: TIMESTAMP [HOSTNAME] TAG[PID]: MSG
+            if (!parseBsdTimestamp(p, end, entry.timestamp)) {
+                memcpy(entry.timestamp, receivedText, 20);
+            }
+            // Local senders (syslog(3) to /dev/log) omit the hostname: the
+            // first word is then the tag, ending in ':' or holding '['
+            const char* body = p;
+            const char* tag = p;
+            while (p < end && *p != ' ' && *p != ':' && *p != '[') {
+                p++;
+            }
+            if (p < end && *p == ' ') {
+                p++;
+                tag = p;
+                while (p < end && *p != ' ' && *p != ':' && *p != '[') {
+                    p++;
+                }
+            }
+            size_t tagLength = (size_t)(p - tag);
+            const char* pid = nullptr;
+            size_t pidLength = 0;
+            if (p < end && *p == '[') {
+                pid = ++p;
+                while (p < end && *p != ']') {
+                    p++;
+                }
+                pidLength = (size_t)(p - pid);
+                if (p < end) {
+                    p++;
+                }
+            }
+            if (p < end && *p == ':') {
+                p++;
+                if (p < end && *p == ' ') {
+                    p++;
+                }
+                entry.append(tag, tagLength);
+                entry.append(": ", 2);
+            } else {
+                p = body;   // No tag: the rest is the message
+                pid = nullptr;
+            }
+            const char* messageEnd = end;
+            trimMessage(p, messageEnd);
+            entry.append(p, (size_t)(messageEnd - p));
+            if (pid != nullptr && pidLength > 0) {
+                entry.append(" pid=", 5);
+                entry.append(pid, pidLength);
+            }
+        }
+        entry.message[entry.messageLength] = '\0';
+        return true;
+    }
+};
+
+#endif // SYSLOG_PARSER_H
@@ -0,0 +1,671 @@
+#ifndef TEMPLATE_MINER_H
+#define TEMPLATE_MINER_H
+
+#include "int_hash_map.h"
+#include "memory_usage.h"
+#include "snapshot.h"
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+#include <cctype>
+#include <mutex>
+#include <atomic>
+
+// A mined message template, e.g. "Processing request ID <*>"
+struct LogTemplate {
+    unsigned int id;        // Template ID (index into the miner's template directory)
+    int tokenCount;         // Number of tokens in the template
+    char** tokens;          // Template tokens ("<*>" marks a variable position)
+    char* text;             // Rendered template; rewritten in place, address is stable
+    std::atomic<long long> size;  // Number of messages assigned to this template
+    LogTemplate* nextInLeaf;  // Next template in the same parse tree leaf
+
+    inline ~LogTemplate() {
+        for (int i = 0; i < tokenCount; i++) {
+            delete[] tokens[i];
+        }
+        delete[] tokens;
+        delete[] text;
+    }
+};
+
+// Node of the fixed-depth parse tree
+struct DrainNode {
+    char* token;               // Token this node matches (nullptr for length nodes)
+    DrainNode** buckets;       // Chained hash of child nodes
+    int bucketCount;
+    int childCount;
+    DrainNode* wildcardChild;  // Child for "<*>" and overflow tokens
+    DrainNode* nextInBucket;
+    LogTemplate* templates;    // Templates stored at a leaf
+
+    inline DrainNode(const char* t) {
+        token = nullptr;
+        if (t != nullptr) {
+            token = new char[strlen(t) + 1];
+            strcpy(token, t);
+        }
+        buckets = nullptr;
+        bucketCount = 0;
+        childCount = 0;
+        wildcardChild = nullptr;
+        nextInBucket = nullptr;
+        templates = nullptr;
+    }
+
+    inline ~DrainNode() {
+        for (int i = 0; i < bucketCount; i++) {
+            DrainNode* current = buckets[i];
+            while (current != nullptr) {
+                DrainNode* next = current->nextInBucket;
+                delete current;
+                current = next;
+            }
+        }
+        delete[] buckets;
+        delete wildcardChild;
+        delete[] token;
+    }
+};
+
+// Streaming log template miner (Drain algorithm)
+// Messages are tokenized on whitespace, variable-looking tokens (numbers, hex,
+// UUIDs) are masked, and the message is routed through a fixed-depth tree
+// (token count, then the first few tokens) to a small leaf of candidate
+// templates. The most similar template absorbs the message, replacing differing
+// tokens with "<*>"; otherwise a new template is created. Each distinct message
+// ID is mined once and then answered from a memo, so repeated messages cost O(1).
+//
+// Concurrent callers rarely meet: the memo is split into shards by message ID,
+// each behind its own lock, and the parse tree into shards by token count
+// (messages of different lengths never share a subtree). Templates live in a
+// directory of fixed segments, like the string pool's, so reading a template
+// by ID takes no lock and counts are atomic. A repeated message costs one memo
+// shard lock; only a new message takes a tree shard lock to be mined.
+class TemplateMiner {
+private:
+    static const int MAX_TOKENS = 128;      // Longer messages share one length bucket
+    static const int TREE_DEPTH = 4;        // Root, length layer, then DEPTH-2 token layers
+    static const int MAX_CHILDREN = 100;    // Further distinct tokens go to the wildcard child
+    static const int MAX_TOKEN_LENGTH = 256;
+    static const int TREE_SHARDS = 8;       // Parse tree locks, by token count
+    static const int MEMO_SHARDS = 16;      // Message memo locks, by message ID
+    static const int SEGMENT_BASE_BITS = 6; // First directory segment holds 64 templates
+    static const int MAX_SEGMENTS = 25;
+
+    // Length subtrees with token count % TREE_SHARDS == index
+    struct TreeShard {
+        std::mutex lock;
+        char (*tokenBuffer)[MAX_TOKEN_LENGTH];   // Scratch tokens for mine()
+    };
+
+    struct MemoShard {
+        std::mutex lock;
+        IntHashMap messageToTemplate;            // Message ID -> template ID
+    };
+
+    double similarityThreshold;     // Minimum fraction of equal tokens to merge
+    DrainNode* lengthNodes[MAX_TOKENS + 1];
+    TreeShard treeShards[TREE_SHARDS];
+    MemoShard memoShards[MEMO_SHARDS];
+    std::atomic<LogTemplate**> segments[MAX_SEGMENTS];   // Template ID -> template
+    std::atomic<int> templateCount;
+    std::mutex directoryLock;       // Serializes template creation across tree shards
+
+    static inline bool isWildcard(const char* token) {
+        return strcmp(token, "<*>") == 0;
+    }
+
+    static inline unsigned int hashToken(const char* token) {
+        unsigned int hash = 5381;
+        int c;
+        while ((c = *token++)) {
+            hash = ((hash << 5) + hash) + c;  // djb2
+        }
+        return hash;
+    }
+
+    // Does this token look like a variable (number, hex value, UUID)?
+    static inline bool isVariableToken(const char* token, int length) {
+        int hexChars = 0;
+        for (int i = 0; i < length; i++) {
+            if (isdigit((unsigned char)token[i])) {
+                return true;
+            }
+            if (isxdigit((unsigned char)token[i])) {
+                hexChars++;
+            }
+        }
+        // Long pure-hex words such as "deadbeefcafe"
+        if (length >= 8 && hexChars == length) {
+            return true;
+        }
+        // UUIDs written only with letters a-f still have the 8-4-4-4-12 shape
+        if (length == 36 && token[8] == '-' && token[13] == '-' &&
+            token[18] == '-' && token[23] == '-' && hexChars == 32) {
+            return true;
+        }
+        return false;
+    }
+
+    // Split a message into masked tokens; returns the token count
+    // tokens must hold MAX_TOKENS entries of MAX_TOKEN_LENGTH bytes
+    static inline int tokenize(const char* message, char tokens[][MAX_TOKEN_LENGTH], int maxTokens) {
+        int count = 0;
+        const char* p = message;
+        while (*p != '\0' && count < maxTokens) {
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            if (*p == '\0') {
+                break;
+            }
+            const char* start = p;
+            while (*p != '\0' && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            int length = (int)(p - start);
+            if (isVariableToken(start, length)) {
+                strcpy(tokens[count], "<*>");
+            } else {
+                if (length >= MAX_TOKEN_LENGTH) {
+                    length = MAX_TOKEN_LENGTH - 1;
+                }
+                memcpy(tokens[count], start, length);
+                tokens[count][length] = '\0';
+            }
+            count++;
+        }
+        return count;
+    }
+
+    // Find a child node by token, or nullptr
+    static inline DrainNode* findChild(DrainNode* node, const char* token) {
+        if (isWildcard(token)) {
+            return node->wildcardChild;
+        }
+        if (node->bucketCount == 0) {
+            return nullptr;
+        }
+        DrainNode* current = node->buckets[hashToken(token) % node->bucketCount];
+        while (current != nullptr) {
+            if (strcmp(current->token, token) == 0) {
+                return current;
+            }
+            current = current->nextInBucket;
+        }
+        return nullptr;
+    }
+
+    static inline void insertChild(DrainNode* node, DrainNode* child) {
+        if (node->childCount >= node->bucketCount * 2) {
+            // Rehash children into a larger bucket array
+            int newCount = node->bucketCount == 0 ? 8 : node->bucketCount * 2;
+            DrainNode** newBuckets = new DrainNode*[newCount];
+            for (int i = 0; i < newCount; i++) {
+                newBuckets[i] = nullptr;
+            }
+            for (int i = 0; i < node->bucketCount; i++) {
+                DrainNode* current = node->buckets[i];
+                while (current != nullptr) {
+                    DrainNode* next = current->nextInBucket;
+                    int index = hashToken(current->token) % newCount;
+                    current->nextInBucket = newBuckets[index];
+                    newBuckets[index] = current;
+                    current = next;
+                }
+            }
+            delete[] node->buckets;
+            node->buckets = newBuckets;
+            node->bucketCount = newCount;
+        }
+        int index = hashToken(child->token) % node->bucketCount;
+        child->nextInBucket = node->buckets[index];
+        node->buckets[index] = child;
+        node->childCount++;
+    }
+
+    // Descend (creating nodes as needed) to the leaf for a token sequence
+    inline DrainNode* findLeaf(char tokens[][MAX_TOKEN_LENGTH], int tokenCount) {
+        int lengthKey = tokenCount < MAX_TOKENS ? tokenCount : MAX_TOKENS;
+        if (lengthNodes[lengthKey] == nullptr) {
+            lengthNodes[lengthKey] = new DrainNode(nullptr);
+        }
+        DrainNode* node = lengthNodes[lengthKey];
+
+        int layers = TREE_DEPTH - 2;
+        for (int depth = 0; depth < layers && depth < tokenCount; depth++) {
+            const char* token = tokens[depth];
+            DrainNode* child = findChild(node, token);
+            if (child == nullptr) {
+                if (isWildcard(token) || node->childCount >= MAX_CHILDREN) {
+                    if (node->wildcardChild == nullptr) {
+                        node->wildcardChild = new DrainNode("<*>");
+                    }
+                    child = node->wildcardChild;
+                } else {
+                    child = new DrainNode(token);
+                    insertChild(node, child);
+                }
+            }
+            node = child;
+        }
+        return node;
+    }
+
+    // Fraction of positions where template and message agree
+    static inline double similarity(const LogTemplate* tmpl, char tokens[][MAX_TOKEN_LENGTH],
+                                    int tokenCount, int& wildcards) {
+        int equal = 0;
+        wildcards = 0;
+        for (int i = 0; i < tokenCount; i++) {
+            if (isWildcard(tmpl->tokens[i])) {
+                wildcards++;
+                // A masked variable in the message matches a template wildcard
+                if (isWildcard(tokens[i])) {
+                    equal++;
+                }
+            } else if (strcmp(tmpl->tokens[i], tokens[i]) == 0) {
+                equal++;
+            }
+        }
+        return tokenCount == 0 ? 1.0 : (double)equal / (double)tokenCount;
+    }
+
+    // Re-render a template's text into its stable buffer
+    static inline void renderText(LogTemplate* tmpl) {
+        char* out = tmpl->text;
+        for (int i = 0; i < tmpl->tokenCount; i++) {
+            if (i > 0) {
+                *out++ = ' ';
+            }
+            size_t length = strlen(tmpl->tokens[i]);
+            memcpy(out, tmpl->tokens[i], length);
+            out += length;
+        }
+        *out = '\0';
+    }
+
+    inline LogTemplate* createTemplate(char tokens[][MAX_TOKEN_LENGTH], int tokenCount) {
+        LogTemplate* tmpl = new LogTemplate;
+        tmpl->tokenCount = tokenCount;
+        tmpl->tokens = new char*[tokenCount > 0 ? tokenCount : 1];
+        tmpl->size = 0;
+        tmpl->nextInLeaf = nullptr;
+
+        // Reserve room for every token to later become "<*>"
+        size_t textCapacity = 1;
+        for (int i = 0; i < tokenCount; i++) {
+            size_t length = strlen(tokens[i]);
+            tmpl->tokens[i] = new char[(length > 3 ? length : 3) + 1];
+            strcpy(tmpl->tokens[i], tokens[i]);
+            textCapacity += (length > 3 ? length : 3) + 1;
+        }
+        tmpl->text = new char[textCapacity];
+        renderText(tmpl);
+
+        // Publish in the directory; segments never move once allocated
+        std::lock_guard<std::mutex> guard(directoryLock);
+        int id = templateCount.load(std::memory_order_relaxed);
+        tmpl->id = (unsigned int)id;
+        int segment;
+        unsigned int offset;
+        locate((unsigned int)id, segment, offset);
+        LogTemplate** block = segments[segment].load(std::memory_order_relaxed);
+        if (block == nullptr) {
+            block = new LogTemplate*[1u << (segment + SEGMENT_BASE_BITS)];
+            segments[segment].store(block, std::memory_order_release);
+        }
+        block[offset] = tmpl;
+        templateCount.store(id + 1, std::memory_order_release);
+        return tmpl;
+    }
+
+    // Floor of log2 for a positive value
+    static inline int floorLog2(unsigned int value) {
+        int result = 0;
+        while (value >>= 1) {
+            result++;
+        }
+        return result;
+    }
+
+    // Map a template ID to its directory segment and offset
+    static inline void locate(unsigned int id, int& segment, unsigned int& offset) {
+        unsigned int v = id + (1u << SEGMENT_BASE_BITS);
+        segment = floorLog2(v) - SEGMENT_BASE_BITS;
+        offset = v - (1u << (segment + SEGMENT_BASE_BITS));
+    }
+
+    // Template by ID (lock-free; the ID must have been handed out)
+    inline LogTemplate* templateAt(unsigned int id) const {
+        int segment;
+        unsigned int offset;
+        locate(id, segment, offset);
+        return segments[segment].load(std::memory_order_acquire)[offset];
+    }
+
+    static inline int memoShardOf(unsigned int messageId) {
+        return (int)((messageId * 0x9E3779B1u) >> 28) & (MEMO_SHARDS - 1);
+    }
+
+    // Number of tokens tokenize() will produce, to pick the tree shard first
+    static inline int countTokens(const char* message) {
+        int count = 0;
+        const char* p = message;
+        while (*p != '\0' && count < MAX_TOKENS) {
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            if (*p == '\0') {
+                break;
+            }
+            while (*p != '\0' && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            count++;
+        }
+        return count;
+    }
+
+    // Take every shard lock, for whole-miner operations (clear, save, load,
+    // memory); with every tree shard held no template can be created, so the
+    // directory lock is not needed
+    inline void lockAll() const {
+        TemplateMiner* self = const_cast<TemplateMiner*>(this);
+        for (int i = 0; i < TREE_SHARDS; i++) {
+            self->treeShards[i].lock.lock();
+        }
+        for (int i = 0; i < MEMO_SHARDS; i++) {
+            self->memoShards[i].lock.lock();
+        }
+    }
+
+    inline void unlockAll() const {
+        TemplateMiner* self = const_cast<TemplateMiner*>(this);
+        for (int i = MEMO_SHARDS - 1; i >= 0; i--) {
+            self->memoShards[i].lock.unlock();
+        }
+        for (int i = TREE_SHARDS - 1; i >= 0; i--) {
+            self->treeShards[i].lock.unlock();
+        }
+    }
+
+    // Delete templates, the tree and the memo (caller holds every lock)
+    inline void releaseAll() {
+        for (int i = 0; i <= MAX_TOKENS; i++) {
+            delete lengthNodes[i];
+            lengthNodes[i] = nullptr;
+        }
+        int count = templateCount.load(std::memory_order_relaxed);
+        for (int i = 0; i < count; i++) {
+            delete templateAt((unsigned int)i);
+        }
+        for (int i = 0; i < MAX_SEGMENTS; i++) {
+            delete[] segments[i].load(std::memory_order_relaxed);
+            segments[i].store(nullptr, std::memory_order_relaxed);
+        }
+        templateCount.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < MEMO_SHARDS; i++) {
+            memoShards[i].messageToTemplate.clear();
+        }
+    }
+
+    // Add the memory of a parse tree node and its subtree (caller holds the lock)
+    static inline void addNodeUsage(const DrainNode* node, MemoryUsage& usage) {
+        usage.addHeap(sizeof(DrainNode), 0, sizeof(DrainNode));
+        if (node->token != nullptr) {
+            size_t length = strlen(node->token) + 1;
+            usage.addHeap(length, 0, length);
+        }
+        if (node->buckets != nullptr) {
+            usage.addHeap(sizeof(DrainNode*) * node->bucketCount, 0, sizeof(DrainNode*) * node->bucketCount);
+        }
+        for (int i = 0; i < node->bucketCount; i++) {
+            for (const DrainNode* child = node->buckets[i]; child != nullptr; child = child->nextInBucket) {
+                addNodeUsage(child, usage);
+            }
+        }
+        if (node->wildcardChild != nullptr) {
+            addNodeUsage(node->wildcardChild, usage);
+        }
+    }
+
+    // Mine a message (caller holds the lock of its tree shard)
+    inline unsigned int mine(const char* message, char tokens[][MAX_TOKEN_LENGTH]) {
+        int tokenCount = tokenize(message, tokens, MAX_TOKENS);
+        DrainNode* leaf = findLeaf(tokens, tokenCount);
+
+        // Pick the most similar template in the leaf (ties go to fewer wildcards)
+        LogTemplate* best = nullptr;
+        double bestSimilarity = -1.0;
+        int bestWildcards = 0;
+        for (LogTemplate* tmpl = leaf->templates; tmpl != nullptr; tmpl = tmpl->nextInLeaf) {
+            if (tmpl->tokenCount != tokenCount) {
+                continue;
+            }
+            int wildcards;
+            double sim = similarity(tmpl, tokens, tokenCount, wildcards);
+            if (sim > bestSimilarity || (sim == bestSimilarity && wildcards < bestWildcards)) {
+                best = tmpl;
+                bestSimilarity = sim;
+                bestWildcards = wildcards;
+            }
+        }
+
+        if (best != nullptr && bestSimilarity >= similarityThreshold) {
+            // Generalize positions where the message differs
+            bool changed = false;
+            for (int i = 0; i < tokenCount; i++) {
+                if (!isWildcard(best->tokens[i]) && strcmp(best->tokens[i], tokens[i]) != 0) {
+                    strcpy(best->tokens[i], "<*>");
+                    changed = true;
+                }
+            }
+            if (changed) {
+                renderText(best);
+            }
+        } else {
+            best = createTemplate(tokens, tokenCount);
+            best->nextInLeaf = leaf->templates;
+            leaf->templates = best;
+        }
+        return best->id;
+    }
+
+    // Body of loadFrom() (caller holds every lock)
+    inline bool loadLocked(SnapshotCursor& cursor) {
+        unsigned long long count = cursor.readU64();
+        if (templateCount.load(std::memory_order_relaxed) != 0 || count > 0x7FFFFFFFULL) {
+            cursor.fail();
+            return false;
+        }
+        char (*tokens)[MAX_TOKEN_LENGTH] = treeShards[0].tokenBuffer;
+        for (unsigned long long i = 0; i < count; i++) {
+            long long size = (long long)cursor.readU64();
+            unsigned long long length = cursor.readU64();
+            const char* text = (const char*)cursor.readArray(length + 1);
+            if (cursor.hasFailed() || text[length] != '\0') {
+                cursor.fail();
+                return false;
+            }
+            int tokenCount = tokenize(text, tokens, MAX_TOKENS);
+            DrainNode* leaf = findLeaf(tokens, tokenCount);
+            LogTemplate* tmpl = createTemplate(tokens, tokenCount);
+            tmpl->size.store(size, std::memory_order_relaxed);
+            tmpl->nextInLeaf = leaf->templates;
+            leaf->templates = tmpl;
+        }
+        if (cursor.readU64() != (unsigned long long)MEMO_SHARDS) {
+            cursor.fail();
+            return false;
+        }
+        for (int i = 0; i < MEMO_SHARDS; i++) {
+            IntHashMap& memo = memoShards[i].messageToTemplate;
+            if (!memo.loadFrom(cursor)) {
+                return false;
+            }
+            for (int slot = 0; slot < memo.getCapacity(); slot++) {
+                if (memo.isOccupied(slot) &&
+                    (memo.valueAt(slot) < 0 || (unsigned long long)memo.valueAt(slot) >= count)) {
+                    cursor.fail();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    // Constructor
+    inline TemplateMiner(double threshold = 0.5) : templateCount(0) {
+        similarityThreshold = threshold;
+        for (int i = 0; i <= MAX_TOKENS; i++) {
+            lengthNodes[i] = nullptr;
+        }
+        for (int i = 0; i < TREE_SHARDS; i++) {
+            treeShards[i].tokenBuffer = new char[MAX_TOKENS][MAX_TOKEN_LENGTH];
+        }
+        for (int i = 0; i < MAX_SEGMENTS; i++) {
+            segments[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // Destructor
+    inline ~TemplateMiner() {
+        releaseAll();
+        for (int i = 0; i < TREE_SHARDS; i++) {
+            delete[] treeShards[i].tokenBuffer;
+        }
+    }
+
+    // Assign a template ID to an interned message (thread-safe)
+    inline unsigned int addMessage(unsigned int messageId, const char* message) {
+        MemoShard& memo = memoShards[memoShardOf(messageId)];
+        long long cached;
+        bool found;
+        {
+            std::lock_guard<std::mutex> guard(memo.lock);
+            found = memo.messageToTemplate.get(messageId, cached);
+        }
+        if (!found) {
+            int tokenCount = countTokens(message);
+            TreeShard& tree = treeShards[tokenCount % TREE_SHARDS];
+            unsigned int mined;
+            {
+                std::lock_guard<std::mutex> guard(tree.lock);
+                mined = mine(message, tree.tokenBuffer);
+            }
+            // Another thread may have mined the same message meanwhile; keep its answer
+            std::lock_guard<std::mutex> guard(memo.lock);
+            cached = memo.messageToTemplate.valueRef(messageId, mined);
+        }
+        unsigned int id = (unsigned int)cached;
+        templateAt(id)->size.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    // Get the rendered text of a template (lock-free)
+    // The address stays valid until clear(); the text may be generalized later
+    inline const char* getText(unsigned int templateId) const {
+        return templateAt(templateId)->text;
+    }
+
+    // Number of messages assigned to a template
+    inline long long getSize(unsigned int templateId) const {
+        return templateAt(templateId)->size.load(std::memory_order_relaxed);
+    }
+
+    // Number of distinct templates
+    inline int getTemplateCount() const {
+        return templateCount.load(std::memory_order_acquire);
+    }
+
+    // Add the memory held by templates, the parse tree and the message memo
+    // Template tokens and text are payload (their capacity is estimated, since
+    // generalized tokens keep their original buffers); the tree is overhead.
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        lockAll();
+        int count = templateCount.load(std::memory_order_relaxed);
+        for (int i = 0; i < MAX_SEGMENTS; i++) {
+            if (segments[i].load(std::memory_order_relaxed) != nullptr) {
+                size_t slots = (size_t)1 << (i + SEGMENT_BASE_BITS);
+                size_t first = slots - ((size_t)1 << SEGMENT_BASE_BITS);   // First ID in the segment
+                size_t used = (size_t)count > first ? (size_t)count - first : 0;
+                if (used > slots) {
+                    used = slots;
+                }
+                usage.addHeap(sizeof(LogTemplate*) * slots, 0, sizeof(LogTemplate*) * used);
+            }
+        }
+        for (int t = 0; t < count; t++) {
+            const LogTemplate* tmpl = templateAt((unsigned int)t);
+            usage.addHeap(sizeof(LogTemplate), sizeof(unsigned int) + sizeof(int) + sizeof(long long),
+                          sizeof(char**) + sizeof(char*) + sizeof(LogTemplate*));
+            int slots = tmpl->tokenCount > 0 ? tmpl->tokenCount : 1;
+            usage.addHeap(sizeof(char*) * slots, 0, sizeof(char*) * tmpl->tokenCount);
+            size_t textCapacity = 1;
+            for (int i = 0; i < tmpl->tokenCount; i++) {
+                size_t length = strlen(tmpl->tokens[i]);
+                usage.addHeap((length > 3 ? length : 3) + 1, length + 1, 0);
+                textCapacity += (length > 3 ? length : 3) + 1;
+            }
+            usage.addHeap(textCapacity, strlen(tmpl->text) + 1, 0);
+        }
+        for (int i = 0; i <= MAX_TOKENS; i++) {
+            if (lengthNodes[i] != nullptr) {
+                addNodeUsage(lengthNodes[i], usage);
+            }
+        }
+        for (int i = 0; i < MEMO_SHARDS; i++) {
+            memoShards[i].messageToTemplate.addMemoryUsage(usage);
+        }
+        size_t scratch = sizeof(char) * MAX_TOKENS * MAX_TOKEN_LENGTH * TREE_SHARDS;
+        usage.addHeap(scratch, 0, scratch);
+        unlockAll();
+    }
+
+    // Write templates (in ID order) and the message memo shards to a snapshot
+    inline void saveTo(SnapshotWriter& writer) const {
+        lockAll();
+        int count = templateCount.load(std::memory_order_relaxed);
+        writer.writeU64((unsigned long long)count);
+        for (int i = 0; i < count; i++) {
+            const LogTemplate* tmpl = templateAt((unsigned int)i);
+            unsigned long long length = strlen(tmpl->text);
+            writer.writeU64((unsigned long long)tmpl->size.load(std::memory_order_relaxed));
+            writer.writeU64(length);
+            writer.writeArray(tmpl->text, length + 1);
+        }
+        writer.writeU64((unsigned long long)MEMO_SHARDS);
+        for (int i = 0; i < MEMO_SHARDS; i++) {
+            memoShards[i].messageToTemplate.saveTo(writer);
+        }
+        unlockAll();
+    }
+
+    // Load templates saved by saveTo() into an empty miner
+    // Each template is re-inserted into the parse tree under its own tokens, so
+    // template IDs and message assignments are preserved; a template generalized
+    // in one of its first tree-layer tokens now sits under the wildcard branch.
+    inline bool loadFrom(SnapshotCursor& cursor) {
+        lockAll();
+        bool ok = loadLocked(cursor);
+        unlockAll();
+        return ok;
+    }
+
+    // Remove all templates
+    inline void clear() {
+        lockAll();
+        releaseAll();
+        unlockAll();
+    }
+
+private:
+    // Copying is not supported
+    TemplateMiner(const TemplateMiner&);
+    TemplateMiner& operator=(const TemplateMiner&);
+};
+
+#endif // TEMPLATE_MINER_H
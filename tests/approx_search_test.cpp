@@ -0,0 +1,112 @@
+// ApproximateSearch: confidence intervals cover the exact count about as
+// often as their confidence level says, narrow as more units are sampled,
+// and collapse to the exact count once every unit has been.
+
+#include "check.h"
+#include <cstring>
+
+static const int TRIALS = 200;
+static const int SAMPLE_UNITS = 20;        // About 10% of the logs
+
+// Logs containing keyword and its occurrences, counted row by row
+static void countExact(const LogAnalyzer& analyzer, const char* keyword, long long& logs, long long& found) {
+    logs = 0;
+    found = 0;
+    size_t length = strlen(keyword);
+    LogEntry entry;
+    for (int row = 0; row < analyzer.getTotalLogs(); row++) {
+        analyzer.getLogEntry(row, entry);
+        const char* at = strstr(entry.message, keyword);
+        if (at != nullptr) {
+            logs++;
+        }
+        for (; at != nullptr; at = strstr(at + length, keyword)) {
+            found++;
+        }
+    }
+}
+
+static void checkCoverage(const LogAnalyzer& analyzer, const char* keyword) {
+    long long exactLogs;
+    long long exactFound;
+    countExact(analyzer, keyword, exactLogs, exactFound);
+    CHECK(exactLogs > 0);
+    CHECK(analyzer.searchKeyword(keyword, true) == exactFound);
+
+    int logsCovered = 0;
+    int foundCovered = 0;
+    double narrowWidth = 0.0;
+    double wideWidth = 0.0;
+    for (int trial = 0; trial < TRIALS; trial++) {
+        ApproximateSearch search;
+        ApproxEstimate estimate;
+        CHECK(analyzer.startApproximateSearch(keyword, true, search, 1000 + trial, 0.95));
+        analyzer.refineApproximateSearch(search, SAMPLE_UNITS / 4, estimate);
+        wideWidth += estimate.logsHigh - estimate.logsLow;
+        analyzer.refineApproximateSearch(search, SAMPLE_UNITS - SAMPLE_UNITS / 4, estimate);
+        narrowWidth += estimate.logsHigh - estimate.logsLow;
+        CHECK(!estimate.exact);
+        CHECK(estimate.sampledUnits == SAMPLE_UNITS);
+        if (estimate.logsLow <= exactLogs && exactLogs <= estimate.logsHigh) {
+            logsCovered++;
+        }
+        if (estimate.occurrencesLow <= exactFound && exactFound <= estimate.occurrencesHigh) {
+            foundCovered++;
+        }
+    }
+    // 95% intervals over 200 seeds: 90% is three standard errors below
+    CHECK(logsCovered >= TRIALS * 90 / 100);
+    CHECK(foundCovered >= TRIALS * 90 / 100);
+    CHECK(narrowWidth < wideWidth);
+    std::cout << "  \"" << keyword << "\": " << exactLogs << " logs, 95% intervals covered " << logsCovered
+              << "/" << TRIALS << " (logs), " << foundCovered << "/" << TRIALS << " (occurrences)\n";
+
+    // Sampling every unit gives the exact counts
+    ApproximateSearch search;
+    ApproxEstimate estimate;
+    analyzer.startApproximateSearch(keyword, true, search, 7);
+    while (analyzer.refineApproximateSearch(search, 64, estimate) > 0) {
+    }
+    CHECK(estimate.exact);
+    CHECK((long long)(estimate.logs + 0.5) == exactLogs);
+    CHECK((long long)(estimate.occurrences + 0.5) == exactFound);
+    CHECK(estimate.relativeError() == 0.0);
+}
+
+int main() {
+    LogAnalyzer analyzer;
+    loadGenerated(analyzer, 100000);
+
+    checkCoverage(analyzer, "shipped");
+    checkCoverage(analyzer, "user-1");
+
+    // The same seed samples the same units
+    ApproximateSearch first;
+    ApproximateSearch second;
+    ApproxEstimate a;
+    ApproxEstimate b;
+    analyzer.startApproximateSearch("GET", true, first, 42);
+    analyzer.startApproximateSearch("GET", true, second, 42);
+    analyzer.refineApproximateSearch(first, 5, a);
+    analyzer.refineApproximateSearch(second, 5, b);
+    CHECK(a.logs == b.logs && a.logsLow == b.logsLow && a.logsHigh == b.logsHigh);
+
+    // A keyword that never matches has a zero estimate with a positive upper bound
+    ApproximateSearch none;
+    ApproxEstimate estimate;
+    analyzer.startApproximateSearch("no such keyword", true, none, 1);
+    analyzer.refineApproximateSearch(none, 10, estimate);
+    CHECK(estimate.logs == 0.0 && estimate.logsLow == 0.0 && estimate.logsHigh > 0.0);
+
+    // Clearing the data ends a search
+    ApproximateSearch stale;
+    analyzer.startApproximateSearch("shipped", true, stale, 1);
+    {
+        QuietOutput quiet;
+        analyzer.clearAll();
+    }
+    CHECK(analyzer.refineApproximateSearch(stale, 10, estimate) == 0);
+    CHECK(!analyzer.startApproximateSearch("", true, stale, 1));
+
+    return checkResult("approx_search_test");
+}
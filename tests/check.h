@@ -0,0 +1,52 @@
+// Minimal checks shared by the programs in tests/
+// CHECK() prints a failed condition with its location and counts it; each
+// program ends with `return checkResult("name");`, so `make test` stops at
+// the first program with a failure.
+
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include "core.h"
+#include <iostream>
+
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            checkFailures++;                                                              \
+        }                                                                                 \
+    } while (0)
+
+// Silences std::cout while in scope (the analyzer reports progress there)
+class QuietOutput {
+private:
+    std::streambuf* saved;
+
+public:
+    inline QuietOutput() : saved(std::cout.rdbuf(nullptr)) {}
+    inline ~QuietOutput() {
+        std::cout.rdbuf(saved);
+    }
+};
+
+// Fill an analyzer with generated entries (seeded, so every run is the same)
+inline void loadGenerated(LogAnalyzer& analyzer, long long entries, unsigned long long seed = 1) {
+    QuietOutput quiet;
+    GeneratorConfig config;
+    config.entries = entries;
+    config.seed = seed;
+    analyzer.loadGeneratedData(config);
+}
+
+inline int checkResult(const char* name) {
+    if (checkFailures == 0) {
+        std::cout << name << ": passed\n";
+        return 0;
+    }
+    std::cout << name << ": " << checkFailures << " checks failed\n";
+    return 1;
+}
+
+#endif // TESTS_CHECK_H
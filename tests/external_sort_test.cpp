@@ -0,0 +1,217 @@
+// External sort: records come out in key order with ties in insertion
+// order whether or not they spill, merges never open more runs than the
+// fan-in allows, and a file sort writes back exactly the lines it read.
+
+#include "check.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+struct SortCheck {
+    long long records;
+    long long lastKey;
+    long long lastSequence;
+    bool ordered;
+    int maxOpenFiles;
+};
+
+static int countOpenFiles() {
+    int count = 0;
+    DIR* directory = opendir("/proc/self/fd");
+    if (directory == nullptr) {
+        return 0;
+    }
+    while (readdir(directory) != nullptr) {
+        count++;
+    }
+    closedir(directory);
+    return count - 3;   // ".", ".." and the directory itself
+}
+
+static void checkRecord(void* context, long long key, const char* payload, unsigned int length) {
+    SortCheck* check = (SortCheck*)context;
+    long long sequence = 0;
+    if (length >= sizeof(sequence)) {
+        memcpy(&sequence, payload, sizeof(sequence));
+    }
+    if (key < check->lastKey || (key == check->lastKey && sequence <= check->lastSequence)) {
+        check->ordered = false;
+    }
+    check->lastKey = key;
+    check->lastSequence = sequence;
+    if (check->records++ % 4096 == 0) {
+        int open = countOpenFiles();
+        check->maxOpenFiles = open > check->maxOpenFiles ? open : check->maxOpenFiles;
+    }
+}
+
+// Sort records with keys in [0, keyRange) and 8..200 byte payloads
+static void checkSorter(long long records, size_t memoryLimit, long long keyRange, bool expectSpill) {
+    int before = countOpenFiles();
+    ExternalSorter sorter(memoryLimit);
+    unsigned long long state = 7;
+    char payload[200];
+    memset(payload, 'p', sizeof(payload));
+    for (long long sequence = 0; sequence < records; sequence++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        long long key = (long long)((state >> 33) % (unsigned long long)keyRange) - keyRange / 2;
+        memcpy(payload, &sequence, sizeof(sequence));
+        CHECK(sorter.add(key, payload, (unsigned int)(8 + (state >> 20) % 192)) || !"add failed");
+    }
+    SortCheck check = { 0, -(1LL << 62), -1, true, 0 };
+    CHECK(sorter.finish(checkRecord, &check));
+    CHECK(check.records == records);
+    CHECK(check.ordered);
+    CHECK((sorter.getRunCount() > 0) == expectSpill);
+    // 1 MB allows a fan-in of 16: past that, runs are merged while spilling
+    CHECK((sorter.getRunCount() > 16) == (sorter.getMergePassCount() > 0));
+    CHECK(check.maxOpenFiles - before <= 16);
+    if (expectSpill) {
+        std::cout << "  " << records << " records: " << sorter.getRunCount() << " runs, "
+                  << sorter.getMergePassCount() << " intermediate merges, at most "
+                  << (check.maxOpenFiles - before) << " runs open\n";
+    }
+}
+
+// ---- File sort round trip ----
+
+static void writeLines(const char* path, const std::vector<std::string>& lines) {
+    FILE* file = fopen(path, "w");
+    if (file != nullptr) {
+        for (size_t i = 0; i < lines.size(); i++) {
+            fputs(lines[i].c_str(), file);
+            fputc('\n', file);
+        }
+        fclose(file);
+    }
+}
+
+static std::vector<std::string> readLines(const char* path) {
+    std::vector<std::string> lines;
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return lines;
+    }
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+        size_t length = strlen(buffer);
+        if (length > 0 && buffer[length - 1] == '\n') {
+            buffer[length - 1] = '\0';
+        }
+        lines.push_back(buffer);
+    }
+    fclose(file);
+    return lines;
+}
+
+// Entry header lines in the formats the parser accepts, with an entry number
+static std::string entryLine(int file, int entry, long long epoch, unsigned long long random) {
+    char timestamp[20];
+    formatTimestamp(epoch, timestamp);
+    char line[256];
+    switch (random % 5) {
+    case 0:
+        snprintf(line, sizeof(line), "%s INFO entry %d.%d", timestamp, file, entry);
+        break;
+    case 1:
+        snprintf(line, sizeof(line), "%s [WARN] entry %d.%d  (two spaces kept)", timestamp, file, entry);
+        break;
+    case 2:
+        snprintf(line, sizeof(line), "%s | Error | entry %d.%d", timestamp, file, entry);
+        break;
+    case 3:
+        snprintf(line, sizeof(line), "%s plain entry %d.%d without a level", timestamp, file, entry);
+        break;
+    default:
+        snprintf(line, sizeof(line), "{\"ts\":\"%s\",\"level\":\"fatal\",\"msg\":\"entry %d.%d\",\"n\":%llu}",
+                 timestamp, file, entry, random % 1000);
+        break;
+    }
+    return line;
+}
+
+static void checkFileSort() {
+    char directory[] = "/tmp/external_sort_test_XXXXXX";
+    CHECK(mkdtemp(directory) != nullptr);
+    std::vector<std::string> input;
+    std::vector<std::string> paths;
+    unsigned long long state = 3;
+    for (int file = 0; file < 3; file++) {
+        std::vector<std::string> lines;
+        long long epoch = 1705305600;
+        for (int entry = 0; entry < 8000; entry++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            epoch += (long long)((state >> 40) % 3);
+            lines.push_back(entryLine(file, entry, epoch, state >> 33));
+            int frames = (int)((state >> 50) % 4 == 0 ? (state >> 52) % 3 + 1 : 0);
+            for (int frame = 0; frame < frames; frame++) {
+                char line[64];
+                snprintf(line, sizeof(line), "    at frame %d of entry %d.%d", frame, file, entry);
+                lines.push_back(line);
+            }
+        }
+        char path[128];
+        snprintf(path, sizeof(path), "%s/part%d.log", directory, file);
+        writeLines(path, lines);
+        paths.push_back(path);
+        input.insert(input.end(), lines.begin(), lines.end());
+    }
+
+    char output[128];
+    snprintf(output, sizeof(output), "%s/sorted.out", directory);
+    char pattern[128];
+    snprintf(pattern, sizeof(pattern), "%s/*.log", directory);
+    JsonFormat format;
+    {
+        QuietOutput quiet;
+        CHECK(LogAnalyzer::sortLogFiles(pattern, output, 1 << 20, &format));
+    }
+    std::vector<std::string> sorted = readLines(output);
+
+    // Every input line comes out once, unchanged
+    std::vector<std::string> a = input;
+    std::vector<std::string> b = sorted;
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    CHECK(a == b);
+
+    // Entries by timestamp, each followed by its own frames
+    bool ordered = true;
+    bool framesFollow = true;
+    long long lastEpoch = 0;
+    std::string current;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const std::string& line = sorted[i];
+        if (line.compare(0, 4, "    ") == 0) {
+            framesFollow = framesFollow && line.substr(line.rfind(' ')) == current;
+            continue;
+        }
+        const char* text = line.c_str();
+        long long epoch = parseTimestamp(text[0] == '{' ? text + 7 : text);
+        ordered = ordered && epoch != INVALID_EPOCH && epoch >= lastEpoch;
+        lastEpoch = epoch;
+        size_t at = line.find("entry ") + 6;
+        current = " " + line.substr(at, line.find_first_of(" \"", at) - at);
+    }
+    CHECK(ordered);
+    CHECK(framesFollow);
+
+    unlink(output);
+    for (size_t i = 0; i < paths.size(); i++) {
+        unlink(paths[i].c_str());
+    }
+    rmdir(directory);
+}
+
+int main() {
+    checkSorter(50000, 64 << 20, 1000, false);        // Fits in memory
+    checkSorter(300000, 1 << 20, 1000, true);         // About 30 MB through 1 MB
+    checkSorter(300000, 1 << 20, 1, true);            // One key: pure stability
+    checkFileSort();
+    return checkResult("external_sort_test");
+}
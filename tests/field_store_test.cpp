@@ -0,0 +1,45 @@
+// Numeric key=value extraction: token boundaries, quoting and units, and a
+// non-numeric match that must not hide a numeric one later in the text.
+
+#include "check.h"
+#include <cstring>
+
+static bool extract(const char* text, const char* name, double& value) {
+    return extractNumericField(text, name, strlen(name), value);
+}
+
+static bool extractsAs(const char* text, const char* name, double expected) {
+    double value = -1;
+    return extract(text, name, value) && value == expected;
+}
+
+static bool absent(const char* text, const char* name) {
+    double value = -1;
+    return !extract(text, name, value) && value == -1;
+}
+
+int main() {
+    // Plain, quoted, with units, negative and fractional
+    CHECK(extractsAs("latency_ms=310", "latency_ms", 310));
+    CHECK(extractsAs("done latency_ms=310ms status=200", "latency_ms", 310));
+    CHECK(extractsAs("{code=1,latency=\"12.5\"}", "latency", 12.5));
+    CHECK(extractsAs("retry delay='-3'", "delay", -3));
+    CHECK(extractsAs("a=1,size=2048;b=3", "size", 2048));
+
+    // The name must start a token and be followed by '='
+    CHECK(absent("max_latency=310", "latency"));
+    CHECK(absent("latency 310", "latency"));
+    CHECK(absent("", "latency"));
+    CHECK(extractsAs("max_latency=1 latency=2", "latency", 2));
+    CHECK(extractsAs("latency_p99=9 latency=4", "latency", 4));
+
+    // A non-numeric match is skipped, not the end of the search
+    CHECK(extractsAs("user=alice logged in as user=42", "user", 42));
+    CHECK(extractsAs("status=\"ok\" retried status=503", "status", 503));
+    CHECK(extractsAs("id= id=7", "id", 7));
+    CHECK(absent("user=alice user=bob", "user"));
+
+    // The first numeric match wins
+    CHECK(extractsAs("port=80 port=443", "port", 80));
+    return checkResult("field_store_test");
+}
@@ -0,0 +1,139 @@
+// JSON lines: field mapping, escapes, canonical levels, rejection of
+// malformed objects, and the SSE2 classifier agreeing with the scalar one.
+
+#include "check.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+static bool parsesAs(JsonLineParser& parser, const char* line, const char* timestamp, const char* level,
+                     const char* message) {
+    ParsedLine out;
+    return parser.parse(line, strlen(line), out) && strcmp(out.timestamp, timestamp) == 0 &&
+           strcmp(out.level, level) == 0 && out.messageLength == strlen(message) &&
+           memcmp(out.message, message, out.messageLength) == 0;
+}
+
+static void checkFields() {
+    JsonLineParser parser;
+    CHECK(parsesAs(parser,
+                   "{\"ts\":\"2024-01-15T08:00:00Z\",\"level\":\"INFO\",\"msg\":\"started\",\"pid\":42,"
+                   "\"user\":\"a b\",\"ok\":true,\"ctx\":{\"a\":[1,2]}}",
+                   "2024-01-15T08:00:00Z", "INFO", "started pid=42 user=\"a b\" ok=true ctx={\"a\":[1,2]}"));
+
+    // Escapes are decoded, including \u and an escaped backslash before the closing quote
+    CHECK(parsesAs(parser, "{\"msg\":\"say \\\"hi\\\"\\n\\u00e9\\\\\"}", "", UNKNOWN_LEVEL, "say \"hi\"\n\xc3\xa9\\"));
+
+    // Numeric timestamps in milliseconds
+    ParsedLine out;
+    const char* numeric = "{\"time\":1705305600123,\"message\":\"x\"}";
+    CHECK(parser.parse(numeric, strlen(numeric), out));
+    CHECK(out.epoch == 1705305600 && strcmp(out.timestamp, "2024-01-15 08:00:00") == 0);
+
+    // Levels get canonical names; unknown values are kept
+    static const char* const LEVELS[][2] = {
+        { "warn", "WARNING" }, { "fatal", "ERROR" }, { "Error", "ERROR" }, { "err", "ERROR" },
+        { "notice", "INFO" }, { "trace", "DEBUG" }, { "audit", "audit" }
+    };
+    for (size_t i = 0; i < sizeof(LEVELS) / sizeof(LEVELS[0]); i++) {
+        char line[128];
+        snprintf(line, sizeof(line), "{\"ts\":\"2024-01-15 08:00:00\",\"severity\":\"%s\",\"msg\":\"m\"}",
+                 LEVELS[i][0]);
+        CHECK(parsesAs(parser, line, "2024-01-15 08:00:00", LEVELS[i][1], "m"));
+    }
+
+    // Malformed objects are left to the text parser
+    static const char* const BAD[] = {
+        "{\"ts\":\"2024-01-15 08:00:00\",\"level\":\"x\"",
+        "{\"ts\":\"2024-01-15 08:00:00\" \"level\":\"x\"}",
+        "{\"a\":\"unterminated}",
+        "{\"a\":1} trailing",
+        "[1,2]",
+        "2024-01-15 08:00:00 INFO {\"a\":1}"
+    };
+    for (size_t i = 0; i < sizeof(BAD) / sizeof(BAD[0]); i++) {
+        CHECK(!parser.parse(BAD[i], strlen(BAD[i]), out));
+    }
+}
+
+// The SSE2 and scalar classifiers give the same masks, and both parsers the
+// same entries, on strings that cross 64-byte chunks and backslash runs at
+// chunk edges
+static void checkClassifiers() {
+    unsigned long long state = 99;
+    bool sameMasks = true;
+    char chunk[64];
+    for (int trial = 0; trial < 2000; trial++) {
+        for (int i = 0; i < 64; i++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            static const char ALPHABET[] = "\"\\{}[]:, ax0";
+            chunk[i] = ALPHABET[(state >> 33) % (sizeof(ALPHABET) - 1)];
+        }
+        JsonChunkMasks vector;
+        JsonChunkMasks scalar;
+        classifyJsonChunk(chunk, vector);
+        classifyJsonChunkScalar(chunk, scalar);
+        sameMasks = sameMasks && vector.quote == scalar.quote && vector.backslash == scalar.backslash &&
+                    vector.structural == scalar.structural;
+    }
+    CHECK(sameMasks);
+
+    JsonLineParser simd(JsonFormat(), true);
+    JsonLineParser plain(JsonFormat(), false);
+    bool sameEntries = true;
+    for (int pad = 0; pad < 140; pad++) {
+        std::string line = "{\"ts\":\"2024-01-15 08:00:00\",\"level\":\"ERROR\",\"msg\":\"";
+        line.append((size_t)pad, 'x');
+        line += "\\\\\\\"{,}\\\\\",\"k\":[\"a\\\"]\",{\"b\":1}]}";
+        ParsedLine a;
+        ParsedLine b;
+        bool okA = simd.parse(line.c_str(), line.size(), a);
+        std::string messageA = okA ? std::string(a.message, a.messageLength) : "";
+        bool okB = plain.parse(line.c_str(), line.size(), b);
+        std::string messageB = okB ? std::string(b.message, b.messageLength) : "";
+        sameEntries = sameEntries && okA && okB && messageA == messageB &&
+                      messageA == std::string(pad, 'x') + "\\\"{,}\\ k=[\"a\\\"]\",{\"b\":1}]";
+    }
+    CHECK(sameEntries);
+}
+
+// JSON input through the analyzer: aliases are counted as errors
+static void checkIngest() {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/json_lines_test_%d.log", (int)getpid());
+    FILE* file = fopen(path, "w");
+    if (file != nullptr) {
+        fputs("{\"ts\":\"2024-01-15 08:00:00\",\"level\":\"fatal\",\"msg\":\"out of memory\"}\n"
+              "{\"ts\":\"2024-01-15 08:00:01\",\"level\":\"Error\",\"msg\":\"disk failure\"}\n"
+              "    at Disk.write(Disk.java:3)\n"
+              "{\"ts\":\"2024-01-15 08:00:02\",\"level\":\"warn\",\"msg\":\"retrying\"}\n"
+              "2024-01-15 08:00:03 ERR plain text line\n", file);
+        fclose(file);
+    }
+    LogAnalyzer analyzer;
+    JsonFormat format;
+    int fd = open(path, O_RDONLY);
+    CHECK(fd >= 0);
+    {
+        QuietOutput quiet;
+        CHECK(analyzer.ingestStream(fd, &format) == 4);
+    }
+    close(fd);
+    unlink(path);
+    CHECK(analyzer.getErrorCount() == 3);
+    LogEntry entry;
+    analyzer.getLogEntry(1, entry);
+    CHECK(strcmp(entry.log_level, "ERROR") == 0);
+    CHECK(strcmp(entry.message, "disk failure\n    at Disk.write(Disk.java:3)") == 0);
+    analyzer.getLogEntry(2, entry);
+    CHECK(strcmp(entry.log_level, "WARNING") == 0);
+}
+
+int main() {
+    checkFields();
+    checkClassifiers();
+    checkIngest();
+    return checkResult("json_lines_test");
+}
@@ -0,0 +1,193 @@
+// Text log parsing: the accepted line formats, canonical level names,
+// continuation folding, the multi-file merge feeding the analyzer, and a
+// stream that never ends stopped by SIGINT without losing its last entry.
+
+#include "check.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <thread>
+#include <chrono>
+#include <pthread.h>
+#include <unistd.h>
+
+// Parse a copy of text; false if it is not a log line
+static bool parse(const char* text, ParsedLine& out, char* buffer) {
+    strcpy(buffer, text);
+    return parseLogLine(buffer, strlen(buffer), out);
+}
+
+static bool parsesAs(const char* text, const char* timestamp, const char* level, const char* message) {
+    static char buffer[256];
+    ParsedLine out;
+    return parse(text, out, buffer) && strcmp(out.timestamp, timestamp) == 0 && strcmp(out.level, level) == 0 &&
+           out.messageLength == strlen(message) && memcmp(out.message, message, out.messageLength) == 0;
+}
+
+static void checkLines() {
+    CHECK(parsesAs("2024-01-15 08:00:00 INFO Server started", "2024-01-15 08:00:00", "INFO", "Server started"));
+    CHECK(parsesAs("2024-01-15 08:00:00 [WARN] Disk 91% full", "2024-01-15 08:00:00", "WARNING", "Disk 91% full"));
+    CHECK(parsesAs("2024-01-15 08:00:00 | ERROR | Timeout", "2024-01-15 08:00:00", "ERROR", "Timeout"));
+    CHECK(parsesAs("2024-01-15T08:00:00.123Z error: bad input", "2024-01-15T08:00:00.123Z", "ERROR", "bad input"));
+    CHECK(parsesAs("2024-01-15T08:00:00+02:00 Debug x", "2024-01-15T08:00:00+02:00", "DEBUG", "x"));
+
+    // Aliases map like syslog severities, in any case
+    static const char* const ALIASES[][2] = {
+        { "Error", "ERROR" }, { "ERR", "ERROR" }, { "FATAL", "ERROR" }, { "Critical", "ERROR" },
+        { "crit", "ERROR" }, { "SEVERE", "ERROR" }, { "warning", "WARNING" }, { "Notice", "INFO" },
+        { "TRACE", "DEBUG" }
+    };
+    for (size_t i = 0; i < sizeof(ALIASES) / sizeof(ALIASES[0]); i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "2024-01-15 08:00:00 %s message", ALIASES[i][0]);
+        CHECK(parsesAs(line, "2024-01-15 08:00:00", ALIASES[i][1], "message"));
+    }
+
+    // A first word that is not a level stays in the message
+    CHECK(parsesAs("2024-01-15 08:00:00 plain message", "2024-01-15 08:00:00", UNKNOWN_LEVEL, "plain message"));
+    CHECK(parsesAs("2024-01-15 08:00:00 Information only", "2024-01-15 08:00:00", UNKNOWN_LEVEL, "Information only"));
+    CHECK(parsesAs("2024-01-15 08:00:00 INFO.x", "2024-01-15 08:00:00", UNKNOWN_LEVEL, "INFO.x"));
+
+    // Lines without a leading timestamp are continuations
+    char buffer[64];
+    ParsedLine out;
+    CHECK(!parse("    at com.example.Main.run(Main.java:42)", out, buffer));
+    CHECK(!parse("2024-13-45 08:00:00 INFO bad date", out, buffer));
+    CHECK(!parse("2024-01-15", out, buffer));
+}
+
+static void checkAssembler() {
+    static const char* const LINES[] = {
+        "leading text",
+        "2024-01-15 08:00:00 ERROR NullPointerException",
+        "    at A.run(A.java:1)",
+        "    at B.main(B.java:2)",
+        "2024-01-15 08:00:01 INFO done"
+    };
+    LogLineAssembler assembler;
+    int completed = 0;
+    char line[64];
+    char first[64] = "";
+    for (size_t i = 0; i < sizeof(LINES) / sizeof(LINES[0]); i++) {
+        strcpy(line, LINES[i]);
+        if (assembler.addLine(line, strlen(line))) {
+            completed++;
+            if (completed == 2) {
+                const AssembledEntry& entry = assembler.entry();
+                CHECK(strcmp(entry.level, "ERROR") == 0);
+                CHECK(strcmp(entry.message, "NullPointerException\n    at A.run(A.java:1)\n    at B.main(B.java:2)") == 0);
+            } else {
+                snprintf(first, sizeof(first), "%s|%s", assembler.entry().level, assembler.entry().message);
+                CHECK(assembler.entry().epoch == INVALID_EPOCH);
+            }
+        }
+    }
+    CHECK(completed == 2);
+    CHECK(strcmp(first, "UNKNOWN|leading text") == 0);
+    CHECK(assembler.finish());
+    CHECK(strcmp(assembler.entry().message, "done") == 0);
+    CHECK(!assembler.finish());
+    CHECK(assembler.getContinuationLines() == 2);
+}
+
+static void writeFile(const char* path, const char* text) {
+    FILE* file = fopen(path, "w");
+    if (file != nullptr) {
+        fputs(text, file);
+        fclose(file);
+    }
+}
+
+// Two files with interleaved timestamps, merged into one analyzer
+static void checkIngest() {
+    char directory[] = "/tmp/log_parser_test_XXXXXX";
+    CHECK(mkdtemp(directory) != nullptr);
+    char first[128];
+    char second[128];
+    snprintf(first, sizeof(first), "%s/a.log", directory);
+    snprintf(second, sizeof(second), "%s/b.log", directory);
+    writeFile(first,
+              "2024-01-15 08:00:00 Error disk failure\n"
+              "2024-01-15 08:00:02 ERR connection reset\n"
+              "    at Net.read(Net.java:7)\n"
+              "2024-01-15 08:00:04 INFO recovered\n");
+    writeFile(second,
+              "2024-01-15 08:00:01 [WARN] retrying\n"
+              "2024-01-15 08:00:03 | FATAL | out of memory\n"
+              "2024-01-15 08:00:05 ERROR disk failure\n");
+
+    LogAnalyzer analyzer;
+    IngestConfig config;
+    IngestStats stats;
+    {
+        QuietOutput quiet;
+        CHECK(analyzer.ingestFiles(directory, config, stats) == 6);
+    }
+    CHECK(stats.files == 2 && stats.continuationLines == 1 && stats.outOfOrder == 0);
+    CHECK(analyzer.getTotalLogs() == 6);
+    CHECK(analyzer.getErrorCount() == 3);       // Distinct ERROR messages ("disk failure" twice)
+
+    static const char* const LEVELS[] = { "ERROR", "WARNING", "ERROR", "ERROR", "INFO", "ERROR" };
+    LogEntry entry;
+    bool ordered = true;
+    for (int row = 0; row < 6; row++) {
+        analyzer.getLogEntry(row, entry);
+        char expected[20];
+        snprintf(expected, sizeof(expected), "2024-01-15 08:00:0%d", row);
+        ordered = ordered && strcmp(entry.timestamp, expected) == 0 && strcmp(entry.log_level, LEVELS[row]) == 0;
+    }
+    CHECK(ordered);
+    analyzer.getLogEntry(2, entry);
+    CHECK(strcmp(entry.message, "connection reset\n    at Net.read(Net.java:7)") == 0);
+
+    unlink(first);
+    unlink(second);
+    rmdir(directory);
+}
+
+// Write two entries to a pipe that stays open, then interrupt the process
+static void writeThenInterrupt(int fd) {
+    const char text[] = "2024-01-15 08:00:00 INFO first\n"
+                        "2024-01-15 08:00:01 ERROR second\n"
+                        "    at Main.run(Main.java:3)\n";
+    if (write(fd, text, sizeof(text) - 1) != (ssize_t)(sizeof(text) - 1)) {
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    kill(getpid(), SIGINT);
+}
+
+static void checkInterruptedStream() {
+    // Block SIGINT in every thread so it stays pending for the signalfd
+    // (no thread is left to take it with the default action)
+    sigset_t interrupt;
+    sigemptyset(&interrupt);
+    sigaddset(&interrupt, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &interrupt, nullptr);
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    std::thread writer(writeThenInterrupt, fds[1]);
+    LogAnalyzer analyzer;
+    {
+        QuietOutput quiet;
+        CHECK(analyzer.ingestStream(fds[0]) == 2);
+    }
+    writer.join();
+    LogEntry entry;
+    analyzer.getLogEntry(1, entry);
+    CHECK(analyzer.getTotalLogs() == 2 && strcmp(entry.message, "second\n    at Main.run(Main.java:3)") == 0);
+    sigset_t pending;
+    sigpending(&pending);
+    CHECK(!sigismember(&pending, SIGINT));     // Consumed, not left for later
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main() {
+    checkLines();
+    checkAssembler();
+    checkIngest();
+    checkInterruptedStream();
+    return checkResult("log_parser_test");
+}
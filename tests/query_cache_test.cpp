@@ -0,0 +1,158 @@
+// Query cache: cached, extended and narrowed results always equal a search
+// without the cache, and results never outlive the data they came from.
+
+#include "check.h"
+
+static void addBoth(LogAnalyzer& cached, LogAnalyzer& plain, const char* level, const char* message) {
+    QuietOutput quiet;
+    cached.addLog("2024-01-15 08:00:00", level, message);
+    plain.addLog("2024-01-15 08:00:00", level, message);
+}
+
+// Same count, occurrences and rows (newest first) with and without the cache
+static bool sameResult(const LogAnalyzer& cached, const LogAnalyzer& plain, const char* keyword, bool caseSensitive) {
+    static int cachedRows[100000];
+    static int plainRows[100000];
+    int count = cached.findLogsWithKeyword(keyword, caseSensitive, cachedRows, 100000);
+    if (count != plain.findLogsWithKeyword(keyword, caseSensitive, plainRows, 100000) ||
+        cached.searchKeyword(keyword, caseSensitive) != plain.searchKeyword(keyword, caseSensitive)) {
+        return false;
+    }
+    for (int i = 0; i < count && i < 100000; i++) {
+        if (cachedRows[i] != plainRows[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static QueryCacheStats statsOf(const LogAnalyzer& analyzer) {
+    QueryCacheStats stats;
+    analyzer.getQueryCacheStats(stats);
+    return stats;
+}
+
+static void checkAnalyzer() {
+    LogAnalyzer cached;
+    LogAnalyzer plain;
+    plain.setQueryCacheEnabled(false);
+    loadGenerated(cached, 20000);
+    loadGenerated(plain, 20000);
+
+    // First search misses, the repeat hits
+    CHECK(sameResult(cached, plain, "shipped", true));
+    QueryCacheStats before = statsOf(cached);
+    CHECK(before.misses == 1 && before.entries == 1);
+    CHECK(sameResult(cached, plain, "shipped", true));
+    QueryCacheStats after = statsOf(cached);
+    CHECK(after.hits > before.hits && after.misses == before.misses);
+
+    // Rows added after the cached result extend it
+    addBoth(cached, plain, "INFO", "Order 1 shipped to warehouse 2");
+    addBoth(cached, plain, "ERROR", "shipped shipped, twice");
+    addBoth(cached, plain, "INFO", "nothing to see");
+    before = statsOf(cached);
+    CHECK(sameResult(cached, plain, "shipped", true));
+    after = statsOf(cached);
+    CHECK(after.hits > before.hits && after.misses == before.misses);
+    CHECK(plain.searchKeyword("shipped") == cached.searchKeyword("shipped"));
+
+    // A longer keyword narrows the cached rows
+    before = statsOf(cached);
+    CHECK(sameResult(cached, plain, "shipped to warehouse", true));
+    after = statsOf(cached);
+    CHECK(after.narrowed > before.narrowed && after.misses == before.misses);
+
+    // A case-insensitive result narrows queries in either case mode, and
+    // answers the same keyword in any case
+    CHECK(sameResult(cached, plain, "order", false));
+    before = statsOf(cached);
+    CHECK(sameResult(cached, plain, "Order 1", true));
+    CHECK(sameResult(cached, plain, "ORDER 1", false));
+    after = statsOf(cached);
+    CHECK(after.narrowed >= before.narrowed + 2 && after.misses == before.misses);
+    before = after;
+    CHECK(sameResult(cached, plain, "OrDeR", false));
+    after = statsOf(cached);
+    CHECK(after.hits > before.hits && after.misses == before.misses);
+
+    // A case-sensitive result cannot narrow a case-insensitive query
+    CHECK(sameResult(cached, plain, "Query", true));
+    before = statsOf(cached);
+    CHECK(sameResult(cached, plain, "query plan", false));
+    after = statsOf(cached);
+    CHECK(after.misses > before.misses);
+
+    // Clearing the data retires every result
+    {
+        QuietOutput quiet;
+        cached.clearAll();
+        plain.clearAll();
+    }
+    CHECK(statsOf(cached).entries == 0);
+    loadGenerated(cached, 5000, 2);
+    loadGenerated(plain, 5000, 2);
+    before = statsOf(cached);
+    CHECK(sameResult(cached, plain, "shipped", true));
+    after = statsOf(cached);
+    CHECK(after.misses > before.misses);
+
+    // Disabling drops the entries
+    cached.setQueryCacheEnabled(false);
+    CHECK(statsOf(cached).entries == 0 && statsOf(cached).bytes == 0);
+    CHECK(sameResult(cached, plain, "shipped", true));
+    CHECK(statsOf(cached).entries == 0);
+}
+
+static void storeRows(QueryCache& cache, const char* key, long long generation, int watermark, int rows) {
+    KeywordMatches matches;
+    for (int row = 0; row < rows; row++) {
+        matches.append(row);
+    }
+    matches.occurrences = rows;
+    matches.watermark = watermark;
+    cache.store(key, true, generation, matches);
+}
+
+static void checkCache() {
+    QueryCache cache(2);
+    KeywordMatches matches;
+
+    // A result older than the cached one is ignored
+    storeRows(cache, "alpha", 1, 100, 10);
+    storeRows(cache, "alpha", 1, 50, 5);
+    CHECK(cache.lookup("alpha", true, 1, matches) == QUERY_CACHE_HIT);
+    CHECK(matches.watermark == 100 && matches.count == 10 && matches.occurrences == 10);
+    storeRows(cache, "alpha", 1, 200, 12);
+    CHECK(cache.lookup("alpha", true, 1, matches) == QUERY_CACHE_HIT);
+    CHECK(matches.watermark == 200 && matches.count == 12);
+
+    // Another generation does not see the result
+    CHECK(cache.lookup("alpha", true, 2, matches) == QUERY_CACHE_MISS);
+    CHECK(matches.count == 0 && matches.watermark == 0);
+
+    // The least recently used entry goes first
+    storeRows(cache, "beta", 1, 100, 3);
+    CHECK(cache.lookup("alpha", true, 1, matches) == QUERY_CACHE_HIT);
+    storeRows(cache, "gamma", 1, 100, 3);
+    CHECK(cache.lookup("beta", true, 1, matches) == QUERY_CACHE_MISS);
+    CHECK(cache.lookup("alpha", true, 1, matches) == QUERY_CACHE_HIT);
+    QueryCacheStats stats;
+    cache.getStats(stats);
+    CHECK(stats.entries == 2 && stats.evictions == 1);
+
+    // Narrowing hands over the parent's rows but not its occurrences
+    CHECK(cache.lookup("alphabet", true, 1, matches) == QUERY_CACHE_NARROWED);
+    CHECK(matches.count == 12 && matches.occurrences == 0 && matches.watermark == 200);
+
+    // Storing for a new generation retires the old one's entries
+    storeRows(cache, "delta", 2, 10, 1);
+    cache.getStats(stats);
+    CHECK(stats.entries == 1);
+}
+
+int main() {
+    checkAnalyzer();
+    checkCache();
+    return checkResult("query_cache_test");
+}
@@ -0,0 +1,99 @@
+// Search cursors: pages concatenate to the full result in either order,
+// stop scanning once a page is full, and follow (or ignore) new logs as
+// documented.
+
+#include "check.h"
+
+static const int MAX_ROWS = 100000;
+static int expected[MAX_ROWS];
+static int paged[MAX_ROWS];
+
+// Read a cursor to the end in pages of pageSize rows
+static int readAll(const LogAnalyzer& analyzer, SearchCursor& cursor, int pageSize) {
+    int count = 0;
+    int found;
+    while ((found = analyzer.nextSearchPage(cursor, paged + count, pageSize)) > 0) {
+        count += found;
+    }
+    return count;
+}
+
+static void checkOrder(const LogAnalyzer& analyzer, const char* keyword, bool caseSensitive, int pageSize) {
+    int total = analyzer.findLogsWithKeyword(keyword, caseSensitive, expected, MAX_ROWS);
+    CHECK(total > 0 && total <= MAX_ROWS);
+
+    SearchCursor cursor;
+    CHECK(analyzer.openSearchCursor(keyword, caseSensitive, true, cursor));
+    CHECK(readAll(analyzer, cursor, pageSize) == total);
+    bool same = true;
+    for (int i = 0; i < total; i++) {
+        same = same && paged[i] == expected[i];
+    }
+    CHECK(same);
+    CHECK(analyzer.searchCursorDone(cursor));
+    CHECK(cursor.getMatched() == total && cursor.getScanned() == analyzer.getTotalLogs());
+
+    CHECK(analyzer.openSearchCursor(keyword, caseSensitive, false, cursor));
+    CHECK(readAll(analyzer, cursor, pageSize) == total);
+    same = true;
+    for (int i = 0; i < total; i++) {
+        same = same && paged[i] == expected[total - 1 - i];
+    }
+    CHECK(same);
+    CHECK(analyzer.searchCursorDone(cursor));
+}
+
+int main() {
+    LogAnalyzer analyzer;
+    loadGenerated(analyzer, 50000);
+
+    checkOrder(analyzer, "shipped", true, 100);
+    checkOrder(analyzer, "user-1", true, 7);
+    checkOrder(analyzer, "ORDER", false, 1000);
+
+    // The first page stops scanning once it is full
+    SearchCursor cursor;
+    int rows[20];
+    CHECK(analyzer.openSearchCursor("shipped", true, true, cursor));
+    CHECK(analyzer.nextSearchPage(cursor, rows, 20) == 20);
+    CHECK(cursor.getPageScanned() < analyzer.getTotalLogs() / 10);
+    CHECK(!analyzer.searchCursorDone(cursor));
+
+    // Newest first covers the rows stored when it was opened
+    int total = analyzer.findLogsWithKeyword("shipped", true, expected, MAX_ROWS);
+    int before = analyzer.getTotalLogs();
+    {
+        QuietOutput quiet;
+        analyzer.addLog("2024-01-15 08:00:00", "INFO", "Order 1 shipped to warehouse 2");
+    }
+    CHECK(readAll(analyzer, cursor, 500) == total - 20);
+    CHECK(paged[0] < before);
+
+    // Oldest first picks up logs added between pages
+    CHECK(analyzer.openSearchCursor("shipped", true, false, cursor));
+    int count = readAll(analyzer, cursor, 500);
+    CHECK(count == total + 1);
+    CHECK(analyzer.searchCursorDone(cursor));
+    {
+        QuietOutput quiet;
+        analyzer.addLog("2024-01-15 08:00:01", "INFO", "Order 2 shipped to warehouse 3");
+    }
+    CHECK(!analyzer.searchCursorDone(cursor));
+    CHECK(analyzer.nextSearchPage(cursor, rows, 20) == 1 && rows[0] == analyzer.getTotalLogs() - 1);
+
+    // An empty keyword opens nothing
+    CHECK(!analyzer.openSearchCursor("", true, true, cursor));
+    CHECK(analyzer.nextSearchPage(cursor, rows, 20) == 0);
+
+    // Clearing the data ends every cursor
+    CHECK(analyzer.openSearchCursor("shipped", true, true, cursor));
+    {
+        QuietOutput quiet;
+        analyzer.clearAll();
+    }
+    loadGenerated(analyzer, 1000);
+    CHECK(analyzer.searchCursorDone(cursor));
+    CHECK(analyzer.nextSearchPage(cursor, rows, 20) == 0);
+
+    return checkResult("search_cursor_test");
+}
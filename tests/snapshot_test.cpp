@@ -0,0 +1,209 @@
+// Snapshots: a saved analyzer loads back identical, and a truncated or
+// corrupted file is rejected (or at worst loads garbage) without crashing.
+
+#include "check.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+static char path[256];
+static char* image = nullptr;          // The saved snapshot
+static size_t imageSize = 0;
+
+static bool readImage() {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    imageSize = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    image = new char[imageSize];
+    bool ok = fread(image, 1, imageSize, file) == imageSize;
+    fclose(file);
+    return ok;
+}
+
+// Replace the file (unlinked first: a loaded snapshot stays mapped)
+static void writeFile(const char* data, size_t size) {
+    unlink(path);
+    FILE* file = fopen(path, "wb");
+    if (file != nullptr) {
+        fwrite(data, 1, size, file);
+        fclose(file);
+    }
+}
+
+static bool loadQuietly(LogAnalyzer& analyzer) {
+    QuietOutput quiet;
+    return analyzer.loadSnapshot(path);
+}
+
+static unsigned long long sectionOffset(unsigned int tag) {
+    SnapshotHeader header;
+    memcpy(&header, image, sizeof(header));
+    for (unsigned long long i = 0; i < header.sectionCount; i++) {
+        SnapshotSectionEntry entry;
+        memcpy(&entry, image + header.directoryOffset + i * sizeof(entry), sizeof(entry));
+        if (entry.tag == tag) {
+            return entry.offset;
+        }
+    }
+    return 0;
+}
+
+// Load the image with a 32-bit field overwritten; true if the load failed
+static bool rejectsPatch(LogAnalyzer& analyzer, unsigned long long offset, unsigned int value) {
+    char* copy = new char[imageSize];
+    memcpy(copy, image, imageSize);
+    memcpy(copy + offset, &value, sizeof(value));
+    writeFile(copy, imageSize);
+    delete[] copy;
+    return !loadQuietly(analyzer);
+}
+
+// Touch every row and run a query, so a bad ID would fault here
+static long long exercise(const LogAnalyzer& analyzer) {
+    long long bytes = 0;
+    LogEntry entry;
+    for (int row = 0; row < analyzer.getTotalLogs(); row++) {
+        analyzer.getLogEntry(row, entry);
+        bytes += strlen(entry.timestamp) + strlen(entry.log_level) + strlen(entry.message);
+    }
+    return bytes + analyzer.searchKeyword("ERROR", false);
+}
+
+static bool sameRows(const LogAnalyzer& a, const LogAnalyzer& b) {
+    if (a.getTotalLogs() != b.getTotalLogs()) {
+        return false;
+    }
+    LogEntry left;
+    LogEntry right;
+    for (int row = 0; row < a.getTotalLogs(); row++) {
+        a.getLogEntry(row, left);
+        b.getLogEntry(row, right);
+        if (strcmp(left.timestamp, right.timestamp) != 0 || strcmp(left.log_level, right.log_level) != 0 ||
+            strcmp(left.message, right.message) != 0 || left.templateId != right.templateId ||
+            left.epoch != right.epoch) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    snprintf(path, sizeof(path), "/tmp/snapshot_test_%d.snap", (int)getpid());
+    LogAnalyzer original;
+    loadGenerated(original, 20000);
+    {
+        QuietOutput quiet;
+        CHECK(original.saveSnapshot(path));
+    }
+    CHECK(readImage());
+
+    // Round trip
+    LogAnalyzer loaded;
+    CHECK(loadQuietly(loaded));
+    CHECK(sameRows(original, loaded));
+    CHECK(loaded.getErrorCount() == original.getErrorCount());
+    CHECK(loaded.getTemplateCount() == original.getTemplateCount());
+    CHECK(loaded.getErrorTemplateCount() == original.getErrorTemplateCount());
+    CHECK(loaded.searchKeyword("shipped") == original.searchKeyword("shipped"));
+
+    // New entries after a load reuse interned strings and get new ones
+    {
+        QuietOutput quiet;
+        original.addLog("2024-01-15 08:00:00", "ERROR", "added after the snapshot");
+        loaded.addLog("2024-01-15 08:00:00", "ERROR", "added after the snapshot");
+    }
+    CHECK(sameRows(original, loaded));
+    CHECK(loaded.getErrorCount() == original.getErrorCount());
+
+    // Truncated files and a bad header
+    static const size_t cuts[] = { 0, 8, sizeof(SnapshotHeader), 4096 };
+    for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        writeFile(image, cuts[i]);
+        CHECK(!loadQuietly(loaded));
+    }
+    writeFile(image, imageSize - 8);
+    CHECK(!loadQuietly(loaded));
+    char* copy = new char[imageSize];
+    memcpy(copy, image, imageSize);
+    copy[0] = 'X';
+    writeFile(copy, imageSize);
+    CHECK(!loadQuietly(loaded));
+    delete[] copy;
+
+    // IDs that point outside the structures they index
+    unsigned long long logStore = sectionOffset(SNAPSHOT_LOG_STORE);
+    unsigned long long pool = sectionOffset(SNAPSHOT_STRING_POOL);
+    unsigned long long errors = sectionOffset(SNAPSHOT_ERROR_COUNTS);
+    CHECK(logStore != 0 && pool != 0 && errors != 0);
+    unsigned long long rows;
+    memcpy(&rows, image + logStore, sizeof(rows));
+    unsigned long long idColumn = (rows * 4 + 7) / 8 * 8;
+    CHECK(rejectsPatch(loaded, logStore + 8, 0xFFFFFFFFu));                    // First timestamp ID
+    CHECK(rejectsPatch(loaded, logStore + 8 + 3 * idColumn, 0x7FFFFFFFu));     // First template ID
+    CHECK(rejectsPatch(loaded, errors + 8 + 4, 0x0FFFFFFFu));                  // First error message ID
+
+    // A pool slot naming a string past its shard's count, and an empty slot
+    // marked occupied
+    unsigned long long count;
+    unsigned long long slotCount;
+    memcpy(&count, image + pool + 8, sizeof(count));
+    memcpy(&slotCount, image + pool + 16, sizeof(slotCount));
+    unsigned long long slots = pool + 8 + 5 * 8;
+    unsigned long long occupied = slotCount;
+    unsigned long long empty = slotCount;
+    for (unsigned long long slot = 0; slot < slotCount; slot++) {
+        unsigned int localPlusOne;
+        memcpy(&localPlusOne, image + slots + slot * 8 + 4, sizeof(localPlusOne));
+        if (localPlusOne != 0 && occupied == slotCount) {
+            occupied = slot;
+        }
+        if (localPlusOne == 0 && empty == slotCount) {
+            empty = slot;
+        }
+    }
+    CHECK(occupied < slotCount && empty < slotCount);
+    CHECK(rejectsPatch(loaded, slots + occupied * 8 + 4, (unsigned int)count + 1));
+    CHECK(rejectsPatch(loaded, slots + empty * 8 + 4, 1));
+
+    // A failed load leaves an empty, usable analyzer
+    CHECK(loaded.getTotalLogs() == 0);
+    {
+        QuietOutput quiet;
+        loaded.addLog("2024-01-15 08:00:00", "ERROR", "after a failed load");
+    }
+    CHECK(loaded.getTotalLogs() == 1 && loaded.getErrorCount() == 1);
+
+    // Random byte flips: rejected or loaded, never a crash
+    unsigned long long state = 12345;
+    int accepted = 0;
+    copy = new char[imageSize];
+    for (int trial = 0; trial < 300; trial++) {
+        memcpy(copy, image, imageSize);
+        for (int flip = 0; flip < 4; flip++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            size_t at = (size_t)((state >> 33) % imageSize);
+            copy[at] ^= (char)(1 + (state >> 13) % 255);
+        }
+        writeFile(copy, imageSize);
+        LogAnalyzer analyzer;
+        if (loadQuietly(analyzer)) {
+            accepted++;
+            CHECK(exercise(analyzer) >= 0);
+        }
+    }
+    delete[] copy;
+    std::cout << "  " << accepted << "/300 randomly corrupted snapshots loaded (the rest were rejected)\n";
+
+    // The original image still loads after all that
+    writeFile(image, imageSize);
+    CHECK(loadQuietly(loaded));
+    CHECK(loaded.getTotalLogs() == original.getTotalLogs() - 1);
+
+    unlink(path);
+    delete[] image;
+    return checkResult("snapshot_test");
+}
@@ -0,0 +1,88 @@
+// Syslog parsing: RFC 5424 and RFC 3164 headers, severities mapped to
+// analyzer levels, structured data and process IDs as key=value fields,
+// timestamps normalized to UTC, and messages without a <PRI> rejected.
+
+#include "check.h"
+#include <cstring>
+
+static SyslogParser parser;
+
+// Parse text; true if it gives this timestamp, level and message
+static bool parsesAs(const char* text, const char* timestamp, const char* level, const char* message) {
+    char buffer[256];
+    SyslogEntry entry;
+    entry.message = buffer;
+    entry.messageCapacity = sizeof(buffer);
+    if (!parser.parse(text, strlen(text), entry)) {
+        return false;
+    }
+    bool same = strcmp(entry.timestamp, timestamp) == 0 && strcmp(entry.level, level) == 0 &&
+                strcmp(entry.message, message) == 0 && entry.messageLength == strlen(message);
+    if (!same) {
+        std::cout << "  got " << entry.timestamp << " | " << entry.level << " | " << entry.message << "\n";
+    }
+    return same;
+}
+
+static bool rejects(const char* text) {
+    char buffer[64];
+    SyslogEntry entry;
+    entry.message = buffer;
+    entry.messageCapacity = sizeof(buffer);
+    return !parser.parse(text, strlen(text), entry);
+}
+
+int main() {
+    char received[] = "2024-03-10 12:00:00";
+    parser.setReceiveTime(parseTimestamp(received));
+
+    // Severities: the low three bits of PRI
+    static const char* const LEVELS[8] = { "ERROR", "ERROR", "ERROR", "ERROR", "WARNING", "INFO", "INFO", "DEBUG" };
+    bool mapped = true;
+    for (int severity = 0; severity < 8; severity++) {
+        mapped = mapped && strcmp(syslogLevelName(severity), LEVELS[severity]) == 0 &&
+                 strcmp(syslogLevelName(8 * 23 + severity), LEVELS[severity]) == 0;
+    }
+    CHECK(mapped);
+
+    // RFC 5424: offsets converted to UTC, structured data and PID after the message
+    CHECK(parsesAs("<165>1 2024-01-15T10:30:00.123+02:00 host app 1234 ID47 "
+                   "[origin@32473 iut=\"3\" source=\"Application\"] \xEF\xBB\xBFstarted",
+                   "2024-01-15 08:30:00", "INFO", "app: started iut=3 source=Application pid=1234"));
+    CHECK(parsesAs("<11>1 2024-01-15T23:30:00-01:30 host app - - - disk failed\n",
+                   "2024-01-16 01:00:00", "ERROR", "app: disk failed"));
+    CHECK(parsesAs("<12>1 2024-01-15T10:30:00Z host - - - [a x=\"1\"][b y=\"2\"] two elements",
+                   "2024-01-15 10:30:00", "WARNING", "two elements x=1 y=2"));
+    CHECK(parsesAs("<15>1 2024-01-15T10:30:00Z host app - - [esc v=\"q\\\"b\\\\c\\]d\"] escaped",
+                   "2024-01-15 10:30:00", "DEBUG", "app: escaped v=q\"b\\c]d"));
+    CHECK(parsesAs("<14>1 - host app - - - no timestamp", received, "INFO", "app: no timestamp"));
+    CHECK(parsesAs("<14>1 yesterday host app - - - bad timestamp", received, "INFO", "app: bad timestamp"));
+
+    // RFC 3164: the year comes from the receive time (the previous one for
+    // months more than one ahead), and local senders omit the hostname
+    CHECK(parsesAs("<34>Oct 11 22:14:15 mymachine su: 'su root' failed",
+                   "2023-10-11 22:14:15", "ERROR", "su: 'su root' failed"));
+    CHECK(parsesAs("<30>Mar  5 01:02:03 sshd[42]: Accepted publickey\r\n",
+                   "2024-03-05 01:02:03", "INFO", "sshd: Accepted publickey pid=42"));
+    CHECK(parsesAs("<28>Apr  1 00:00:00 host cron[7]: next month",
+                   "2024-04-01 00:00:00", "WARNING", "cron: next month pid=7"));
+    CHECK(parsesAs("<13>Mar 10 11:00:00 host just text", "2024-03-10 11:00:00", "INFO", "host just text"));
+    CHECK(parsesAs("<13>just a message", received, "INFO", "just a message"));
+
+    // Long messages are truncated to the buffer
+    char buffer[16];
+    SyslogEntry entry;
+    entry.message = buffer;
+    entry.messageCapacity = sizeof(buffer);
+    const char* longText = "<14>1 - host app - - - a message longer than the buffer";
+    CHECK(parser.parse(longText, strlen(longText), entry));
+    CHECK(entry.messageLength == sizeof(buffer) - 1 && strcmp(buffer, "app: a message ") == 0);
+
+    // No <PRI> header, or an invalid one
+    CHECK(rejects(""));
+    CHECK(rejects("Jan 15 10:30:00 host app: text"));
+    CHECK(rejects("<192>1 - host app - - - too high"));
+    CHECK(rejects("<14"));
+    CHECK(rejects("<1x>text"));
+    return checkResult("syslog_parser_test");
+}
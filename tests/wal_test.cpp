@@ -0,0 +1,168 @@
+// Write-ahead log: recovery replays what was logged, a torn tail is cut off,
+// checkpoints truncate the log, and recovery replays only the records the
+// snapshot does not cover.
+
+#include "check.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static char logPath[256];
+static char snapshotPath[256];
+
+static void removeFiles() {
+    unlink(logPath);
+    unlink(snapshotPath);
+}
+
+static long long fileSize(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? (long long)info.st_size : -1;
+}
+
+// Records left in the log (replay() needs a callback)
+static void ignoreRecord(void*, const WalRecord&) {}
+
+static long long countRecords() {
+    unsigned long long lastSequence = 0;
+    return WriteAheadLog::replay(logPath, ignoreRecord, nullptr, lastSequence);
+}
+
+static void addNumbered(LogAnalyzer& analyzer, int first, int count) {
+    char message[64];
+    for (int i = first; i < first + count; i++) {
+        snprintf(message, sizeof(message), "entry %d", i);
+        analyzer.addLog("2024-01-15 08:00:00", i % 3 == 0 ? "ERROR" : "INFO", message);
+    }
+}
+
+// Recover into a fresh analyzer; true if every row holds "entry <row>"
+static bool recoverNumbered(LogAnalyzer& analyzer, const WalConfig& config, int expected) {
+    QuietOutput quiet;
+    if (!analyzer.enableDurability(logPath, snapshotPath, config) || analyzer.getTotalLogs() != expected) {
+        return false;
+    }
+    char message[64];
+    LogEntry entry;
+    for (int row = 0; row < expected; row++) {
+        analyzer.getLogEntry(row, entry);
+        snprintf(message, sizeof(message), "entry %d", row);
+        if (strcmp(entry.message, message) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    snprintf(logPath, sizeof(logPath), "/tmp/wal_test_%d.wal", (int)getpid());
+    snprintf(snapshotPath, sizeof(snapshotPath), "/tmp/wal_test_%d.snap", (int)getpid());
+    removeFiles();
+    WalConfig config;
+    config.checkpointRecords = 0;
+
+    // Every acknowledged entry is replayed, in order
+    {
+        LogAnalyzer analyzer;
+        QuietOutput quiet;
+        CHECK(analyzer.enableDurability(logPath, snapshotPath, config));
+        addNumbered(analyzer, 0, 500);
+        CHECK(analyzer.getWalSyncCount() > 0);
+    }
+    {
+        LogAnalyzer analyzer;
+        CHECK(recoverNumbered(analyzer, config, 500));
+        CHECK(analyzer.getErrorCount() > 0);
+    }
+
+    // A torn last record is dropped and cut off, and logging continues after it
+    long long intact = fileSize(logPath);
+    FILE* file = fopen(logPath, "ab");
+    CHECK(file != nullptr);
+    if (file != nullptr) {
+        const char partial[10] = { 40, 0, 0, 0, 1, 2, 3, 4, 5, 6 };
+        fwrite(partial, 1, sizeof(partial), file);
+        fclose(file);
+    }
+    {
+        LogAnalyzer analyzer;
+        CHECK(recoverNumbered(analyzer, config, 500));
+        CHECK(fileSize(logPath) == intact);
+        QuietOutput quiet;
+        addNumbered(analyzer, 500, 10);
+    }
+    {
+        LogAnalyzer analyzer;
+        CHECK(recoverNumbered(analyzer, config, 510));
+    }
+
+    // A corrupted record ends recovery there
+    CHECK(countRecords() == 510);
+    file = fopen(logPath, "r+b");
+    if (file != nullptr) {
+        fseek(file, -3, SEEK_END);       // Inside the last message
+        fputc('#', file);
+        fclose(file);
+    }
+    {
+        LogAnalyzer analyzer;
+        CHECK(recoverNumbered(analyzer, config, 509));
+    }
+
+    // A checkpoint truncates the log; recovery loads the snapshot and
+    // replays only what was logged after it
+    {
+        LogAnalyzer analyzer;
+        CHECK(recoverNumbered(analyzer, config, 509));
+        QuietOutput quiet;
+        CHECK(analyzer.checkpoint());
+        CHECK(fileSize(logPath) == WriteAheadLog::HEADER_SIZE);
+        CHECK(fileSize(snapshotPath) > 0);
+        addNumbered(analyzer, 509, 25);
+    }
+    CHECK(countRecords() == 25);
+    {
+        LogAnalyzer analyzer;
+        CHECK(recoverNumbered(analyzer, config, 534));
+    }
+
+    // Periodic checkpoints keep the log short
+    removeFiles();
+    WalConfig periodic;
+    periodic.checkpointRecords = 100;
+    {
+        LogAnalyzer analyzer;
+        QuietOutput quiet;
+        CHECK(analyzer.enableDurability(logPath, snapshotPath, periodic));
+        addNumbered(analyzer, 0, 250);
+    }
+    CHECK(countRecords() <= 100);
+    {
+        LogAnalyzer analyzer;
+        CHECK(recoverNumbered(analyzer, periodic, 250));
+    }
+
+    // Bulk loads commit per batch but are fully recoverable
+    removeFiles();
+    long long generated = 0;
+    {
+        LogAnalyzer analyzer;
+        {
+            QuietOutput quiet;
+            CHECK(analyzer.enableDurability(logPath, snapshotPath, config));
+        }
+        loadGenerated(analyzer, 20000);
+        generated = analyzer.getTotalLogs();
+        CHECK(analyzer.getWalSyncCount() < generated / 100);
+    }
+    {
+        LogAnalyzer analyzer;
+        QuietOutput quiet;
+        CHECK(analyzer.enableDurability(logPath, snapshotPath, config));
+        CHECK(analyzer.getTotalLogs() == generated);
+    }
+
+    removeFiles();
+    return checkResult("wal_test");
+}
@@ -0,0 +1,241 @@
+#ifndef TIME_HISTOGRAM_H
+#define TIME_HISTOGRAM_H
+
+#include "int_hash_map.h"
+#include "timestamp.h"
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+
+// One error key whose recent rate rose above its baseline
+struct SpikeEntry {
+    unsigned int key;        // Error key (template ID)
+    long long windowCount;   // Occurrences in the recent window
+    double baselineCount;    // Average occurrences per window over the baseline
+    double ratio;            // windowCount / max(baselineCount, 1)
+};
+
+// Time-bucketed counters maintained incrementally at ingest
+// Every row increments one minute, one hour and one day bucket for its level,
+// and, for error rows, the same three buckets for its error key. A count over
+// any [from, to) window is then summed from at most ~59 + 23 minute/hour
+// buckets at each edge plus whole days in between, without touching rows.
+class TimeHistogram {
+public:
+    static const int LEVEL_SLOTS = 5;    // Matches LogSketches::LEVEL_COUNT
+
+private:
+    static const int GRANULARITIES = 3;      // Minute, hour, day
+
+    IntHashMap levelCounts[GRANULARITIES];   // (bucket * LEVEL_SLOTS + level) -> count
+    IntHashMap keyCounts[GRANULARITIES];     // (bucket << 32 | key) -> count
+    IntHashMap keyTotals;                    // key -> total count (set of known keys)
+    long long minEpoch;
+    long long maxEpoch;
+
+    // Bucket width in seconds for a granularity
+    static inline long long bucketWidth(int g) {
+        return g == 0 ? 60 : (g == 1 ? 3600 : 86400);
+    }
+
+    static inline unsigned long long levelKey(long long bucket, int level) {
+        return (unsigned long long)(bucket * LEVEL_SLOTS + level);
+    }
+
+    static inline unsigned long long errorKey(long long bucket, unsigned int key) {
+        return ((unsigned long long)bucket << 32) | key;
+    }
+
+    // Count stored in one bucket, for a level or for an error key
+    inline long long bucketCount(int g, long long bucket, bool byKey, unsigned int id) const {
+        long long value = 0;
+        if (byKey) {
+            keyCounts[g].get(errorKey(bucket, id), value);
+        } else {
+            levelCounts[g].get(levelKey(bucket, (int)id), value);
+        }
+        return value;
+    }
+
+    // Sum buckets over [from, to), taking the widest aligned bucket at each step
+    // A partial minute at either edge is counted whole.
+    inline long long sumRange(long long from, long long to, bool byKey, unsigned int id) const {
+        if (from < 0) {
+            from = 0;
+        }
+        long long total = 0;
+        long long t = from;
+        while (t < to) {
+            if (t % 60 != 0 || t + 60 > to) {
+                total += bucketCount(0, t / 60, byKey, id);
+                t = (t / 60 + 1) * 60;
+                continue;
+            }
+            int g = GRANULARITIES - 1;
+            while (g > 0 && (t % bucketWidth(g) != 0 || t + bucketWidth(g) > to)) {
+                g--;
+            }
+            total += bucketCount(g, t / bucketWidth(g), byKey, id);
+            t += bucketWidth(g);
+        }
+        return total;
+    }
+
+public:
+    // Constructor
+    inline TimeHistogram() : keyTotals(64) {
+        minEpoch = INVALID_EPOCH;
+        maxEpoch = INVALID_EPOCH;
+    }
+
+    // Record a row at a level (O(1)); rows without a valid timestamp
+    // (or before 1970) are ignored
+    inline void addLevel(long long epoch, int level) {
+        if (epoch < 0) {
+            return;
+        }
+        for (int g = 0; g < GRANULARITIES; g++) {
+            levelCounts[g].add(levelKey(epoch / bucketWidth(g), level), 1);
+        }
+        if (minEpoch == INVALID_EPOCH || epoch < minEpoch) {
+            minEpoch = epoch;
+        }
+        if (maxEpoch == INVALID_EPOCH || epoch > maxEpoch) {
+            maxEpoch = epoch;
+        }
+    }
+
+    // Record an error row for an error key (O(1))
+    inline void addErrorKey(long long epoch, unsigned int key) {
+        if (epoch < 0) {
+            return;
+        }
+        for (int g = 0; g < GRANULARITIES; g++) {
+            keyCounts[g].add(errorKey(epoch / bucketWidth(g), key), 1);
+        }
+        keyTotals.add(key, 1);
+    }
+
+    // Rows at a level with timestamps in [from, to)
+    // Edge minutes are counted whole, so windows should be minute-aligned
+    inline long long countLevel(int level, long long from, long long to) const {
+        return sumRange(from, to, false, (unsigned int)level);
+    }
+
+    // Error rows for a key with timestamps in [from, to)
+    inline long long countErrorKey(unsigned int key, long long from, long long to) const {
+        return sumRange(from, to, true, key);
+    }
+
+    // Find error keys whose count in [now - window, now) is at least `factor`
+    // times their average per-window count over the preceding baseline
+    // Writes up to maxOut entries (highest ratio first); returns the number written
+    inline int findSpikes(long long now, long long window, long long baseline, double factor,
+                          SpikeEntry* out, int maxOut) const {
+        int found = 0;
+        for (int slot = 0; slot < keyTotals.getCapacity(); slot++) {
+            if (!keyTotals.isOccupied(slot)) {
+                continue;
+            }
+            unsigned int key = (unsigned int)keyTotals.keyAt(slot);
+            long long recent = countErrorKey(key, now - window, now);
+            if (recent == 0) {
+                continue;
+            }
+            long long before = countErrorKey(key, now - window - baseline, now - window);
+            double perWindow = baseline > 0 ? (double)before * window / baseline : 0.0;
+            double ratio = recent / (perWindow > 1.0 ? perWindow : 1.0);
+            if (ratio < factor) {
+                continue;
+            }
+
+            // Insert by descending ratio, keeping at most maxOut entries
+            int pos = found < maxOut ? found : maxOut;
+            while (pos > 0 && out[pos - 1].ratio < ratio) {
+                if (pos < maxOut) {
+                    out[pos] = out[pos - 1];
+                }
+                pos--;
+            }
+            if (pos < maxOut) {
+                out[pos].key = key;
+                out[pos].windowCount = recent;
+                out[pos].baselineCount = perWindow;
+                out[pos].ratio = ratio;
+                if (found < maxOut) {
+                    found++;
+                }
+            }
+        }
+        return found;
+    }
+
+    // Earliest and latest timestamps seen (INVALID_EPOCH if none)
+    inline long long getMinEpoch() const {
+        return minEpoch;
+    }
+
+    inline long long getMaxEpoch() const {
+        return maxEpoch;
+    }
+
+    // Add the memory held by the bucket tables
+    inline void addMemoryUsage(MemoryUsage& usage) const {
+        for (int g = 0; g < GRANULARITIES; g++) {
+            levelCounts[g].addMemoryUsage(usage);
+            keyCounts[g].addMemoryUsage(usage);
+        }
+        keyTotals.addMemoryUsage(usage);
+    }
+
+    // Write all bucket tables to a snapshot
+    inline void saveTo(SnapshotWriter& writer) const {
+        writer.writeU64((unsigned long long)minEpoch);
+        writer.writeU64((unsigned long long)maxEpoch);
+        for (int g = 0; g < GRANULARITIES; g++) {
+            levelCounts[g].saveTo(writer);
+            keyCounts[g].saveTo(writer);
+        }
+        keyTotals.saveTo(writer);
+    }
+
+    // Load bucket tables saved by saveTo()
+    // Error keys must be below keyCount (they are resolved as template IDs).
+    inline bool loadFrom(SnapshotCursor& cursor, int keyCount) {
+        minEpoch = (long long)cursor.readU64();
+        maxEpoch = (long long)cursor.readU64();
+        for (int g = 0; g < GRANULARITIES; g++) {
+            if (!levelCounts[g].loadFrom(cursor) || !keyCounts[g].loadFrom(cursor)) {
+                return false;
+            }
+        }
+        if (!keyTotals.loadFrom(cursor)) {
+            return false;
+        }
+        for (int slot = 0; slot < keyTotals.getCapacity(); slot++) {
+            if (keyTotals.isOccupied(slot) && keyTotals.keyAt(slot) >= (unsigned long long)keyCount) {
+                cursor.fail();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Remove all counts
+    inline void clear() {
+        for (int g = 0; g < GRANULARITIES; g++) {
+            levelCounts[g].clear();
+            keyCounts[g].clear();
+        }
+        keyTotals.clear();
+        minEpoch = INVALID_EPOCH;
+        maxEpoch = INVALID_EPOCH;
+    }
+
+private:
+    // Copying is not supported
+    TimeHistogram(const TimeHistogram&);
+    TimeHistogram& operator=(const TimeHistogram&);
+};
+
+#endif // TIME_HISTOGRAM_H
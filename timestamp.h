@@ -0,0 +1,87 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstring>
+#include <cctype>
+
+// Marker for a timestamp that could not be parsed
+const long long INVALID_EPOCH = -9223372036854775807LL - 1;
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm)
+inline long long daysFromCivil(long long year, int month, int day) {
+    year -= month <= 2 ? 1 : 0;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    long long yoe = year - era * 400;
+    long long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Read exactly `digits` decimal digits
+inline bool readDigits(const char*& p, int digits, int& value) {
+    value = 0;
+    for (int i = 0; i < digits; i++) {
+        if (!isdigit((unsigned char)p[i])) {
+            return false;
+        }
+        value = value * 10 + (p[i] - '0');
+    }
+    p += digits;
+    return true;
+}
+
+// Parse "YYYY-MM-DD HH:MM:SS" (a 'T' separator and trailing fractions or
+// zone suffixes are accepted and ignored) into seconds since the Unix epoch
+// Returns INVALID_EPOCH if the text does not start with such a timestamp.
+inline long long parseTimestamp(const char* text) {
+    const char* p = text;
+    int year, month, day, hour, minute, second;
+    if (!readDigits(p, 4, year) || *p++ != '-' ||
+        !readDigits(p, 2, month) || *p++ != '-' ||
+        !readDigits(p, 2, day) || (*p != ' ' && *p != 'T')) {
+        return INVALID_EPOCH;
+    }
+    p++;
+    if (!readDigits(p, 2, hour) || *p++ != ':' ||
+        !readDigits(p, 2, minute) || *p++ != ':' ||
+        !readDigits(p, 2, second)) {
+        return INVALID_EPOCH;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return INVALID_EPOCH;
+    }
+    return daysFromCivil(year, month, day) * 86400LL + hour * 3600LL + minute * 60LL + second;
+}
+
+// Format seconds since the epoch as "YYYY-MM-DD HH:MM:SS" (buffer >= 20 bytes)
+inline void formatTimestamp(long long epoch, char* buffer) {
+    long long days = epoch >= 0 ? epoch / 86400 : (epoch - 86399) / 86400;
+    long long secs = epoch - days * 86400;
+
+    // Inverse of daysFromCivil
+    long long z = days + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    int day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    int month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    long long year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+    int fields[6] = { (int)(year % 10000), month, day,
+                      (int)(secs / 3600), (int)(secs % 3600 / 60), (int)(secs % 60) };
+    const char separators[6] = { '-', '-', ' ', ':', ':', '\0' };
+    char* out = buffer;
+    for (int i = 0; i < 6; i++) {
+        int digits = i == 0 ? 4 : 2;
+        for (int d = digits - 1; d >= 0; d--) {
+            out[d] = (char)('0' + fields[i] % 10);
+            fields[i] /= 10;
+        }
+        out += digits;
+        *out++ = separators[i];
+    }
+}
+
+#endif // TIMESTAMP_H
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <cstring>
 #include <cstdlib>
+#include <ctime>
 
 // Terminal UI functions
 void displayTerminalMenu() {
@@ -22,10 +23,48 @@ void displayTerminalMenu() {
     std::cout << "6. Show Statistics\n";
     std::cout << "7. Clear All Data\n";
     std::cout << "8. Exit\n";
+    std::cout << "9. Show Top-K ERROR Messages\n";
+    std::cout << "10. Enable/Disable Approximate Sketches\n";
+    std::cout << "11. Show Sketch Estimates\n";
+    std::cout << "12. Show Log Levels for Time Range\n";
+    std::cout << "13. Detect ERROR Spikes\n";
+    std::cout << "14. Group-By Aggregation\n";
+    std::cout << "15. Save Snapshot\n";
+    std::cout << "16. Load Snapshot\n";
+    std::cout << "17. Enable/Disable Durable Ingestion (WAL)\n";
+    std::cout << "18. Ingest Log Files (directory or glob)\n";
+    std::cout << "19. Display Logs in Time Order\n";
+    std::cout << "20. Sort Log Files by Timestamp\n";
+    std::cout << "21. Filter Logs by Field (e.g. latency_ms > 300)\n";
+    std::cout << "22. Field Statistics (count/avg/min/max)\n";
+    std::cout << "23. Show Performance Metrics\n";
+    std::cout << "24. Show Memory Usage\n";
+    std::cout << "25. Saved Searches (kept up to date as logs arrive)\n";
+    std::cout << "26. Browse Logs with Keyword (page by page)\n";
+    std::cout << "27. Approximate Keyword Count (sampled)\n";
     std::cout << "========================================\n";
     std::cout << "Enter your choice: ";
 }
 
+// Read a whole input line of any length, growing buffer as needed
+static void readLongLine(char*& buffer, size_t& capacity) {
+    size_t length = 0;
+    while (true) {
+        std::cin.getline(buffer + length, (std::streamsize)(capacity - length));
+        length += strlen(buffer + length);
+        if (!std::cin.fail() || std::cin.eof()) {
+            break;
+        }
+        // The line filled the buffer: grow it and read the rest
+        std::cin.clear();
+        char* grown = new char[capacity * 2];
+        memcpy(grown, buffer, length + 1);
+        delete[] buffer;
+        buffer = grown;
+        capacity *= 2;
+    }
+}
+
 // Run terminal UI
 int runTerminalUI(LogAnalyzer& analyzer) {
     int choice;
@@ -33,6 +72,8 @@ int runTerminalUI(LogAnalyzer& analyzer) {
     char logLevel[32];
     char message[256];
     char keyword[128];
+    size_t entryCapacity = 256;
+    char* entryMessage = new char[entryCapacity];   // Grows for long messages
     
     while (true) {
         displayTerminalMenu();
@@ -55,9 +96,9 @@ int runTerminalUI(LogAnalyzer& analyzer) {
                 std::cin.getline(logLevel, 32);
                 
                 std::cout << "Enter message: ";
-                std::cin.getline(message, 256);
+                readLongLine(entryMessage, entryCapacity);
                 
-                analyzer.addLog(timestamp, logLevel, message);
+                analyzer.addLog(timestamp, logLevel, entryMessage);
                 std::cout << "\n✓ Log entry added successfully!\n";
                 break;
             }
@@ -99,6 +140,15 @@ int runTerminalUI(LogAnalyzer& analyzer) {
                 std::cout << "\n=== Statistics ===\n";
                 std::cout << "Total Logs: " << analyzer.getTotalLogs() << "\n";
                 std::cout << "Unique Errors: " << analyzer.getErrorCount() << "\n";
+                std::cout << "Error Templates: " << analyzer.getErrorTemplateCount() << "\n";
+                std::cout << "Message Templates: " << analyzer.getTemplateCount() << "\n";
+                
+                PoolStats pool;
+                analyzer.getStringPoolStats(pool);
+                std::cout << "Interned Strings: " << pool.uniqueStrings
+                          << " unique of " << pool.internCalls << "\n";
+                std::cout << "Dedup Ratio: " << pool.dedupRatio() << ":1\n";
+                std::cout << "Memory Saved: " << pool.bytesSaved() << " bytes\n";
                 break;
             }
             
@@ -112,9 +162,392 @@ int runTerminalUI(LogAnalyzer& analyzer) {
             case 8: {
                 // Exit
                 std::cout << "\nExiting... Thank you!\n";
+                delete[] entryMessage;
                 return 0;
             }
             
+            case 9: {
+                // Show Top-K ERROR Messages
+                int k;
+                char mode[8];
+                std::cout << "\nHow many entries? ";
+                std::cin >> k;
+                std::cin.ignore();
+                std::cout << "Exact counts? (y/n): ";
+                std::cin.getline(mode, 8);
+                
+                analyzer.displayTopErrors(k, mode[0] == 'y' || mode[0] == 'Y');
+                break;
+            }
+            
+            case 10: {
+                // Enable/Disable Approximate Sketches
+                if (analyzer.sketchesEnabled()) {
+                    analyzer.disableSketches();
+                    std::cout << "\n✓ Sketches disabled.\n";
+                    break;
+                }
+                SketchConfig config;
+                std::cout << "\nHyperLogLog precision (4-18, default 12): ";
+                std::cin >> config.hllPrecision;
+                std::cout << "Count-Min epsilon (e.g. 0.001): ";
+                std::cin >> config.cmsEpsilon;
+                std::cout << "Count-Min delta (e.g. 0.01): ";
+                std::cin >> config.cmsDelta;
+                std::cout << "Distinct-count window in minutes (e.g. 60): ";
+                std::cin >> config.windowSeconds;
+                config.windowSeconds *= 60;
+                std::cin.ignore();
+                
+                analyzer.enableSketches(config);
+                std::cout << "\n✓ Sketches enabled.\n";
+                break;
+            }
+            
+            case 11: {
+                // Show Sketch Estimates
+                std::cout << "\nMessage to estimate (blank to skip): ";
+                std::cin.getline(message, 256);
+                
+                analyzer.displaySketchEstimates(message);
+                break;
+            }
+            
+            case 12: {
+                // Show Log Levels for Time Range
+                long long latest = analyzer.getLatestEpoch();
+                if (latest == INVALID_EPOCH) {
+                    std::cout << "\nNo timestamped log entries found.\n";
+                    break;
+                }
+                std::cout << "\nFrom (YYYY-MM-DD HH:MM:SS, blank = last hour): ";
+                std::cin.getline(timestamp, 64);
+                long long from = parseTimestamp(timestamp);
+                long long to = (latest / 60 + 1) * 60;
+                if (from == INVALID_EPOCH) {
+                    from = to - 3600;
+                } else {
+                    std::cout << "To (YYYY-MM-DD HH:MM:SS, blank = latest): ";
+                    std::cin.getline(timestamp, 64);
+                    if (parseTimestamp(timestamp) != INVALID_EPOCH) {
+                        to = parseTimestamp(timestamp);
+                    }
+                }
+                
+                analyzer.displayLevelCounts(from, to);
+                break;
+            }
+            
+            case 13: {
+                // Detect ERROR Spikes
+                int windowMinutes;
+                int baselineMinutes;
+                double factor;
+                std::cout << "\nRecent window in minutes (e.g. 5): ";
+                std::cin >> windowMinutes;
+                std::cout << "Baseline in minutes (e.g. 60): ";
+                std::cin >> baselineMinutes;
+                std::cout << "Spike factor (e.g. 3): ";
+                std::cin >> factor;
+                std::cin.ignore();
+                
+                analyzer.displayErrorSpikes(windowMinutes, baselineMinutes, factor);
+                break;
+            }
+            
+            case 14: {
+                // Group-By Aggregation
+                GroupByQuery query;
+                std::cout << "\nGroup by (level/template/message/minute/hour/day): ";
+                std::cin.getline(keyword, 128);
+                query.first = parseGroupDimension(keyword);
+                if (query.first == GROUP_NONE) {
+                    std::cout << "\nUnknown column.\n";
+                    break;
+                }
+                std::cout << "Then by (same choices, blank = none): ";
+                std::cin.getline(keyword, 128);
+                query.second = parseGroupDimension(keyword);
+                
+                std::cout << "Only level (blank = all): ";
+                std::cin.getline(logLevel, 32);
+                if (strlen(logLevel) > 0) {
+                    query.levelId = analyzer.findLevelId(logLevel);
+                    if (query.levelId == StringPool::INVALID_ID) {
+                        std::cout << "\nNo logs with level " << logLevel << ".\n";
+                        break;
+                    }
+                }
+                
+                std::cout << "Last N hours (blank = all time): ";
+                std::cin.getline(keyword, 128);
+                int hours = atoi(keyword);
+                long long latest = analyzer.getLatestEpoch();
+                if (hours > 0 && latest != INVALID_EPOCH) {
+                    query.toEpoch = latest + 1;
+                    query.fromEpoch = query.toEpoch - hours * 3600LL;
+                }
+                
+                analyzer.displayGroupBy(query);
+                break;
+            }
+            
+            case 15: {
+                // Save Snapshot
+                std::cout << "\nSnapshot file (blank = analyzer.snap): ";
+                std::cin.getline(message, 256);
+                analyzer.saveSnapshot(strlen(message) > 0 ? message : "analyzer.snap");
+                break;
+            }
+            
+            case 16: {
+                // Load Snapshot
+                std::cout << "\nSnapshot file (blank = analyzer.snap): ";
+                std::cin.getline(message, 256);
+                analyzer.loadSnapshot(strlen(message) > 0 ? message : "analyzer.snap");
+                break;
+            }
+            
+            case 17: {
+                // Enable/Disable Durable Ingestion (WAL)
+                if (analyzer.durabilityEnabled()) {
+                    analyzer.disableDurability();
+                    std::cout << "\nWrite-ahead log closed.\n";
+                    break;
+                }
+                std::cout << "\nWAL file (blank = analyzer.wal): ";
+                std::cin.getline(message, 256);
+                if (strlen(message) == 0) {
+                    strcpy(message, "analyzer.wal");
+                }
+                WalConfig config;
+                std::cout << "Sync policy (always/interval/none, blank = always): ";
+                std::cin.getline(keyword, 128);
+                if (strcmp(keyword, "interval") == 0) {
+                    config.policy = WAL_SYNC_INTERVAL;
+                } else if (strcmp(keyword, "none") == 0) {
+                    config.policy = WAL_SYNC_NONE;
+                }
+                std::cout << "Checkpoint every N entries (blank = 1000000): ";
+                std::cin.getline(keyword, 128);
+                if (strlen(keyword) > 0) {
+                    config.checkpointRecords = atoll(keyword);
+                }
+                
+                char snapshotPath[264];
+                strcpy(snapshotPath, message);
+                strcat(snapshotPath, ".snap");
+                if (analyzer.enableDurability(message, snapshotPath, config)) {
+                    std::cout << "\nDurable ingestion on (checkpoints in " << snapshotPath << ").\n";
+                }
+                break;
+            }
+            
+            case 18: {
+                // Ingest Log Files
+                std::cout << "\nDirectory or glob pattern (e.g. logs/*.log): ";
+                std::cin.getline(message, 256);
+                if (strlen(message) == 0) {
+                    std::cout << "No pattern given.\n";
+                    break;
+                }
+                IngestConfig config;
+                std::cout << "Reorder window in entries per file (blank = 1024): ";
+                std::cin.getline(keyword, 128);
+                if (strlen(keyword) > 0) {
+                    config.reorderWindow = atoi(keyword);
+                }
+                IngestStats stats;
+                analyzer.ingestFiles(message, config, stats);
+                break;
+            }
+            
+            case 19: {
+                // Display Logs in Time Order
+                analyzer.displayLogsByTime((size_t)256 << 20);
+                break;
+            }
+            
+            case 20: {
+                // Sort Log Files by Timestamp
+                std::cout << "\nDirectory or glob pattern: ";
+                std::cin.getline(message, 256);
+                std::cout << "Output file: ";
+                std::cin.getline(keyword, 128);
+                if (strlen(message) == 0 || strlen(keyword) == 0) {
+                    std::cout << "Pattern and output file are required.\n";
+                    break;
+                }
+                char limit[32];
+                std::cout << "Memory limit in MB (blank = 1024): ";
+                std::cin.getline(limit, 32);
+                long long megabytes = strlen(limit) > 0 ? atoll(limit) : 1024;
+                LogAnalyzer::sortLogFiles(message, keyword, (size_t)(megabytes > 0 ? megabytes : 1) << 20);
+                break;
+            }
+            
+            case 21: {
+                // Filter Logs by Field
+                std::cout << "\nFilter (e.g. latency_ms > 300 and status >= 500): ";
+                std::cin.getline(message, 256);
+                analyzer.displayLogsWhere(message);
+                break;
+            }
+            
+            case 22: {
+                // Field Statistics
+                std::cout << "\nNumeric field (e.g. latency_ms): ";
+                std::cin.getline(keyword, 128);
+                char field[128];
+                strcpy(field, keyword);
+                std::cout << "Group by (level/template/message/minute/hour/day, blank = none): ";
+                std::cin.getline(keyword, 128);
+                GroupDimension by = parseGroupDimension(keyword);
+                if (by == GROUP_NONE && strlen(keyword) > 0) {
+                    std::cout << "\nUnknown column.\n";
+                    break;
+                }
+                std::cout << "Filter (blank = all rows): ";
+                std::cin.getline(message, 256);
+                analyzer.displayFieldStats(field, message, by);
+                break;
+            }
+            
+            case 23: {
+                // Show Performance Metrics
+                char mode[8];
+                analyzer.displayMetrics();
+                std::cout << "\nReset metrics? (y/n): ";
+                std::cin.getline(mode, 8);
+                if (mode[0] == 'y' || mode[0] == 'Y') {
+                    analyzer.resetMetrics();
+                    std::cout << "Metrics reset.\n";
+                }
+                break;
+            }
+            
+            case 24: {
+                // Show Memory Usage
+                analyzer.displayMemoryUsage();
+                break;
+            }
+            
+            case 25: {
+                // Saved Searches
+                analyzer.displaySavedSearches();
+                std::cout << "\nAdd, show, remove (a/s/r, blank = back): ";
+                std::cin.getline(logLevel, 32);
+                if (logLevel[0] == 'a' || logLevel[0] == 'A') {
+                    std::cout << "Keyword: ";
+                    std::cin.getline(keyword, 128);
+                    std::cout << "Case-sensitive? (y/n): ";
+                    std::cin.getline(message, 256);
+                    int id = analyzer.addSavedSearch(keyword, message[0] != 'n' && message[0] != 'N');
+                    if (id < 0) {
+                        std::cout << "\nCannot save the search (empty keyword or too many searches).\n";
+                    } else {
+                        std::cout << "\n✓ Saved as search " << id << ".\n";
+                        analyzer.displaySavedSearches();
+                    }
+                } else if (logLevel[0] == 's' || logLevel[0] == 'S') {
+                    std::cout << "Search ID: ";
+                    std::cin.getline(keyword, 128);
+                    std::cout << "How many logs? (blank = 20): ";
+                    std::cin.getline(message, 256);
+                    int limit = atoi(message);
+                    analyzer.displaySavedSearchLogs(atoi(keyword), limit > 0 ? limit : 20);
+                } else if (logLevel[0] == 'r' || logLevel[0] == 'R') {
+                    std::cout << "Search ID: ";
+                    std::cin.getline(keyword, 128);
+                    if (analyzer.removeSavedSearch(atoi(keyword))) {
+                        std::cout << "\n✓ Search removed.\n";
+                    } else {
+                        std::cout << "\nNo such search.\n";
+                    }
+                }
+                break;
+            }
+            
+            case 26: {
+                // Browse Logs with Keyword
+                std::cout << "\nEnter keyword: ";
+                std::cin.getline(keyword, 128);
+                std::cout << "Case-sensitive? (y/n): ";
+                std::cin.getline(logLevel, 32);
+                bool caseSensitive = logLevel[0] != 'n' && logLevel[0] != 'N';
+                std::cout << "Oldest first? (y/n, blank = newest first): ";
+                std::cin.getline(logLevel, 32);
+                bool newestFirst = logLevel[0] != 'y' && logLevel[0] != 'Y';
+                std::cout << "Logs per page (blank = 20): ";
+                std::cin.getline(message, 256);
+                int pageSize = atoi(message) > 0 ? atoi(message) : 20;
+                
+                SearchCursor cursor;
+                if (!analyzer.openSearchCursor(keyword, caseSensitive, newestFirst, cursor)) {
+                    std::cout << "Invalid keyword.\n";
+                    break;
+                }
+                std::cout << "\n=== Logs containing \"" << keyword << "\" ===\n";
+                while (analyzer.displaySearchPage(cursor, pageSize) > 0 && !analyzer.searchCursorDone(cursor)) {
+                    std::cout << "Enter = next page, q = stop: ";
+                    std::cin.getline(message, 256);
+                    if (message[0] == 'q' || message[0] == 'Q') {
+                        break;
+                    }
+                }
+                break;
+            }
+            
+            case 27: {
+                // Approximate Keyword Count
+                std::cout << "\nEnter keyword: ";
+                std::cin.getline(keyword, 128);
+                std::cout << "Case-sensitive? (y/n): ";
+                std::cin.getline(logLevel, 32);
+                bool caseSensitive = logLevel[0] != 'n' && logLevel[0] != 'N';
+                std::cout << "Target precision, +-% (blank = 5): ";
+                std::cin.getline(message, 256);
+                double target = atof(message) > 0.0 ? atof(message) / 100.0 : 0.05;
+                
+                ApproximateSearch search;
+                if (!analyzer.startApproximateSearch(keyword, caseSensitive, search,
+                                                     (unsigned long long)time(nullptr))) {
+                    std::cout << "Invalid keyword.\n";
+                    break;
+                }
+                std::cout << "\n=== Estimated logs containing \"" << keyword << "\" ===\n";
+                ApproxEstimate estimate;
+                analyzer.refineApproximateSearch(search, 0, estimate);
+                // Start with about 1% of the logs, then double the sample each round
+                int round = estimate.totalUnits / 100 > 8 ? estimate.totalUnits / 100 : 8;
+                while (true) {
+                    if (analyzer.refineApproximateSearch(search, round, estimate) == 0 && !estimate.exact) {
+                        std::cout << "The logs were cleared; search stopped.\n";
+                        break;
+                    }
+                    analyzer.displayApproximateEstimate(estimate);
+                    if (estimate.exact) {
+                        break;
+                    }
+                    if (estimate.sampledUnits >= 2 && estimate.relativeError() <= target) {
+                        std::cout << "Within +-" << target * 100.0 << "%. Enter = stop, r = refine further: ";
+                        std::cin.getline(message, 256);
+                        if (message[0] != 'r' && message[0] != 'R') {
+                            break;
+                        }
+                        target /= 2.0;
+                    } else {
+                        std::cout << "Enter = refine, q = stop: ";
+                        std::cin.getline(message, 256);
+                        if (message[0] == 'q' || message[0] == 'Q') {
+                            break;
+                        }
+                    }
+                    round = estimate.sampledUnits;
+                }
+                break;
+            }
+            
             default:
                 std::cout << "\nInvalid choice. Please try again.\n";
                 break;
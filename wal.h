@@ -0,0 +1,406 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include "memory_usage.h"
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// When appended records reach disk
+enum WalSyncPolicy {
+    WAL_SYNC_ALWAYS,     // addLog() returns after its record is fsynced (group commit)
+    WAL_SYNC_INTERVAL,   // A background thread writes and fsyncs every syncIntervalMs
+    WAL_SYNC_NONE        // Records are written when the buffer fills; the OS decides when to sync
+};
+
+// Write-ahead log settings
+struct WalConfig {
+    WalSyncPolicy policy;
+    int syncIntervalMs;            // WAL_SYNC_INTERVAL period
+    long long checkpointRecords;   // Snapshot + truncate after this many records (0 = never)
+
+    inline WalConfig() {
+        policy = WAL_SYNC_ALWAYS;
+        syncIntervalMs = 10;
+        checkpointRecords = 1000000;
+    }
+};
+
+// One record read back during recovery (pointers into the reader's buffer)
+struct WalRecord {
+    unsigned long long sequence;
+    const char* timestamp;
+    const char* level;
+    const char* message;
+};
+
+// Append-only write-ahead log of addLog() calls
+//
+// File layout: an 16-byte header (magic, base sequence), then records of
+//     u32 payloadLength | u32 checksum | u64 sequence | timestamp\0 level\0 message\0
+// The checksum (FNV-1a over sequence and payload) detects torn writes; recovery
+// stops at the first bad record and truncates the file there.
+//
+// Group commit: appends go into an in-memory batch under a short lock. A
+// caller that needs durability becomes the flusher if nobody is flushing,
+// swaps the batch out, and writes and fsyncs it outside the lock; callers that
+// arrive meanwhile queue into the next batch and are covered by the next
+// fsync. One fsync therefore commits every record appended while the
+// previous one was in progress.
+class WriteAheadLog {
+public:
+    static const int HEADER_SIZE = 16;
+    static const int RECORD_HEADER = 16;
+
+private:
+    static const int FLUSH_THRESHOLD = 1 << 20;   // Write out a batch once it reaches 1 MB
+
+    int fd;
+    WalConfig config;
+    std::mutex lock;
+    std::condition_variable flushedSignal;
+    char* active;                  // Batch receiving appends
+    size_t activeSize;
+    size_t activeCapacity;
+    char* standby;                 // Batch being written by the flusher
+    size_t standbyCapacity;
+    unsigned long long nextSequence;
+    unsigned long long durableSequence;    // Highest sequence written and synced
+    bool flushing;
+    bool failed;
+    long long syncCount;
+    std::atomic<bool> stopping;
+    std::thread syncThread;
+
+    static inline unsigned int checksum(const char* data, size_t length, unsigned int hash) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char)data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static inline unsigned int recordChecksum(unsigned long long sequence, const char* payload, size_t length) {
+        return checksum(payload, length, checksum((const char*)&sequence, sizeof(sequence), 2166136261u));
+    }
+
+    static inline bool writeAll(int file, const char* data, size_t length) {
+        while (length > 0) {
+            ssize_t written = ::write(file, data, length);
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            length -= (size_t)written;
+        }
+        return true;
+    }
+
+    // Write out the active batch; sync = fsync afterwards
+    // Called with `guard` held; releases it during I/O.
+    inline void flushBatch(std::unique_lock<std::mutex>& guard, bool sync) {
+        while (flushing) {
+            flushedSignal.wait(guard);
+        }
+        flushing = true;
+        char* batch = active;
+        size_t batchSize = activeSize;
+        unsigned long long target = nextSequence - 1;
+        active = standby;
+        activeSize = 0;
+        size_t capacity = activeCapacity;
+        activeCapacity = standbyCapacity;
+        standby = batch;
+        standbyCapacity = capacity;
+
+        guard.unlock();
+        bool ok = writeAll(fd, batch, batchSize);
+        if (ok && sync) {
+            ok = fdatasync(fd) == 0;
+        }
+        guard.lock();
+
+        if (!ok) {
+            failed = true;
+        } else if (sync) {
+            durableSequence = target;
+            syncCount++;
+        }
+        flushing = false;
+        flushedSignal.notify_all();
+    }
+
+    inline void syncLoop() {
+        while (!stopping.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(config.syncIntervalMs));
+            std::unique_lock<std::mutex> guard(lock);
+            if (durableSequence + 1 < nextSequence) {
+                flushBatch(guard, true);
+            }
+        }
+    }
+
+public:
+    // Constructor
+    inline WriteAheadLog() {
+        fd = -1;
+        activeCapacity = standbyCapacity = FLUSH_THRESHOLD * 2;
+        active = new char[activeCapacity];
+        standby = new char[standbyCapacity];
+        activeSize = 0;
+        nextSequence = 1;
+        durableSequence = 0;
+        flushing = false;
+        failed = false;
+        syncCount = 0;
+        stopping.store(false);
+    }
+
+    // Destructor (flushes and syncs pending records)
+    inline ~WriteAheadLog() {
+        close();
+        delete[] active;
+        delete[] standby;
+    }
+
+    // Open (creating if needed) a log for appending after recovery
+    // nextSeq is the sequence number the next append receives.
+    inline bool open(const char* path, const WalConfig& walConfig, unsigned long long nextSeq) {
+        config = walConfig;
+        fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            return false;
+        }
+        if (info.st_size == 0) {
+            // New file: header records the first sequence it may contain
+            char header[HEADER_SIZE];
+            memcpy(header, "SLAWAL01", 8);
+            memcpy(header + 8, &nextSeq, sizeof(nextSeq));
+            if (!writeAll(fd, header, HEADER_SIZE) || fdatasync(fd) != 0) {
+                return false;
+            }
+        }
+        nextSequence = nextSeq;
+        durableSequence = nextSeq - 1;
+        stopping.store(false);
+        if (config.policy == WAL_SYNC_INTERVAL) {
+            syncThread = std::thread(&WriteAheadLog::syncLoop, this);
+        }
+        return true;
+    }
+
+    // Append one record; returns its sequence number (thread-safe)
+    inline unsigned long long append(const char* timestamp, const char* level, const char* message) {
+        size_t tsLength = strlen(timestamp) + 1;
+        size_t levelLength = strlen(level) + 1;
+        size_t messageLength = strlen(message) + 1;
+        size_t payload = tsLength + levelLength + messageLength;
+
+        std::unique_lock<std::mutex> guard(lock);
+        if (activeSize + RECORD_HEADER + payload > activeCapacity) {
+            if (activeSize > 0) {
+                flushBatch(guard, false);
+            }
+            if (RECORD_HEADER + payload > activeCapacity) {
+                size_t capacity = RECORD_HEADER + payload;
+                delete[] active;
+                active = new char[capacity];
+                activeCapacity = capacity;
+            }
+        }
+        unsigned long long sequence = nextSequence++;
+        char* record = active + activeSize;
+        char* body = record + RECORD_HEADER;
+        memcpy(body, timestamp, tsLength);
+        memcpy(body + tsLength, level, levelLength);
+        memcpy(body + tsLength + levelLength, message, messageLength);
+        unsigned int length = (unsigned int)payload;
+        unsigned int sum = recordChecksum(sequence, body, payload);
+        memcpy(record, &length, sizeof(length));
+        memcpy(record + 4, &sum, sizeof(sum));
+        memcpy(record + 8, &sequence, sizeof(sequence));
+        activeSize += RECORD_HEADER + payload;
+
+        if (config.policy == WAL_SYNC_NONE && activeSize >= (size_t)FLUSH_THRESHOLD) {
+            flushBatch(guard, false);
+        }
+        return sequence;
+    }
+
+    // Wait until a record is durable according to the sync policy
+    // Under WAL_SYNC_ALWAYS the caller may become the group-commit flusher.
+    inline bool commit(unsigned long long sequence) {
+        if (config.policy != WAL_SYNC_ALWAYS) {
+            return !failed;
+        }
+        std::unique_lock<std::mutex> guard(lock);
+        while (durableSequence < sequence && !failed) {
+            if (flushing) {
+                flushedSignal.wait(guard);
+            } else {
+                flushBatch(guard, true);
+            }
+        }
+        return !failed;
+    }
+
+    // Write and fsync everything appended so far
+    inline bool sync() {
+        std::unique_lock<std::mutex> guard(lock);
+        if (fd >= 0 && durableSequence + 1 < nextSequence) {
+            flushBatch(guard, true);
+        }
+        return !failed;
+    }
+
+    // Drop all records (after a checkpoint covered them); the next record
+    // keeps its sequence number, which becomes the file's base sequence
+    inline bool truncate() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (flushing) {
+            flushedSignal.wait(guard);
+        }
+        char header[HEADER_SIZE];
+        memcpy(header, "SLAWAL01", 8);
+        memcpy(header + 8, &nextSequence, sizeof(nextSequence));
+        if (activeSize != 0 || ftruncate(fd, 0) != 0 || !writeAll(fd, header, HEADER_SIZE) ||
+            fdatasync(fd) != 0) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    // Last sequence number handed out (0 if none)
+    inline unsigned long long getLastSequence() {
+        std::lock_guard<std::mutex> guard(lock);
+        return nextSequence - 1;
+    }
+
+    inline long long getSyncCount() {
+        std::lock_guard<std::mutex> guard(lock);
+        return syncCount;
+    }
+
+    // Add the memory held by the batch buffers
+    // Pending records are payload; the standby buffer is overhead of double buffering.
+    inline void addMemoryUsage(MemoryUsage& usage) {
+        std::lock_guard<std::mutex> guard(lock);
+        usage.addHeap(activeCapacity, activeSize, 0);
+        usage.addHeap(standbyCapacity, 0, standbyCapacity);
+    }
+
+    inline bool isOpen() const {
+        return fd >= 0;
+    }
+
+    // Flush, sync and close
+    inline void close() {
+        if (fd < 0) {
+            return;
+        }
+        stopping.store(true);
+        if (syncThread.joinable()) {
+            syncThread.join();
+        }
+        sync();
+        ::close(fd);
+        fd = -1;
+    }
+
+    // Read every intact record of a log, calling apply(context, record) in order
+    // A torn or corrupt tail is cut off so later appends start cleanly.
+    // Returns the number of records read, or -1 if the file is not a WAL.
+    static inline long long replay(const char* path, void (*apply)(void* context, const WalRecord& record),
+                                   void* context, unsigned long long& lastSequence) {
+        lastSequence = 0;
+        int file = ::open(path, O_RDWR);
+        if (file < 0) {
+            return 0;   // No log yet
+        }
+        struct stat info;
+        if (fstat(file, &info) != 0) {
+            ::close(file);
+            return -1;
+        }
+        size_t size = (size_t)info.st_size;
+        char* data = new char[size > 0 ? size : 1];
+        size_t done = 0;
+        while (done < size) {
+            ssize_t got = pread(file, data + done, size - done, (off_t)done);
+            if (got <= 0) {
+                break;
+            }
+            done += (size_t)got;
+        }
+        if (done < (size_t)HEADER_SIZE || memcmp(data, "SLAWAL01", 8) != 0) {
+            delete[] data;
+            ::close(file);
+            return size == 0 ? 0 : -1;
+        }
+        unsigned long long baseSequence;
+        memcpy(&baseSequence, data + 8, sizeof(baseSequence));
+        lastSequence = baseSequence - 1;
+
+        long long records = 0;
+        size_t pos = HEADER_SIZE;
+        while (pos + RECORD_HEADER <= done) {
+            unsigned int length;
+            unsigned int sum;
+            unsigned long long sequence;
+            memcpy(&length, data + pos, sizeof(length));
+            memcpy(&sum, data + pos + 4, sizeof(sum));
+            memcpy(&sequence, data + pos + 8, sizeof(sequence));
+            const char* body = data + pos + RECORD_HEADER;
+            if (length < 3 || length > done - pos - RECORD_HEADER ||
+                sequence != lastSequence + 1 || recordChecksum(sequence, body, length) != sum ||
+                body[length - 1] != '\0') {
+                break;
+            }
+            WalRecord record;
+            record.sequence = sequence;
+            record.timestamp = body;
+            record.level = record.timestamp + strlen(record.timestamp) + 1;
+            if (record.level >= body + length) {
+                break;
+            }
+            record.message = record.level + strlen(record.level) + 1;
+            if (record.message >= body + length) {
+                break;
+            }
+            apply(context, record);
+            lastSequence = sequence;
+            records++;
+            pos += RECORD_HEADER + length;
+        }
+        if (pos < done) {
+            std::cout << "WAL: discarded " << (done - pos) << " bytes of incomplete records\n";
+            if (ftruncate(file, (off_t)pos) != 0) {
+                records = -1;
+            }
+        }
+        delete[] data;
+        ::close(file);
+        return records;
+    }
+
+private:
+    // Copying is not supported
+    WriteAheadLog(const WriteAheadLog&);
+    WriteAheadLog& operator=(const WriteAheadLog&);
+};
+
+#endif // WAL_H